@@ -11,10 +11,12 @@
 #include <cstring>
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <stack>
 #include <string>
 
+#include <BakedFile.h>
 #include <L3DFile.h>
 #include <cxxopts.hpp>
 
@@ -571,6 +573,7 @@ struct Arguments
 		ExtraMetrics,
 		Write,
 		Extract,
+		Bake,
 	};
 	Mode mode;
 	struct Read
@@ -587,6 +590,11 @@ struct Arguments
 		std::filesystem::path inFilename;
 		std::filesystem::path gltfFile;
 	} extract;
+	struct Bake
+	{
+		std::vector<std::filesystem::path> filenames;
+		std::filesystem::path cacheDirectory;
+	} bake;
 };
 
 namespace details
@@ -1203,6 +1211,61 @@ int ExtractFile(const Arguments::Extract& args) noexcept
 	return EXIT_SUCCESS;
 }
 
+int BakeFiles(const Arguments::Bake& args) noexcept
+{
+	std::error_code ec;
+	std::filesystem::create_directories(args.cacheDirectory, ec);
+	if (ec)
+	{
+		std::cerr << "Can't create " << args.cacheDirectory.generic_string() << ": " << ec.message() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	int returnCode = EXIT_SUCCESS;
+	for (const auto& filename : args.filenames)
+	{
+		// The cache is keyed on the bytes of the file so it is read whole rather than opened by path
+		std::ifstream stream(filename, std::ios::binary);
+		if (!stream.is_open())
+		{
+			std::cerr << filename.generic_string() << ": "
+			          << openblack::l3d::ResultToStr(openblack::l3d::L3DResult::ErrCantOpen) << '\n';
+			returnCode = EXIT_FAILURE;
+			continue;
+		}
+		const std::vector<uint8_t> source((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+		openblack::l3d::L3DFile l3d;
+		const auto openResult = l3d.Open(source);
+		if (openResult != openblack::l3d::L3DResult::Success)
+		{
+			std::cerr << filename.generic_string() << ": " << openblack::l3d::ResultToStr(openResult) << '\n';
+			returnCode = EXIT_FAILURE;
+			continue;
+		}
+
+		openblack::baked::BakedFile baked;
+		auto bakeResult = baked.BakeMesh(l3d, source);
+		if (bakeResult == openblack::baked::BakedResult::Success)
+		{
+			const auto path = openblack::baked::GetCachePath(args.cacheDirectory, openblack::baked::BakedKind::Mesh,
+			                                                 baked.GetHeader().sourceHash);
+			bakeResult = baked.Write(path);
+			if (bakeResult == openblack::baked::BakedResult::Success)
+			{
+				std::printf("%s -> %s\n", filename.generic_string().c_str(), path.generic_string().c_str());
+			}
+		}
+		if (bakeResult != openblack::baked::BakedResult::Success)
+		{
+			std::cerr << filename.generic_string() << ": " << openblack::baked::ResultToStr(bakeResult) << '\n';
+			returnCode = EXIT_FAILURE;
+		}
+	}
+
+	return returnCode;
+}
+
 bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexcept
 {
 	cxxopts::Options options("l3dtool", "Inspect and extract files from LionHead L3D files.");
@@ -1211,7 +1274,7 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 	    ("h,help", "Display this help message.")                     //
 	    ("subcommand", "Subcommand.", cxxopts::value<std::string>()) //
 	    ;
-	options.positional_help("[read|write|extract] [OPTION...]");
+	options.positional_help("[read|write|extract|bake] [OPTION...]");
 	options.add_options("read")                                                                                       //
 	    ("H,header", "Print Header Contents.", cxxopts::value<std::vector<std::filesystem::path>>())                  //
 	    ("m,mesh-header", "Print Mesh Headers.", cxxopts::value<std::vector<std::filesystem::path>>())                //
@@ -1232,6 +1295,10 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 	    ("o,output", "Output file (required).", cxxopts::value<std::filesystem::path>())    //
 	    ("i,input-mesh", "Input file (required).", cxxopts::value<std::filesystem::path>()) //
 	    ;
+	options.add_options("bake for the engine's --baked-cache, compressed .zzz meshes must be inflated first") //
+	    ("c,cache", "Cache directory (required).", cxxopts::value<std::filesystem::path>())                   //
+	    ("meshes", "Meshes to bake (required).", cxxopts::value<std::vector<std::filesystem::path>>())         //
+	    ;
 
 	options.parse_positional({"subcommand"});
 
@@ -1363,6 +1430,16 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 			return true;
 		}
 	}
+	else if (result["subcommand"].as<std::string>() == "bake")
+	{
+		if (result["cache"].count() > 0 && result["meshes"].count() > 0)
+		{
+			args.mode = Arguments::Mode::Bake;
+			args.bake.cacheDirectory = result["cache"].as<std::filesystem::path>();
+			args.bake.filenames = result["meshes"].as<std::vector<std::filesystem::path>>();
+			return true;
+		}
+	}
 
 	std::cerr << options.help() << '\n';
 	returnCode = EXIT_FAILURE;
@@ -1388,6 +1465,11 @@ int main(int argc, char* argv[]) noexcept
 		return ExtractFile(args.extract);
 	}
 
+	if (args.mode == Arguments::Mode::Bake)
+	{
+		return BakeFiles(args.bake);
+	}
+
 	for (auto& filename : args.read.filenames)
 	{
 		openblack::l3d::L3DFile l3d;
@@ -9,11 +9,15 @@
 
 #include <cstdlib>
 
+#include <algorithm>
+#include <chrono>
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <string>
 
+#include <LHVM.h>
 #include <LHVMFile.h>
 #include <cxxopts.hpp>
 
@@ -34,7 +38,9 @@ struct Arguments
 		Stack,
 		VarValues,
 		Tasks,
-		RuntimeInfo
+		RuntimeInfo,
+		Bench,
+		Fuse
 	};
 	Mode mode {Mode::Header};
 	struct Read
@@ -42,6 +48,10 @@ struct Arguments
 		std::filesystem::path filename;
 		std::string objName;
 	} read;
+	struct Bench
+	{
+		uint32_t ticks;
+	} bench;
 };
 
 int PrintInfo(const LHVMFile& file)
@@ -418,11 +428,12 @@ int PrintTasks(const LHVMFile& file)
 		std::printf("Active tasks:\n");
 		for (const auto& task : tasks)
 		{
+			const auto& script = file.GetScripts().at(task.scriptId - 1);
 			std::printf("Task number: %u\n", task.id);
 			std::printf("Type: %s\n", k_ScriptTypeNames.at(task.type).c_str());
 			std::printf("Script ID: %u\n", task.scriptId);
-			std::printf("Script name: %s\n", task.name.c_str());
-			std::printf("Filename: %s\n", task.filename.c_str());
+			std::printf("Script name: %s\n", script.name.c_str());
+			std::printf("Filename: %s\n", script.filename.c_str());
 			std::printf("Instruction address: 0x%04x\n", task.instructionAddress);
 			std::printf("Prev instruction address: 0x%04x\n", task.pevInstructionAddress);
 			std::printf("Ticks: %u\n", task.ticks);
@@ -445,7 +456,7 @@ int PrintTasks(const LHVMFile& file)
 			{
 				const auto& var = vars[i];
 				const int id = task.variablesOffset + 1 + i;
-				std::printf("0x%04x, %s = %s\n", id, var.name.c_str(), DataToString(var.value, var.type).c_str());
+				std::printf("0x%04x, %s = %s\n", id, script.variables.at(i).c_str(), DataToString(var.value, var.type).c_str());
 			}
 			std::printf("\n");
 			PrintStack(task.stack);
@@ -479,15 +490,213 @@ int PrintRuntimeInfo(const LHVMFile& file)
 	return EXIT_SUCCESS;
 }
 
+struct BenchResult
+{
+	uint32_t instructions;
+	double seconds;
+};
+
+BenchResult RunBench(LHVM& vm, uint32_t ticks)
+{
+	const auto start = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < ticks; ++i)
+	{
+		vm.LookIn(ScriptType::All);
+	}
+	const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return {vm.GetExecutedInstructions(), elapsed.count()};
+}
+
+bool SameStack(const VMStack& a, const VMStack& b)
+{
+	if (a.count != b.count)
+	{
+		return false;
+	}
+	for (uint32_t i = 0; i < a.count; ++i)
+	{
+		if (a.types[i] != b.types[i] || a.values[i].uintVal != b.values[i].uintVal)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Globals and locals alike
+template <typename Var>
+bool SameVariables(const std::vector<Var>& a, const std::vector<Var>& b)
+{
+	if (a.size() != b.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		if (a[i].type != b[i].type || a[i].value.uintVal != b[i].value.uintVal)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool SameState(LHVM& a, LHVM& b)
+{
+	if (a.GetExecutedInstructions() != b.GetExecutedInstructions() || !SameStack(a.GetMainStack(), b.GetMainStack()) ||
+	    !SameVariables(a.GetVariables(), b.GetVariables()) || a.GetTasks().size() != b.GetTasks().size())
+	{
+		return false;
+	}
+	for (auto ia = a.GetTasks().begin(), ib = b.GetTasks().begin(); ia != a.GetTasks().end(); ++ia, ++ib)
+	{
+		const auto& taskA = ia->second;
+		const auto& taskB = ib->second;
+		if (taskA.id != taskB.id || taskA.instructionAddress != taskB.instructionAddress ||
+		    taskA.waitingTaskId != taskB.waitingTaskId || taskA.inExceptionHandler != taskB.inExceptionHandler ||
+		    !SameStack(taskA.stack, taskB.stack) || !SameVariables(taskA.localVars, taskB.localVars))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool LoadVm(LHVM& vm, const std::vector<NativeFunction>& natives, const LHVMFile& file,
+            const std::filesystem::path& filename)
+{
+	vm.Initialise(&natives, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+	const auto result = file.HasStatus() ? vm.RestoreState(filename) : vm.LoadBinary(file);
+	if (result != EXIT_SUCCESS)
+	{
+		std::fprintf(stderr, "Failed to load the file\n");
+		return false;
+	}
+	return true;
+}
+
+int Bench(const LHVMFile& file, const std::filesystem::path& filename, uint32_t ticks)
+{
+	// The natives are implemented by the game, calls to them only signal an error here. All cores still take the
+	// same path through the scripts.
+	const std::vector<NativeFunction> natives;
+	std::vector<std::pair<const char*, InterpreterCore>> cores {{"Reference", InterpreterCore::Reference},
+	                                                            {"Threaded", InterpreterCore::Threaded}};
+	if (LHVM::IsJitAvailable())
+	{
+		cores.emplace_back("Jit", InterpreterCore::Jit);
+	}
+	std::vector<LHVM> vms(cores.size());
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		vms[i].SetInterpreterCore(cores[i].second);
+		if (!LoadVm(vms[i], natives, file, filename))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::printf("Running %u ticks\n", ticks);
+	std::vector<BenchResult> results;
+	for (auto& vm : vms)
+	{
+		results.push_back(RunBench(vm, ticks));
+	}
+	for (size_t i = 0; i < cores.size(); ++i)
+	{
+		const auto& result = results[i];
+		std::printf("%-10s %12u instructions %10.3f ms %14.0f instructions/s %6.2fx\n", cores[i].first,
+		            result.instructions, result.seconds * 1000.0, result.instructions / result.seconds,
+		            results[0].seconds / result.seconds);
+	}
+
+	for (size_t i = 1; i < cores.size(); ++i)
+	{
+		if (!SameState(vms[0], vms[i]))
+		{
+			std::fprintf(stderr, "The final states of the %s and %s cores differ\n", cores[0].first, cores[i].first);
+			return EXIT_FAILURE;
+		}
+	}
+	std::printf("The final states of the cores match\n");
+	return EXIT_SUCCESS;
+}
+
+void PrintHistogram(const std::map<std::string_view, uint32_t>& histogram)
+{
+	std::vector<std::pair<std::string_view, uint32_t>> sorted(histogram.begin(), histogram.end());
+	std::ranges::stable_sort(sorted, [](const auto& a, const auto& b) { return a.second > b.second; });
+	for (const auto& [name, count] : sorted)
+	{
+		std::printf("\t%-24.*s %8u\n", static_cast<int>(name.size()), name.data(), count);
+	}
+}
+
+int PrintFusedProgram(const LHVMFile& file, const std::filesystem::path& filename, const std::string& name)
+{
+	const std::vector<NativeFunction> natives;
+	LHVM vm;
+	if (!LoadVm(vm, natives, file, filename))
+	{
+		return EXIT_FAILURE;
+	}
+	const auto& instructions = vm.GetInstructions();
+	const auto program = vm.GetThreadedProgram();
+
+	std::map<std::string_view, uint32_t> before;
+	for (const auto& instruction : instructions)
+	{
+		++before[k_OpcodeNames.at(static_cast<int>(instruction.code))];
+	}
+	std::map<std::string_view, uint32_t> after;
+	for (const auto& instruction : program)
+	{
+		++after[instruction.name];
+	}
+	std::printf("Before: %zu instructions\n", instructions.size());
+	PrintHistogram(before);
+	std::printf("After: %zu instructions\n", program.size());
+	PrintHistogram(after);
+	std::printf("\n");
+
+	std::vector<uint32_t> starts;
+	for (const auto& script : vm.GetScripts())
+	{
+		starts.push_back(script.instructionAddress);
+	}
+	std::ranges::sort(starts);
+	for (const auto& script : vm.GetScripts())
+	{
+		if (!name.empty() && name != script.name)
+		{
+			continue;
+		}
+		// Scripts are laid out one after the other
+		const auto next = std::ranges::upper_bound(starts, script.instructionAddress);
+		const auto end = next != starts.end() ? *next : instructions.size();
+		std::printf("begin %s\n", script.name.c_str());
+		auto instruction = std::ranges::lower_bound(program, script.instructionAddress, {},
+		                                            &ThreadedProgramInstruction::address);
+		for (; instruction != program.end() && instruction->address < end; ++instruction)
+		{
+			std::printf("\t0x%04x %-24.*s %u\n", instruction->address, static_cast<int>(instruction->name.size()),
+			            instruction->name.data(), instruction->length);
+		}
+		std::printf("\n");
+	}
+	return EXIT_SUCCESS;
+}
+
 bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexcept
 {
 	cxxopts::Options options("lhvmtool", "Inspect and extract files from LionHead Virtual Machine files.");
 
-	options.add_options()                                            //
-	    ("h,help", "Display this help message.")                     //
-	    ("subcommand", "Subcommand.", cxxopts::value<std::string>()) //
+	options.add_options()                                                     //
+	    ("h,help", "Display this help message.")                              //
+	    ("subcommand", "Subcommand.", cxxopts::value<std::string>())          //
+	    ("f,file", "File for bench and fuse.", cxxopts::value<std::string>()) //
 	    ;
-	options.positional_help("[read] [OPTION...]");
+	options.positional_help("[read|bench|fuse] [OPTION...]");
 	options.add_options("read")                                                     //
 	    ("I,info", "Print info.", cxxopts::value<std::string>())                    //
 	    ("A,all", "Print all relevant data.", cxxopts::value<std::string>())        //
@@ -503,6 +712,9 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 	    ("R,rtinfo", "Print runtime info.", cxxopts::value<std::string>())          //
 	    ("n,name", "Object name", cxxopts::value<std::string>()->default_value("")) //
 	    ;
+	options.add_options("bench")                                                                   //
+	    ("t,ticks", "Number of ticks to run.", cxxopts::value<uint32_t>()->default_value("10000")) //
+	    ;
 
 	options.parse_positional({"subcommand"});
 	auto result = options.parse(argc, argv);
@@ -595,6 +807,26 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 			return true;
 		}
 	}
+	if (result["subcommand"].as<std::string>() == "bench")
+	{
+		if (result["file"].count() > 0)
+		{
+			args.mode = Arguments::Mode::Bench;
+			args.read.filename = result["file"].as<std::string>();
+			args.bench.ticks = result["ticks"].as<uint32_t>();
+			return true;
+		}
+	}
+	if (result["subcommand"].as<std::string>() == "fuse")
+	{
+		if (result["file"].count() > 0)
+		{
+			args.mode = Arguments::Mode::Fuse;
+			args.read.filename = result["file"].as<std::string>();
+			args.read.objName = result["name"].as<std::string>();
+			return true;
+		}
+	}
 	std::cerr << options.help() << '\n';
 	returnCode = EXIT_FAILURE;
 	return false;
@@ -671,6 +903,12 @@ int main(int argc, char* argv[]) noexcept
 	case Arguments::Mode::RuntimeInfo:
 		returnCode |= PrintRuntimeInfo(file);
 		break;
+	case Arguments::Mode::Bench:
+		returnCode |= Bench(file, args.read.filename, args.bench.ticks);
+		break;
+	case Arguments::Mode::Fuse:
+		returnCode |= PrintFusedProgram(file, args.read.filename, args.read.objName);
+		break;
 
 	default:
 		returnCode = EXIT_FAILURE;
@@ -8,13 +8,19 @@
  *******************************************************************************/
 
 #include <cassert>
+#include <cctype>
 #include <cstdlib>
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <limits>
+#include <span>
 #include <string>
 
+#include <ANMFile.h>
+#include <BakedFile.h>
+#include <L3DFile.h>
 #include <PackFile.h>
 #include <cxxopts.hpp>
 
@@ -57,7 +63,7 @@ int ListBlocks(openblack::pack::PackFile& pack)
 	std::printf("%u blocks\n", static_cast<uint32_t>(blocks.size()));
 	std::printf("%u textures\n", static_cast<uint32_t>(pack.GetTextures().size()));
 	std::printf("%u meshes\n", static_cast<uint32_t>(pack.GetMeshes().size()));
-	std::printf("%u animations\n", static_cast<uint32_t>(pack.GetAnimations().size()));
+	std::printf("%u animations\n", static_cast<uint32_t>(pack.GetAnimationCount()));
 	uint32_t i = 0;
 	for (const auto& [name, data] : blocks)
 	{
@@ -168,12 +174,16 @@ int ViewMeshes(openblack::pack::PackFile& pack)
 
 int ViewAnimations(openblack::pack::PackFile& pack)
 {
-	const auto& animations = pack.GetAnimations();
-
-	uint32_t i = 0;
-	for (const auto& animation : animations)
+	std::vector<uint8_t> animation;
+	for (uint32_t i = 0; i < pack.GetAnimationCount(); ++i)
 	{
-		std::printf("animation #%-5d %-32s size %u\n", i++, animation.data(), static_cast<uint32_t>(animation.size()));
+		const auto result = pack.LoadAnimation(i, animation);
+		if (result != openblack::pack::PackResult::Success)
+		{
+			std::printf("animation #%-5d %s\n", i, openblack::pack::ResultToStr(result).data());
+			continue;
+		}
+		std::printf("animation #%-5d %-32s size %u\n", i, animation.data(), static_cast<uint32_t>(animation.size()));
 	}
 
 	return EXIT_SUCCESS;
@@ -265,12 +275,18 @@ int ViewMesh(openblack::pack::PackFile& pack, uint32_t index, const std::filesys
 
 int ViewAnimation(openblack::pack::PackFile& pack, uint32_t index, const std::filesystem::path& outFilename)
 {
-	if (index > pack.GetAnimations().size())
+	if (index > pack.GetAnimationCount())
 	{
 		return EXIT_FAILURE;
 	}
 
-	const auto& animation = pack.GetAnimation(index);
+	std::vector<uint8_t> animation;
+	const auto result = pack.LoadAnimation(index, animation);
+	if (result != openblack::pack::PackResult::Success)
+	{
+		std::fprintf(stderr, "Could not get animation #%u: %s\n", index, openblack::pack::ResultToStr(result).data());
+		return EXIT_FAILURE;
+	}
 
 	std::printf("animation: %-32s %u bytes\n", animation.data(), static_cast<uint32_t>(animation.size()));
 
@@ -313,6 +329,127 @@ int ViewSound(openblack::pack::PackFile& pack, uint32_t index, const std::filesy
 	return EXIT_SUCCESS;
 }
 
+/// Load a single asset described as TYPE:INDEX, or texture:NAME, the data either points into the pack or to storage
+openblack::pack::PackResult LoadAsset(const openblack::pack::PackFile& pack, const std::string& asset,
+                                      std::vector<uint8_t>& storage, std::span<const uint8_t>& data) noexcept
+{
+	using openblack::pack::PackResult;
+
+	const auto separator = asset.find(':');
+	if (separator == std::string::npos)
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+	const auto type = asset.substr(0, separator);
+	const auto key = asset.substr(separator + 1);
+
+	if (type == "texture")
+	{
+		openblack::pack::G3DTexture texture;
+		const auto result = pack.LoadTexture(key, texture);
+		data = texture.ddsData;
+		return result;
+	}
+
+	// The other assets are looked up by index, in decimal or hexadecimal
+	char* end = nullptr;
+	const auto parsed = std::strtoul(key.c_str(), &end, 0);
+	if (key.empty() || std::isdigit(static_cast<unsigned char>(key.front())) == 0 || *end != '\0' ||
+	    parsed > std::numeric_limits<uint32_t>::max())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+	const auto index = static_cast<uint32_t>(parsed);
+
+	if (type == "mesh")
+	{
+		return pack.LoadMesh(index, data);
+	}
+	if (type == "animation")
+	{
+		const auto result = pack.LoadAnimation(index, storage);
+		data = storage;
+		return result;
+	}
+	if (type == "sound")
+	{
+		return pack.LoadAudioSample(index, data);
+	}
+
+	return PackResult::ErrAssetNotFound;
+}
+
+int GetAsset(const openblack::pack::PackFile& pack, const std::string& asset, const std::filesystem::path& outFilename)
+{
+	std::vector<uint8_t> storage;
+	std::span<const uint8_t> data;
+	const auto result = LoadAsset(pack, asset, storage, data);
+	if (result != openblack::pack::PackResult::Success)
+	{
+		std::fprintf(stderr, "Could not get \"%s\": %s\n", asset.c_str(), openblack::pack::ResultToStr(result).data());
+		return EXIT_FAILURE;
+	}
+
+	std::printf("%s: %u bytes\n", asset.c_str(), static_cast<uint32_t>(data.size()));
+
+	if (!outFilename.empty())
+	{
+		std::ofstream output(outFilename, std::ios::binary);
+		output.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+		std::printf("\n%s writen to %s\n", asset.c_str(), outFilename.string().c_str());
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int Benchmark(const std::filesystem::path& filename, const std::string& asset, uint32_t iterations) noexcept
+{
+	using Clock = std::chrono::steady_clock;
+	using Milliseconds = std::chrono::duration<double, std::milli>;
+
+	auto eagerTime = Clock::duration::zero();
+	auto indexTime = Clock::duration::zero();
+	for (uint32_t i = 0; i < iterations; ++i)
+	{
+		auto start = Clock::now();
+		{
+			openblack::pack::PackFile pack;
+			const auto result = pack.Open(filename);
+			if (result != openblack::pack::PackResult::Success)
+			{
+				std::cerr << openblack::pack::ResultToStr(result) << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+		eagerTime += Clock::now() - start;
+
+		start = Clock::now();
+		{
+			openblack::pack::PackFile pack;
+			auto result = pack.OpenIndex(filename);
+			if (result == openblack::pack::PackResult::Success && !asset.empty())
+			{
+				std::vector<uint8_t> storage;
+				std::span<const uint8_t> data;
+				result = LoadAsset(pack, asset, storage, data);
+			}
+			if (result != openblack::pack::PackResult::Success)
+			{
+				std::cerr << openblack::pack::ResultToStr(result) << "\n";
+				return EXIT_FAILURE;
+			}
+		}
+		indexTime += Clock::now() - start;
+	}
+
+	std::printf("%u iterations\n", iterations);
+	std::printf("open:                %10.3f ms\n", Milliseconds(eagerTime).count() / iterations);
+	std::printf("open index%-10s %10.3f ms\n", asset.empty() ? ":" : " + get:", Milliseconds(indexTime).count() / iterations);
+
+	return EXIT_SUCCESS;
+}
+
 int WriteRaw(const std::filesystem::path& outFilename, const std::vector<std::filesystem::path>& inFilenames) noexcept
 {
 	openblack::pack::PackFile pack;
@@ -394,6 +531,79 @@ int WriteSoundFile(const std::filesystem::path& outFilename) noexcept
 	return EXIT_SUCCESS;
 }
 
+/// Write a baked file keyed on the source bytes, which is how the engine looks assets up in its --baked-cache
+int WriteBaked(openblack::baked::BakedFile& baked, openblack::baked::BakedResult result,
+               const std::filesystem::path& cacheDirectory, openblack::baked::BakedKind kind, const std::string& name)
+{
+	if (result == openblack::baked::BakedResult::Success)
+	{
+		result = baked.Write(openblack::baked::GetCachePath(cacheDirectory, kind, baked.GetHeader().sourceHash));
+	}
+	if (result != openblack::baked::BakedResult::Success)
+	{
+		std::cerr << name << ": " << openblack::baked::ResultToStr(result) << '\n';
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int BakeAssets(openblack::pack::PackFile& pack, const std::filesystem::path& cacheDirectory)
+{
+	std::error_code ec;
+	std::filesystem::create_directories(cacheDirectory, ec);
+	if (ec)
+	{
+		std::cerr << "Can't create " << cacheDirectory.generic_string() << ": " << ec.message() << '\n';
+		return EXIT_FAILURE;
+	}
+
+	int returnCode = EXIT_SUCCESS;
+	const auto& meshes = pack.GetMeshes();
+	for (uint32_t i = 0; i < meshes.size(); ++i)
+	{
+		const auto name = "mesh #" + std::to_string(i);
+		openblack::l3d::L3DFile l3d;
+		const auto result = l3d.Open(meshes[i]);
+		if (result != openblack::l3d::L3DResult::Success)
+		{
+			std::cerr << name << ": " << openblack::l3d::ResultToStr(result) << '\n';
+			returnCode = EXIT_FAILURE;
+			continue;
+		}
+		openblack::baked::BakedFile baked;
+		returnCode |=
+		    WriteBaked(baked, baked.BakeMesh(l3d, meshes[i]), cacheDirectory, openblack::baked::BakedKind::Mesh, name);
+	}
+
+	std::vector<uint8_t> animation;
+	for (uint32_t i = 0; i < pack.GetAnimationCount(); ++i)
+	{
+		const auto name = "animation #" + std::to_string(i);
+		if (const auto packResult = pack.LoadAnimation(i, animation); packResult != openblack::pack::PackResult::Success)
+		{
+			std::cerr << name << ": " << openblack::pack::ResultToStr(packResult) << '\n';
+			returnCode = EXIT_FAILURE;
+			continue;
+		}
+		openblack::anm::ANMFile anm;
+		const auto result = anm.Open(animation);
+		if (result != openblack::anm::ANMResult::Success)
+		{
+			std::cerr << name << ": " << openblack::anm::ResultToStr(result) << '\n';
+			returnCode = EXIT_FAILURE;
+			continue;
+		}
+		openblack::baked::BakedFile baked;
+		returnCode |= WriteBaked(baked, baked.BakeAnimation(anm, animation), cacheDirectory,
+		                         openblack::baked::BakedKind::Animation, name);
+	}
+
+	std::printf("baked %u meshes and %u animations into %s\n", static_cast<uint32_t>(meshes.size()),
+	            static_cast<uint32_t>(pack.GetAnimationCount()), cacheDirectory.generic_string().c_str());
+
+	return returnCode;
+}
+
 struct Arguments
 {
 	enum class Mode : uint8_t
@@ -410,15 +620,20 @@ struct Arguments
 		Mesh,
 		Animation,
 		Sound,
+		Get,
+		Benchmark,
 		Body,
 		WriteRaw,
 		WriteMeshPack,
 		WriteAnimationPack,
+		Bake,
 	};
 	std::vector<std::filesystem::path> filenames;
 	Mode mode;
 	std::string block;
 	uint32_t blockId;
+	std::string asset;
+	uint32_t iterations;
 	std::filesystem::path outFilename;
 };
 
@@ -489,12 +704,19 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 	    ("S,sound-block", "List sound block statistics.")                                                   //
 	    ("a,animation", "List animation statistics.", cxxopts::value<uint32_t>())                           //
 	    ("d,sound", "List sound statistics.", cxxopts::value<uint32_t>())                                   //
+	    ("g,get", "Get a single asset (mesh:INDEX, texture:NAME, animation:INDEX or sound:INDEX) from the " //
+	              "index of the pack without extracting the others.",                                       //
+	     cxxopts::value<std::string>())                                                                     //
+	    ("benchmark", "Time opening the whole pack against opening its index and getting the --get asset.") //
+	    ("iterations", "Iterations of --benchmark.", cxxopts::value<uint32_t>()->default_value("10"))       //
 	    ("e,extract", "Extract contents of a block to filename (use \"stdout\" for piping to other tool).", //
 	     cxxopts::value<std::filesystem::path>())                                                           //
 	    ("w,write-raw", "Create Raw Data Pack.", cxxopts::value<std::filesystem::path>())                   //
 	    ("write-mesh", "Create Mesh Pack (file.l3d[[:START]:LENGTH]...).",                                  //
 	     cxxopts::value<std::filesystem::path>())                                                           //
 	    ("write-animation", "Create Mesh Pack.", cxxopts::value<std::filesystem::path>())                   //
+	    ("bake", "Bake the meshes and animations into a directory for the engine's --baked-cache.",         //
+	     cxxopts::value<std::filesystem::path>())                                                           //
 	    ("pack-files", "Pack Files.", cxxopts::value<std::vector<std::filesystem::path>>())                 //
 	    ;
 
@@ -654,6 +876,32 @@ bool parseOptions(int argc, char** argv, Arguments& args, int& returnCode) noexc
 		args.block = result["texture"].as<std::string>();
 		return true;
 	}
+	if (result["benchmark"].count() > 0)
+	{
+		args.mode = Arguments::Mode::Benchmark;
+		args.filenames = result["pack-files"].as<std::vector<std::filesystem::path>>();
+		args.asset = result["get"].count() > 0 ? result["get"].as<std::string>() : "";
+		args.iterations = std::max(1u, result["iterations"].as<uint32_t>());
+		return true;
+	}
+	if (result["get"].count() > 0)
+	{
+		if (result["extract"].count() > 0)
+		{
+			args.outFilename = result["extract"].as<std::filesystem::path>();
+		}
+		args.mode = Arguments::Mode::Get;
+		args.filenames = result["pack-files"].as<std::vector<std::filesystem::path>>();
+		args.asset = result["get"].as<std::string>();
+		return true;
+	}
+	if (result["bake"].count() > 0)
+	{
+		args.mode = Arguments::Mode::Bake;
+		args.filenames = result["pack-files"].as<std::vector<std::filesystem::path>>();
+		args.outFilename = result["bake"].as<std::filesystem::path>();
+		return true;
+	}
 	if (result["sound"].count() > 0)
 	{
 		if (result["extract"].count() > 0)
@@ -695,11 +943,21 @@ int main(int argc, char* argv[]) noexcept
 		return WriteAnimationFile(args.outFilename);
 	}
 
+	if (args.mode == Arguments::Mode::Benchmark)
+	{
+		for (auto& filename : args.filenames)
+		{
+			std::printf("file: %s\n", filename.generic_string().c_str());
+			returnCode |= Benchmark(filename, args.asset, args.iterations);
+		}
+		return returnCode;
+	}
+
 	for (auto& filename : args.filenames)
 	{
 		openblack::pack::PackFile pack;
-		// Open file
-		const auto result = pack.Open(filename);
+		// Open file, only the index is needed to get a single asset
+		const auto result = args.mode == Arguments::Mode::Get ? pack.OpenIndex(filename) : pack.Open(filename);
 		if (result != openblack::pack::PackResult::Success)
 		{
 			std::cerr << openblack::pack::ResultToStr(result) << "\n";
@@ -761,6 +1019,14 @@ int main(int argc, char* argv[]) noexcept
 			std::printf("file: %s\n", filename.generic_string().c_str());
 			returnCode |= ViewSound(pack, args.blockId, args.outFilename);
 			break;
+		case Arguments::Mode::Get:
+			std::printf("file: %s\n", filename.generic_string().c_str());
+			returnCode |= GetAsset(pack, args.asset, args.outFilename);
+			break;
+		case Arguments::Mode::Bake:
+			std::printf("file: %s\n", filename.generic_string().c_str());
+			returnCode |= BakeAssets(pack, args.outFilename);
+			break;
 		default:
 			returnCode = EXIT_FAILURE;
 			break;
@@ -1,5 +1,7 @@
-#ifdef USE_INSTANCING
+#if defined(USE_SKINNING)
 $input a_position, a_texcoord0, a_normal, a_indices, i_data0, i_data1, i_data2, i_data3, i_data4
+#elif defined(USE_INSTANCING)
+$input a_position, a_texcoord0, a_normal, a_indices, i_data0, i_data1, i_data2, i_data3
 #else
 $input a_position, a_texcoord0, a_normal, a_indices
 #endif // USE_INSTANCING
@@ -18,6 +20,27 @@ SAMPLER2D(s_heightmap, 1);
 uniform vec4 u_islandExtent;
 #endif // USE_HEIGHT_MAP
 
+#ifdef USE_SKINNING
+// See AnimationPalette.h for the layout
+SAMPLER2D(s_animationPalette, 2);
+uniform vec4 u_animationPaletteSize; // width, height, 1 / width, 1 / height
+uniform vec4 u_animationTime;        // scene time in milliseconds
+
+vec4 paletteTexel(float index)
+{
+	float y = floor(index * u_animationPaletteSize.z);
+	float x = index - y * u_animationPaletteSize.x;
+	vec2 uv = (vec2(x, y) + 0.5f) * u_animationPaletteSize.zw;
+	return texture2DLod(s_animationPalette, uv, 0.0f);
+}
+
+mat4 paletteBone(float index)
+{
+	return mtxFromRows(paletteTexel(index), paletteTexel(index + 1.0f), paletteTexel(index + 2.0f),
+	                   vec4(0.0f, 0.0f, 0.0f, 1.0f));
+}
+#endif // USE_SKINNING
+
 void main()
 {
 	// Unpack
@@ -32,7 +55,24 @@ void main()
 	uint modelIndex = uint(max(0, a_indices.x));
 #endif
 
+#ifdef USE_SKINNING
+	// i_data4: header texel, time offset, speed
+	vec4 header = paletteTexel(i_data4.x); // bone count, frame count, frame duration, duration
+	float time = mod(u_animationTime.x * i_data4.z + i_data4.y, header.w);
+	float frame0 = min(floor(time / header.z), header.y - 2.0f);
+	float frame1 = frame0 + 1.0f;
+	float bone = float(modelIndex) * 3.0f;
+	mat4 bone0 = paletteBone(i_data4.x + 1.0f + frame0 * header.x * 3.0f + bone);
+	mat4 bone1 = paletteBone(i_data4.x + 1.0f + frame1 * header.x * 3.0f + bone);
+	// The last frame is at the end of the animation, closer than a frame duration to the one before
+	float time0 = frame0 * header.z;
+	float t = (time - time0) / (min(frame1 * header.z, header.w) - time0);
+	// Interpolate matrices like L3DAnim::GetBoneMatrices does on the cpu
+	mat4 skin = bone0 * (1.0f - t) + bone1 * t;
+	v_position = mul(skin, vec4(a_position.xyz, 1.0f));
+#else
 	v_position = mul(u_model[modelIndex], vec4(a_position.xyz, 1.0f));
+#endif // USE_SKINNING
 
 #ifdef USE_INSTANCING
 	mat4 model;
@@ -0,0 +1,3 @@
+#define USE_SKINNING 1
+
+#include "vs_object_instanced.sc"
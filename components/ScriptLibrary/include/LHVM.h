@@ -15,22 +15,102 @@
 #include <filesystem>
 #include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
 #include "LHVMFile.h"
+#include "LHVMNodePool.h"
+
+// The native call callbacks are for debuggers, without them the natives are called straight from the instructions.
+// Debug builds define it.
+#if !defined(LHVM_NATIVE_CALL_CALLBACKS)
+#define LHVM_NATIVE_CALL_CALLBACKS 0
+#endif
 
 namespace openblack::lhvm
 {
 
+class JitCompiler;
+class LHVMSnapshot;
+
+enum class InterpreterCore : uint8_t
+{
+	/// Dispatches every VMInstruction through the table of opcode handlers
+	Reference,
+	/// Runs the instructions pre-decoded into handlers specialised by mode and type
+	Threaded,
+	/// Runs the scripts which run the most compiled to machine code, and the rest like Threaded. It is the default in
+	/// builds with OPENBLACK_LHVM_JIT and runs like Threaded in the others.
+	Jit,
+};
+
+/// Instruction of the program the threaded core runs, see LHVM::GetThreadedProgram
+struct ThreadedProgramInstruction
+{
+	/// Address of the first instruction it runs
+	uint32_t address;
+	/// Number of instructions it runs when it falls through to the next one, including the line markers it skips
+	uint32_t length;
+	std::string_view name;
+};
+
 class LHVM
 {
+	friend class JitCompiler;
+
 protected:
 	static constexpr const std::array<char, 4> k_Magic = {'L', 'H', 'V', 'M'};
 
+	/// Instruction pre-decoded for the threaded core. Addresses are the same as those of _instructions, so that the
+	/// tasks, the exception handlers and the saved states need no translation.
+	struct ThreadedInstruction
+	{
+		/// Index of the handler, see LHVMThreaded.h
+		uint8_t op;
+		/// Distance to the instruction which runs next when it falls through, past the line markers which follow it
+		uint8_t length;
+		/// For a pair of instructions, the distance to the second one. For a forward jump, the number of instructions
+		/// skipped at the target, which are line markers and forward jumps.
+		uint8_t offset;
+		DataType type;
+		VMValue data;
+	};
+
+	static constexpr const size_t k_TimerWheelSize = 64;
+
+	/// Ticks of the tasks of a script type. The tasks which don't run catch up with it when they are needed.
+	struct TaskClock
+	{
+		uint32_t ticks {0};
+		/// Instructions the tasks parked in a sleep loop would run each tick
+		uint32_t parkedInstructions {0};
+		/// Parked tasks by the tick they wake at, modulo the size of the wheel
+		std::array<std::vector<uint32_t>, k_TimerWheelSize> wheel;
+	};
+
+	/// Task which doesn't run, because it waits for another task or because it is parked in a sleep loop
+	struct IdleTask
+	{
+		/// Ticks of the clock when the task last caught up with it
+		uint32_t since;
+		/// Ticks of the clock when the parked task runs again
+		uint32_t wakeAt;
+		/// Length of the sleep loop the task is parked in, 0 when it waits for another task
+		uint32_t instructions;
+	};
+
 	std::vector<std::string> _variablesNames;
 	std::vector<VMInstruction> _instructions;
+	/// One per instruction, followed by one which traps running past the end
+	std::vector<ThreadedInstruction> _threadedInstructions;
+	InterpreterCore _interpreterCore {InterpreterCore::Threaded};
+	std::unique_ptr<JitCompiler> _jit;
 	std::vector<VMScript> _scripts;
+	/// Index in _scripts by name, of the first script of each name
+	std::unordered_map<std::string, uint32_t> _scriptIndices;
 	std::vector<uint32_t> _auto;
 	std::vector<char> _data;
 	VMStack _mainStack;
@@ -44,6 +124,25 @@ class LHVM
 	uint32_t _highestScriptId {0};
 	uint32_t _executedInstructions {0};
 
+	/// Tasks which run in the next tick of their type, ordered like _tasks
+	std::map<uint32_t, VMTask*> _readyTasks;
+	std::unordered_map<uint32_t, IdleTask> _idleTasks;
+	/// Tasks waiting for a task, by the id of that task
+	std::unordered_map<uint32_t, std::vector<uint32_t>> _waitingTasks;
+	/// Tasks whose task has stopped, resumed in the next tick of their type
+	std::vector<uint32_t> _unblockedTasks;
+	/// Tasks which reached their end, stopped at the end of the tick
+	std::vector<uint32_t> _endedTasks;
+	/// Tasks which yielded this tick, parked at the end of it if they sleep
+	std::vector<uint32_t> _yieldedTasks;
+	std::map<ScriptType, TaskClock> _clocks;
+
+	/// Tasks are started and stopped all the time, their nodes are reused rather than allocated every time
+	NodePool<std::map<uint32_t, VMTask>> _taskPool;
+	NodePool<std::map<uint32_t, VMTask*>> _readyTaskPool;
+	NodePool<std::unordered_map<uint32_t, IdleTask>> _idleTaskPool;
+	NodePool<std::unordered_map<uint32_t, std::vector<uint32_t>>> _waitingTaskPool;
+
 	const std::vector<NativeFunction>* _functions {nullptr};
 	std::function<void(const uint32_t func)> _nativeCallEnterCallback;
 	std::function<void(const uint32_t func)> _nativeCallExitCallback;
@@ -99,15 +198,29 @@ class LHVM
 	uint32_t StartScript(uint32_t id);
 	uint32_t StartScript(const VMScript& script);
 	const VMScript* GetScript(const std::string& name);
+	void IndexScripts();
 	bool TaskExists(uint32_t taskId);
 	uint32_t GetTicksCount();
 	void PushElaspedTime();
-	VMVar& GetVar(VMTask& task, uint32_t id);
+	VMTypedValue& GetVar(VMTask& task, uint32_t id);
 	uint32_t GetExceptionHandlersCount();
 	uint32_t GetCurrentExceptionHandlerIp(uint32_t index);
 
 	void PrintInstruction(const VMTask& task, const VMInstruction& instruction);
 	void CpuLoop(VMTask& task);
+	void CpuLoopThreaded(VMTask& task);
+	void DecodeThreadedInstructions();
+
+	void ScheduleTask(VMTask& task);
+	void UnscheduleTask(uint32_t taskNumber);
+	void RebuildSchedule();
+	void AfterRun(VMTask& task);
+	void CatchUp(VMTask& task, IdleTask& idle);
+	bool IsInSleepLoop(const VMTask& task, uint32_t& length, uint32_t& duration) const;
+	void ParkYieldedTasks();
+	void WakeTasks(ScriptType allowedScriptTypesMask);
+	/// Brings the idle tasks up to date, as if they had run every tick of their type
+	void SettleIdleTasks();
 
 	static float Fmod(float a, float b);
 
@@ -116,7 +229,7 @@ class LHVM
 
 	~LHVM();
 
-	/// Set environment
+	/// Set environment. The native call callbacks are only called in builds with LHVM_NATIVE_CALL_CALLBACKS.
 	void Initialise(
 	    const std::vector<NativeFunction>* functions, std::function<void(uint32_t func)> nativeCallEnterCallback,
 	    std::function<void(uint32_t func)> nativeCallExitCallback, std::function<void(uint32_t taskNumber)> stopTaskCallback,
@@ -151,6 +264,12 @@ class LHVM
 	/// Write SAV file to filesystem
 	int SaveState(const std::filesystem::path& filepath);
 
+	/// Copy of the runtime state, cheap enough to take between two ticks and write on another thread
+	[[nodiscard]] LHVMSnapshot TakeSnapshot();
+
+	/// Restore a snapshot of the loaded program, the state is left as it was if the snapshot is of another one
+	int RestoreSnapshot(const LHVMSnapshot& snapshot);
+
 	void LookIn(ScriptType allowedScriptTypesMask);
 
 	uint32_t StartScript(const std::string& name, ScriptType allowedScriptTypesMask);
@@ -163,14 +282,36 @@ class LHVM
 
 	void StopTasksOfType(ScriptType typesMask);
 
+	/// All the cores leave the VM in the same state, the reference one is simpler to step through
+	void SetInterpreterCore(InterpreterCore core) { _interpreterCore = core; }
+	[[nodiscard]] InterpreterCore GetInterpreterCore() const { return _interpreterCore; }
+	/// Whether the Jit core compiles the scripts in this build
+	[[nodiscard]] static bool IsJitAvailable();
+	/// Scripts of the loaded program which the Jit core has compiled so far
+	[[nodiscard]] uint32_t GetJitCompiledScriptCount() const;
+	/// Scripts of the loaded program which the Jit core failed to compile and left to the interpreter
+	[[nodiscard]] uint32_t GetJitFailedScriptCount() const;
+	/// The handlers the threaded core runs from the first address when every instruction falls through
+	[[nodiscard]] std::vector<ThreadedProgramInstruction> GetThreadedProgram() const;
+
 	[[nodiscard]] std::string GetString(uint32_t offset);
 	[[nodiscard]] const std::vector<NativeFunction>* GetFunctions() const { return _functions; };
 
 	[[nodiscard]] const std::vector<VMVar>& GetVariables() const { return _variables; }
 	[[nodiscard]] const std::vector<VMInstruction>& GetInstructions() const { return _instructions; }
 	[[nodiscard]] const std::vector<VMScript>& GetScripts() const { return _scripts; }
-	[[nodiscard]] const std::map<uint32_t, VMTask>& GetTasks() const { return _tasks; }
+	/// Tasks have the name, the source file and the variable names of their script
+	[[nodiscard]] const VMScript& GetScript(const VMTask& task) const { return _scripts.at(task.scriptId - 1); }
+	/// Idle tasks are brought up to date first, which is why it isn't const
+	[[nodiscard]] const std::map<uint32_t, VMTask>& GetTasks()
+	{
+		SettleIdleTasks();
+		return _tasks;
+	}
 	[[nodiscard]] const std::vector<char>& GetData() const { return _data; }
+	[[nodiscard]] const VMStack& GetMainStack() const { return _mainStack; }
+	[[nodiscard]] uint32_t GetTicks() const { return _ticks; }
+	[[nodiscard]] uint32_t GetExecutedInstructions() const { return _executedInstructions; }
 };
 
 } // namespace openblack::lhvm
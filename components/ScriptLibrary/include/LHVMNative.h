@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "LHVM.h"
+#include "LHVMTypes.h"
+
+namespace openblack::lhvm
+{
+
+/// How a value of a native's signature is taken from the stack and put on it, as k_StackSize values. Specialise it for
+/// the types of an API, like vectors.
+template <typename T>
+struct NativeArgument;
+
+template <>
+struct NativeArgument<float>
+{
+	static constexpr int32_t k_StackSize = 1;
+	static float Pop(LHVM& vm) { return vm.Popf(); }
+	static void Push(LHVM& vm, float value) { vm.Pushf(value); }
+};
+
+template <>
+struct NativeArgument<int32_t>
+{
+	static constexpr int32_t k_StackSize = 1;
+	static int32_t Pop(LHVM& vm) { return vm.Pop().intVal; }
+	static void Push(LHVM& vm, int32_t value) { vm.Pushi(value); }
+};
+
+/// Objects
+template <>
+struct NativeArgument<uint32_t>
+{
+	static constexpr int32_t k_StackSize = 1;
+	static uint32_t Pop(LHVM& vm) { return vm.Pop().uintVal; }
+	static void Push(LHVM& vm, uint32_t value) { vm.Pusho(value); }
+};
+
+template <>
+struct NativeArgument<bool>
+{
+	static constexpr int32_t k_StackSize = 1;
+	static bool Pop(LHVM& vm) { return vm.Pop().intVal != 0; }
+	static void Push(LHVM& vm, bool value) { vm.Pushb(value); }
+};
+
+template <auto Function>
+struct Native;
+
+/// Calls a function with its arguments popped from the stack, the last one first, and pushes what it returns
+template <typename Result, typename... Args, Result (*Function)(Args...)>
+struct Native<Function>
+{
+	using Arguments = std::tuple<std::remove_cvref_t<Args>...>;
+
+	static constexpr int32_t k_StackIn = (0 + ... + NativeArgument<std::remove_cvref_t<Args>>::k_StackSize);
+	static constexpr int32_t k_StackOut = [] {
+		if constexpr (std::is_void_v<Result>)
+		{
+			return 0;
+		}
+		else
+		{
+			return NativeArgument<Result>::k_StackSize;
+		}
+	}();
+
+	static void Call(LHVM& vm)
+	{
+		auto arguments = PopArguments(vm, std::index_sequence_for<Args...>());
+		if constexpr (std::is_void_v<Result>)
+		{
+			std::apply(Function, std::move(arguments));
+		}
+		else
+		{
+			NativeArgument<Result>::Push(vm, std::apply(Function, std::move(arguments)));
+		}
+	}
+
+private:
+	template <size_t... I>
+	static Arguments PopArguments(LHVM& vm, std::index_sequence<I...> /*unused*/)
+	{
+		Arguments arguments;
+		((std::get<sizeof...(I) - 1 - I>(arguments) =
+		      NativeArgument<std::tuple_element_t<sizeof...(I) - 1 - I, Arguments>>::Pop(vm)),
+		 ...);
+		return arguments;
+	}
+};
+
+/// Binds a function with typed arguments and result, taking as many values from the stack as they span
+template <auto Function>
+NativeFunction MakeNative(std::string name)
+{
+	return {&Native<Function>::Call, Native<Function>::k_StackIn, Native<Function>::k_StackOut, std::move(name)};
+}
+
+} // namespace openblack::lhvm
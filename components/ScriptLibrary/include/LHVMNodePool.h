@@ -0,0 +1,59 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+namespace openblack::lhvm
+{
+
+/// Free-list of the nodes of the elements erased from a node based map, which the elements emplaced after reuse. Once
+/// the map has been as large as it gets, it no longer allocates.
+template <typename Map>
+class NodePool
+{
+public:
+	/// The value of a reused node is left as it was for the caller to overwrite, with the capacity of its members
+	typename Map::mapped_type& Emplace(Map& map, const typename Map::key_type& key)
+	{
+		if (_nodes.empty())
+		{
+			return map.try_emplace(key).first->second;
+		}
+
+		auto node = std::move(_nodes.back());
+		_nodes.pop_back();
+		node.key() = key;
+		auto result = map.insert(std::move(node));
+		if (!result.inserted)
+		{
+			_nodes.emplace_back(std::move(result.node));
+		}
+		return result.position->second;
+	}
+
+	void Erase(Map& map, typename Map::iterator position) { _nodes.emplace_back(map.extract(position)); }
+
+	void Erase(Map& map, const typename Map::key_type& key)
+	{
+		if (auto node = map.extract(key); !node.empty())
+		{
+			_nodes.emplace_back(std::move(node));
+		}
+	}
+
+	void Clear() { _nodes.clear(); }
+
+private:
+	std::vector<typename Map::node_type> _nodes;
+};
+
+} // namespace openblack::lhvm
@@ -0,0 +1,122 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace openblack::lhvm
+{
+
+/// Runtime state of a LHVM, without the program it runs, in flat arrays. Taking one copies the state in a single pass,
+/// after which the snapshot can be encoded and written on another thread while the VM carries on. See LHVM::TakeSnapshot
+/// and LHVM::RestoreSnapshot.
+class LHVMSnapshot
+{
+	friend class LHVM;
+
+public:
+	static constexpr std::array<char, 4> k_Magic = {'L', 'H', 'V', 'S'};
+	/// Snapshots of other versions are rejected
+	static constexpr uint32_t k_Version = 1;
+
+	/// Encode the snapshot, compressed with a fast LZ77 coder when asked
+	[[nodiscard]] std::vector<uint8_t> Encode(bool compress) const;
+
+	/// Decode an encoded snapshot, which is checked to be consistent
+	int Decode(const std::vector<uint8_t>& buffer);
+
+	/// Write the encoded snapshot to the filesystem
+	int Write(const std::filesystem::path& filepath, bool compress) const;
+
+	/// Read an encoded snapshot from the filesystem
+	int Read(const std::filesystem::path& filepath);
+
+	/// Encode and write a snapshot on another thread
+	static std::future<int> WriteAsync(LHVMSnapshot snapshot, std::filesystem::path filepath, bool compress);
+
+	[[nodiscard]] uint32_t GetTicks() const { return _ticks; }
+	[[nodiscard]] size_t GetTaskCount() const { return _tasks.size(); }
+
+private:
+	enum Flags : uint32_t
+	{
+		Compressed = 1 << 0,
+	};
+
+	struct Stack
+	{
+		uint32_t count;
+		uint32_t pushCount;
+		uint32_t popCount;
+	};
+
+	enum TaskFlags : uint8_t
+	{
+		InExceptionHandler = 1 << 0,
+		Stop = 1 << 1,
+		Yield = 1 << 2,
+		Sleeping = 1 << 3,
+	};
+
+	/// The variables, handlers and stack values of the tasks follow each other in the arrays of the snapshot
+	struct Task
+	{
+		uint32_t id;
+		uint32_t scriptId;
+		/// Index in _strings, checked against the program the snapshot is restored into
+		uint32_t scriptName;
+		uint32_t instructionAddress;
+		uint32_t pevInstructionAddress;
+		uint32_t waitingTaskId;
+		uint32_t variablesOffset;
+		uint32_t currentExceptionHandlerIndex;
+		uint32_t ticks;
+		uint32_t type;
+		uint32_t localCount;
+		uint32_t exceptionHandlerCount;
+		Stack stack;
+		uint8_t flags;
+		std::array<uint8_t, 3> padding;
+	};
+	static_assert(std::is_trivially_copyable_v<Task> && sizeof(Task) == 64);
+
+	/// Of the program the snapshot was taken of
+	uint32_t _instructionCount {0};
+	uint32_t _scriptCount {0};
+
+	uint32_t _ticks {0};
+	uint32_t _currentLineNumber {0};
+	uint32_t _highestTaskId {0};
+	uint32_t _highestScriptId {0};
+	uint32_t _executedInstructions {0};
+
+	/// Names of the global variables and of the scripts of the tasks, each one once
+	std::vector<std::string> _strings;
+	std::vector<uint32_t> _globalNames;
+	std::vector<uint8_t> _globalTypes;
+	std::vector<uint32_t> _globalValues;
+	Stack _mainStack {};
+	std::vector<Task> _tasks;
+	std::vector<uint8_t> _localTypes;
+	std::vector<uint32_t> _localValues;
+	std::vector<uint32_t> _exceptionHandlerIps;
+	/// The main stack, then the stack of each task
+	std::vector<uint8_t> _stackTypes;
+	std::vector<uint32_t> _stackValues;
+};
+
+} // namespace openblack::lhvm
@@ -13,7 +13,6 @@
 #include <cstdint>
 
 #include <array>
-#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -21,6 +20,8 @@
 namespace openblack::lhvm
 {
 
+class LHVM;
+
 enum class LHVMVersion : uint32_t
 {
 	BlackAndWhite = 7,
@@ -78,18 +79,22 @@ struct VMValue
 };
 static_assert(sizeof(VMValue) == 4);
 
-class VMVar
+/// Value of a variable. The local variables of a task are only these, their names are those of the script.
+struct VMTypedValue
+{
+	DataType type {DataType::Float};
+	VMValue value {0.0f};
+};
+
+class VMVar: public VMTypedValue
 {
 public:
 	VMVar(DataType type, VMValue value, std::string name)
-	    : type(type)
-	    , value(value)
+	    : VMTypedValue {type, value}
 	    , name(std::move(name))
 	{
 	}
 
-	DataType type;
-	VMValue value;
 	std::string name;
 };
 
@@ -267,21 +272,19 @@ class VMTask
 public:
 	VMTask() = default;
 
-	VMTask(std::vector<VMVar> localVars, uint32_t scriptId, uint32_t id, uint32_t instructionAddress, uint32_t variablesOffset,
-	       VMStack stack, std::string name, std::string filename, ScriptType type)
+	VMTask(std::vector<VMTypedValue> localVars, uint32_t scriptId, uint32_t id, uint32_t instructionAddress,
+	       uint32_t variablesOffset, const VMStack& stack, ScriptType type)
 	    : localVars(std::move(localVars))
 	    , scriptId(scriptId)
 	    , id(id)
 	    , instructionAddress(instructionAddress)
 	    , variablesOffset(variablesOffset)
 	    , stack(stack)
-	    , name(std::move(name))
-	    , filename(std::move(filename))
 	    , type(type)
 	{
 	}
 
-	std::vector<VMVar> localVars;
+	std::vector<VMTypedValue> localVars;
 	uint32_t scriptId {0};
 	uint32_t id {0};
 	uint32_t instructionAddress {0};
@@ -296,23 +299,24 @@ class VMTask
 	bool stop {false};
 	bool iield {false};
 	bool sleeping {false};
-	std::string name;
-	std::string filename;
 	ScriptType type {ScriptType::Script};
 };
 
 class NativeFunction
 {
 public:
-	NativeFunction(std::function<void()> impl, int32_t stackIn, int32_t stackOut, std::string name)
-	    : impl(std::move(impl))
+	/// Natives take their arguments from the stack of the VM which calls them, see LHVMNative.h for typed ones
+	using Function = void (*)(LHVM& vm);
+
+	NativeFunction(Function impl, int32_t stackIn, int32_t stackOut, std::string name)
+	    : impl(impl)
 	    , stackIn(stackIn)
 	    , stackOut(stackOut)
 	    , name(std::move(name))
 	{
 	}
 
-	std::function<void()> impl;
+	Function impl;
 	int32_t stackIn;
 	uint32_t stackOut;
 	std::string name;
@@ -16,8 +16,12 @@
 
 #include <fstream>
 #include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 
 #include "LHVMFile.h"
+#include "LHVMJit.h"
+#include "LHVMSnapshot.h"
 
 namespace openblack::lhvm
 {
@@ -97,10 +101,31 @@ LHVM::LHVM()
 	_opcodesImpl[28] = &LHVM::Opcode28BrkExcept;
 	_opcodesImpl[29] = &LHVM::Opcode29Swap;
 	_opcodesImpl[30] = &LHVM::Opcode30Line;
+
+	DecodeThreadedInstructions();
+	_jit = std::make_unique<JitCompiler>(*this);
+#if LHVM_JIT
+	_interpreterCore = InterpreterCore::Jit;
+#endif
 }
 
 LHVM::~LHVM() = default;
 
+bool LHVM::IsJitAvailable()
+{
+	return LHVM_JIT != 0;
+}
+
+uint32_t LHVM::GetJitCompiledScriptCount() const
+{
+	return _jit->GetCompiledScriptCount();
+}
+
+uint32_t LHVM::GetJitFailedScriptCount() const
+{
+	return _jit->GetFailedScriptCount();
+}
+
 void LHVM::Initialise(const std::vector<NativeFunction>* functions, std::function<void(uint32_t func)> nativeCallEnterCallback,
                       std::function<void(uint32_t func)> nativeCallExitCallback,
                       std::function<void(uint32_t taskNumber)> stopTaskCallback,
@@ -141,7 +166,10 @@ int LHVM::LoadBinary(const LHVMFile& file)
 	StopAllTasks();
 
 	_instructions = file.GetInstructions();
+	DecodeThreadedInstructions();
+	_jit->Reset();
 	_scripts = file.GetScripts();
+	IndexScripts();
 	_data = file.GetData();
 	_mainStack.count = 0;
 	_mainStack.pushCount = 0;
@@ -158,6 +186,7 @@ int LHVM::LoadBinary(const LHVMFile& file)
 	}
 
 	_tasks.clear();
+	RebuildSchedule();
 	_ticks = 0;
 	_currentLineNumber = 0;
 	_highestTaskId = 0;
@@ -193,7 +222,10 @@ int LHVM::RestoreState(const std::filesystem::path& filepath)
 	StopAllTasks();
 
 	_instructions = file.GetInstructions();
+	DecodeThreadedInstructions();
+	_jit->Reset();
 	_scripts = file.GetScripts();
+	IndexScripts();
 	_data = file.GetData();
 	_mainStack = file.GetStack();
 	_currentStack = &_mainStack;
@@ -207,6 +239,7 @@ int LHVM::RestoreState(const std::filesystem::path& filepath)
 	{
 		_tasks.emplace(task.id, task);
 	}
+	RebuildSchedule();
 
 	_ticks = file.GetTicks();
 	_currentLineNumber = file.GetCurrentLineNumber();
@@ -286,11 +319,19 @@ void LHVM::Pushb(bool value)
 void LHVM::Reboot()
 {
 	StopAllTasks();
+	RebuildSchedule();
+	_taskPool.Clear();
+	_readyTaskPool.Clear();
+	_idleTaskPool.Clear();
+	_waitingTaskPool.Clear();
 	_variables.clear();
 	_variablesNames.clear();
 	_scripts.clear();
+	_scriptIndices.clear();
 	_auto.clear();
 	_instructions.clear();
+	DecodeThreadedInstructions();
+	_jit->Reset();
 	_data.clear();
 
 	_ticks = 0;
@@ -315,6 +356,8 @@ int LHVM::SaveBinary(const std::filesystem::path& filepath)
 
 int LHVM::SaveState(const std::filesystem::path& filepath)
 {
+	SettleIdleTasks();
+
 	std::vector<VMTask> tasks;
 	tasks.reserve(_tasks.size());
 	for (const auto& [id, task] : _tasks)
@@ -328,71 +371,174 @@ int LHVM::SaveState(const std::filesystem::path& filepath)
 	return EXIT_SUCCESS;
 }
 
-void LHVM::LookIn(const ScriptType allowedScriptTypesMask)
+LHVMSnapshot LHVM::TakeSnapshot()
 {
-	// execute exception handlers first
-	for (auto& [id, task] : _tasks)
-	{
-		if (task.type & allowedScriptTypesMask)
+	SettleIdleTasks();
+
+	LHVMSnapshot snapshot;
+	snapshot._instructionCount = static_cast<uint32_t>(_instructions.size());
+	snapshot._scriptCount = static_cast<uint32_t>(_scripts.size());
+	snapshot._ticks = _ticks;
+	snapshot._currentLineNumber = _currentLineNumber;
+	snapshot._highestTaskId = _highestTaskId;
+	snapshot._highestScriptId = _highestScriptId;
+	snapshot._executedInstructions = _executedInstructions;
+
+	// Each name is stored once, most tasks run the same few scripts
+	std::unordered_map<std::string_view, uint32_t> stringIndices;
+	const auto stringIndex = [&snapshot, &stringIndices](const std::string& string) {
+		const auto [position, inserted] = stringIndices.try_emplace(string, static_cast<uint32_t>(snapshot._strings.size()));
+		if (inserted)
 		{
-			_currentStack = &task.stack;
-			if (task.inExceptionHandler)
-			{
-				CpuLoop(task);
-			}
-			else if (task.waitingTaskId == 0)
-			{
-				task.currentExceptionHandlerIndex = 0;
-				if (GetExceptionHandlersCount() > 0)
-				{
-					task.pevInstructionAddress = task.instructionAddress;
-					task.instructionAddress = GetCurrentExceptionHandlerIp(task.currentExceptionHandlerIndex);
-					task.inExceptionHandler = true;
-					CpuLoop(task);
-				}
-			}
+			snapshot._strings.emplace_back(string);
+		}
+		return position->second;
+	};
+	const auto copyStack = [&snapshot](const VMStack& stack) {
+		for (uint32_t i = 0; i < stack.count; ++i)
+		{
+			snapshot._stackTypes.push_back(static_cast<uint8_t>(stack.types[i]));
+			snapshot._stackValues.push_back(stack.values[i].uintVal);
 		}
+		return LHVMSnapshot::Stack {stack.count, stack.pushCount, stack.popCount};
+	};
+
+	snapshot._globalNames.reserve(_variables.size());
+	snapshot._globalTypes.reserve(_variables.size());
+	snapshot._globalValues.reserve(_variables.size());
+	for (const auto& var : _variables)
+	{
+		snapshot._globalNames.push_back(stringIndex(var.name));
+		snapshot._globalTypes.push_back(static_cast<uint8_t>(var.type));
+		snapshot._globalValues.push_back(var.value.uintVal);
 	}
+	snapshot._mainStack = copyStack(_mainStack);
 
-	// execute normal code
-	for (auto& [id, task] : _tasks)
+	snapshot._tasks.reserve(_tasks.size());
+	for (const auto& [id, task] : _tasks)
 	{
-		if (task.type & allowedScriptTypesMask)
+		for (const auto& var : task.localVars)
 		{
-			_currentStack = &task.stack;
-			if (!task.inExceptionHandler)
-			{
-				CpuLoop(task);
-			}
+			snapshot._localTypes.push_back(static_cast<uint8_t>(var.type));
+			snapshot._localValues.push_back(var.value.uintVal);
 		}
+		snapshot._exceptionHandlerIps.insert(snapshot._exceptionHandlerIps.end(), task.exceptionHandlerIps.begin(),
+		                                     task.exceptionHandlerIps.end());
+		const uint8_t flags = (task.inExceptionHandler ? LHVMSnapshot::InExceptionHandler : 0) |
+		                      (task.stop ? LHVMSnapshot::Stop : 0) | (task.iield ? LHVMSnapshot::Yield : 0) |
+		                      (task.sleeping ? LHVMSnapshot::Sleeping : 0);
+		snapshot._tasks.push_back({
+		    task.id,
+		    task.scriptId,
+		    stringIndex(GetScript(task).name),
+		    task.instructionAddress,
+		    task.pevInstructionAddress,
+		    task.waitingTaskId,
+		    task.variablesOffset,
+		    task.currentExceptionHandlerIndex,
+		    task.ticks,
+		    static_cast<uint32_t>(task.type),
+		    static_cast<uint32_t>(task.localVars.size()),
+		    static_cast<uint32_t>(task.exceptionHandlerIps.size()),
+		    copyStack(task.stack),
+		    flags,
+		    {},
+		});
+	}
+
+	return snapshot;
+}
+
+int LHVM::RestoreSnapshot(const LHVMSnapshot& snapshot)
+{
+	// Snapshots only hold the state, which only fits the program they were taken of
+	if (snapshot._instructionCount != _instructions.size() || snapshot._scriptCount != _scripts.size() ||
+	    snapshot._globalNames.size() != _variables.size())
+	{
+		return EXIT_FAILURE;
 	}
-
-	// handle tasks termination
-	for (auto iter = _tasks.begin(); iter != _tasks.end();)
+	for (size_t i = 0; i < _variables.size(); ++i)
 	{
-		auto& task = (*iter++).second;
-		if (task.stop)
+		if (snapshot._strings[snapshot._globalNames[i]] != _variables[i].name)
 		{
-			StopTask(task.id);
+			return EXIT_FAILURE;
 		}
 	}
-
-	// unlock waiting tasks
-	for (auto& [id, task] : _tasks)
+	uint32_t previousId = 0;
+	for (const auto& task : snapshot._tasks)
 	{
-		if (task.type & allowedScriptTypesMask)
+		if (task.id <= previousId || task.scriptId == 0 || task.scriptId > _scripts.size() ||
+		    snapshot._strings[task.scriptName] != _scripts[task.scriptId - 1].name)
 		{
-			task.ticks++;
-			if (task.waitingTaskId != 0 && !TaskExists(task.waitingTaskId))
-			{
-				task.waitingTaskId = 0;
-				task.instructionAddress++;
-			}
+			return EXIT_FAILURE;
 		}
+		previousId = task.id;
 	}
 
-	_ticks++;
+	StopAllTasks();
+
+	const auto* stackType = snapshot._stackTypes.data();
+	const auto* stackValue = snapshot._stackValues.data();
+	const auto restoreStack = [&stackType, &stackValue](const LHVMSnapshot::Stack& from, VMStack& stack) {
+		stack = VMStack();
+		stack.count = from.count;
+		stack.pushCount = from.pushCount;
+		stack.popCount = from.popCount;
+		for (uint32_t i = 0; i < from.count; ++i)
+		{
+			stack.types[i] = static_cast<DataType>(*stackType++);
+			stack.values[i].uintVal = *stackValue++;
+		}
+	};
+
+	for (size_t i = 0; i < _variables.size(); ++i)
+	{
+		_variables[i].type = static_cast<DataType>(snapshot._globalTypes[i]);
+		_variables[i].value.uintVal = snapshot._globalValues[i];
+	}
+	restoreStack(snapshot._mainStack, _mainStack);
 	_currentStack = &_mainStack;
+	_currentTask = nullptr;
+
+	// Stopped tasks lend their nodes and the capacity of their vectors
+	const auto* localType = snapshot._localTypes.data();
+	const auto* localValue = snapshot._localValues.data();
+	const auto* exceptionHandlerIp = snapshot._exceptionHandlerIps.data();
+	for (const auto& from : snapshot._tasks)
+	{
+		auto& task = _taskPool.Emplace(_tasks, from.id);
+		task.localVars.resize(from.localCount);
+		for (auto& var : task.localVars)
+		{
+			var.type = static_cast<DataType>(*localType++);
+			var.value.uintVal = *localValue++;
+		}
+		task.exceptionHandlerIps.assign(exceptionHandlerIp, exceptionHandlerIp + from.exceptionHandlerCount);
+		exceptionHandlerIp += from.exceptionHandlerCount;
+		task.scriptId = from.scriptId;
+		task.id = from.id;
+		task.instructionAddress = from.instructionAddress;
+		task.pevInstructionAddress = from.pevInstructionAddress;
+		task.waitingTaskId = from.waitingTaskId;
+		task.variablesOffset = from.variablesOffset;
+		task.currentExceptionHandlerIndex = from.currentExceptionHandlerIndex;
+		task.ticks = from.ticks;
+		task.type = static_cast<ScriptType>(from.type);
+		task.inExceptionHandler = (from.flags & LHVMSnapshot::InExceptionHandler) != 0;
+		task.stop = (from.flags & LHVMSnapshot::Stop) != 0;
+		task.iield = (from.flags & LHVMSnapshot::Yield) != 0;
+		task.sleeping = (from.flags & LHVMSnapshot::Sleeping) != 0;
+		restoreStack(from.stack, task.stack);
+	}
+	RebuildSchedule();
+
+	_ticks = snapshot._ticks;
+	_currentLineNumber = snapshot._currentLineNumber;
+	_highestTaskId = snapshot._highestTaskId;
+	_highestScriptId = snapshot._highestScriptId;
+	_executedInstructions = snapshot._executedInstructions;
+
+	return EXIT_SUCCESS;
 }
 
 uint32_t LHVM::StartScript(const std::string& name, const ScriptType allowedScriptTypesMask)
@@ -443,19 +589,19 @@ uint32_t LHVM::StartScript(const VMScript& script)
 		}
 	}
 
-	// allocate local variables with default values
-	const auto& scriptVariables = script.variables;
-	std::vector<VMVar> taskVariables;
-	taskVariables.reserve(scriptVariables.size());
-	for (const auto& name : scriptVariables)
-	{
-		taskVariables.emplace_back(DataType::Float, VMValue(0.0f), name);
-	}
+	// a stopped task lends its node, and the vectors of its variables and handlers keep their capacity
+	auto& task = _taskPool.Emplace(_tasks, taskNumber);
+	auto taskVariables = std::move(task.localVars);
+	auto exceptionHandlerIps = std::move(task.exceptionHandlerIps);
 
-	const auto& task = VMTask(taskVariables, script.scriptId, taskNumber, script.instructionAddress, script.variablesOffset,
-	                          stack, script.name, script.filename, script.type);
+	// allocate local variables with default values
+	taskVariables.assign(script.variables.size(), VMTypedValue {DataType::Float, VMValue(0.0f)});
+	exceptionHandlerIps.clear();
 
-	_tasks.emplace(taskNumber, task);
+	task = VMTask(std::move(taskVariables), script.scriptId, taskNumber, script.instructionAddress, script.variablesOffset,
+	              stack, script.type);
+	task.exceptionHandlerIps = std::move(exceptionHandlerIps);
+	ScheduleTask(task);
 
 	return taskNumber;
 }
@@ -474,7 +620,8 @@ void LHVM::StopScripts(std::function<bool(const std::string& name, const std::st
 	std::vector<uint32_t> ids;
 	for (const auto& [id, task] : _tasks)
 	{
-		if (filter(task.name, task.filename))
+		const auto& script = GetScript(task);
+		if (filter(script.name, script.filename))
 		{
 			ids.emplace_back(id);
 		}
@@ -505,7 +652,8 @@ void LHVM::StopTask(uint32_t taskNumber)
 			_currentStack = &_mainStack;
 		}
 
-		_tasks.erase(taskNumber);
+		UnscheduleTask(taskNumber);
+		_taskPool.Erase(_tasks, taskNumber);
 	}
 	else
 	{
@@ -605,14 +753,18 @@ void LHVM::SignalError(const ErrorCode code, const std::string& data)
 
 const VMScript* LHVM::GetScript(const std::string& name)
 {
-	for (const auto& script : _scripts)
+	const auto index = _scriptIndices.find(name);
+	return index != _scriptIndices.end() ? &_scripts[index->second] : nullptr;
+}
+
+void LHVM::IndexScripts()
+{
+	_scriptIndices.clear();
+	_scriptIndices.reserve(_scripts.size());
+	for (uint32_t i = 0; i < _scripts.size(); ++i)
 	{
-		if (script.name == name)
-		{
-			return &script;
-		}
+		_scriptIndices.emplace(_scripts[i].name, i);
 	}
-	return nullptr;
 }
 
 bool LHVM::TaskExists(const uint32_t taskId)
@@ -631,7 +783,7 @@ void LHVM::PushElaspedTime()
 	Pushf(time);
 }
 
-VMVar& LHVM::GetVar(VMTask& task, const uint32_t id)
+VMTypedValue& LHVM::GetVar(VMTask& task, const uint32_t id)
 {
 	const auto offset = task.variablesOffset;
 	return (id > offset) ? task.localVars.at(id - offset - 1) : _variables.at(id);
@@ -684,7 +836,7 @@ void LHVM::PrintInstruction(const VMTask& task, const VMInstruction& instruction
 		{
 			if (instruction.data.intVal > task.variablesOffset)
 			{
-				arg = task.localVars[instruction.data.intVal - task.variablesOffset - 1].name;
+				arg = GetScript(task).variables.at(instruction.data.intVal - task.variablesOffset - 1);
 			}
 			else
 			{
@@ -712,12 +864,23 @@ void LHVM::PrintInstruction(const VMTask& task, const VMInstruction& instruction
 			arg += val ? " [true] -> continue" : " [false] -> JUMP";
 		}
 	}
-	printf("%s:%d %s[%d] %s %s\n", task.filename.c_str(), instruction.line, task.name.c_str(), task.id, opcode.c_str(),
+	const auto& script = GetScript(task);
+	printf("%s:%d %s[%d] %s %s\n", script.filename.c_str(), instruction.line, script.name.c_str(), task.id, opcode.c_str(),
 	       arg.c_str());
 }
 
 void LHVM::CpuLoop(VMTask& task)
 {
+	if (_interpreterCore == InterpreterCore::Jit && _jit->Run(task))
+	{
+		return;
+	}
+	if (_interpreterCore != InterpreterCore::Reference)
+	{
+		CpuLoopThreaded(task);
+		return;
+	}
+
 	const auto wasExceptionHandler = task.inExceptionHandler;
 	task.iield = false;
 	while (task.waitingTaskId == 0)
@@ -856,9 +1019,13 @@ void LHVM::Opcode05Sys(VMTask& /*task*/, const VMInstruction& instruction)
 		{
 			_currentStack->pushCount = 0;
 			_currentStack->popCount = 0;
+#if LHVM_NATIVE_CALL_CALLBACKS
 			InvokeNativeCallEnterCallback(id);
-			func.impl();
+#endif
+			func.impl(*this);
+#if LHVM_NATIVE_CALL_CALLBACKS
 			InvokeNativeCallExitCallback(id);
+#endif
 		}
 		else // if impl not provided, then just adjust the stack
 		{
@@ -0,0 +1,1112 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "LHVMJit.h"
+
+#include <cstddef>
+#include <cstring>
+
+#include <algorithm>
+#include <map>
+#include <type_traits>
+#include <utility>
+
+#if LHVM_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "LHVM.h"
+#include "LHVMThreaded.h"
+
+// The blocks keep the frame in rbx, the task in r12, the current stack in r13, the count of executed instructions in
+// r14 and the table of the blocks in r15. All of them are callee-saved, so the helpers leave them alone, except for the
+// current stack which the natives can change and which is loaded again after every call. The count of the stack is
+// kept in r8, and what is popped, pushed and run is added up in r9, r10 and r11. They are written to the VM before
+// every call and when the run is over, like the threaded core does with the count of executed instructions.
+
+namespace openblack::lhvm
+{
+
+#if LHVM_JIT
+
+struct JitCompiler::Frame
+{
+	LHVM* vm;
+	VMTask* task;
+	VMStack** currentStack;
+	uint32_t* executed;
+	const uint8_t* const* blocks;
+	VMTypedValue* locals;
+	VMVar* globals;
+	uint32_t localsCount;
+	uint32_t globalsCount;
+	bool wasExceptionHandler;
+};
+
+struct JitCompiler::CompiledScript
+{
+	using Entry = uint32_t (*)(Frame* frame, const uint8_t* block);
+
+	CompiledScript(void* memory, size_t size)
+	    : memory(memory)
+	    , size(size)
+	{
+	}
+
+	CompiledScript(const CompiledScript&) = delete;
+	CompiledScript& operator=(const CompiledScript&) = delete;
+
+	~CompiledScript() { munmap(memory, size); }
+
+	void* memory;
+	size_t size;
+	Entry entry {nullptr};
+	uint32_t start {0};
+	uint32_t end {0};
+	uint32_t variablesOffset {0};
+	/// Block of each instruction of the script
+	std::vector<const uint8_t*> blocks;
+};
+
+namespace
+{
+static_assert(std::is_standard_layout_v<VMTask> && std::is_standard_layout_v<VMStack>);
+static_assert(sizeof(VMValue) == 4 && sizeof(DataType) == 4 && sizeof(bool) == 1);
+
+enum Reg : uint8_t
+{
+	Rax,
+	Rcx,
+	Rdx,
+	Rbx,
+	Rsp,
+	Rbp,
+	Rsi,
+	Rdi,
+	R8,
+	R9,
+	R10,
+	R11,
+	R12,
+	R13,
+	R14,
+	R15,
+	NoIndex = 0xFF,
+};
+
+enum Xmm : uint8_t
+{
+	Xmm0,
+	Xmm1,
+	Xmm2,
+};
+
+enum class Condition : uint8_t
+{
+	Below = 0x2,
+	AboveEqual = 0x3,
+	Equal = 0x4,
+	NotEqual = 0x5,
+	BelowEqual = 0x6,
+	Above = 0x7,
+	Parity = 0xA,
+	NoParity = 0xB,
+	Less = 0xC,
+	GreaterEqual = 0xD,
+	LessEqual = 0xE,
+	Greater = 0xF,
+};
+
+/// [base + index * 2^scale + disp]
+struct Mem
+{
+	uint8_t base;
+	int32_t disp {0};
+	uint8_t index {NoIndex};
+	uint8_t scale {0};
+};
+
+/// Encoder of the few x86-64 instructions the blocks are made of, with jumps to labels which are bound later
+class Assembler
+{
+public:
+	using Label = uint32_t;
+
+	Label NewLabel()
+	{
+		_labels.push_back(-1);
+		return static_cast<Label>(_labels.size() - 1);
+	}
+
+	void Bind(Label label) { _labels[label] = static_cast<int64_t>(_code.size()); }
+
+	[[nodiscard]] size_t Offset(Label label) const { return static_cast<size_t>(_labels[label]); }
+
+	/// The code with the jumps resolved, all labels have to be bound
+	std::vector<uint8_t> Finish()
+	{
+		for (const auto& [position, label] : _fixups)
+		{
+			const auto relative = static_cast<int32_t>(_labels[label] - static_cast<int64_t>(position + 4));
+			std::memcpy(_code.data() + position, &relative, sizeof(relative));
+		}
+		_fixups.clear();
+		return std::move(_code);
+	}
+
+	void Load32(uint8_t dst, const Mem& mem) { Op(0x8B, dst, mem); }
+	void Load64(uint8_t dst, const Mem& mem) { Op(0x8B, dst, mem, true); }
+	void Store32(const Mem& mem, uint8_t src) { Op(0x89, src, mem); }
+
+	void Store32(const Mem& mem, uint32_t imm)
+	{
+		Op(0xC7, 0, mem);
+		Imm32(imm);
+	}
+
+	void Store8(const Mem& mem, uint8_t imm)
+	{
+		Op(0xC6, 0, mem);
+		Byte(imm);
+	}
+
+	void Add32(const Mem& mem, int32_t imm) { OpImm(0, mem, imm); }
+	void Cmp32(const Mem& mem, int32_t imm) { OpImm(7, mem, imm); }
+	void Xor32(const Mem& mem, int32_t imm) { OpImm(6, mem, imm); }
+	void Neg32(const Mem& mem) { Op(0xF7, 3, mem); }
+
+	void Add32(const Mem& mem, uint8_t src) { Op(0x01, src, mem); }
+	void Add32(uint8_t reg, int32_t imm) { OpImm(0, reg, imm); }
+	void Cmp32(uint8_t reg, int32_t imm) { OpImm(7, reg, imm); }
+	void Sub32(uint8_t reg, int32_t imm) { OpImm(5, reg, imm); }
+
+	void Mov32(uint8_t dst, uint32_t imm)
+	{
+		Rex(false, 0, 0, dst);
+		Byte(0xB8 + (dst & 7));
+		Imm32(imm);
+	}
+
+	void Mov64(uint8_t dst, uint64_t imm)
+	{
+		Rex(true, 0, 0, dst);
+		Byte(0xB8 + (dst & 7));
+		for (int i = 0; i < 8; ++i)
+		{
+			Byte(static_cast<uint8_t>(imm >> (i * 8)));
+		}
+	}
+
+	void Mov64(uint8_t dst, uint8_t src) { OpReg(0x89, src, dst, true); }
+	void Add32(uint8_t dst, uint8_t src) { OpReg(0x01, src, dst); }
+	void Sub32(uint8_t dst, uint8_t src) { OpReg(0x29, src, dst); }
+	void Cmp32(uint8_t a, uint8_t b) { OpReg(0x39, b, a); }
+	void Xor32(uint8_t dst, uint8_t src) { OpReg(0x31, src, dst); }
+	void Test32(uint8_t a, uint8_t b) { OpReg(0x85, b, a); }
+	void And8(uint8_t dst, uint8_t src) { OpReg(0x20, src, dst); }
+	void Or8(uint8_t dst, uint8_t src) { OpReg(0x08, src, dst); }
+
+	void Imul32(uint8_t dst, uint8_t src)
+	{
+		Rex(false, dst, 0, src);
+		Byte(0x0F);
+		Byte(0xAF);
+		ModRm(dst, src);
+	}
+
+	/// Of cl or dl, which need no prefix
+	void Set(Condition condition, uint8_t dst)
+	{
+		Byte(0x0F);
+		Byte(0x90 + static_cast<uint8_t>(condition));
+		ModRm(0, dst);
+	}
+
+	void Movzx8(uint8_t dst, uint8_t src)
+	{
+		Byte(0x0F);
+		Byte(0xB6);
+		ModRm(dst, src);
+	}
+
+	void Movss(Xmm dst, const Mem& mem) { Sse(0x10, dst, mem); }
+	void Movss(const Mem& mem, Xmm src) { Sse(0x11, src, mem); }
+	void Addss(Xmm dst, Xmm src) { Sse(0x58, dst, src); }
+	void Mulss(Xmm dst, Xmm src) { Sse(0x59, dst, src); }
+	void Subss(Xmm dst, Xmm src) { Sse(0x5C, dst, src); }
+	void Divss(Xmm dst, Xmm src) { Sse(0x5E, dst, src); }
+
+	void Ucomiss(Xmm a, Xmm b)
+	{
+		Byte(0x0F);
+		Byte(0x2E);
+		ModRm(a, b);
+	}
+
+	void Xorps(Xmm dst, Xmm src)
+	{
+		Byte(0x0F);
+		Byte(0x57);
+		ModRm(dst, src);
+	}
+
+	void Push(uint8_t reg)
+	{
+		Rex(false, 0, 0, reg);
+		Byte(0x50 + (reg & 7));
+	}
+
+	void Pop(uint8_t reg)
+	{
+		Rex(false, 0, 0, reg);
+		Byte(0x58 + (reg & 7));
+	}
+
+	void Ret() { Byte(0xC3); }
+	void Call(uint8_t reg) { OpReg(0xFF, 2, reg); }
+	void Jmp(uint8_t reg) { OpReg(0xFF, 4, reg); }
+	void Jmp(const Mem& mem) { Op(0xFF, 4, mem); }
+
+	void Jmp(Label label)
+	{
+		Byte(0xE9);
+		Fixup(label);
+	}
+
+	void J(Condition condition, Label label)
+	{
+		Byte(0x0F);
+		Byte(0x80 + static_cast<uint8_t>(condition));
+		Fixup(label);
+	}
+
+private:
+	std::vector<uint8_t> _code;
+	std::vector<int64_t> _labels;
+	std::vector<std::pair<size_t, Label>> _fixups;
+
+	void Byte(uint8_t byte) { _code.push_back(byte); }
+
+	void Imm32(uint32_t imm)
+	{
+		for (int i = 0; i < 4; ++i)
+		{
+			Byte(static_cast<uint8_t>(imm >> (i * 8)));
+		}
+	}
+
+	void Fixup(Label label)
+	{
+		_fixups.emplace_back(_code.size(), label);
+		Imm32(0);
+	}
+
+	void Rex(bool wide, uint8_t reg, uint8_t index, uint8_t base)
+	{
+		const uint8_t rex = 0x40 | (wide ? 8 : 0) | ((reg >> 1) & 4) | ((index >> 2) & 2) | ((base >> 3) & 1);
+		if (rex != 0x40)
+		{
+			Byte(rex);
+		}
+	}
+
+	void ModRm(uint8_t reg, uint8_t rm) { Byte(0xC0 | ((reg & 7) << 3) | (rm & 7)); }
+
+	void ModRm(uint8_t reg, const Mem& mem)
+	{
+		const bool hasIndex = mem.index != NoIndex;
+		const uint8_t base = mem.base & 7;
+		// rbp and r13 have no encoding without a displacement
+		const bool small = mem.disp >= -128 && mem.disp <= 127;
+		const uint8_t mod = mem.disp == 0 && base != Rbp ? 0 : (small ? 1 : 2);
+		if (hasIndex || base == Rsp)
+		{
+			Byte((mod << 6) | ((reg & 7) << 3) | 4);
+			Byte((mem.scale << 6) | ((hasIndex ? mem.index & 7 : 4) << 3) | base);
+		}
+		else
+		{
+			Byte((mod << 6) | ((reg & 7) << 3) | base);
+		}
+		if (mod == 1)
+		{
+			Byte(static_cast<uint8_t>(mem.disp));
+		}
+		else if (mod == 2)
+		{
+			Imm32(static_cast<uint32_t>(mem.disp));
+		}
+	}
+
+	void Op(uint8_t opcode, uint8_t reg, const Mem& mem, bool wide = false)
+	{
+		Rex(wide, reg, mem.index == NoIndex ? 0 : mem.index, mem.base);
+		Byte(opcode);
+		ModRm(reg, mem);
+	}
+
+	void OpReg(uint8_t opcode, uint8_t reg, uint8_t rm, bool wide = false)
+	{
+		Rex(wide, reg, 0, rm);
+		Byte(opcode);
+		ModRm(reg, rm);
+	}
+
+	void OpImm(uint8_t extension, const Mem& mem, int32_t imm)
+	{
+		const bool small = imm >= -128 && imm <= 127;
+		Op(small ? 0x83 : 0x81, extension, mem);
+		small ? Byte(static_cast<uint8_t>(imm)) : Imm32(static_cast<uint32_t>(imm));
+	}
+
+	void OpImm(uint8_t extension, uint8_t reg, int32_t imm)
+	{
+		const bool small = imm >= -128 && imm <= 127;
+		OpReg(small ? 0x83 : 0x81, extension, reg);
+		small ? Byte(static_cast<uint8_t>(imm)) : Imm32(static_cast<uint32_t>(imm));
+	}
+
+	void Sse(uint8_t opcode, uint8_t reg, const Mem& mem)
+	{
+		Byte(0xF3);
+		Rex(false, reg, mem.index == NoIndex ? 0 : mem.index, mem.base);
+		Byte(0x0F);
+		Byte(opcode);
+		ModRm(reg, mem);
+	}
+
+	void Sse(uint8_t opcode, Xmm dst, Xmm src)
+	{
+		Byte(0xF3);
+		Byte(0x0F);
+		Byte(opcode);
+		ModRm(dst, src);
+	}
+};
+
+using Label = Assembler::Label;
+
+constexpr int32_t k_LocalSize = sizeof(VMTypedValue);
+constexpr int32_t k_GlobalSize = sizeof(VMVar);
+/// Beyond this, the displacement of a variable doesn't fit in an instruction and it is left to the helpers
+constexpr uint32_t k_MaxVariables = 1u << 20;
+
+constexpr Reg k_Count = R8;
+constexpr Reg k_Pops = R9;
+constexpr Reg k_Pushes = R10;
+constexpr Reg k_Executed = R11;
+
+/// Where the value of a stack slot is, relative to the count
+Mem Value(int32_t slot)
+{
+	return {R13, static_cast<int32_t>(offsetof(VMStack, values)) + slot * 4, k_Count, 2};
+}
+
+Mem Type(int32_t slot)
+{
+	return {R13, static_cast<int32_t>(offsetof(VMStack, types)) + slot * 4, k_Count, 2};
+}
+
+Mem Stack(size_t offset)
+{
+	return {R13, static_cast<int32_t>(offset)};
+}
+
+Mem Task(size_t offset)
+{
+	return {R12, static_cast<int32_t>(offset)};
+}
+
+/// Offset of the VMTypedValue in a VMVar, which isn't standard layout
+int32_t GlobalValueOffset()
+{
+	const VMVar probe(DataType::Float, VMValue(0.0f), "");
+	return static_cast<int32_t>(reinterpret_cast<const std::byte*>(static_cast<const VMTypedValue*>(&probe)) -
+	                            reinterpret_cast<const std::byte*>(&probe));
+}
+
+} // namespace
+
+JitCompiler::JitCompiler(LHVM& vm)
+    : _vm(vm)
+{
+}
+
+JitCompiler::~JitCompiler() = default;
+
+bool JitCompiler::Run(VMTask& task)
+{
+	if (task.waitingTaskId != 0 || task.scriptId == 0 || task.scriptId > _vm._scripts.size())
+	{
+		return false;
+	}
+	if (_scripts.size() != _vm._scripts.size())
+	{
+		_scripts.resize(_vm._scripts.size());
+	}
+
+	auto& script = _scripts[task.scriptId - 1];
+	if (script.compiled == nullptr)
+	{
+		if (script.failed || ++script.runs < k_HotRuns)
+		{
+			return false;
+		}
+
+		// Scripts are laid out one after the other
+		const auto& source = _vm._scripts[task.scriptId - 1];
+		auto end = static_cast<uint32_t>(_vm._instructions.size());
+		for (const auto& other : _vm._scripts)
+		{
+			if (other.instructionAddress > source.instructionAddress)
+			{
+				end = std::min(end, other.instructionAddress);
+			}
+		}
+		script.compiled = Compile(source, end);
+		if (script.compiled == nullptr)
+		{
+			script.failed = true;
+			return false;
+		}
+	}
+
+	// Tasks run their code with the variables of their script, anything else is left to the interpreter
+	const auto& compiled = *script.compiled;
+	const auto address = task.instructionAddress;
+	if (address < compiled.start || address >= compiled.end || task.variablesOffset != compiled.variablesOffset)
+	{
+		return false;
+	}
+
+	task.iield = false;
+	_vm._currentTask = &task;
+	Frame frame {
+	    &_vm,
+	    &task,
+	    &_vm._currentStack,
+	    &_vm._executedInstructions,
+	    compiled.blocks.data(),
+	    task.localVars.data(),
+	    _vm._variables.data(),
+	    static_cast<uint32_t>(task.localVars.size()),
+	    static_cast<uint32_t>(_vm._variables.size()),
+	    task.inExceptionHandler,
+	};
+	++_running;
+	const auto status = compiled.entry(&frame, compiled.blocks[address - compiled.start]);
+	if (--_running == 0)
+	{
+		_retired.clear();
+	}
+
+	switch (status)
+	{
+	case Rethrow:
+		std::rethrow_exception(std::exchange(_exception, nullptr));
+	case Interpret:
+		_vm.CpuLoopThreaded(task);
+		break;
+	default:
+		_vm._currentTask = nullptr;
+		break;
+	}
+	return true;
+}
+
+std::unique_ptr<JitCompiler::CompiledScript> JitCompiler::Compile(const VMScript& script, uint32_t end) const
+{
+	const auto& instructions = _vm._instructions;
+	const auto start = script.instructionAddress;
+	if (start >= end || end > instructions.size())
+	{
+		return nullptr;
+	}
+	const auto count = end - start;
+	const auto offset = script.variablesOffset;
+	const auto globalValue = GlobalValueOffset();
+	const auto runInstruction = reinterpret_cast<uint64_t>(&JitCompiler::RunInstruction);
+	const auto callNative = reinterpret_cast<uint64_t>(&JitCompiler::CallNative);
+
+	Assembler a;
+	const auto exit = a.NewLabel();
+	const auto status = a.NewLabel();
+	std::vector<Label> blocks(count + 1);
+	for (auto& block : blocks)
+	{
+		block = a.NewLabel();
+	}
+	// Out of line code, emitted after the blocks
+	std::map<uint32_t, Label> exits;
+	std::vector<std::pair<Label, uint32_t>> slowPaths;
+	std::vector<std::pair<Label, uint32_t>> backwardJumps;
+
+	const auto block = [&](uint32_t address) {
+		return address - start < count ? blocks[address - start] : exits.try_emplace(address, a.NewLabel()).first->second;
+	};
+	const auto slowPath = [&](uint32_t address) {
+		slowPaths.emplace_back(a.NewLabel(), address);
+		return slowPaths.back().first;
+	};
+	const auto leave = [&](Status result) {
+		a.Mov32(Rax, result);
+		a.Jmp(exit);
+	};
+	const auto flush = [&]() {
+		a.Store32(Stack(offsetof(VMStack, count)), static_cast<uint8_t>(k_Count));
+		a.Add32(Stack(offsetof(VMStack, popCount)), k_Pops);
+		a.Add32(Stack(offsetof(VMStack, pushCount)), k_Pushes);
+		a.Add32({R14, 0}, k_Executed);
+	};
+	const auto load = [&]() {
+		a.Load64(R13, {Rbx, static_cast<int32_t>(offsetof(Frame, currentStack))});
+		a.Load64(R13, {R13, 0});
+		a.Load32(k_Count, Stack(offsetof(VMStack, count)));
+		a.Xor32(k_Pops, k_Pops);
+		a.Xor32(k_Pushes, k_Pushes);
+		a.Xor32(k_Executed, k_Executed);
+	};
+	const auto call = [&](uint64_t helper, uint32_t address) {
+		flush();
+		a.Mov64(Rdi, static_cast<uint8_t>(Rbx));
+		a.Mov32(Rsi, address);
+		a.Mov64(Rax, helper);
+		a.Call(Rax);
+		load();
+		a.Test32(Rax, Rax);
+		a.J(Condition::NotEqual, status);
+	};
+	// The instruction runs inline only when the stack holds what it pops and has room for what it pushes, the
+	// reference handler deals with the rest
+	const auto guardStack = [&](uint32_t pops, Label slow) {
+		if (pops == 0)
+		{
+			a.Cmp32(k_Count, static_cast<int32_t>(VMStack::k_Size));
+			a.J(Condition::AboveEqual, slow);
+		}
+		else
+		{
+			a.Cmp32(k_Count, static_cast<int32_t>(pops));
+			a.J(Condition::Below, slow);
+		}
+	};
+	const auto commit = [&](int32_t pops, int32_t pushes) {
+		if (pops != 0)
+		{
+			a.Add32(k_Pops, pops);
+		}
+		if (pushes != 0)
+		{
+			a.Add32(k_Pushes, pushes);
+		}
+		if (pushes != pops)
+		{
+			a.Add32(k_Count, pushes - pops);
+		}
+	};
+	// Leaves the address of the variable in rdx and returns where its type and value are from there
+	const auto variable = [&](uint32_t id, Label slow) -> std::pair<Mem, Mem> {
+		const bool local = id > offset;
+		const auto index = local ? id - offset - 1 : id;
+		if (index >= k_MaxVariables)
+		{
+			a.Jmp(slow);
+			return {{Rdx}, {Rdx}};
+		}
+		const auto countOffset = local ? offsetof(Frame, localsCount) : offsetof(Frame, globalsCount);
+		const auto dataOffset = local ? offsetof(Frame, locals) : offsetof(Frame, globals);
+		a.Cmp32({Rbx, static_cast<int32_t>(countOffset)}, static_cast<int32_t>(index));
+		a.J(Condition::BelowEqual, slow);
+		a.Load64(Rdx, {Rbx, static_cast<int32_t>(dataOffset)});
+		const auto base = local ? static_cast<int32_t>(index) * k_LocalSize
+		                        : static_cast<int32_t>(index) * k_GlobalSize + globalValue;
+		return {{Rdx, base + static_cast<int32_t>(offsetof(VMTypedValue, type))},
+		        {Rdx, base + static_cast<int32_t>(offsetof(VMTypedValue, value))}};
+	};
+	const auto pushResult = [&](uint8_t reg, DataType type, int32_t pops) {
+		a.Store32(Value(-pops), reg);
+		a.Store32(Type(-pops), static_cast<uint32_t>(type));
+		commit(pops, 1);
+	};
+	// a0 is on top of b0, the operations are a0 op b0 or b0 op a0
+	const auto floatOperation = [&](void (Assembler::*operation)(Xmm, Xmm), bool reversed) {
+		a.Movss(Xmm0, Value(-1));
+		a.Movss(Xmm1, Value(-2));
+		const auto result = reversed ? Xmm1 : Xmm0;
+		(a.*operation)(result, reversed ? Xmm0 : Xmm1);
+		a.Movss(Value(-2), result);
+		a.Store32(Type(-2), static_cast<uint32_t>(DataType::Float));
+		commit(2, 1);
+	};
+	const auto intOperation = [&](ThreadedOp op, Label slow) {
+		guardStack(2, slow);
+		a.Load32(Rcx, Value(-1));
+		a.Load32(Rdx, Value(-2));
+		switch (op)
+		{
+		case ThreadedOp::AddInt:
+			a.Add32(Rcx, Rdx);
+			break;
+		case ThreadedOp::SubInt:
+			a.Sub32(Rdx, Rcx);
+			a.Mov64(Rcx, static_cast<uint8_t>(Rdx));
+			break;
+		default:
+			a.Imul32(Rcx, Rdx);
+			break;
+		}
+		pushResult(Rcx, DataType::Int, 2);
+	};
+	// Pushes whether a0 compares to b0, b0 being on top
+	const auto floatComparison = [&](ThreadedOp op, Label slow) {
+		guardStack(2, slow);
+		a.Movss(Xmm0, Value(-2));
+		a.Movss(Xmm1, Value(-1));
+		switch (op)
+		{
+		case ThreadedOp::EqFloat:
+			a.Ucomiss(Xmm0, Xmm1);
+			a.Set(Condition::Equal, Rcx);
+			a.Set(Condition::NoParity, Rdx);
+			a.And8(Rcx, Rdx);
+			break;
+		case ThreadedOp::NeqFloat:
+			a.Ucomiss(Xmm0, Xmm1);
+			a.Set(Condition::NotEqual, Rcx);
+			a.Set(Condition::Parity, Rdx);
+			a.Or8(Rcx, Rdx);
+			break;
+		case ThreadedOp::GeqFloat:
+			a.Ucomiss(Xmm0, Xmm1);
+			a.Set(Condition::AboveEqual, Rcx);
+			break;
+		case ThreadedOp::GtFloat:
+			a.Ucomiss(Xmm0, Xmm1);
+			a.Set(Condition::Above, Rcx);
+			break;
+		case ThreadedOp::LeqFloat:
+			a.Ucomiss(Xmm1, Xmm0);
+			a.Set(Condition::AboveEqual, Rcx);
+			break;
+		default:
+			a.Ucomiss(Xmm1, Xmm0);
+			a.Set(Condition::Above, Rcx);
+			break;
+		}
+		a.Movzx8(Rcx, Rcx);
+		pushResult(Rcx, DataType::Boolean, 2);
+	};
+	const auto intComparison = [&](Condition condition, Label slow) {
+		guardStack(2, slow);
+		a.Load32(Rcx, Value(-2));
+		a.Load32(Rdx, Value(-1));
+		a.Cmp32(Rcx, Rdx);
+		a.Set(condition, Rcx);
+		a.Movzx8(Rcx, Rcx);
+		pushResult(Rcx, DataType::Boolean, 2);
+	};
+	const auto logical = [&](bool isAnd, Label slow) {
+		guardStack(2, slow);
+		a.Load32(Rcx, Value(-2));
+		a.Test32(Rcx, Rcx);
+		a.Set(Condition::NotEqual, Rcx);
+		a.Load32(Rdx, Value(-1));
+		a.Test32(Rdx, Rdx);
+		a.Set(Condition::NotEqual, Rdx);
+		isAnd ? a.And8(Rcx, Rdx) : a.Or8(Rcx, Rdx);
+		a.Movzx8(Rcx, Rcx);
+		pushResult(Rcx, DataType::Boolean, 2);
+	};
+	// Pops the condition of a jump into rcx
+	const auto popCondition = [&](Label slow) {
+		guardStack(1, slow);
+		a.Load32(Rcx, Value(-1));
+		commit(1, 0);
+		a.Test32(Rcx, Rcx);
+	};
+
+	a.Push(Rbx);
+	a.Push(R12);
+	a.Push(R13);
+	a.Push(R14);
+	a.Push(R15);
+	a.Mov64(Rbx, static_cast<uint8_t>(Rdi));
+	a.Load64(R12, {Rbx, static_cast<int32_t>(offsetof(Frame, task))});
+	a.Load64(R14, {Rbx, static_cast<int32_t>(offsetof(Frame, executed))});
+	a.Load64(R15, {Rbx, static_cast<int32_t>(offsetof(Frame, blocks))});
+	load();
+	a.Jmp(Rsi);
+
+	const auto ip = Task(offsetof(VMTask, instructionAddress));
+	for (uint32_t address = start; address < end; ++address)
+	{
+		const auto& instruction = instructions[address];
+		const auto target = instruction.data.uintVal;
+		a.Bind(blocks[address - start]);
+		a.Add32(k_Executed, 1);
+
+		const auto op = DecodeThreadedOp(instruction, instructions.size(), _vm._functions);
+		switch (op)
+		{
+		case ThreadedOp::End:
+			a.Store8(Task(offsetof(VMTask, stop)), 1);
+			a.Store32(ip, address);
+			leave(Done);
+			break;
+		case ThreadedOp::JzForward:
+			popCondition(slowPath(address));
+			a.J(Condition::Equal, block(target));
+			a.Store32(Task(offsetof(VMTask, ticks)), 1u);
+			break;
+		case ThreadedOp::JzBackward:
+			popCondition(slowPath(address));
+			backwardJumps.emplace_back(a.NewLabel(), target);
+			a.J(Condition::Equal, backwardJumps.back().first);
+			a.Store32(Task(offsetof(VMTask, ticks)), 1u);
+			break;
+		case ThreadedOp::JmpForward:
+			a.Jmp(block(target));
+			break;
+		case ThreadedOp::JmpBackward:
+			a.Store32(ip, target);
+			a.Store8(Task(offsetof(VMTask, iield)), 1);
+			leave(Done);
+			break;
+		case ThreadedOp::PushImmediate:
+			guardStack(0, slowPath(address));
+			a.Store32(Value(0), instruction.data.uintVal);
+			a.Store32(Type(0), static_cast<uint32_t>(instruction.type));
+			commit(0, 1);
+			break;
+		case ThreadedOp::PushReference:
+		{
+			const auto slow = slowPath(address);
+			guardStack(0, slow);
+			const auto [type, value] = variable(target, slow);
+			a.Load32(Rcx, type);
+			a.Load32(Rdx, value);
+			a.Store32(Value(0), Rdx);
+			a.Store32(Type(0), Rcx);
+			commit(0, 1);
+			break;
+		}
+		case ThreadedOp::PopReference:
+		{
+			// Objects are counted by the helpers
+			const auto slow = slowPath(address);
+			guardStack(1, slow);
+			const auto [type, value] = variable(target, slow);
+			a.Cmp32(type, static_cast<int32_t>(DataType::Object));
+			a.J(Condition::Equal, slow);
+			a.Load32(Rcx, Type(-1));
+			a.Cmp32(Rcx, static_cast<int32_t>(DataType::Object));
+			a.J(Condition::Equal, slow);
+			a.Load32(Rsi, Value(-1));
+			a.Store32(value, Rsi);
+			a.Store32(type, Rcx);
+			commit(1, 0);
+			break;
+		}
+		case ThreadedOp::PopDiscard:
+			guardStack(1, slowPath(address));
+			commit(1, 0);
+			break;
+		case ThreadedOp::AddFloat:
+			guardStack(2, slowPath(address));
+			floatOperation(&Assembler::Addss, false);
+			break;
+		case ThreadedOp::SubFloat:
+			guardStack(2, slowPath(address));
+			floatOperation(&Assembler::Subss, true);
+			break;
+		case ThreadedOp::MulFloat:
+			guardStack(2, slowPath(address));
+			floatOperation(&Assembler::Mulss, false);
+			break;
+		case ThreadedOp::DivFloat:
+		{
+			// Division by zero signals an error, which is left to the helper
+			const auto slow = slowPath(address);
+			const auto divide = a.NewLabel();
+			guardStack(2, slow);
+			a.Movss(Xmm0, Value(-1));
+			a.Xorps(Xmm2, Xmm2);
+			a.Ucomiss(Xmm0, Xmm2);
+			a.J(Condition::Parity, divide);
+			a.J(Condition::Equal, slow);
+			a.Bind(divide);
+			floatOperation(&Assembler::Divss, true);
+			break;
+		}
+		case ThreadedOp::AddInt:
+		case ThreadedOp::SubInt:
+		case ThreadedOp::MulInt:
+			intOperation(op, slowPath(address));
+			break;
+		case ThreadedOp::NegFloat:
+		case ThreadedOp::NegInt:
+		{
+			const bool isFloat = op == ThreadedOp::NegFloat;
+			guardStack(1, slowPath(address));
+			isFloat ? a.Xor32(Value(-1), INT32_MIN) : a.Neg32(Value(-1));
+			a.Store32(Type(-1), static_cast<uint32_t>(isFloat ? DataType::Float : DataType::Int));
+			commit(1, 1);
+			break;
+		}
+		case ThreadedOp::EqFloat:
+		case ThreadedOp::NeqFloat:
+		case ThreadedOp::GeqFloat:
+		case ThreadedOp::LeqFloat:
+		case ThreadedOp::GtFloat:
+		case ThreadedOp::LtFloat:
+			floatComparison(op, slowPath(address));
+			break;
+		case ThreadedOp::EqInt:
+		case ThreadedOp::EqObject:
+			intComparison(Condition::Equal, slowPath(address));
+			break;
+		case ThreadedOp::NeqInt:
+		case ThreadedOp::NeqObject:
+			intComparison(Condition::NotEqual, slowPath(address));
+			break;
+		case ThreadedOp::GeqInt:
+			intComparison(Condition::GreaterEqual, slowPath(address));
+			break;
+		case ThreadedOp::LeqInt:
+			intComparison(Condition::LessEqual, slowPath(address));
+			break;
+		case ThreadedOp::GtInt:
+			intComparison(Condition::Greater, slowPath(address));
+			break;
+		case ThreadedOp::LtInt:
+			intComparison(Condition::Less, slowPath(address));
+			break;
+		case ThreadedOp::Not:
+			guardStack(1, slowPath(address));
+			a.Load32(Rcx, Value(-1));
+			a.Test32(Rcx, Rcx);
+			a.Set(Condition::Equal, Rcx);
+			a.Movzx8(Rcx, Rcx);
+			pushResult(Rcx, DataType::Boolean, 1);
+			break;
+		case ThreadedOp::And:
+		case ThreadedOp::Or:
+			logical(op == ThreadedOp::And, slowPath(address));
+			break;
+		case ThreadedOp::Cast:
+			guardStack(1, slowPath(address));
+			a.Store32(Type(-1), static_cast<uint32_t>(instruction.type));
+			commit(1, 1);
+			break;
+		case ThreadedOp::Yield:
+			a.Store8(Task(offsetof(VMTask, iield)), 1);
+			a.Store32(ip, address + 1);
+			leave(Done);
+			break;
+		case ThreadedOp::Line:
+			break;
+		case ThreadedOp::Sys:
+			call(callNative, address);
+			break;
+		default:
+			// Vectors, integer divisions, sleeps, exception handlers, runs and the rare opcodes
+			call(runInstruction, address);
+			break;
+		}
+	}
+	a.Bind(blocks[count]);
+	a.Store32(ip, end);
+	leave(Interpret);
+
+	// The helpers return Next, handled where they are called, or one of these
+	const auto dispatch = a.NewLabel();
+	const auto outside = a.NewLabel();
+	a.Bind(status);
+	a.Cmp32(Rax, static_cast<int32_t>(Dispatch));
+	a.J(Condition::NotEqual, exit);
+	a.Bind(dispatch);
+	a.Load32(Rax, ip);
+	a.Sub32(Rax, static_cast<int32_t>(start));
+	a.Cmp32(Rax, static_cast<int32_t>(count));
+	a.J(Condition::AboveEqual, outside);
+	a.Jmp(Mem {R15, 0, Rax, 3});
+	a.Bind(outside);
+	leave(Interpret);
+
+	for (const auto& [address, label] : exits)
+	{
+		a.Bind(label);
+		a.Store32(ip, address);
+		leave(Interpret);
+	}
+	for (const auto& [label, target] : backwardJumps)
+	{
+		a.Bind(label);
+		a.Store32(ip, target);
+		a.Store8(Task(offsetof(VMTask, iield)), 1);
+		leave(Done);
+	}
+	for (const auto& [label, address] : slowPaths)
+	{
+		a.Bind(label);
+		call(runInstruction, address);
+		a.Jmp(blocks[address + 1 - start]);
+	}
+
+	a.Bind(exit);
+	flush();
+	a.Pop(R15);
+	a.Pop(R14);
+	a.Pop(R13);
+	a.Pop(R12);
+	a.Pop(Rbx);
+	a.Ret();
+
+	std::vector<Label> labels(blocks.begin(), blocks.end() - 1);
+	std::vector<size_t> offsets;
+	offsets.reserve(labels.size());
+	for (const auto label : labels)
+	{
+		offsets.push_back(a.Offset(label));
+	}
+	const auto code = a.Finish();
+
+	// Written, then made executable
+	const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const auto size = (code.size() + pageSize - 1) / pageSize * pageSize;
+	auto* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	auto compiled = std::make_unique<CompiledScript>(memory, size);
+	std::memcpy(memory, code.data(), code.size());
+	if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0)
+	{
+		return nullptr;
+	}
+
+	const auto* base = static_cast<const uint8_t*>(memory);
+	compiled->entry = reinterpret_cast<CompiledScript::Entry>(memory);
+	compiled->start = start;
+	compiled->end = end;
+	compiled->variablesOffset = offset;
+	compiled->blocks.reserve(offsets.size());
+	for (const auto blockOffset : offsets)
+	{
+		compiled->blocks.push_back(base + blockOffset);
+	}
+	return compiled;
+}
+
+uint32_t JitCompiler::RunInstruction(Frame* frame, uint32_t address)
+{
+	auto& vm = *frame->vm;
+	auto& task = *frame->task;
+	task.instructionAddress = address;
+	try
+	{
+		const auto& instruction = vm._instructions[address];
+		(vm.*vm._opcodesImpl.at(static_cast<int>(instruction.code)))(task, instruction);
+		vm._currentTask = &task;
+	}
+	catch (...)
+	{
+		vm._jit->_exception = std::current_exception();
+		return Rethrow;
+	}
+	return CheckNext(frame, address);
+}
+
+uint32_t JitCompiler::CallNative(Frame* frame, uint32_t address)
+{
+	auto& vm = *frame->vm;
+	auto& task = *frame->task;
+	task.instructionAddress = address;
+	try
+	{
+		const auto id = vm._instructions[address].data.uintVal;
+		vm._currentStack->pushCount = 0;
+		vm._currentStack->popCount = 0;
+#if LHVM_NATIVE_CALL_CALLBACKS
+		vm.InvokeNativeCallEnterCallback(id);
+#endif
+		(*vm._functions)[id].impl(vm);
+#if LHVM_NATIVE_CALL_CALLBACKS
+		vm.InvokeNativeCallExitCallback(id);
+#endif
+		vm._currentTask = &task;
+	}
+	catch (...)
+	{
+		vm._jit->_exception = std::current_exception();
+		return Rethrow;
+	}
+	return CheckNext(frame, address);
+}
+
+/// The checks the reference core does after every instruction
+uint32_t JitCompiler::CheckNext(Frame* frame, uint32_t address)
+{
+	auto& task = *frame->task;
+	if (task.stop || task.iield || task.waitingTaskId != 0 || task.inExceptionHandler != frame->wasExceptionHandler)
+	{
+		return Done;
+	}
+	return ++task.instructionAddress == address + 1 ? Next : Dispatch;
+}
+
+#else
+
+struct JitCompiler::CompiledScript
+{
+};
+
+JitCompiler::JitCompiler(LHVM& vm)
+    : _vm(vm)
+{
+}
+
+JitCompiler::~JitCompiler() = default;
+
+bool JitCompiler::Run(VMTask& /*task*/)
+{
+	return false;
+}
+
+#endif
+
+void JitCompiler::Reset()
+{
+	if (_running > 0)
+	{
+		for (auto& script : _scripts)
+		{
+			if (script.compiled != nullptr)
+			{
+				_retired.emplace_back(std::move(script.compiled));
+			}
+		}
+	}
+	_scripts.clear();
+}
+
+uint32_t JitCompiler::GetCompiledScriptCount() const
+{
+	return static_cast<uint32_t>(
+	    std::ranges::count_if(_scripts, [](const Script& script) { return script.compiled != nullptr; }));
+}
+
+uint32_t JitCompiler::GetFailedScriptCount() const
+{
+	return static_cast<uint32_t>(std::ranges::count_if(_scripts, [](const Script& script) { return script.failed; }));
+}
+
+} // namespace openblack::lhvm
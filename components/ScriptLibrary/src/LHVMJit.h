@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "LHVMTypes.h"
+
+// Compiles the scripts which run the most to x86-64 machine code. OPENBLACK_LHVM_JIT defines it on x86-64 Linux.
+#if !defined(LHVM_JIT)
+#define LHVM_JIT 0
+#endif
+
+namespace openblack::lhvm
+{
+
+class LHVM;
+
+/// Baseline compiler of the instructions of a script, one block of machine code for each. The blocks keep the stack and
+/// the variables in the VM, where the interpreters find them, and hand the instructions they don't handle to the
+/// reference handlers. Sleeps, yields and anything which leaves the script end the run like in the interpreters.
+class JitCompiler
+{
+public:
+	explicit JitCompiler(LHVM& vm);
+	~JitCompiler();
+
+	/// Runs the task if its script is compiled, compiling the script once it has run often enough. Returns false when
+	/// the task is left to the interpreter.
+	bool Run(VMTask& task);
+
+	/// Drops the compiled scripts, for when the program changes
+	void Reset();
+
+	[[nodiscard]] uint32_t GetCompiledScriptCount() const;
+	/// Scripts which went hot but couldn't be compiled and are left to the interpreter
+	[[nodiscard]] uint32_t GetFailedScriptCount() const;
+
+private:
+	struct Frame;
+	struct CompiledScript;
+
+	/// Scripts are compiled once their tasks have run this many times, most only ever run once
+	static constexpr uint32_t k_HotRuns = 16;
+
+	struct Script
+	{
+		uint32_t runs {0};
+		bool failed {false};
+		std::unique_ptr<CompiledScript> compiled;
+	};
+
+	std::unique_ptr<CompiledScript> Compile(const VMScript& script, uint32_t end) const;
+
+	/// What the blocks and the helpers they call tell each other
+	enum Status : uint32_t
+	{
+		/// Carry on with the next instruction
+		Next,
+		/// Carry on at the address of the task
+		Dispatch,
+		/// The run is over
+		Done,
+		/// The exception of a helper has to be thrown again
+		Rethrow,
+		/// The address of the task is outside of the script, the interpreter carries on from there
+		Interpret,
+	};
+
+	static uint32_t RunInstruction(Frame* frame, uint32_t address);
+	static uint32_t CallNative(Frame* frame, uint32_t address);
+	static uint32_t CheckNext(Frame* frame, uint32_t address);
+
+	LHVM& _vm;
+	std::vector<Script> _scripts;
+	/// Code which is still running when the scripts are dropped is freed once the outermost run is over
+	std::vector<std::unique_ptr<CompiledScript>> _retired;
+	uint32_t _running {0};
+	/// Exceptions can't unwind through the compiled code, the helpers catch them and Run throws them again
+	std::exception_ptr _exception;
+};
+
+} // namespace openblack::lhvm
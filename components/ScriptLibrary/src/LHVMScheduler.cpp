@@ -0,0 +1,328 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "LHVM.h"
+
+#include <algorithm>
+#include <vector>
+
+// A tick only visits the tasks which can run. Tasks waiting for another task sleep until it stops, and tasks polling a
+// sleep in a loop of their own are parked on a timer wheel until their sleep is over. Neither changes what the tick
+// does: the idle tasks catch up with the clock of their type, from which their state follows, when they run again or
+// when the tasks are looked at.
+
+namespace openblack::lhvm
+{
+
+void LHVM::LookIn(const ScriptType allowedScriptTypesMask)
+{
+	// execute exception handlers first, tasks which stop running are taken out of the ready ones as they go
+	for (auto iter = _readyTasks.begin(); iter != _readyTasks.end();)
+	{
+		const auto id = iter->first;
+		auto& task = *iter->second;
+		if (task.type & allowedScriptTypesMask)
+		{
+			_currentStack = &task.stack;
+			if (task.inExceptionHandler)
+			{
+				CpuLoop(task);
+				AfterRun(task);
+			}
+			else if (task.waitingTaskId == 0)
+			{
+				task.currentExceptionHandlerIndex = 0;
+				if (GetExceptionHandlersCount() > 0)
+				{
+					task.pevInstructionAddress = task.instructionAddress;
+					task.instructionAddress = GetCurrentExceptionHandlerIp(task.currentExceptionHandlerIndex);
+					task.inExceptionHandler = true;
+					CpuLoop(task);
+					AfterRun(task);
+				}
+			}
+		}
+		iter = _readyTasks.upper_bound(id);
+	}
+
+	// execute normal code
+	for (auto iter = _readyTasks.begin(); iter != _readyTasks.end();)
+	{
+		const auto id = iter->first;
+		auto& task = *iter->second;
+		if (task.type & allowedScriptTypesMask)
+		{
+			_currentStack = &task.stack;
+			if (!task.inExceptionHandler)
+			{
+				CpuLoop(task);
+				AfterRun(task);
+				if (task.iield)
+				{
+					_yieldedTasks.emplace_back(task.id);
+				}
+			}
+		}
+		iter = _readyTasks.upper_bound(id);
+	}
+
+	// handle tasks termination
+	std::sort(_endedTasks.begin(), _endedTasks.end());
+	for (const auto id : _endedTasks)
+	{
+		if (TaskExists(id))
+		{
+			StopTask(id);
+		}
+	}
+	_endedTasks.clear();
+
+	// unlock waiting tasks
+	for (auto& [id, task] : _readyTasks)
+	{
+		if (task->type & allowedScriptTypesMask)
+		{
+			task->ticks++;
+		}
+	}
+	WakeTasks(allowedScriptTypesMask);
+	ParkYieldedTasks();
+
+	_ticks++;
+	_currentStack = &_mainStack;
+}
+
+void LHVM::ScheduleTask(VMTask& task)
+{
+	_readyTaskPool.Emplace(_readyTasks, task.id) = &task;
+	_clocks.try_emplace(task.type);
+}
+
+void LHVM::UnscheduleTask(const uint32_t taskNumber)
+{
+	_readyTaskPool.Erase(_readyTasks, taskNumber);
+
+	if (const auto idle = _idleTasks.find(taskNumber); idle != _idleTasks.end())
+	{
+		_clocks.at(_tasks.at(taskNumber).type).parkedInstructions -= idle->second.instructions;
+		_idleTaskPool.Erase(_idleTasks, idle);
+	}
+
+	// the ids left in the wheel and in the lists of waiting tasks are dropped when they come up
+	if (const auto waiting = _waitingTasks.find(taskNumber); waiting != _waitingTasks.end())
+	{
+		_unblockedTasks.insert(_unblockedTasks.end(), waiting->second.begin(), waiting->second.end());
+		waiting->second.clear();
+		_waitingTaskPool.Erase(_waitingTasks, waiting);
+	}
+}
+
+void LHVM::RebuildSchedule()
+{
+	_readyTasks.clear();
+	_idleTasks.clear();
+	_waitingTasks.clear();
+	_unblockedTasks.clear();
+	_endedTasks.clear();
+	_yieldedTasks.clear();
+	_clocks.clear();
+
+	// waiting tasks are ready until they run once, which puts them back in the list of their task
+	for (auto& [id, task] : _tasks)
+	{
+		ScheduleTask(task);
+		if (task.stop)
+		{
+			_endedTasks.emplace_back(id);
+		}
+	}
+}
+
+void LHVM::AfterRun(VMTask& task)
+{
+	if (task.stop)
+	{
+		_endedTasks.emplace_back(task.id);
+	}
+
+	if (task.waitingTaskId != 0)
+	{
+		_readyTaskPool.Erase(_readyTasks, task.id);
+		_idleTaskPool.Emplace(_idleTasks, task.id) = IdleTask {_clocks.at(task.type).ticks, 0, 0};
+		if (TaskExists(task.waitingTaskId))
+		{
+			const auto waiting = _waitingTasks.find(task.waitingTaskId);
+			auto& waitingTasks = waiting != _waitingTasks.end() ? waiting->second
+			                                                     : _waitingTaskPool.Emplace(_waitingTasks, task.waitingTaskId);
+			waitingTasks.emplace_back(task.id);
+		}
+		else
+		{
+			_unblockedTasks.emplace_back(task.id);
+		}
+	}
+}
+
+void LHVM::CatchUp(VMTask& task, IdleTask& idle)
+{
+	const auto ticks = _clocks.at(task.type).ticks;
+	const auto elapsed = ticks - idle.since;
+	if (elapsed == 0)
+	{
+		return;
+	}
+
+	task.ticks += elapsed;
+	if (idle.instructions != 0)
+	{
+		// every tick pushed the duration, which the sleep replaced with false, which the jump popped
+		task.stack.pushCount += 2 * elapsed;
+		task.stack.popCount += 2 * elapsed;
+		task.stack.values.at(task.stack.count) = VMValue(0);
+		task.stack.types.at(task.stack.count) = DataType::Boolean;
+		task.sleeping = true;
+		task.iield = true;
+	}
+	idle.since = ticks;
+}
+
+bool LHVM::IsInSleepLoop(const VMTask& task, uint32_t& length, uint32_t& duration) const
+{
+	const auto skipLines = [this](uint32_t address) {
+		while (address < _instructions.size() && _instructions[address].code == Opcode::Line)
+		{
+			address++;
+		}
+		return address;
+	};
+
+	// SLEEP with an immediate duration and a JZ back to it, as the compiler writes "wait <seconds> seconds"
+	const auto push = skipLines(task.instructionAddress);
+	const auto sleep = skipLines(push + 1);
+	const auto jump = skipLines(sleep + 1);
+	if (jump >= _instructions.size())
+	{
+		return false;
+	}
+
+	const auto& pushInstruction = _instructions[push];
+	const auto& jumpInstruction = _instructions[jump];
+	if (pushInstruction.code != Opcode::Push || pushInstruction.mode != VMMode::Immediate ||
+	    _instructions[sleep].code != Opcode::Sleep || jumpInstruction.code != Opcode::Wait ||
+	    jumpInstruction.mode != VMMode::Backward || jumpInstruction.data.uintVal != task.instructionAddress)
+	{
+		return false;
+	}
+
+	const auto tenths = pushInstruction.data.floatVal * 10.0f;
+	if (!(tenths >= 0.0f && tenths < 4294967296.0f))
+	{
+		return false;
+	}
+
+	length = jump - task.instructionAddress + 1;
+	duration = static_cast<uint32_t>(tenths);
+	return true;
+}
+
+void LHVM::ParkYieldedTasks()
+{
+	for (const auto id : _yieldedTasks)
+	{
+		const auto ready = _readyTasks.find(id);
+		if (ready == _readyTasks.end())
+		{
+			continue;
+		}
+
+		// tasks with exception handlers would run them every tick
+		auto& task = *ready->second;
+		uint32_t length;
+		uint32_t duration;
+		if (!task.iield || task.stop || task.waitingTaskId != 0 || task.inExceptionHandler ||
+		    !task.exceptionHandlerIps.empty() || task.stack.count >= VMStack::k_Size ||
+		    !IsInSleepLoop(task, length, duration) || duration < task.ticks)
+		{
+			continue;
+		}
+
+		// the sleep is over once the ticks of the task are past the duration
+		auto& clock = _clocks.at(task.type);
+		const auto wakeAt = clock.ticks + (duration - task.ticks + 1);
+		_idleTaskPool.Emplace(_idleTasks, id) = IdleTask {clock.ticks, wakeAt, length};
+		clock.wheel.at(wakeAt % k_TimerWheelSize).emplace_back(id);
+		clock.parkedInstructions += length;
+		_readyTaskPool.Erase(_readyTasks, ready);
+	}
+	_yieldedTasks.clear();
+}
+
+void LHVM::WakeTasks(const ScriptType allowedScriptTypesMask)
+{
+	for (auto& [type, clock] : _clocks)
+	{
+		if (!(type & allowedScriptTypesMask))
+		{
+			continue;
+		}
+
+		clock.ticks++;
+		_executedInstructions += clock.parkedInstructions;
+
+		std::erase_if(clock.wheel.at(clock.ticks % k_TimerWheelSize), [this, &clock](const uint32_t id) {
+			const auto idle = _idleTasks.find(id);
+			if (idle == _idleTasks.end())
+			{
+				return true;
+			}
+			if (idle->second.wakeAt != clock.ticks)
+			{
+				return false;
+			}
+
+			auto& task = _tasks.at(id);
+			CatchUp(task, idle->second);
+			clock.parkedInstructions -= idle->second.instructions;
+			_idleTaskPool.Erase(_idleTasks, idle);
+			_readyTaskPool.Emplace(_readyTasks, id) = &task;
+			return true;
+		});
+	}
+
+	std::erase_if(_unblockedTasks, [this, allowedScriptTypesMask](const uint32_t id) {
+		const auto idle = _idleTasks.find(id);
+		if (idle == _idleTasks.end())
+		{
+			return true;
+		}
+
+		auto& task = _tasks.at(id);
+		if (!(task.type & allowedScriptTypesMask))
+		{
+			return false;
+		}
+
+		CatchUp(task, idle->second);
+		task.waitingTaskId = 0;
+		task.instructionAddress++;
+		_idleTaskPool.Erase(_idleTasks, idle);
+		_readyTaskPool.Emplace(_readyTasks, id) = &task;
+		return true;
+	});
+}
+
+void LHVM::SettleIdleTasks()
+{
+	for (auto& [id, idle] : _idleTasks)
+	{
+		CatchUp(_tasks.at(id), idle);
+	}
+}
+
+} // namespace openblack::lhvm
@@ -0,0 +1,433 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "LHVMSnapshot.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+#include "LHVMTypes.h"
+
+namespace openblack::lhvm
+{
+
+namespace
+{
+struct Header
+{
+	std::array<char, 4> magic;
+	uint32_t version;
+	uint32_t flags;
+	/// Of the body once decompressed
+	uint32_t size;
+};
+static_assert(std::is_trivially_copyable_v<Header> && sizeof(Header) == 16);
+
+// LZ77 coder in the spirit of LZ4. Each sequence is a token with the number of literals in the high nibble and the
+// length of the match minus k_MinMatch in the low one, either of which continues in bytes of 255 when it is 15, then the
+// literals and the 16 bit distance of the match. The last sequence only has literals.
+constexpr size_t k_MinMatch = 4;
+constexpr size_t k_MaxDistance = 0xFFFF;
+constexpr uint32_t k_HashBits = 12;
+
+void PutLength(std::vector<uint8_t>& output, size_t length)
+{
+	for (length -= 15; length >= 255; length -= 255)
+	{
+		output.push_back(255);
+	}
+	output.push_back(static_cast<uint8_t>(length));
+}
+
+void PutSequence(std::vector<uint8_t>& output, const uint8_t* literals, size_t literalCount, size_t distance,
+                 size_t matchLength)
+{
+	const auto match = matchLength != 0 ? matchLength - k_MinMatch : 0;
+	output.push_back(static_cast<uint8_t>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(match, 15)));
+	if (literalCount >= 15)
+	{
+		PutLength(output, literalCount);
+	}
+	output.insert(output.end(), literals, literals + literalCount);
+	if (matchLength == 0)
+	{
+		return;
+	}
+	output.push_back(static_cast<uint8_t>(distance));
+	output.push_back(static_cast<uint8_t>(distance >> 8));
+	if (match >= 15)
+	{
+		PutLength(output, match);
+	}
+}
+
+std::vector<uint8_t> Compress(const std::vector<uint8_t>& input)
+{
+	const auto* const data = input.data();
+	const auto size = input.size();
+	std::vector<uint8_t> output;
+	output.reserve(size + size / 255 + 16);
+
+	// Last position plus one of each hash of k_MinMatch bytes
+	std::vector<uint32_t> positions(1u << k_HashBits, 0);
+	size_t anchor = 0;
+	size_t i = 0;
+	while (i + k_MinMatch <= size)
+	{
+		uint32_t sequence;
+		std::memcpy(&sequence, data + i, sizeof(sequence));
+		const auto hash = (sequence * 2654435761u) >> (32 - k_HashBits);
+		const auto candidate = positions[hash];
+		positions[hash] = static_cast<uint32_t>(i + 1);
+		if (candidate == 0 || i - (candidate - 1) > k_MaxDistance ||
+		    std::memcmp(data + candidate - 1, data + i, k_MinMatch) != 0)
+		{
+			// Skip ahead faster the longer nothing matches
+			i += 1 + ((i - anchor) >> 6);
+			continue;
+		}
+
+		const size_t match = candidate - 1;
+		auto length = k_MinMatch;
+		while (i + length < size && data[match + length] == data[i + length])
+		{
+			++length;
+		}
+		PutSequence(output, data + anchor, i - anchor, i - match, length);
+		i += length;
+		anchor = i;
+	}
+	PutSequence(output, data + anchor, size - anchor, 0, 0);
+	return output;
+}
+
+bool GetLength(const uint8_t*& cursor, const uint8_t* end, size_t& length)
+{
+	if (length != 15)
+	{
+		return true;
+	}
+	uint8_t byte;
+	do
+	{
+		if (cursor == end)
+		{
+			return false;
+		}
+		byte = *cursor++;
+		length += byte;
+	} while (byte == 255);
+	return true;
+}
+
+bool Decompress(const uint8_t* cursor, const uint8_t* end, std::vector<uint8_t>& output, size_t size)
+{
+	output.clear();
+	output.reserve(size);
+	// The last sequence only has literals, a stream which ends after a match is cut short
+	while (cursor != end)
+	{
+		const auto token = *cursor++;
+		size_t literalCount = token >> 4;
+		if (!GetLength(cursor, end, literalCount) || literalCount > static_cast<size_t>(end - cursor) ||
+		    literalCount > size - output.size())
+		{
+			return false;
+		}
+		output.insert(output.end(), cursor, cursor + literalCount);
+		cursor += literalCount;
+		if (cursor == end)
+		{
+			return output.size() == size;
+		}
+
+		if (end - cursor < 2)
+		{
+			return false;
+		}
+		const size_t distance = cursor[0] | (cursor[1] << 8);
+		cursor += 2;
+		size_t length = token & 15;
+		if (!GetLength(cursor, end, length) || distance == 0 || distance > output.size() ||
+		    length + k_MinMatch > size - output.size())
+		{
+			return false;
+		}
+		// The match can overlap what it copies
+		for (auto from = output.size() - distance, to = from + length + k_MinMatch; from < to; ++from)
+		{
+			output.push_back(output[from]);
+		}
+	}
+	return false;
+}
+
+class Writer
+{
+public:
+	explicit Writer(std::vector<uint8_t>& output)
+	    : _output(output)
+	{
+	}
+
+	template <typename T>
+	void Put(const T& value)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+		_output.insert(_output.end(), bytes, bytes + sizeof(T));
+	}
+
+	template <typename T>
+	void PutArray(const std::vector<T>& values)
+	{
+		static_assert(std::is_trivially_copyable_v<T>);
+		Put(static_cast<uint32_t>(values.size()));
+		const auto* bytes = reinterpret_cast<const uint8_t*>(values.data());
+		_output.insert(_output.end(), bytes, bytes + values.size() * sizeof(T));
+	}
+
+	void PutString(const std::string& value)
+	{
+		Put(static_cast<uint32_t>(value.size()));
+		_output.insert(_output.end(), value.begin(), value.end());
+	}
+
+private:
+	std::vector<uint8_t>& _output;
+};
+
+class Reader
+{
+public:
+	Reader(const uint8_t* cursor, const uint8_t* end)
+	    : _cursor(cursor)
+	    , _end(end)
+	{
+	}
+
+	[[nodiscard]] bool AtEnd() const { return _cursor == _end; }
+
+	template <typename T>
+	bool Get(T& value)
+	{
+		if (static_cast<size_t>(_end - _cursor) < sizeof(T))
+		{
+			return false;
+		}
+		std::memcpy(&value, _cursor, sizeof(T));
+		_cursor += sizeof(T);
+		return true;
+	}
+
+	template <typename T>
+	bool GetArray(std::vector<T>& values)
+	{
+		uint32_t count;
+		if (!Get(count) || static_cast<size_t>(_end - _cursor) / sizeof(T) < count)
+		{
+			return false;
+		}
+		values.resize(count);
+		if (count != 0)
+		{
+			std::memcpy(values.data(), _cursor, count * sizeof(T));
+		}
+		_cursor += count * sizeof(T);
+		return true;
+	}
+
+	bool GetString(std::string& value)
+	{
+		uint32_t size;
+		if (!Get(size) || static_cast<size_t>(_end - _cursor) < size)
+		{
+			return false;
+		}
+		value.assign(reinterpret_cast<const char*>(_cursor), size);
+		_cursor += size;
+		return true;
+	}
+
+private:
+	const uint8_t* _cursor;
+	const uint8_t* _end;
+};
+
+} // namespace
+
+std::vector<uint8_t> LHVMSnapshot::Encode(bool compress) const
+{
+	std::vector<uint8_t> body;
+	Writer writer(body);
+	writer.Put(_instructionCount);
+	writer.Put(_scriptCount);
+	writer.Put(_ticks);
+	writer.Put(_currentLineNumber);
+	writer.Put(_highestTaskId);
+	writer.Put(_highestScriptId);
+	writer.Put(_executedInstructions);
+	writer.Put(static_cast<uint32_t>(_strings.size()));
+	for (const auto& string : _strings)
+	{
+		writer.PutString(string);
+	}
+	writer.PutArray(_globalNames);
+	writer.PutArray(_globalTypes);
+	writer.PutArray(_globalValues);
+	writer.Put(_mainStack);
+	writer.PutArray(_tasks);
+	writer.PutArray(_localTypes);
+	writer.PutArray(_localValues);
+	writer.PutArray(_exceptionHandlerIps);
+	writer.PutArray(_stackTypes);
+	writer.PutArray(_stackValues);
+
+	const Header header {k_Magic, k_Version, compress ? Compressed : 0u, static_cast<uint32_t>(body.size())};
+	auto payload = compress ? Compress(body) : std::move(body);
+	std::vector<uint8_t> output;
+	output.reserve(sizeof(header) + payload.size());
+	Writer(output).Put(header);
+	output.insert(output.end(), payload.begin(), payload.end());
+	return output;
+}
+
+int LHVMSnapshot::Decode(const std::vector<uint8_t>& buffer)
+{
+	Header header;
+	Reader headerReader(buffer.data(), buffer.data() + buffer.size());
+	if (!headerReader.Get(header) || header.magic != k_Magic || header.version != k_Version ||
+	    (header.flags & ~Compressed) != 0)
+	{
+		return EXIT_FAILURE; // Not a snapshot of this version
+	}
+
+	const auto* payload = buffer.data() + sizeof(header);
+	const auto payloadSize = buffer.size() - sizeof(header);
+	std::vector<uint8_t> decompressed;
+	if ((header.flags & Compressed) != 0)
+	{
+		// A sequence can't expand to more than 255 times its size, which bounds what a corrupt header allocates
+		if (header.size / 255 > payloadSize || !Decompress(payload, payload + payloadSize, decompressed, header.size))
+		{
+			return EXIT_FAILURE; // Corrupt compressed body
+		}
+		payload = decompressed.data();
+	}
+	else if (payloadSize != header.size)
+	{
+		return EXIT_FAILURE; // Truncated body
+	}
+
+	LHVMSnapshot snapshot;
+	Reader reader(payload, payload + header.size);
+	uint32_t stringCount;
+	if (!reader.Get(snapshot._instructionCount) || !reader.Get(snapshot._scriptCount) || !reader.Get(snapshot._ticks) ||
+	    !reader.Get(snapshot._currentLineNumber) || !reader.Get(snapshot._highestTaskId) ||
+	    !reader.Get(snapshot._highestScriptId) || !reader.Get(snapshot._executedInstructions) || !reader.Get(stringCount))
+	{
+		return EXIT_FAILURE; // Truncated runtime info
+	}
+	for (uint32_t i = 0; i < stringCount; ++i)
+	{
+		if (!reader.GetString(snapshot._strings.emplace_back()))
+		{
+			return EXIT_FAILURE; // Truncated strings
+		}
+	}
+	if (!reader.GetArray(snapshot._globalNames) || !reader.GetArray(snapshot._globalTypes) ||
+	    !reader.GetArray(snapshot._globalValues) || !reader.Get(snapshot._mainStack) || !reader.GetArray(snapshot._tasks) ||
+	    !reader.GetArray(snapshot._localTypes) || !reader.GetArray(snapshot._localValues) ||
+	    !reader.GetArray(snapshot._exceptionHandlerIps) || !reader.GetArray(snapshot._stackTypes) ||
+	    !reader.GetArray(snapshot._stackValues) || !reader.AtEnd())
+	{
+		return EXIT_FAILURE; // Truncated state
+	}
+
+	// The arrays have to add up so that restoring never reads out of them, and the VM must be able to look up every
+	// address and type it is left with
+	const auto stringIndexValid = [&snapshot](uint32_t index) { return index < snapshot._strings.size(); };
+	const auto addressValid = [&snapshot](uint32_t address) { return address < snapshot._instructionCount; };
+	const auto typeValid = [](uint8_t type) { return type < static_cast<uint8_t>(DataType::_Count); };
+	uint64_t locals = 0;
+	uint64_t handlers = 0;
+	uint64_t stackValues = snapshot._mainStack.count;
+	bool valid = snapshot._mainStack.count <= VMStack::k_Size && std::ranges::all_of(snapshot._globalNames, stringIndexValid);
+	valid = valid && std::ranges::all_of(snapshot._globalTypes, typeValid) &&
+	        std::ranges::all_of(snapshot._localTypes, typeValid) && std::ranges::all_of(snapshot._stackTypes, typeValid) &&
+	        std::ranges::all_of(snapshot._exceptionHandlerIps, addressValid);
+	for (const auto& task : snapshot._tasks)
+	{
+		valid = valid && task.stack.count <= VMStack::k_Size && stringIndexValid(task.scriptName) &&
+		        addressValid(task.instructionAddress);
+		locals += task.localCount;
+		handlers += task.exceptionHandlerCount;
+		stackValues += task.stack.count;
+	}
+	if (!valid || snapshot._globalTypes.size() != snapshot._globalNames.size() ||
+	    snapshot._globalValues.size() != snapshot._globalNames.size() || snapshot._localTypes.size() != locals ||
+	    snapshot._localValues.size() != locals || snapshot._exceptionHandlerIps.size() != handlers ||
+	    snapshot._stackTypes.size() != stackValues || snapshot._stackValues.size() != stackValues)
+	{
+		return EXIT_FAILURE; // Inconsistent state
+	}
+
+	*this = std::move(snapshot);
+	return EXIT_SUCCESS;
+}
+
+int LHVMSnapshot::Write(const std::filesystem::path& filepath, bool compress) const
+{
+	const auto buffer = Encode(compress);
+
+	// A save which is cut short leaves the previous one as it was
+	auto temporary = filepath;
+	temporary += ".tmp";
+	{
+		std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+		if (!stream.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	std::error_code error;
+	std::filesystem::rename(temporary, filepath, error);
+	return error ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int LHVMSnapshot::Read(const std::filesystem::path& filepath)
+{
+	std::ifstream stream(filepath, std::ios::binary | std::ios::ate);
+	if (!stream)
+	{
+		return EXIT_FAILURE;
+	}
+	std::vector<uint8_t> buffer(static_cast<size_t>(stream.tellg()));
+	stream.seekg(0);
+	if (!stream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size())))
+	{
+		return EXIT_FAILURE;
+	}
+	return Decode(buffer);
+}
+
+std::future<int> LHVMSnapshot::WriteAsync(LHVMSnapshot snapshot, std::filesystem::path filepath, bool compress)
+{
+	return std::async(std::launch::async,
+	                  [snapshot = std::move(snapshot), filepath = std::move(filepath), compress]() {
+		                  return snapshot.Write(filepath, compress);
+	                  });
+}
+
+} // namespace openblack::lhvm
@@ -0,0 +1,1204 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "LHVMThreaded.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "LHVM.h"
+
+// Jump straight from the end of one handler to the next with the labels-as-values extension, which lets the branch
+// predictor tell the handlers apart. Other compilers go back through a switch.
+#if !defined(LHVM_COMPUTED_GOTO)
+#if defined(__GNUC__) || defined(__clang__)
+#define LHVM_COMPUTED_GOTO 1
+#else
+#define LHVM_COMPUTED_GOTO 0
+#endif
+#endif
+
+#if LHVM_COMPUTED_GOTO
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+namespace openblack::lhvm
+{
+
+namespace
+{
+/// Limit of the distances stored in a ThreadedInstruction
+constexpr uint32_t k_MaxSkipped = 255;
+
+#define LHVM_THREADED_OP_NAME(name) #name,
+constexpr std::array<std::string_view, static_cast<size_t>(ThreadedOp::_Count)> k_ThreadedOpNames = {
+    LHVM_THREADED_OPS(LHVM_THREADED_OP_NAME)};
+#undef LHVM_THREADED_OP_NAME
+
+/// Instructions are counted locally and added up when the loop is left, including by an exception
+struct ExecutedCount
+{
+	uint32_t& total;
+	uint32_t count {0};
+
+	~ExecutedCount() { total += count; }
+};
+
+ThreadedOp Specialise(DataType type, ThreadedOp intOp, ThreadedOp floatOp, ThreadedOp vectorOp)
+{
+	switch (type)
+	{
+	case DataType::Int:
+		return intOp;
+	case DataType::Float:
+		return floatOp;
+	case DataType::Vector:
+		return vectorOp;
+	default:
+		return ThreadedOp::Generic;
+	}
+}
+
+ThreadedOp SpecialiseCompare(DataType type, ThreadedOp intOp, ThreadedOp floatOp)
+{
+	switch (type)
+	{
+	case DataType::Int:
+		return intOp;
+	case DataType::Float:
+		return floatOp;
+	default:
+		return ThreadedOp::Generic;
+	}
+}
+
+ThreadedOp SpecialiseEquality(DataType type, ThreadedOp intOp, ThreadedOp floatOp, ThreadedOp vectorOp, ThreadedOp objectOp)
+{
+	switch (type)
+	{
+	case DataType::Int:
+	case DataType::Boolean:
+		return intOp;
+	case DataType::Float:
+		return floatOp;
+	case DataType::Vector:
+		return vectorOp;
+	case DataType::Object:
+		return objectOp;
+	default:
+		return ThreadedOp::Generic;
+	}
+}
+
+} // namespace
+
+ThreadedOp DecodeThreadedOp(const VMInstruction& instruction, size_t instructionCount,
+                            const std::vector<NativeFunction>* functions)
+{
+	// Forward jumps land on the target without going through the checks, so it has to be an instruction or the trap
+	const bool forwardTargetValid = instruction.data.uintVal <= instructionCount;
+	switch (instruction.code)
+	{
+	case Opcode::End:
+		return ThreadedOp::End;
+	case Opcode::Wait:
+		if (instruction.mode == VMMode::Forward)
+		{
+			return forwardTargetValid ? ThreadedOp::JzForward : ThreadedOp::Generic;
+		}
+		return ThreadedOp::JzBackward;
+	case Opcode::Push:
+		return instruction.mode == VMMode::Immediate ? ThreadedOp::PushImmediate : ThreadedOp::PushReference;
+	case Opcode::Pop:
+		return instruction.mode == VMMode::Reference ? ThreadedOp::PopReference : ThreadedOp::PopDiscard;
+	case Opcode::Add:
+		return Specialise(instruction.type, ThreadedOp::AddInt, ThreadedOp::AddFloat, ThreadedOp::AddVector);
+	case Opcode::Sub:
+		return Specialise(instruction.type, ThreadedOp::SubInt, ThreadedOp::SubFloat, ThreadedOp::SubVector);
+	case Opcode::Neg:
+		return Specialise(instruction.type, ThreadedOp::NegInt, ThreadedOp::NegFloat, ThreadedOp::NegVector);
+	case Opcode::Mul:
+		return Specialise(instruction.type, ThreadedOp::MulInt, ThreadedOp::MulFloat, ThreadedOp::MulVector);
+	case Opcode::Div:
+		return Specialise(instruction.type, ThreadedOp::DivInt, ThreadedOp::DivFloat, ThreadedOp::DivVector);
+	case Opcode::Mod:
+		return Specialise(instruction.type, ThreadedOp::ModInt, ThreadedOp::ModFloat, ThreadedOp::ModVector);
+	case Opcode::Not:
+		return ThreadedOp::Not;
+	case Opcode::And:
+		return ThreadedOp::And;
+	case Opcode::Or:
+		return ThreadedOp::Or;
+	case Opcode::Eq:
+		return SpecialiseEquality(instruction.type, ThreadedOp::EqInt, ThreadedOp::EqFloat, ThreadedOp::EqVector,
+		                          ThreadedOp::EqObject);
+	case Opcode::Ne:
+		return SpecialiseEquality(instruction.type, ThreadedOp::NeqInt, ThreadedOp::NeqFloat, ThreadedOp::NeqVector,
+		                          ThreadedOp::NeqObject);
+	case Opcode::Ge:
+		return SpecialiseCompare(instruction.type, ThreadedOp::GeqInt, ThreadedOp::GeqFloat);
+	case Opcode::Le:
+		return SpecialiseCompare(instruction.type, ThreadedOp::LeqInt, ThreadedOp::LeqFloat);
+	case Opcode::Gt:
+		return SpecialiseCompare(instruction.type, ThreadedOp::GtInt, ThreadedOp::GtFloat);
+	case Opcode::Lt:
+		return SpecialiseCompare(instruction.type, ThreadedOp::LtInt, ThreadedOp::LtFloat);
+	case Opcode::Jmp:
+		if (instruction.mode == VMMode::Forward)
+		{
+			return forwardTargetValid ? ThreadedOp::JmpForward : ThreadedOp::Generic;
+		}
+		return ThreadedOp::JmpBackward;
+	case Opcode::Sleep:
+		return ThreadedOp::Sleep;
+	case Opcode::Except:
+		return ThreadedOp::Except;
+	case Opcode::Cast:
+		return instruction.mode == VMMode::Zero ? ThreadedOp::Zero : ThreadedOp::Cast;
+	case Opcode::EndExcept:
+		return instruction.mode == VMMode::EndExcept ? ThreadedOp::EndExcept : ThreadedOp::Yield;
+	case Opcode::Line:
+		return ThreadedOp::Line;
+	case Opcode::Sys:
+		// natives which only adjust the stack and unknown ones are left to the reference handler
+		if (functions != nullptr && instruction.data.intVal > 0 && instruction.data.uintVal < functions->size() &&
+		    (*functions)[instruction.data.uintVal].impl != nullptr)
+		{
+			return ThreadedOp::Sys;
+		}
+		return ThreadedOp::Generic;
+	default:
+		// Run, the exception handler exits, Swap and invalid opcodes
+		return ThreadedOp::Generic;
+	}
+}
+
+namespace
+{
+/// Handlers which carry on with the next instruction when they are done
+bool FallsThrough(ThreadedOp op)
+{
+	switch (op)
+	{
+	case ThreadedOp::End:
+	case ThreadedOp::JmpForward:
+	case ThreadedOp::JmpBackward:
+	case ThreadedOp::Yield:
+	case ThreadedOp::Sys:
+	case ThreadedOp::Generic:
+	case ThreadedOp::OutOfRange:
+		return false;
+	default:
+		return true;
+	}
+}
+
+bool IsPair(ThreadedOp op)
+{
+	return op > ThreadedOp::OutOfRange;
+}
+
+/// Handler which runs both instructions, or the first one if they aren't a common pair
+ThreadedOp Pair(ThreadedOp first, ThreadedOp second)
+{
+	if (second == ThreadedOp::PopReference)
+	{
+		switch (first)
+		{
+		case ThreadedOp::PushImmediate:
+			return ThreadedOp::PushImmediatePop;
+		case ThreadedOp::PushReference:
+			return ThreadedOp::PushReferencePop;
+		case ThreadedOp::AddFloat:
+			return ThreadedOp::AddFloatPop;
+		case ThreadedOp::SubFloat:
+			return ThreadedOp::SubFloatPop;
+		case ThreadedOp::MulFloat:
+			return ThreadedOp::MulFloatPop;
+		case ThreadedOp::DivFloat:
+			return ThreadedOp::DivFloatPop;
+		default:
+			return first;
+		}
+	}
+	if (second == ThreadedOp::JzForward)
+	{
+		switch (first)
+		{
+		case ThreadedOp::PushReference:
+			return ThreadedOp::PushReferenceJz;
+		case ThreadedOp::EqFloat:
+			return ThreadedOp::EqFloatJz;
+		case ThreadedOp::NeqFloat:
+			return ThreadedOp::NeqFloatJz;
+		case ThreadedOp::GeqFloat:
+			return ThreadedOp::GeqFloatJz;
+		case ThreadedOp::LeqFloat:
+			return ThreadedOp::LeqFloatJz;
+		case ThreadedOp::GtFloat:
+			return ThreadedOp::GtFloatJz;
+		case ThreadedOp::LtFloat:
+			return ThreadedOp::LtFloatJz;
+		case ThreadedOp::Not:
+			return ThreadedOp::NotJz;
+		default:
+			return first;
+		}
+	}
+	if (first == ThreadedOp::PushReference && second == ThreadedOp::PushImmediate)
+	{
+		return ThreadedOp::PushReferenceImmediate;
+	}
+	if (first == ThreadedOp::PushReference && second == ThreadedOp::PushReference)
+	{
+		return ThreadedOp::PushReferenceReference;
+	}
+	return first;
+}
+} // namespace
+
+void LHVM::DecodeThreadedInstructions()
+{
+	const auto count = static_cast<uint32_t>(_instructions.size());
+	std::vector<ThreadedOp> ops(count + 1);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		ops[i] = DecodeThreadedOp(_instructions[i], count, _functions);
+	}
+	ops[count] = ThreadedOp::OutOfRange;
+
+	_threadedInstructions.resize(count + 1);
+	_threadedInstructions[count] = {static_cast<uint8_t>(ThreadedOp::OutOfRange), 1, 0, DataType::None, VMValue(0u)};
+
+	// Line markers don't do anything, the instruction before them skips them. They are still in _instructions, which is
+	// what the debugger shows.
+	uint32_t lines = 0;
+	for (uint32_t i = count; i-- > 0;)
+	{
+		const auto& instruction = _instructions[i];
+		const auto length = FallsThrough(ops[i]) ? 1 + std::min(lines, k_MaxSkipped - 1) : 1;
+		_threadedInstructions[i] = {static_cast<uint8_t>(ops[i]), static_cast<uint8_t>(length), 0, instruction.type,
+		                            instruction.data};
+		lines = ops[i] == ThreadedOp::Line ? lines + 1 : 0;
+	}
+
+	// Forward jumps land past the line markers and the forward jumps at their target
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (ops[i] != ThreadedOp::JzForward && ops[i] != ThreadedOp::JmpForward)
+		{
+			continue;
+		}
+		auto target = _instructions[i].data.uintVal;
+		uint32_t skipped = 0;
+		for (; target < count && skipped < k_MaxSkipped; ++skipped)
+		{
+			if (ops[target] == ThreadedOp::Line)
+			{
+				++target;
+			}
+			else if (ops[target] == ThreadedOp::JmpForward)
+			{
+				target = _instructions[target].data.uintVal;
+			}
+			else
+			{
+				break;
+			}
+		}
+		_threadedInstructions[i].data = VMValue(target);
+		_threadedInstructions[i].offset = static_cast<uint8_t>(skipped);
+	}
+
+	// Common pairs of instructions run as one. Each address is decoded on its own, so jumping to the second instruction
+	// of a pair still runs it alone.
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		auto& threaded = _threadedInstructions[i];
+		const auto second = i + threaded.length;
+		const auto pair = FallsThrough(ops[i]) ? Pair(ops[i], ops[second]) : ops[i];
+		if (pair != ops[i])
+		{
+			threaded.op = static_cast<uint8_t>(pair);
+			threaded.offset = threaded.length;
+		}
+	}
+}
+
+std::vector<ThreadedProgramInstruction> LHVM::GetThreadedProgram() const
+{
+	std::vector<ThreadedProgramInstruction> program;
+	for (uint32_t address = 0; address + 1 < _threadedInstructions.size();)
+	{
+		const auto& instruction = _threadedInstructions[address];
+		uint32_t length = instruction.length;
+		if (IsPair(static_cast<ThreadedOp>(instruction.op)))
+		{
+			length = instruction.offset + _threadedInstructions[address + instruction.offset].length;
+		}
+		program.push_back({address, length, k_ThreadedOpNames.at(instruction.op)});
+		address += length;
+	}
+	return program;
+}
+
+void LHVM::CpuLoopThreaded(VMTask& task)
+{
+	const auto wasExceptionHandler = task.inExceptionHandler;
+	task.iield = false;
+	if (task.waitingTaskId != 0)
+	{
+		_currentTask = nullptr;
+		return;
+	}
+	_currentTask = &task;
+
+	// Same semantics as Pop and Push, inlined into the handlers
+	const auto pop = [this]() {
+		auto& stack = *_currentStack;
+		stack.popCount++;
+		if (stack.count > 0)
+		{
+			return stack.values[--stack.count];
+		}
+		SignalError(ErrorCode::ErrStackEmpty);
+		return VMValue(0u);
+	};
+	const auto popTyped = [this](DataType& type) {
+		auto& stack = *_currentStack;
+		stack.popCount++;
+		if (stack.count > 0)
+		{
+			--stack.count;
+			type = stack.types[stack.count];
+			return stack.values[stack.count];
+		}
+		type = DataType::None;
+		SignalError(ErrorCode::ErrStackEmpty);
+		return VMValue(0u);
+	};
+	const auto push = [this](VMValue value, DataType type) {
+		auto& stack = *_currentStack;
+		stack.pushCount++;
+		if (stack.count < VMStack::k_Size)
+		{
+			stack.values[stack.count] = value;
+			stack.types[stack.count] = type;
+			stack.count++;
+		}
+		else
+		{
+			SignalError(ErrorCode::ErrStackFull);
+		}
+	};
+	const auto pushi = [&push](int32_t value) { push(VMValue(value), DataType::Int); };
+	const auto pushf = [&push](float value) { push(VMValue(value), DataType::Float); };
+	const auto pushv = [&push](float value) { push(VMValue(value), DataType::Vector); };
+	const auto pushb = [&push](bool value) { push(VMValue(value ? 1 : 0), DataType::Boolean); };
+	const auto pushReference = [this, &task, &push](uint32_t id) {
+		const auto& var = GetVar(task, id);
+		push(var.value, var.type);
+	};
+	const auto popReference = [this, &task, &popTyped](uint32_t id) {
+		auto& var = GetVar(task, id);
+		DataType type;
+		const auto newVal = popTyped(type);
+		if (type == DataType::Object)
+		{
+			AddReference(newVal.uintVal);
+		}
+		if (var.type == DataType::Object)
+		{
+			RemoveReference(newVal.uintVal);
+		}
+		var.value = newVal;
+		var.type = type;
+	};
+
+	const auto* const code = _threadedInstructions.data();
+	// Index of the trap, which any address past the last instruction is clamped to
+	const auto end = static_cast<uint32_t>(_threadedInstructions.size() - 1);
+	auto& ip = task.instructionAddress;
+	ExecutedCount executed {_executedInstructions};
+
+#if LHVM_COMPUTED_GOTO
+#define LHVM_THREADED_OP_LABEL(name) &&op_##name,
+	static void* const k_Labels[] = {LHVM_THREADED_OPS(LHVM_THREADED_OP_LABEL)};
+#undef LHVM_THREADED_OP_LABEL
+#define LHVM_OP(name) op_##name:
+#define LHVM_DISPATCH(index)                \
+	do                                      \
+	{                                       \
+		++executed.count;                   \
+		goto* k_Labels[code[(index)].op];   \
+	} while (false)
+#else
+	uint32_t next;
+#define LHVM_OP(name) case ThreadedOp::name:
+#define LHVM_DISPATCH(index) \
+	do                       \
+	{                        \
+		next = (index);      \
+		goto dispatch;       \
+	} while (false)
+#endif
+
+// For handlers which can't stop, yield, wait or leave the exception handler. The line markers after the instruction
+// are counted as run.
+#define LHVM_NEXT()                             \
+	do                                          \
+	{                                           \
+		executed.count += code[ip].length - 1u; \
+		ip += code[ip].length;                  \
+		LHVM_DISPATCH(ip);                      \
+	} while (false)
+
+// Move on to the second instruction of a pair, which the handler then runs as its own
+#define LHVM_SECOND()                      \
+	do                                     \
+	{                                      \
+		executed.count += code[ip].offset; \
+		ip += code[ip].offset;             \
+	} while (false)
+
+// Land past the line markers and the forward jumps at the target, which are counted as run
+#define LHVM_JUMP_FORWARD()                \
+	do                                     \
+	{                                      \
+		executed.count += code[ip].offset; \
+		ip = code[ip].data.uintVal;        \
+		LHVM_DISPATCH(ip);                 \
+	} while (false)
+
+#define LHVM_JZ_FORWARD()      \
+	do                         \
+	{                          \
+		if (pop().intVal != 0) \
+		{                      \
+			task.ticks = 1;    \
+			LHVM_NEXT();       \
+		}                      \
+		LHVM_JUMP_FORWARD();   \
+	} while (false)
+
+// The checks the reference core does after every instruction
+#define LHVM_CHECK_NEXT()                                                                                                 \
+	do                                                                                                                    \
+	{                                                                                                                     \
+		if (task.stop || task.iield || task.waitingTaskId != 0 || task.inExceptionHandler != wasExceptionHandler)         \
+		{                                                                                                                 \
+			goto done;                                                                                                    \
+		}                                                                                                                 \
+		++ip;                                                                                                             \
+		LHVM_DISPATCH(std::min(ip, end));                                                                                 \
+	} while (false)
+
+	LHVM_DISPATCH(std::min(ip, end));
+
+#if !LHVM_COMPUTED_GOTO
+dispatch:
+	++executed.count;
+	switch (static_cast<ThreadedOp>(code[next].op))
+	{
+#endif
+
+	LHVM_OP(End)
+	{
+		task.stop = true;
+		goto done;
+	}
+
+	LHVM_OP(JzForward)
+	{
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(JzBackward)
+	{
+		if (pop().intVal != 0)
+		{
+			task.ticks = 1;
+			LHVM_NEXT();
+		}
+		ip = code[ip].data.uintVal;
+		task.iield = true;
+		goto done;
+	}
+
+	LHVM_OP(PushImmediate)
+	{
+		push(code[ip].data, code[ip].type);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PushReference)
+	{
+		pushReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PopReference)
+	{
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PopDiscard)
+	{
+		pop();
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(AddInt)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushi(a0.intVal + b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(AddFloat)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(a0.floatVal + b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(AddVector)
+	{
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		pushv(a2.floatVal + b2.floatVal);
+		pushv(a1.floatVal + b1.floatVal);
+		pushv(a0.floatVal + b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(SubInt)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushi(b0.intVal - a0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(SubFloat)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(b0.floatVal - a0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(SubVector)
+	{
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		pushv(b2.floatVal - a2.floatVal);
+		pushv(b1.floatVal - a1.floatVal);
+		pushv(b0.floatVal - a0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NegInt)
+	{
+		pushi(-pop().intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NegFloat)
+	{
+		pushf(-pop().floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NegVector)
+	{
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		pushv(-a2.floatVal);
+		pushv(-a1.floatVal);
+		pushv(-a0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(MulInt)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushi(a0.intVal * b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(MulFloat)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(a0.floatVal * b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(MulVector)
+	{
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		const auto b0 = pop();
+		pushv(a2.floatVal * b0.floatVal);
+		pushv(a1.floatVal * b0.floatVal);
+		pushv(a0.floatVal * b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(DivInt)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		if (a0.intVal != 0)
+		{
+			pushi(b0.intVal / a0.intVal);
+		}
+		else
+		{
+			pushi(0);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(DivFloat)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		if (a0.floatVal != 0.0f)
+		{
+			pushf(b0.floatVal / a0.floatVal);
+		}
+		else
+		{
+			pushf(0.0f);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(DivVector)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		if (a0.floatVal != 0.0f)
+		{
+			pushv(b2.floatVal / a0.floatVal);
+			pushv(b1.floatVal / a0.floatVal);
+			pushv(b0.floatVal / a0.floatVal);
+		}
+		else
+		{
+			pushv(0.0f);
+			pushv(0.0f);
+			pushv(0.0f);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(ModInt)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		if (a0.intVal != 0)
+		{
+			pushi(b0.intVal % a0.intVal);
+		}
+		else
+		{
+			pushi(0);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(ModFloat)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		if (a0.floatVal != 0.0f)
+		{
+			pushf(Fmod(b0.floatVal, a0.floatVal));
+		}
+		else
+		{
+			pushf(0.0f);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(ModVector)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		if (a0.floatVal != 0.0f)
+		{
+			pushv(Fmod(b2.floatVal, a0.floatVal));
+			pushv(Fmod(b1.floatVal, a0.floatVal));
+			pushv(Fmod(b0.floatVal, a0.floatVal));
+		}
+		else
+		{
+			pushv(0.0f);
+			pushv(0.0f);
+			pushv(0.0f);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Not)
+	{
+		pushb(pop().intVal == 0);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(And)
+	{
+		const bool b = pop().intVal != 0;
+		const bool a = pop().intVal != 0;
+		pushb(a && b);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Or)
+	{
+		const bool b = pop().intVal != 0;
+		const bool a = pop().intVal != 0;
+		pushb(a || b);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EqInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal == b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EqFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal == b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EqVector)
+	{
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		pushb(a0.floatVal == b0.floatVal && a1.floatVal == b1.floatVal && a2.floatVal == b2.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EqObject)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.uintVal == b0.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NeqInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal != b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NeqFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal != b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NeqVector)
+	{
+		const auto b0 = pop();
+		const auto b1 = pop();
+		const auto b2 = pop();
+		const auto a0 = pop();
+		const auto a1 = pop();
+		const auto a2 = pop();
+		pushb(a0.floatVal != b0.floatVal || a1.floatVal != b1.floatVal || a2.floatVal != b2.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(NeqObject)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.uintVal != b0.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(GeqInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal >= b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(GeqFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal >= b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(LeqInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal <= b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(LeqFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal <= b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(GtInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal > b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(GtFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal > b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(LtInt)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.intVal < b0.intVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(LtFloat)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal < b0.floatVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(JmpForward)
+	{
+		LHVM_JUMP_FORWARD();
+	}
+
+	LHVM_OP(JmpBackward)
+	{
+		ip = code[ip].data.uintVal;
+		task.iield = true;
+		goto done;
+	}
+
+	LHVM_OP(Sleep)
+	{
+		const auto seconds = pop().floatVal;
+		task.sleeping = static_cast<uint32_t>(seconds * 10.0f) >= task.ticks;
+		pushb(!task.sleeping);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Except)
+	{
+		task.exceptionHandlerIps.emplace_back(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Zero)
+	{
+		auto& var = GetVar(task, code[ip].data.uintVal);
+		if (var.type == DataType::Object)
+		{
+			RemoveReference(var.value.uintVal);
+		}
+		var.value.floatVal = 0.0f;
+		var.type = DataType::Float;
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Cast)
+	{
+		push(pop(), code[ip].type);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EndExcept)
+	{
+		if (!task.exceptionHandlerIps.empty())
+		{
+			task.exceptionHandlerIps.pop_back();
+		}
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Yield)
+	{
+		task.iield = true;
+		++ip;
+		goto done;
+	}
+
+	LHVM_OP(Line)
+	{
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(Sys)
+	{
+		const auto id = code[ip].data.uintVal;
+		_currentStack->pushCount = 0;
+		_currentStack->popCount = 0;
+#if LHVM_NATIVE_CALL_CALLBACKS
+		InvokeNativeCallEnterCallback(id);
+#endif
+		(*_functions)[id].impl(*this);
+#if LHVM_NATIVE_CALL_CALLBACKS
+		InvokeNativeCallExitCallback(id);
+#endif
+		_currentTask = &task;
+		LHVM_CHECK_NEXT();
+	}
+
+	LHVM_OP(Generic)
+	{
+		const auto& instruction = _instructions[ip];
+		(this->*_opcodesImpl.at(static_cast<int>(instruction.code)))(task, instruction);
+		_currentTask = &task;
+		LHVM_CHECK_NEXT();
+	}
+
+	LHVM_OP(OutOfRange)
+	{
+		throw std::out_of_range("LHVM instruction address out of range");
+	}
+
+	LHVM_OP(PushReferenceImmediate)
+	{
+		pushReference(code[ip].data.uintVal);
+		LHVM_SECOND();
+		push(code[ip].data, code[ip].type);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PushReferenceReference)
+	{
+		pushReference(code[ip].data.uintVal);
+		LHVM_SECOND();
+		pushReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PushImmediatePop)
+	{
+		push(code[ip].data, code[ip].type);
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PushReferencePop)
+	{
+		pushReference(code[ip].data.uintVal);
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(PushReferenceJz)
+	{
+		pushReference(code[ip].data.uintVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(AddFloatPop)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(a0.floatVal + b0.floatVal);
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(SubFloatPop)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(b0.floatVal - a0.floatVal);
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(MulFloatPop)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		pushf(a0.floatVal * b0.floatVal);
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(DivFloatPop)
+	{
+		const auto a0 = pop();
+		const auto b0 = pop();
+		if (a0.floatVal != 0.0f)
+		{
+			pushf(b0.floatVal / a0.floatVal);
+		}
+		else
+		{
+			pushf(0.0f);
+			SignalError(ErrorCode::ErrDivByZero);
+		}
+		LHVM_SECOND();
+		popReference(code[ip].data.uintVal);
+		LHVM_NEXT();
+	}
+
+	LHVM_OP(EqFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal == b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(NeqFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal != b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(GeqFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal >= b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(LeqFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal <= b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(GtFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal > b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(LtFloatJz)
+	{
+		const auto b0 = pop();
+		const auto a0 = pop();
+		pushb(a0.floatVal < b0.floatVal);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+	LHVM_OP(NotJz)
+	{
+		pushb(pop().intVal == 0);
+		LHVM_SECOND();
+		LHVM_JZ_FORWARD();
+	}
+
+#if !LHVM_COMPUTED_GOTO
+	default:
+		assert(false);
+		goto done;
+	}
+#endif
+
+#undef LHVM_JZ_FORWARD
+#undef LHVM_JUMP_FORWARD
+#undef LHVM_SECOND
+#undef LHVM_CHECK_NEXT
+#undef LHVM_NEXT
+#undef LHVM_DISPATCH
+#undef LHVM_OP
+
+done:
+	_currentTask = nullptr;
+}
+
+} // namespace openblack::lhvm
+
+#if LHVM_COMPUTED_GOTO
+#pragma GCC diagnostic pop
+#endif
@@ -0,0 +1,113 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <vector>
+
+#include "LHVMTypes.h"
+
+// Handlers of the threaded core. Each opcode is split by the mode and type it is decoded with, so that the handlers
+// don't have to check them again. Sys calls the natives which have an implementation. Generic runs the reference
+// handler of the original instruction, for the rare opcodes and for operands the reference handlers reject. The handlers
+// after OutOfRange each run a common pair of instructions, the first one at the address they are decoded at and the
+// second one after it.
+#define LHVM_THREADED_OPS(X)  \
+	X(End)                    \
+	X(JzForward)              \
+	X(JzBackward)             \
+	X(PushImmediate)          \
+	X(PushReference)          \
+	X(PopReference)           \
+	X(PopDiscard)             \
+	X(AddInt)                 \
+	X(AddFloat)               \
+	X(AddVector)              \
+	X(SubInt)                 \
+	X(SubFloat)               \
+	X(SubVector)              \
+	X(NegInt)                 \
+	X(NegFloat)               \
+	X(NegVector)              \
+	X(MulInt)                 \
+	X(MulFloat)               \
+	X(MulVector)              \
+	X(DivInt)                 \
+	X(DivFloat)               \
+	X(DivVector)              \
+	X(ModInt)                 \
+	X(ModFloat)               \
+	X(ModVector)              \
+	X(Not)                    \
+	X(And)                    \
+	X(Or)                     \
+	X(EqInt)                  \
+	X(EqFloat)                \
+	X(EqVector)               \
+	X(EqObject)               \
+	X(NeqInt)                 \
+	X(NeqFloat)               \
+	X(NeqVector)              \
+	X(NeqObject)              \
+	X(GeqInt)                 \
+	X(GeqFloat)               \
+	X(LeqInt)                 \
+	X(LeqFloat)               \
+	X(GtInt)                  \
+	X(GtFloat)                \
+	X(LtInt)                  \
+	X(LtFloat)                \
+	X(JmpForward)             \
+	X(JmpBackward)            \
+	X(Sleep)                  \
+	X(Except)                 \
+	X(Zero)                   \
+	X(Cast)                   \
+	X(EndExcept)              \
+	X(Yield)                  \
+	X(Line)                   \
+	X(Sys)                    \
+	X(Generic)                \
+	X(OutOfRange)             \
+	X(PushReferenceImmediate) \
+	X(PushReferenceReference) \
+	X(PushImmediatePop)       \
+	X(PushReferencePop)       \
+	X(PushReferenceJz)        \
+	X(AddFloatPop)            \
+	X(SubFloatPop)            \
+	X(MulFloatPop)            \
+	X(DivFloatPop)            \
+	X(EqFloatJz)              \
+	X(NeqFloatJz)             \
+	X(GeqFloatJz)             \
+	X(LeqFloatJz)             \
+	X(GtFloatJz)              \
+	X(LtFloatJz)              \
+	X(NotJz)
+
+namespace openblack::lhvm
+{
+
+enum class ThreadedOp : uint8_t
+{
+#define LHVM_THREADED_OP_ENUM(name) name,
+	LHVM_THREADED_OPS(LHVM_THREADED_OP_ENUM)
+#undef LHVM_THREADED_OP_ENUM
+	    _Count
+};
+
+/// Handler which runs the instruction, before the line markers after it are skipped and common pairs are fused
+ThreadedOp DecodeThreadedOp(const VMInstruction& instruction, size_t instructionCount,
+                            const std::vector<NativeFunction>* functions);
+
+} // namespace openblack::lhvm
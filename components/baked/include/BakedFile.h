@@ -0,0 +1,248 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <ANMFile.h>
+
+namespace openblack::l3d
+{
+class L3DFile;
+}
+
+namespace openblack::mapped
+{
+class MappedFile;
+}
+
+namespace openblack::baked
+{
+
+enum class BakedResult : uint8_t
+{
+	Success = 0,
+	ErrCantOpen,
+	ErrFileTooSmall,
+	ErrBadMagic,
+	ErrBadVersion,
+	ErrBadKind,
+	ErrBadSpan,
+	ErrTooLarge,
+};
+
+std::string_view ResultToStr(BakedResult result);
+
+enum class BakedKind : uint32_t
+{
+	Mesh = 1,
+	Animation = 2,
+};
+
+/// Hash of the bytes of a source asset, a baked file is only used for the source it was baked from
+uint64_t HashSource(std::span<const uint8_t> source) noexcept;
+
+/// Name of the baked file of a source asset in a cache directory
+std::filesystem::path GetCachePath(const std::filesystem::path& directory, BakedKind kind, uint64_t sourceHash);
+
+struct BakedHeader
+{
+	std::array<char, 4> magic;
+	uint32_t version;
+	BakedKind kind;
+	/// Size of the whole file, to catch truncated files
+	uint32_t size;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+};
+static_assert(sizeof(BakedHeader) == 32);
+
+/// Elements of an array in the file, arrays start on 16 byte boundaries
+struct BakedSpan
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+/// Column major 4x4 matrix
+using BakedMatrix = std::array<float, 16>;
+
+/// Vertex as uploaded to the GPU, bone indices are -1 when unused
+struct BakedVertex
+{
+	std::array<float, 3> position;
+	std::array<float, 2> texCoord;
+	std::array<float, 3> normal;
+	std::array<int16_t, 2> bones;
+};
+static_assert(sizeof(BakedVertex) == 36);
+
+struct BakedPrimitive
+{
+	uint32_t materialType;
+	uint32_t skinId;
+	/// Range of the indices of the submesh drawn by the primitive
+	uint32_t indicesOffset;
+	uint32_t indicesCount;
+	/// In the range [0, 1]
+	float alphaCutoutThreshold;
+};
+
+struct BakedSubmesh
+{
+	/// Bits of l3d::L3DSubmeshHeader::Flags
+	uint32_t flags;
+	/// Bounds of the vertices once moved by their bones
+	std::array<float, 3> minima;
+	std::array<float, 3> maxima;
+	/// BakedVertex
+	BakedSpan vertices;
+	/// uint16_t, offset by the first vertex of each primitive
+	BakedSpan indices;
+	/// BakedPrimitive
+	BakedSpan primitives;
+};
+
+struct BakedSkin
+{
+	uint32_t id;
+	/// uint16_t BGRA4 texels of l3d::L3DTexture::k_Width by l3d::L3DTexture::k_Height
+	BakedSpan texels;
+};
+
+struct BakedFootprintVertex
+{
+	std::array<float, 2> position;
+	/// Normalized to the size of the footprint texture
+	std::array<float, 2> texCoord;
+};
+
+struct BakedFootprint
+{
+	uint32_t width;
+	uint32_t height;
+	/// uint16_t BGRA4 pixels
+	BakedSpan pixels;
+	/// BakedFootprintVertex, three per triangle
+	BakedSpan vertices;
+};
+
+struct BakedMeshHeader
+{
+	/// Bits of l3d::L3DMeshFlags
+	uint32_t flags;
+	uint32_t hasDoorPosition;
+	std::array<float, 3> doorPosition;
+	/// char
+	BakedSpan nameData;
+	/// BakedSkin
+	BakedSpan skins;
+	/// BakedFootprint
+	BakedSpan footprints;
+	/// BakedMatrix
+	BakedSpan extraMetrics;
+	/// uint32_t
+	BakedSpan boneParents;
+	/// BakedMatrix of each bone multiplied by those of its parents
+	BakedSpan boneMatrices;
+	/// BakedSubmesh
+	BakedSpan submeshes;
+};
+
+struct BakedKeyframe
+{
+	uint32_t time;
+	/// Range of the matrices of the keyframe
+	BakedSpan bones;
+};
+
+struct BakedAnimationHeader
+{
+	/// Frame offsets and counts are those of the source file
+	anm::ANMHeader header;
+	uint32_t boneCount;
+	/// False if a bone matrix has scale or shear, or if keyframes have different bone counts. The rotations and
+	/// translations of such keyframes can't reproduce their matrices.
+	uint32_t rigid;
+	/// BakedKeyframe
+	BakedSpan keyframes;
+	/// BakedMatrix
+	BakedSpan matrices;
+	/// uint32_t time of each keyframe
+	BakedSpan times;
+	/// std::array<float, 4> x, y, z, w quaternion of each bone of the keyframes which have boneCount bones
+	BakedSpan rotations;
+	/// std::array<float, 3> of each bone of the keyframes which have boneCount bones
+	BakedSpan translations;
+};
+
+/**
+  This class is used to read and write meshes and animations which have been converted to the layout used by the engine.
+
+  Baked files can be memory mapped and their arrays handed to the GPU without being copied.
+ */
+class BakedFile
+{
+public:
+	static constexpr uint32_t k_Version = 1;
+
+	BakedFile() noexcept;
+	virtual ~BakedFile() noexcept;
+	BakedFile(const BakedFile&) = delete;
+	BakedFile& operator=(const BakedFile&) = delete;
+
+	/// Map a baked file from the filesystem
+	BakedResult Open(const std::filesystem::path& filepath) noexcept;
+	/// Read a baked file from a buffer
+	BakedResult Open(std::vector<uint8_t> buffer) noexcept;
+	/// Write baked file to path on the filesystem
+	BakedResult Write(const std::filesystem::path& filepath) const noexcept;
+
+	/// Convert a mesh, the source is the file it was read from and may be empty when it is not going to be cached
+	BakedResult BakeMesh(const l3d::L3DFile& l3d, std::span<const uint8_t> source) noexcept;
+	/// Convert an animation, the source is the file it was read from and may be empty when it is not going to be cached
+	BakedResult BakeAnimation(const anm::ANMFile& anm, std::span<const uint8_t> source) noexcept;
+
+	[[nodiscard]] std::span<const uint8_t> GetData() const noexcept { return _data; }
+	[[nodiscard]] const BakedHeader& GetHeader() const noexcept { return *reinterpret_cast<const BakedHeader*>(_data.data()); }
+	[[nodiscard]] const BakedMeshHeader& GetMeshHeader() const noexcept
+	{
+		return *reinterpret_cast<const BakedMeshHeader*>(_data.data() + sizeof(BakedHeader));
+	}
+	[[nodiscard]] const BakedAnimationHeader& GetAnimationHeader() const noexcept
+	{
+		return *reinterpret_cast<const BakedAnimationHeader*>(_data.data() + sizeof(BakedHeader));
+	}
+	/// Spans are checked when the file is opened
+	template <typename T>
+	[[nodiscard]] std::span<const T> Get(BakedSpan span) const noexcept
+	{
+		return {reinterpret_cast<const T*>(_data.data() + span.offset), span.count};
+	}
+
+private:
+	/// Check the header and that all arrays are in the file
+	BakedResult Validate() const noexcept;
+
+	/// Memory mapping of the file when opened from the filesystem
+	std::unique_ptr<mapped::MappedFile> _mapping;
+	/// Contents of the file when baked or read from a buffer
+	std::vector<uint8_t> _buffer;
+	std::span<const uint8_t> _data;
+};
+
+} // namespace openblack::baked
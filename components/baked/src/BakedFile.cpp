@@ -0,0 +1,722 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+/*
+ * The layout of a Baked File is as follows:
+ *
+ * - 32 byte header containing:
+ *         4 char magic "OBBK"
+ *         version of the layout, files of other versions are rejected
+ *         kind - 1 for a mesh, 2 for an animation
+ *         size of the whole file
+ *         hash of the source file (see HashSource)
+ *         size of the source file
+ * - mesh or animation header (see BakedMeshHeader and BakedAnimationHeader)
+ * - arrays referenced by the headers with offsets from the start of the file
+ *   and element counts, each starting on a 16 byte boundary. Arrays of
+ *   structures which hold spans are written after the arrays they reference.
+ *
+ * Values are stored in the byte order of the machine which baked them, caches
+ * are not meant to be shared between machines.
+ *
+ */
+
+#include "BakedFile.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+#include <L3DFile.h>
+#include <MappedFile.h>
+
+using namespace openblack::baked;
+
+namespace
+{
+constexpr const std::array<char, 4> k_Magic = {'O', 'B', 'B', 'K'};
+constexpr uint32_t k_Alignment = 16;
+
+/// Appends arrays to a baked file, the headers are written last
+class Writer
+{
+public:
+	explicit Writer(std::size_t headerSize)
+	    : _data(headerSize)
+	{
+	}
+
+	template <typename T>
+	BakedSpan Append(std::span<const T> values)
+	{
+		const auto offset = (_data.size() + k_Alignment - 1) & ~static_cast<std::size_t>(k_Alignment - 1);
+		_data.resize(offset + values.size_bytes());
+		if (!values.empty())
+		{
+			std::memcpy(_data.data() + offset, values.data(), values.size_bytes());
+		}
+		return {static_cast<uint32_t>(offset), static_cast<uint32_t>(values.size())};
+	}
+
+	template <typename T>
+	BakedSpan Append(const std::vector<T>& values)
+	{
+		return Append(std::span<const T>(values));
+	}
+
+	template <typename T>
+	void Write(std::size_t offset, const T& value)
+	{
+		std::memcpy(_data.data() + offset, &value, sizeof(value));
+	}
+
+	[[nodiscard]] std::size_t GetSize() const noexcept { return _data.size(); }
+	std::vector<uint8_t> Release() { return std::move(_data); }
+
+private:
+	std::vector<uint8_t> _data;
+};
+
+BakedMatrix Multiply(const BakedMatrix& a, const BakedMatrix& b) noexcept
+{
+	BakedMatrix result {};
+	for (uint32_t column = 0; column < 4; ++column)
+	{
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			float sum = 0.0f;
+			for (uint32_t k = 0; k < 4; ++k)
+			{
+				sum += a[k * 4 + row] * b[column * 4 + k];
+			}
+			result[column * 4 + row] = sum;
+		}
+	}
+	return result;
+}
+
+std::array<float, 3> Transform(const BakedMatrix& m, const std::array<float, 3>& p) noexcept
+{
+	std::array<float, 3> result {};
+	for (uint32_t row = 0; row < 3; ++row)
+	{
+		result[row] = m[0 * 4 + row] * p[0] + m[1 * 4 + row] * p[1] + m[2 * 4 + row] * p[2] + m[3 * 4 + row];
+	}
+	return result;
+}
+
+constexpr BakedMatrix k_Identity = {
+    1.0f, 0.0f, 0.0f, 0.0f, //
+    0.0f, 1.0f, 0.0f, 0.0f, //
+    0.0f, 0.0f, 1.0f, 0.0f, //
+    0.0f, 0.0f, 0.0f, 1.0f, //
+};
+
+/// Matrix of a rotation followed by a translation, as stored by l3d extra metrics and anm keyframes
+BakedMatrix FromAffine(const std::array<float, 12>& m) noexcept
+{
+	return {
+	    m[0], m[1], m[2],  0.0f, //
+	    m[3], m[4], m[5],  0.0f, //
+	    m[6], m[7], m[8],  0.0f, //
+	    m[9], m[10], m[11], 1.0f, //
+	};
+}
+
+/// Rotation of the upper 3x3 of a matrix, same branches as glm::quat_cast
+std::array<float, 4> ToQuaternion(const BakedMatrix& m) noexcept
+{
+	const auto at = [&m](uint32_t column, uint32_t row) { return m[column * 4 + row]; };
+
+	const float fourXSquaredMinus1 = at(0, 0) - at(1, 1) - at(2, 2);
+	const float fourYSquaredMinus1 = at(1, 1) - at(0, 0) - at(2, 2);
+	const float fourZSquaredMinus1 = at(2, 2) - at(0, 0) - at(1, 1);
+	const float fourWSquaredMinus1 = at(0, 0) + at(1, 1) + at(2, 2);
+
+	uint32_t biggestIndex = 0;
+	float fourBiggestSquaredMinus1 = fourWSquaredMinus1;
+	if (fourXSquaredMinus1 > fourBiggestSquaredMinus1)
+	{
+		fourBiggestSquaredMinus1 = fourXSquaredMinus1;
+		biggestIndex = 1;
+	}
+	if (fourYSquaredMinus1 > fourBiggestSquaredMinus1)
+	{
+		fourBiggestSquaredMinus1 = fourYSquaredMinus1;
+		biggestIndex = 2;
+	}
+	if (fourZSquaredMinus1 > fourBiggestSquaredMinus1)
+	{
+		fourBiggestSquaredMinus1 = fourZSquaredMinus1;
+		biggestIndex = 3;
+	}
+
+	const float biggestValue = std::sqrt(fourBiggestSquaredMinus1 + 1.0f) * 0.5f;
+	const float mult = 0.25f / biggestValue;
+
+	// x, y, z, w
+	switch (biggestIndex)
+	{
+	case 0:
+		return {(at(1, 2) - at(2, 1)) * mult, (at(2, 0) - at(0, 2)) * mult, (at(0, 1) - at(1, 0)) * mult, biggestValue};
+	case 1:
+		return {biggestValue, (at(0, 1) + at(1, 0)) * mult, (at(2, 0) + at(0, 2)) * mult, (at(1, 2) - at(2, 1)) * mult};
+	case 2:
+		return {(at(0, 1) + at(1, 0)) * mult, biggestValue, (at(1, 2) + at(2, 1)) * mult, (at(2, 0) - at(0, 2)) * mult};
+	default:
+		return {(at(2, 0) + at(0, 2)) * mult, (at(1, 2) + at(2, 1)) * mult, biggestValue, (at(0, 1) - at(1, 0)) * mult};
+	}
+}
+
+/// True if the rotation reproduces the upper 3x3 of the matrix
+bool IsRigid(const BakedMatrix& m, const std::array<float, 4>& q) noexcept
+{
+	const auto [x, y, z, w] = q;
+	// Columns of the rotation matrix, same as glm::mat3_cast
+	const std::array<float, 9> r = {
+	    1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z),        2.0f * (x * z - w * y),        //
+	    2.0f * (x * y - w * z),        1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x),        //
+	    2.0f * (x * z + w * y),        2.0f * (y * z - w * x),        1.0f - 2.0f * (x * x + y * y), //
+	};
+	constexpr float epsilon = 1e-3f;
+	for (uint32_t column = 0; column < 3; ++column)
+	{
+		for (uint32_t row = 0; row < 3; ++row)
+		{
+			if (!(std::abs(r[column * 3 + row] - m[column * 4 + row]) < epsilon))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+BakedSubmesh BakeSubmesh(const openblack::l3d::L3DFile& l3d, uint32_t submeshIndex, Writer& writer)
+{
+	const auto& header = l3d.GetSubmeshHeaders()[submeshIndex];
+	const auto primitiveSpan = l3d.GetPrimitiveSpan(submeshIndex);
+	const auto& verticesSpan = l3d.GetVertexSpan(submeshIndex);
+	const auto& indexSpan = l3d.GetIndexSpan(submeshIndex);
+	const auto& vertexGroupSpans = l3d.GetVertexGroupSpan(submeshIndex);
+	const auto& boneSpans = l3d.GetBoneSpan(submeshIndex);
+
+	BakedSubmesh submesh {};
+	std::memcpy(&submesh.flags, &header.flags, sizeof(submesh.flags));
+
+	uint32_t nVertices = 0;
+	uint32_t nIndices = 0;
+	for (const auto& primitive : primitiveSpan)
+	{
+		nVertices += primitive.numVertices;
+		nIndices += primitive.numTriangles * 3;
+	}
+	nVertices = std::min(nVertices, static_cast<uint32_t>(verticesSpan.size()));
+	nIndices = std::min(nIndices, static_cast<uint32_t>(indexSpan.size()));
+
+	// Bounding box of the vertices moved by their bones
+	submesh.minima.fill(std::numeric_limits<float>::max());
+	submesh.maxima.fill(-std::numeric_limits<float>::max());
+	const auto expand = [&submesh](const std::array<float, 3>& position) {
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			submesh.minima[k] = std::min(submesh.minima[k], position[k]);
+			submesh.maxima[k] = std::max(submesh.maxima[k], position[k]);
+		}
+	};
+	if (header.flags.hasBones)
+	{
+		for (const auto& primitive : primitiveSpan)
+		{
+			uint32_t vertexOffset = 0;
+			for (uint32_t i = 0; i < std::min<std::size_t>(primitive.numGroups, vertexGroupSpans.size()); ++i)
+			{
+				auto matrix = k_Identity;
+				for (uint32_t parent = vertexGroupSpans[i].boneIndex; parent < boneSpans.size();
+				     parent = boneSpans[parent].parent)
+				{
+					const auto& o = boneSpans[parent].orientation;
+					const auto& p = boneSpans[parent].position;
+					// The bone position is in the rotated space of the bone
+					const std::array<float, 3> translation = {
+					    p.x * o[0] + p.y * o[1] + p.z * o[2],
+					    p.x * o[3] + p.y * o[4] + p.z * o[5],
+					    p.x * o[6] + p.y * o[7] + p.z * o[8],
+					};
+					auto local = FromAffine({o[0], o[1], o[2], o[3], o[4], o[5], o[6], o[7], o[8], 0.0f, 0.0f, 0.0f});
+					const auto rotatedTranslation = Transform(local, translation);
+					local[12] = rotatedTranslation[0];
+					local[13] = rotatedTranslation[1];
+					local[14] = rotatedTranslation[2];
+					matrix = Multiply(local, matrix);
+				}
+
+				for (uint32_t j = 0; j < vertexGroupSpans[i].vertexCount && vertexOffset + j < verticesSpan.size(); ++j)
+				{
+					const auto& vertex = verticesSpan[vertexOffset + j];
+					expand(Transform(matrix, {vertex.position.x, vertex.position.y, vertex.position.z}));
+				}
+				vertexOffset += vertexGroupSpans[i].vertexCount;
+			}
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < nVertices; i++)
+		{
+			expand({verticesSpan[i].position.x, verticesSpan[i].position.y, verticesSpan[i].position.z});
+		}
+	}
+
+	std::vector<BakedVertex> vertices(nVertices);
+	for (uint32_t i = 0; i < nVertices; ++i)
+	{
+		const auto& vertex = verticesSpan[i];
+		vertices[i] = {
+		    .position = {vertex.position.x, vertex.position.y, vertex.position.z},
+		    .texCoord = {vertex.texCoord.x, vertex.texCoord.y},
+		    // TODO(bwrsandman): build normals from mesh
+		    .normal = {vertex.normal.x, vertex.normal.y, vertex.normal.z},
+		    .bones = {-1, -1},
+		};
+	}
+	uint32_t vertexIndex = 0;
+	for (const auto& vertexGroup : vertexGroupSpans)
+	{
+		for (uint32_t i = 0; i < vertexGroup.vertexCount && vertexIndex < nVertices; ++i)
+		{
+			vertices[vertexIndex].bones[0] = static_cast<int16_t>(vertexGroup.boneIndex);
+			++vertexIndex;
+		}
+	}
+
+	// Indices of primitives are relative to their first vertex, offset them for the merged vertex buffer
+	std::vector<uint16_t> indices(nIndices);
+	std::vector<BakedPrimitive> primitives;
+	primitives.reserve(primitiveSpan.size());
+	uint32_t startIndex = 0;
+	uint16_t startVertex = 0;
+	for (const auto& primitive : primitiveSpan)
+	{
+		const auto count = std::min(primitive.numTriangles * 3, nIndices - std::min(startIndex, nIndices));
+		for (uint32_t j = 0; j < count; j++)
+		{
+			indices[startIndex + j] = static_cast<uint16_t>(indexSpan[startIndex + j] + startVertex);
+		}
+
+		primitives.push_back({
+		    .materialType = static_cast<uint32_t>(primitive.material.type),
+		    .skinId = primitive.material.skinID,
+		    .indicesOffset = startIndex,
+		    .indicesCount = primitive.numTriangles * 3,
+		    .alphaCutoutThreshold = primitive.material.alphaCutoutThreshold / 255.0f,
+		});
+
+		startVertex += static_cast<uint16_t>(primitive.numVertices);
+		startIndex += primitive.numTriangles * 3;
+	}
+
+	submesh.vertices = writer.Append(vertices);
+	submesh.indices = writer.Append(indices);
+	submesh.primitives = writer.Append(primitives);
+	return submesh;
+}
+
+template <typename T>
+bool IsInFile(BakedSpan span, std::size_t size) noexcept
+{
+	const auto end = static_cast<uint64_t>(span.offset) + static_cast<uint64_t>(span.count) * sizeof(T);
+	return end <= size && (span.count == 0 || span.offset % k_Alignment == 0);
+}
+} // namespace
+
+std::string_view openblack::baked::ResultToStr(BakedResult result)
+{
+	switch (result)
+	{
+	case BakedResult::Success:
+		return "Success";
+	case BakedResult::ErrCantOpen:
+		return "Could not open file.";
+	case BakedResult::ErrFileTooSmall:
+		return "File too small to be a valid Baked file.";
+	case BakedResult::ErrBadMagic:
+		return "Unrecognized Baked header.";
+	case BakedResult::ErrBadVersion:
+		return "Baked file was written by another version.";
+	case BakedResult::ErrBadKind:
+		return "Unknown kind of baked asset.";
+	case BakedResult::ErrBadSpan:
+		return "Baked array is outside of the file or misaligned.";
+	case BakedResult::ErrTooLarge:
+		return "Asset is too large to be baked.";
+	}
+	return "Unknown error";
+}
+
+uint64_t openblack::baked::HashSource(std::span<const uint8_t> source) noexcept
+{
+	// FNV-1a over 64 bit words, each word is mixed first so that all of its bits affect the low bits of the hash
+	constexpr uint64_t k_Prime = 0x100000001b3;
+	uint64_t hash = 0xcbf29ce484222325;
+	std::size_t i = 0;
+	for (; i + sizeof(uint64_t) <= source.size(); i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, source.data() + i, sizeof(word));
+		word *= 0x9e3779b97f4a7c15;
+		word ^= word >> 29;
+		hash = (hash ^ word) * k_Prime;
+	}
+	for (; i < source.size(); ++i)
+	{
+		hash = (hash ^ source[i]) * k_Prime;
+	}
+	return hash;
+}
+
+std::filesystem::path openblack::baked::GetCachePath(const std::filesystem::path& directory, BakedKind kind,
+                                                     uint64_t sourceHash)
+{
+	std::array<char, 24> name {};
+	std::snprintf(name.data(), name.size(), "%016llx.%s", static_cast<unsigned long long>(sourceHash),
+	              kind == BakedKind::Mesh ? "mesh" : "anim");
+	return directory / name.data();
+}
+
+BakedFile::BakedFile() noexcept = default;
+
+BakedFile::~BakedFile() noexcept = default;
+
+BakedResult BakedFile::Validate() const noexcept
+{
+	if (_data.size() < sizeof(BakedHeader))
+	{
+		return BakedResult::ErrFileTooSmall;
+	}
+
+	const auto& header = GetHeader();
+	if (header.magic != k_Magic)
+	{
+		return BakedResult::ErrBadMagic;
+	}
+	if (header.version != k_Version)
+	{
+		return BakedResult::ErrBadVersion;
+	}
+	if (header.size != _data.size())
+	{
+		return BakedResult::ErrFileTooSmall;
+	}
+
+	const auto size = _data.size();
+	bool valid = true;
+	switch (header.kind)
+	{
+	case BakedKind::Mesh:
+	{
+		if (size < sizeof(BakedHeader) + sizeof(BakedMeshHeader))
+		{
+			return BakedResult::ErrFileTooSmall;
+		}
+		const auto& mesh = GetMeshHeader();
+		valid = IsInFile<char>(mesh.nameData, size) && IsInFile<BakedMatrix>(mesh.extraMetrics, size) &&
+		        IsInFile<uint32_t>(mesh.boneParents, size) && IsInFile<BakedMatrix>(mesh.boneMatrices, size) &&
+		        IsInFile<BakedSkin>(mesh.skins, size) && IsInFile<BakedFootprint>(mesh.footprints, size) &&
+		        IsInFile<BakedSubmesh>(mesh.submeshes, size);
+		if (!valid)
+		{
+			break;
+		}
+		for (const auto& skin : Get<BakedSkin>(mesh.skins))
+		{
+			valid = valid && IsInFile<uint16_t>(skin.texels, size);
+		}
+		for (const auto& footprint : Get<BakedFootprint>(mesh.footprints))
+		{
+			valid = valid && IsInFile<uint16_t>(footprint.pixels, size) &&
+			        IsInFile<BakedFootprintVertex>(footprint.vertices, size);
+		}
+		for (const auto& submesh : Get<BakedSubmesh>(mesh.submeshes))
+		{
+			valid = valid && IsInFile<BakedVertex>(submesh.vertices, size) && IsInFile<uint16_t>(submesh.indices, size) &&
+			        IsInFile<BakedPrimitive>(submesh.primitives, size);
+		}
+		break;
+	}
+	case BakedKind::Animation:
+	{
+		if (size < sizeof(BakedHeader) + sizeof(BakedAnimationHeader))
+		{
+			return BakedResult::ErrFileTooSmall;
+		}
+		const auto& animation = GetAnimationHeader();
+		valid = IsInFile<BakedMatrix>(animation.matrices, size) && IsInFile<uint32_t>(animation.times, size) &&
+		        IsInFile<std::array<float, 4>>(animation.rotations, size) &&
+		        IsInFile<std::array<float, 3>>(animation.translations, size) &&
+		        IsInFile<BakedKeyframe>(animation.keyframes, size);
+		if (!valid)
+		{
+			break;
+		}
+		for (const auto& keyframe : Get<BakedKeyframe>(animation.keyframes))
+		{
+			valid = valid && IsInFile<BakedMatrix>(keyframe.bones, size);
+		}
+		break;
+	}
+	default:
+		return BakedResult::ErrBadKind;
+	}
+
+	return valid ? BakedResult::Success : BakedResult::ErrBadSpan;
+}
+
+BakedResult BakedFile::Open(const std::filesystem::path& filepath) noexcept
+{
+	assert(_data.empty());
+
+	_mapping = mapped::MappedFile::Map(filepath, mapped::Access::Whole);
+	if (_mapping == nullptr)
+	{
+		return BakedResult::ErrCantOpen;
+	}
+	_data = _mapping->GetData();
+
+	const auto result = Validate();
+	if (result != BakedResult::Success)
+	{
+		_data = {};
+		_mapping.reset();
+	}
+	return result;
+}
+
+BakedResult BakedFile::Open(std::vector<uint8_t> buffer) noexcept
+{
+	assert(_data.empty());
+
+	_buffer = std::move(buffer);
+	_data = _buffer;
+
+	const auto result = Validate();
+	if (result != BakedResult::Success)
+	{
+		_data = {};
+		_buffer.clear();
+	}
+	return result;
+}
+
+BakedResult BakedFile::Write(const std::filesystem::path& filepath) const noexcept
+{
+	assert(!_data.empty());
+
+	std::ofstream stream(filepath, std::ios::binary);
+	if (!stream.is_open())
+	{
+		return BakedResult::ErrCantOpen;
+	}
+
+	stream.write(reinterpret_cast<const char*>(_data.data()), static_cast<std::streamsize>(_data.size()));
+	return stream.good() ? BakedResult::Success : BakedResult::ErrCantOpen;
+}
+
+BakedResult BakedFile::BakeMesh(const l3d::L3DFile& l3d, std::span<const uint8_t> source) noexcept
+{
+	assert(_data.empty());
+
+	Writer writer(sizeof(BakedHeader) + sizeof(BakedMeshHeader));
+	BakedMeshHeader mesh {};
+	mesh.flags = static_cast<uint32_t>(l3d.GetHeader().flags);
+	const auto hasFlag = [&mesh](l3d::L3DMeshFlags flag) { return (mesh.flags & static_cast<uint32_t>(flag)) != 0; };
+
+	if (hasFlag(l3d::L3DMeshFlags::HasDoorPosition) && !l3d.GetExtraPoints().empty())
+	{
+		const auto& door = l3d.GetExtraPoints()[0];
+		mesh.hasDoorPosition = 1;
+		mesh.doorPosition = {door.x, door.y, door.z};
+	}
+
+	mesh.nameData = writer.Append(std::span<const char>(l3d.GetNameData()));
+
+	std::vector<BakedSkin> skins;
+	skins.reserve(l3d.GetSkins().size());
+	for (const auto& skin : l3d.GetSkins())
+	{
+		skins.push_back({skin.id, writer.Append(std::span<const l3d::L3DTexture::RGBA4>(skin.texels))});
+	}
+	mesh.skins = writer.Append(skins);
+
+	std::vector<BakedFootprint> footprints;
+	if (hasFlag(l3d::L3DMeshFlags::ContainsLandscapeFeature) && l3d.GetFootprint().has_value())
+	{
+		const auto& footprint = *l3d.GetFootprint();
+		const auto width = static_cast<float>(footprint.header.width);
+		const auto height = static_cast<float>(footprint.header.height);
+		for (const auto& entry : footprint.entries)
+		{
+			std::vector<BakedFootprintVertex> vertices;
+			vertices.reserve(entry.triangles.size() * 3);
+			for (const auto& triangle : entry.triangles)
+			{
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					vertices.push_back({
+					    .position = {triangle.world[k].x, triangle.world[k].y},
+					    .texCoord = {triangle.texture[k].x / width, triangle.texture[k].y / height},
+					});
+				}
+			}
+			footprints.push_back({
+			    .width = footprint.header.width,
+			    .height = footprint.header.height,
+			    .pixels = writer.Append(entry.pixels),
+			    .vertices = writer.Append(vertices),
+			});
+		}
+	}
+	mesh.footprints = writer.Append(footprints);
+
+	std::vector<BakedMatrix> extraMetrics;
+	if (hasFlag(l3d::L3DMeshFlags::ContainsExtraMetrics))
+	{
+		extraMetrics.reserve(l3d.GetExtraMetrics().size());
+		for (const auto& metric : l3d.GetExtraMetrics())
+		{
+			extraMetrics.push_back(FromAffine(metric));
+		}
+	}
+	mesh.extraMetrics = writer.Append(extraMetrics);
+
+	const auto& bones = l3d.GetBones();
+	std::vector<uint32_t> boneParents(bones.size());
+	std::vector<BakedMatrix> boneMatrices(bones.size());
+	for (uint32_t i = 0; i < bones.size(); ++i)
+	{
+		const auto& bone = bones[i];
+		const auto& o = bone.orientation;
+		auto matrix = FromAffine({o[0], o[1], o[2], o[3], o[4], o[5], o[6], o[7], o[8], bone.position.x, bone.position.y,
+		                          bone.position.z});
+		boneParents[i] = bone.parent;
+		// Parents come before their children, other references are treated as identity
+		if (bone.parent < i)
+		{
+			matrix = Multiply(boneMatrices[bone.parent], matrix);
+		}
+		boneMatrices[i] = matrix;
+	}
+	mesh.boneParents = writer.Append(boneParents);
+	mesh.boneMatrices = writer.Append(boneMatrices);
+
+	std::vector<BakedSubmesh> submeshes;
+	submeshes.reserve(l3d.GetSubmeshHeaders().size());
+	for (uint32_t i = 0; i < l3d.GetSubmeshHeaders().size(); ++i)
+	{
+		submeshes.push_back(BakeSubmesh(l3d, i, writer));
+	}
+	mesh.submeshes = writer.Append(submeshes);
+
+	if (writer.GetSize() > std::numeric_limits<uint32_t>::max())
+	{
+		return BakedResult::ErrTooLarge;
+	}
+	const BakedHeader header = {
+	    .magic = k_Magic,
+	    .version = k_Version,
+	    .kind = BakedKind::Mesh,
+	    .size = static_cast<uint32_t>(writer.GetSize()),
+	    .sourceHash = HashSource(source),
+	    .sourceSize = source.size(),
+	};
+	writer.Write(0, header);
+	writer.Write(sizeof(BakedHeader), mesh);
+
+	return Open(writer.Release());
+}
+
+BakedResult BakedFile::BakeAnimation(const anm::ANMFile& anm, std::span<const uint8_t> source) noexcept
+{
+	assert(_data.empty());
+
+	Writer writer(sizeof(BakedHeader) + sizeof(BakedAnimationHeader));
+	BakedAnimationHeader animation {};
+	animation.header = anm.GetHeader();
+
+	const auto& keyframes = anm.GetKeyframes();
+	animation.boneCount = keyframes.empty() ? 0 : static_cast<uint32_t>(keyframes[0].bones.size());
+	animation.rigid = 1;
+
+	std::vector<BakedMatrix> matrices;
+	std::vector<uint32_t> times;
+	std::vector<std::array<float, 4>> rotations;
+	std::vector<std::array<float, 3>> translations;
+	times.reserve(keyframes.size());
+	rotations.reserve(keyframes.size() * animation.boneCount);
+	translations.reserve(keyframes.size() * animation.boneCount);
+	for (const auto& keyframe : keyframes)
+	{
+		times.push_back(keyframe.time);
+		for (const auto& bone : keyframe.bones)
+		{
+			matrices.push_back(FromAffine(bone.matrix));
+		}
+
+		// Decompose into rotations and translations for interpolation
+		if (keyframe.bones.size() != animation.boneCount)
+		{
+			animation.rigid = 0;
+			continue;
+		}
+		for (auto bone = matrices.end() - animation.boneCount; bone != matrices.end(); ++bone)
+		{
+			const auto rotation = ToQuaternion(*bone);
+			rotations.push_back(rotation);
+			translations.push_back({(*bone)[12], (*bone)[13], (*bone)[14]});
+			animation.rigid = animation.rigid != 0 && IsRigid(*bone, rotation) ? 1 : 0;
+		}
+	}
+	animation.matrices = writer.Append(matrices);
+	animation.times = writer.Append(times);
+	animation.rotations = writer.Append(rotations);
+	animation.translations = writer.Append(translations);
+
+	std::vector<BakedKeyframe> bakedKeyframes;
+	bakedKeyframes.reserve(keyframes.size());
+	auto offset = animation.matrices.offset;
+	for (const auto& keyframe : keyframes)
+	{
+		const auto count = static_cast<uint32_t>(keyframe.bones.size());
+		bakedKeyframes.push_back({keyframe.time, {offset, count}});
+		offset += count * static_cast<uint32_t>(sizeof(BakedMatrix));
+	}
+	animation.keyframes = writer.Append(bakedKeyframes);
+
+	if (writer.GetSize() > std::numeric_limits<uint32_t>::max())
+	{
+		return BakedResult::ErrTooLarge;
+	}
+	const BakedHeader header = {
+	    .magic = k_Magic,
+	    .version = k_Version,
+	    .kind = BakedKind::Animation,
+	    .size = static_cast<uint32_t>(writer.GetSize()),
+	    .sourceHash = HashSource(source),
+	    .sourceSize = source.size(),
+	};
+	writer.Write(0, header);
+	writer.Write(sizeof(BakedHeader), animation);
+
+	return Open(writer.Release());
+}
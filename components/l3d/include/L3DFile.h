@@ -346,7 +346,7 @@ class L3DFile
 	L3DResult Open(const std::filesystem::path& filepath) noexcept;
 
 	/// Read l3d file from a buffer
-	L3DResult Open(const std::vector<uint8_t>& buffer) noexcept;
+	L3DResult Open(std::span<const uint8_t> buffer) noexcept;
 
 	/// Write l3d file to path on the filesystem
 	L3DResult Write(const std::filesystem::path& filepath) noexcept;
@@ -872,11 +872,11 @@ L3DResult L3DFile::Open(const std::filesystem::path& filepath) noexcept
 	return ReadFile(stream);
 }
 
-L3DResult L3DFile::Open(const std::vector<uint8_t>& buffer) noexcept
+L3DResult L3DFile::Open(std::span<const uint8_t> buffer) noexcept
 {
 	assert(!_isLoaded);
 
-	imemstream stream(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(buffer[0]));
+	imemstream stream(reinterpret_cast<const char*>(buffer.data()), buffer.size());
 
 	return ReadFile(stream);
 }
@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace openblack::mapped
+{
+
+/// How the mapped file is going to be read, passed on to the OS as a paging hint
+enum class Access : uint8_t
+{
+	/// Parts of the file are read in no particular order, such as the members of an archive
+	Random,
+	/// The whole file is read shortly after being mapped, so it is paged in ahead of use
+	Whole,
+};
+
+/// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	/// Returns nullptr when the file can't be mapped
+	static std::unique_ptr<MappedFile> Map(const std::filesystem::path& filepath, Access access) noexcept;
+
+	MappedFile() noexcept = default;
+	~MappedFile() noexcept;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	[[nodiscard]] std::span<const uint8_t> GetData() const noexcept { return {_data, _size}; }
+
+private:
+	const uint8_t* _data {nullptr};
+	std::size_t _size {0};
+#ifdef _WIN32
+	void* _file {nullptr};
+	void* _fileMapping {nullptr};
+#endif
+};
+
+} // namespace openblack::mapped
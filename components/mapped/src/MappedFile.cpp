@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace openblack::mapped;
+
+#ifdef _WIN32
+std::unique_ptr<MappedFile> MappedFile::Map(const std::filesystem::path& filepath, Access access) noexcept
+{
+	auto mapping = std::make_unique<MappedFile>();
+	const DWORD accessFlag = access == Access::Whole ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+	auto* file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+	                         FILE_ATTRIBUTE_NORMAL | accessFlag, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return nullptr;
+	}
+	mapping->_file = file;
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(file, &size) == 0 || size.QuadPart == 0)
+	{
+		return nullptr;
+	}
+
+	mapping->_fileMapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping->_fileMapping == nullptr)
+	{
+		return nullptr;
+	}
+
+	mapping->_data = static_cast<const uint8_t*>(MapViewOfFile(mapping->_fileMapping, FILE_MAP_READ, 0, 0, 0));
+	if (mapping->_data == nullptr)
+	{
+		return nullptr;
+	}
+	mapping->_size = static_cast<std::size_t>(size.QuadPart);
+
+	return mapping;
+}
+
+MappedFile::~MappedFile() noexcept
+{
+	if (_data != nullptr)
+	{
+		UnmapViewOfFile(_data);
+	}
+	if (_fileMapping != nullptr)
+	{
+		CloseHandle(_fileMapping);
+	}
+	if (_file != nullptr)
+	{
+		CloseHandle(_file);
+	}
+}
+#else
+std::unique_ptr<MappedFile> MappedFile::Map(const std::filesystem::path& filepath, Access access) noexcept
+{
+	const int fd = open(filepath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return nullptr;
+	}
+
+	struct stat status = {};
+	if (fstat(fd, &status) != 0 || status.st_size <= 0)
+	{
+		close(fd);
+		return nullptr;
+	}
+
+	const auto size = static_cast<std::size_t>(status.st_size);
+	void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the descriptor is closed
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return nullptr;
+	}
+	if (access == Access::Whole)
+	{
+		madvise(data, size, MADV_WILLNEED);
+	}
+
+	auto mapping = std::make_unique<MappedFile>();
+	mapping->_data = static_cast<const uint8_t*>(data);
+	mapping->_size = size;
+
+	return mapping;
+}
+
+MappedFile::~MappedFile() noexcept
+{
+	if (_data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(_data), _size);
+	}
+}
+#endif
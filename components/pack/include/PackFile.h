@@ -14,10 +14,16 @@
 #include <istream>
 #include <map>
 #include <memory>
+#include <span>
 #include <streambuf>
 #include <string>
 #include <vector>
 
+namespace openblack::mapped
+{
+class MappedFile;
+}
+
 namespace openblack::pack
 {
 
@@ -42,6 +48,7 @@ enum class PackResult : uint8_t
 	ErrMissingMeshBlock,
 	ErrMeshBlockHeaderMalformed,
 	ErrNotImplemented,
+	ErrAssetNotFound,
 };
 
 std::string_view ResultToStr(PackResult result);
@@ -108,7 +115,8 @@ struct G3DTexture
 {
 	G3DTextureHeader header;
 	DdsHeader ddsHeader;
-	std::vector<uint8_t> ddsData;
+	/// View into the pack's data
+	std::span<const uint8_t> ddsData;
 };
 
 enum class AudioBankLoop : uint16_t
@@ -178,31 +186,61 @@ struct AudioBankSampleHeader
 
 /**
   This class is used to read LionHead Packs files
+
+  Blocks and the assets in them are exposed as views into a single buffer holding the whole file. When opened from
+  the filesystem the file is memory mapped, falling back to reading it when mapping is not possible. Nothing is copied
+  out of the buffer until a consumer asks for it.
  */
 class PackFile
 {
 protected:
 	static constexpr const std::array<char, 8> k_Magic = {'L', 'i', 'O', 'n', 'H', 'e', 'A', 'd'};
 
+	struct AnimationView
+	{
+		std::span<const uint8_t> header;
+		std::span<const uint8_t> body;
+	};
+
 	/// True when a file has been loaded
 	bool _isLoaded {false};
-
-	std::map<std::string, std::vector<uint8_t>> _blocks;
+	/// True when only the look-up tables were read and assets are extracted on request
+	bool _isIndexOnly {false};
+
+	/// Memory mapping of the file when opened from the filesystem
+	std::unique_ptr<mapped::MappedFile> _mapping;
+	/// Contents of the file when it could not be mapped
+	std::vector<uint8_t> _buffer;
+	/// Contents of blocks created for writing, blocks only hold views of them
+	std::map<std::string, std::vector<uint8_t>> _ownedBlocks;
+	/// Contents of meshes inserted for writing, moving the vectors keeps their data in place
+	std::vector<std::vector<uint8_t>> _ownedMeshes;
+
+	std::map<std::string, std::span<const uint8_t>> _blocks;
 	std::vector<InfoBlockLookup> _infoBlockLookup;
 	std::vector<BodyBlockLookup> _bodyBlockLookup;
 	/// Metadata and DDS formatted texture data
 	std::map<std::string, G3DTexture> _textures;
 	/// Bytes of l3d meshes
-	std::vector<std::vector<uint8_t>> _meshes;
-	/// Bytes of anm meshes
-	std::vector<std::vector<uint8_t>> _animations;
+	std::vector<std::span<const uint8_t>> _meshes;
+	/// Header and body of anm animations which are stored in separate blocks
+	std::vector<AnimationView> _animations;
 	/// Headers of snd audio samples
 	std::vector<AudioBankSampleHeader> _audioSampleHeaders;
 	/// Bytes of snd audio samples
-	std::vector<std::vector<uint8_t>> _audioSampleData;
+	std::vector<std::span<const uint8_t>> _audioSampleData;
+
+	/// Read blocks from the contents of a pack
+	PackResult ReadBlocks(std::span<const uint8_t> data) noexcept;
+
+	/// Read blocks and the look-up tables of the assets
+	PackResult ReadIndex(std::span<const uint8_t> data) noexcept;
+
+	/// Read blocks and resolve the assets of the pack
+	PackResult ReadData(std::span<const uint8_t> data) noexcept;
 
-	/// Read blocks from pack
-	PackResult ReadBlocks(std::istream& stream) noexcept;
+	/// Read the whole stream into the buffer
+	void ReadBuffer(std::istream& stream) noexcept;
 
 	/// Write blocks to file
 	PackResult WriteBlocks(std::ostream& stream) const noexcept;
@@ -216,12 +254,21 @@ class PackFile
 	/// Parse Audio Block for sound pack
 	PackResult ResolveAudioBankSampleTableBlock() noexcept;
 
+	/// Extract a Texture from the Block named by an entry of the INFO Block
+	PackResult ExtractTexture(const InfoBlockLookup& item, G3DTexture& texture) const noexcept;
+
 	/// Extract Textures from all Blocks named in INFO Block
 	PackResult ExtractTexturesFromBlock() noexcept;
 
+	/// Extract an Animation from the Body Block and its Julien Block
+	PackResult ExtractAnimation(uint32_t index, AnimationView& animation) const noexcept;
+
 	/// Extract Animations from all Blocks named in Body Block
 	PackResult ExtractAnimationsFromBlock() noexcept;
 
+	/// Extract a Sound from the LHAudioWaveData Block
+	PackResult ExtractSound(uint32_t index, std::span<const uint8_t>& sample) const noexcept;
+
 	/// Extract Sounds from all Blocks named in LHAudioBankSampleTable Block
 	PackResult ExtractSoundsFromBlock() noexcept;
 
@@ -235,9 +282,13 @@ class PackFile
 	/// Read file from the input source
 	PackResult ReadFile(std::istream& stream) noexcept;
 
-	/// Read g3d file from the filesystem
+	/// Map g3d file from the filesystem, reading it if it can't be mapped
 	PackResult Open(const std::filesystem::path& filepath) noexcept;
 
+	/// Map g3d file from the filesystem and only read its block table and look-up tables.
+	/// Textures, animations and sounds are not extracted, the Load functions extract a single one on request.
+	PackResult OpenIndex(const std::filesystem::path& filepath) noexcept;
+
 	/// Read g3d file from a buffer
 	PackResult Open(const std::vector<uint8_t>& buffer) noexcept;
 
@@ -262,18 +313,34 @@ class PackFile
 	/// Create Body block from look-up table
 	PackResult CreateBodyBlock() noexcept;
 
-	[[nodiscard]] const std::map<std::string, std::vector<uint8_t>>& GetBlocks() const noexcept { return _blocks; }
+	/// True when the contents are a memory mapping of the file
+	[[nodiscard]] bool IsMapped() const noexcept { return _mapping != nullptr; }
+	/// True when opened with OpenIndex, the collections of extracted textures, animations and sounds are then empty
+	[[nodiscard]] bool IsIndexOnly() const noexcept { return _isIndexOnly; }
+
+	/// Extract a single asset, these work whether or not the pack was opened with OpenIndex
+	PackResult LoadTexture(uint32_t index, G3DTexture& texture) const noexcept;
+	PackResult LoadTexture(const std::string& name, G3DTexture& texture) const noexcept;
+	PackResult LoadMesh(uint32_t index, std::span<const uint8_t>& mesh) const noexcept;
+	/// Assemble the anm file of an animation, the header and body are stored apart so this is a copy
+	PackResult LoadAnimation(uint32_t index, std::vector<uint8_t>& animation) const noexcept;
+	PackResult LoadAudioSample(uint32_t index, std::span<const uint8_t>& sample) const noexcept;
+
+	[[nodiscard]] size_t GetTextureCount() const noexcept { return _infoBlockLookup.size(); }
+	[[nodiscard]] size_t GetMeshCount() const noexcept { return _meshes.size(); }
+	[[nodiscard]] size_t GetAudioSampleCount() const noexcept { return _audioSampleHeaders.size(); }
+
+	[[nodiscard]] const std::map<std::string, std::span<const uint8_t>>& GetBlocks() const noexcept { return _blocks; }
 	[[nodiscard]] bool HasBlock(const std::string& name) const noexcept { return _blocks.contains(name); }
-	[[nodiscard]] const std::vector<uint8_t>& GetBlock(const std::string& name) const noexcept { return _blocks.at(name); }
+	[[nodiscard]] std::span<const uint8_t> GetBlock(const std::string& name) const noexcept { return _blocks.at(name); }
 	[[nodiscard]] std::unique_ptr<std::istream> GetBlockAsStream(const std::string& name) const noexcept;
 	[[nodiscard]] const std::vector<InfoBlockLookup>& GetInfoBlockLookup() const noexcept { return _infoBlockLookup; }
 	[[nodiscard]] const std::vector<BodyBlockLookup>& GetBodyBlockLookup() const noexcept { return _bodyBlockLookup; }
 	[[nodiscard]] const std::map<std::string, G3DTexture>& GetTextures() const noexcept { return _textures; }
 	[[nodiscard]] const G3DTexture& GetTexture(const std::string& name) const noexcept { return _textures.at(name); }
-	[[nodiscard]] const std::vector<std::vector<uint8_t>>& GetMeshes() const noexcept { return _meshes; }
-	[[nodiscard]] const std::vector<uint8_t>& GetMesh(uint32_t index) const noexcept { return _meshes[index]; }
-	[[nodiscard]] const std::vector<std::vector<uint8_t>>& GetAnimations() const noexcept { return _animations; }
-	[[nodiscard]] const std::vector<uint8_t>& GetAnimation(uint32_t index) const noexcept { return _animations[index]; }
+	[[nodiscard]] const std::vector<std::span<const uint8_t>>& GetMeshes() const noexcept { return _meshes; }
+	[[nodiscard]] std::span<const uint8_t> GetMesh(uint32_t index) const noexcept { return _meshes[index]; }
+	[[nodiscard]] size_t GetAnimationCount() const noexcept { return _bodyBlockLookup.size(); }
 	[[nodiscard]] const std::vector<AudioBankSampleHeader>& GetAudioSampleHeaders() const noexcept
 	{
 		return _audioSampleHeaders;
@@ -282,8 +349,11 @@ class PackFile
 	{
 		return _audioSampleHeaders[index];
 	}
-	[[nodiscard]] const std::vector<std::vector<uint8_t>>& GetAudioSamplesData() const noexcept { return _audioSampleData; }
-	[[nodiscard]] const std::vector<uint8_t>& GetAudioSampleData(uint32_t index) const noexcept
+	[[nodiscard]] const std::vector<std::span<const uint8_t>>& GetAudioSamplesData() const noexcept
+	{
+		return _audioSampleData;
+	}
+	[[nodiscard]] std::span<const uint8_t> GetAudioSampleData(uint32_t index) const noexcept
 	{
 		return _audioSampleData[index];
 	}
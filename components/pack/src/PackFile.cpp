@@ -126,9 +126,13 @@
 #include <cassert>
 #include <cstring>
 
+#include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <utility>
 
+#include <MappedFile.h>
+
 using namespace openblack::pack;
 
 namespace
@@ -226,57 +230,49 @@ std::string_view openblack::pack::ResultToStr(PackResult result)
 		return "Unrecognized Mesh Block header.";
 	case PackResult::ErrNotImplemented:
 		return "Function is not yet implemented.";
+	case PackResult::ErrAssetNotFound:
+		return "No asset with this index or name in pack.";
 	}
 	std::unreachable();
 }
 
-PackResult PackFile::ReadBlocks(std::istream& stream) noexcept
+PackResult PackFile::ReadBlocks(std::span<const uint8_t> data) noexcept
 {
 	assert(!_isLoaded);
 
 	// Total file size
-	std::size_t fsize = 0;
-	if (stream.seekg(0, std::ios_base::end))
-	{
-		fsize = static_cast<std::size_t>(stream.tellg());
-		stream.seekg(0);
-	}
+	const std::size_t fsize = data.size();
 
-	std::array<char, k_Magic.size()> magic;
-	if (fsize < magic.size() + sizeof(PackBlockHeader))
+	if (fsize < k_Magic.size() + sizeof(PackBlockHeader))
 	{
 		return PackResult::ErrFileTooSmall;
 	}
 
 	// First 8 bytes
-	stream.read(magic.data(), magic.size());
-	if (std::memcmp(magic.data(), k_Magic.data(), magic.size()) != 0)
+	if (std::memcmp(data.data(), k_Magic.data(), k_Magic.size()) != 0)
 	{
 		return PackResult::ErrUnrecognizedHeader;
 	}
-
-	if (fsize < static_cast<std::size_t>(stream.tellg()) + sizeof(PackBlockHeader))
-	{
-		return PackResult::ErrFileTooSmall;
-	}
+	std::size_t offset = k_Magic.size();
 
 	PackBlockHeader header;
-	while (fsize - sizeof(PackBlockHeader) > static_cast<std::size_t>(stream.tellg()))
+	while (fsize - sizeof(PackBlockHeader) > offset)
 	{
-		stream.read(reinterpret_cast<char*>(&header), sizeof(PackBlockHeader));
+		std::memcpy(&header, data.data() + offset, sizeof(PackBlockHeader));
+		offset += sizeof(PackBlockHeader);
 
 		if (_blocks.contains(header.blockName.data()))
 		{
 			return PackResult::ErrDuplicateBlockName;
 		}
 
-		_blocks[std::string(header.blockName.data())] = std::vector<uint8_t>(header.blockSize);
-		stream.read(reinterpret_cast<char*>(_blocks[header.blockName.data()].data()), header.blockSize);
-	}
+		if (header.blockSize > fsize - offset)
+		{
+			return PackResult::ErrFileNotEvenlySplit;
+		}
 
-	if (fsize < static_cast<std::size_t>(stream.tellg()))
-	{
-		return PackResult::ErrFileNotEvenlySplit;
+		_blocks[std::string(header.blockName.data())] = data.subspan(offset, header.blockSize);
+		offset += header.blockSize;
 	}
 
 	return PackResult::Success;
@@ -289,7 +285,7 @@ PackResult PackFile::ResolveInfoBlock() noexcept
 		return PackResult::ErrMissingInfoBlock;
 	}
 
-	auto data = GetBlock("INFO");
+	const auto data = GetBlock("INFO");
 	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
 
 	uint32_t totalTextures;
@@ -309,7 +305,7 @@ PackResult PackFile::ResolveBodyBlock() noexcept
 		return PackResult::ErrMissingBodyBlock;
 	}
 
-	auto data = GetBlock("Body");
+	const auto data = GetBlock("Body");
 	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
 
 	// Greetings Jean-Claude Cottier
@@ -337,7 +333,7 @@ PackResult PackFile::ResolveAudioBankSampleTableBlock() noexcept
 		return PackResult::ErrMissingAudioBankSampleTableBlock;
 	}
 
-	auto data = GetBlock("LHAudioBankSampleTable");
+	const auto data = GetBlock("LHAudioBankSampleTable");
 	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
 	std::size_t fsize = 0;
 	if (stream.seekg(0, std::ios_base::end))
@@ -375,104 +371,151 @@ PackResult PackFile::ResolveAudioBankSampleTableBlock() noexcept
 	return PackResult::Success;
 }
 
-PackResult PackFile::ExtractTexturesFromBlock() noexcept
+PackResult PackFile::ExtractTexture(const InfoBlockLookup& item, G3DTexture& texture) const noexcept
 {
-	G3DTextureHeader header;
 	constexpr uint32_t blockNameSize = 0x20;
 	std::array<char, blockNameSize> blockName;
-	for (const auto& item : _infoBlockLookup)
+	// Convert int id to string representation as hexadecimal key
+	std::snprintf(blockName.data(), blockName.size(), "%x", item.blockId);
+
+	if (!HasBlock(blockName.data()))
 	{
-		// Convert int id to string representation as hexadecimal key
-		std::snprintf(blockName.data(), blockName.size(), "%x", item.blockId);
+		return PackResult::ErrMissingTextureBlock;
+	}
 
-		if (!HasBlock(blockName.data()))
-		{
-			return PackResult::ErrMissingTextureBlock;
-		}
+	const auto block = GetBlock(blockName.data());
+	auto& header = texture.header;
+	if (block.size() < sizeof(header))
+	{
+		return PackResult::ErrFileTooSmall;
+	}
+	std::memcpy(&header, block.data(), sizeof(header));
+	const auto dds = block.subspan(sizeof(header), std::min<std::size_t>(header.size, block.size() - sizeof(header)));
 
-		auto stream = GetBlockAsStream(blockName.data());
+	if (header.id != item.blockId)
+	{
+		return PackResult::ErrTextureBlockIdMismatch;
+	}
 
-		stream->read(reinterpret_cast<char*>(&header), sizeof(header));
-		std::vector<uint8_t> dds(header.size);
-		stream->read(reinterpret_cast<char*>(dds.data()), dds.size() * sizeof(dds[0]));
+	auto& ddsHeader = texture.ddsHeader;
+	if (dds.size() < sizeof(DdsHeader))
+	{
+		return PackResult::ErrTextureInvalidDDSHeaderSize;
+	}
+	std::memcpy(&ddsHeader, dds.data(), sizeof(DdsHeader));
 
-		if (header.id != item.blockId)
+	// Verify the header to validate the DDS file
+	if (ddsHeader.size != sizeof(DdsHeader) || ddsHeader.format.size != sizeof(DdsPixelFormat))
+	{
+		return PackResult::ErrTextureInvalidDDSHeaderSize;
+	}
+
+	// Handle cases where this field is not provided
+	// https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
+	// Some Creature Isle DXT5 textures lack this field
+	if (ddsHeader.pitchOrLinearSize == 0)
+	{
+		// The block-size is 8 bytes for DXT1, BC1, and BC4 formats, and 16 bytes for other block-compressed formats
+		int blockSize;
+		auto format = std::string(ddsHeader.format.fourCC.data(), ddsHeader.format.fourCC.size());
+		if (format == "DXT1" || format == "BC1" || format == "BC4")
 		{
-			return PackResult::ErrTextureBlockIdMismatch;
+			blockSize = 8;
 		}
-
-		if (_textures.contains(blockName.data()))
+		else
 		{
-			return PackResult::ErrTextureDuplicate;
+			blockSize = 16;
 		}
 
-		imemstream ddsStream(reinterpret_cast<const char*>(dds.data()), dds.size());
+		ddsHeader.pitchOrLinearSize = ((ddsHeader.width + 3) / 4) * ((ddsHeader.height + 3) / 4) * blockSize;
+	}
+
+	const auto ddsTexels = dds.subspan(sizeof(DdsHeader));
+	texture.ddsData = ddsTexels.first(std::min<std::size_t>(ddsHeader.pitchOrLinearSize, ddsTexels.size()));
 
-		DdsHeader ddsHeader;
-		ddsStream.read(reinterpret_cast<char*>(&ddsHeader), sizeof(DdsHeader));
+	return PackResult::Success;
+}
 
-		// Verify the header to validate the DDS file
-		if (ddsHeader.size != sizeof(DdsHeader) || ddsHeader.format.size != sizeof(DdsPixelFormat))
+PackResult PackFile::ExtractTexturesFromBlock() noexcept
+{
+	constexpr uint32_t blockNameSize = 0x20;
+	std::array<char, blockNameSize> blockName;
+	for (const auto& item : _infoBlockLookup)
+	{
+		G3DTexture texture;
+		const auto result = ExtractTexture(item, texture);
+		if (result != PackResult::Success)
 		{
-			return PackResult::ErrTextureInvalidDDSHeaderSize;
+			return result;
 		}
 
-		// Handle cases where this field is not provided
-		// https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dx-graphics-dds-pguide
-		// Some Creature Isle DXT5 textures lack this field
-		if (ddsHeader.pitchOrLinearSize == 0)
+		std::snprintf(blockName.data(), blockName.size(), "%x", item.blockId);
+		if (_textures.contains(blockName.data()))
 		{
-			// The block-size is 8 bytes for DXT1, BC1, and BC4 formats, and 16 bytes for other block-compressed formats
-			int blockSize;
-			auto format = std::string(ddsHeader.format.fourCC.data(), ddsHeader.format.fourCC.size());
-			if (format == "DXT1" || format == "BC1" || format == "BC4")
-			{
-				blockSize = 8;
-			}
-			else
-			{
-				blockSize = 16;
-			}
-
-			ddsHeader.pitchOrLinearSize = ((ddsHeader.width + 3) / 4) * ((ddsHeader.height + 3) / 4) * blockSize;
+			return PackResult::ErrTextureDuplicate;
 		}
 
-		std::vector<uint8_t> dssTexels(ddsHeader.pitchOrLinearSize);
-		ddsStream.read(reinterpret_cast<char*>(dssTexels.data()), dssTexels.size());
-
-		_textures[blockName.data()] = {header, ddsHeader, dssTexels};
+		_textures[blockName.data()] = texture;
 	}
 
 	return PackResult::Success;
 }
 
-PackResult PackFile::ExtractAnimationsFromBlock() noexcept
+PackResult PackFile::ExtractAnimation(uint32_t index, AnimationView& animation) const noexcept
 {
-	auto data = GetBlock("Body");
-	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
-
-	// Read lookup
 	constexpr uint32_t blockNameSize = 0x20;
 	constexpr uint32_t animationHeaderSize = 0x54;
 
 	std::array<char, blockNameSize> blockName;
+	snprintf(blockName.data(), blockNameSize, "Julien%d", index);
+	if (!HasBlock(blockName.data()))
+	{
+		return PackResult::ErrMissingTextureBlock;
+	}
+
+	const auto data = GetBlock("Body");
+	const auto offset = _bodyBlockLookup[index].offset;
+	if (offset > data.size() || data.size() - offset < animationHeaderSize)
+	{
+		return PackResult::ErrFileTooSmall;
+	}
+
+	animation = {data.subspan(offset, animationHeaderSize), GetBlock(blockName.data())};
+
+	return PackResult::Success;
+}
+
+PackResult PackFile::ExtractAnimationsFromBlock() noexcept
+{
 	_animations.resize(_bodyBlockLookup.size());
 	for (uint32_t i = 0; i < _bodyBlockLookup.size(); ++i)
 	{
-		snprintf(blockName.data(), blockNameSize, "Julien%d", i);
-		if (!HasBlock(blockName.data()))
+		const auto result = ExtractAnimation(i, _animations[i]);
+		if (result != PackResult::Success)
 		{
-			return PackResult::ErrMissingTextureBlock;
+			return result;
 		}
+	}
 
-		auto animationData = GetBlock(blockName.data());
-		_animations[i].resize(animationHeaderSize + animationData.size());
+	return PackResult::Success;
+}
 
-		stream.seekg(_bodyBlockLookup[i].offset);
-		stream.read(reinterpret_cast<char*>(_animations[i].data()), animationHeaderSize);
-		memcpy(_animations[i].data() + animationHeaderSize, animationData.data(), animationData.size());
+PackResult PackFile::ExtractSound(uint32_t index, std::span<const uint8_t>& sample) const noexcept
+{
+	if (!HasBlock("LHAudioWaveData"))
+	{
+		return PackResult::ErrMissingAudioWaveDataBlock;
 	}
 
+	const auto data = GetBlock("LHAudioWaveData");
+	const auto& header = _audioSampleHeaders[index];
+	if (header.offset > data.size() || header.size > data.size() - header.offset)
+	{
+		return PackResult::ErrFileTooSmall;
+	}
+
+	sample = data.subspan(header.offset, header.size);
+
 	return PackResult::Success;
 }
 
@@ -483,29 +526,14 @@ PackResult PackFile::ExtractSoundsFromBlock() noexcept
 		return PackResult::ErrMissingAudioWaveDataBlock;
 	}
 
-	auto data = GetBlock("LHAudioWaveData");
-	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
-	//	auto isSector = false;
-	//	auto isPrevSector = false;
-
 	_audioSampleData.resize(_audioSampleHeaders.size());
-	for (int i = 0; const auto& sample : _audioSampleHeaders)
+	for (uint32_t i = 0; i < _audioSampleHeaders.size(); ++i)
 	{
-		if (sample.offset > data.size())
-		{
-			return PackResult::ErrFileTooSmall;
-		}
-		if (sample.offset + sample.size > data.size())
+		const auto result = ExtractSound(i, _audioSampleData[i]);
+		if (result != PackResult::Success)
 		{
-			return PackResult::ErrFileTooSmall;
+			return result;
 		}
-
-		_audioSampleData[i].resize(sample.size);
-
-		stream.seekg(sample.offset);
-		stream.read(reinterpret_cast<char*>(_audioSampleData[i].data()), sample.size);
-
-		++i;
 	}
 
 	return PackResult::Success;
@@ -517,7 +545,7 @@ PackResult PackFile::ResolveMeshBlock() noexcept
 	{
 		return PackResult::ErrMissingMeshBlock;
 	}
-	auto data = GetBlock("MESHES");
+	const auto data = GetBlock("MESHES");
 
 	imemstream stream(reinterpret_cast<const char*>(data.data()), data.size());
 	// Greetings Jean-Claude Cottier
@@ -536,9 +564,12 @@ PackResult PackFile::ResolveMeshBlock() noexcept
 	_meshes.resize(meshOffsets.size());
 	for (std::size_t i = 0; i < _meshes.size(); i++)
 	{
-		auto size = (i == _meshes.size() - 1 ? data.size() : meshOffsets[i + 1]) - meshOffsets[i];
-		_meshes[i].resize(size);
-		stream.read(reinterpret_cast<char*>(_meshes[i].data()), _meshes[i].size() * sizeof(_meshes[i][0]));
+		const std::size_t end = i == _meshes.size() - 1 ? data.size() : meshOffsets[i + 1];
+		if (meshOffsets[i] > end || end > data.size())
+		{
+			return PackResult::ErrMeshBlockHeaderMalformed;
+		}
+		_meshes[i] = data.subspan(meshOffsets[i], end - meshOffsets[i]);
 	}
 
 	return PackResult::Success;
@@ -581,7 +612,9 @@ PackResult PackFile::CreateRawBlock(const std::string& name, std::vector<uint8_t
 		return PackResult::ErrDuplicateBlockName;
 	}
 
-	_blocks[name] = std::move(data);
+	auto& contents = _ownedBlocks[name];
+	contents = std::move(data);
+	_blocks[name] = contents;
 
 	return PackResult::Success;
 }
@@ -626,14 +659,12 @@ PackResult PackFile::CreateMeshBlock() noexcept
 		}
 	}
 
-	_blocks["MESHES"] = std::move(contents);
-
-	return PackResult::Success;
+	return CreateRawBlock("MESHES", std::move(contents));
 }
 
 PackResult PackFile::InsertMesh(std::vector<uint8_t> data) noexcept
 {
-	_meshes.emplace_back(std::move(data));
+	_meshes.emplace_back(_ownedMeshes.emplace_back(std::move(data)));
 
 	return PackResult::Success;
 }
@@ -656,9 +687,7 @@ PackResult PackFile::CreateInfoBlock() noexcept
 
 	std::memcpy(contents.data() + offset, _infoBlockLookup.data(), _infoBlockLookup.size() * sizeof(_infoBlockLookup[0]));
 
-	_blocks["INFO"] = std::move(contents);
-
-	return PackResult::Success;
+	return CreateRawBlock("INFO", std::move(contents));
 }
 
 PackResult PackFile::CreateBodyBlock() noexcept
@@ -668,21 +697,17 @@ PackResult PackFile::CreateBodyBlock() noexcept
 		return PackResult::ErrDuplicateBlockName;
 	}
 
-	std::vector<uint8_t> contents;
-
-	_blocks["Body"] = std::move(contents);
-
-	return PackResult::Success;
+	return CreateRawBlock("Body", {});
 }
 
 PackFile::PackFile() noexcept = default;
 PackFile::~PackFile() noexcept = default;
 
-PackResult PackFile::ReadFile(std::istream& stream) noexcept
+PackResult PackFile::ReadIndex(std::span<const uint8_t> data) noexcept
 {
 	PackResult result;
 
-	result = ReadBlocks(stream);
+	result = ReadBlocks(data);
 	if (result != PackResult::Success)
 	{
 		return result;
@@ -697,12 +722,6 @@ PackResult PackFile::ReadFile(std::istream& stream) noexcept
 			return result;
 		}
 
-		result = ExtractTexturesFromBlock();
-		if (result != PackResult::Success)
-		{
-			return result;
-		}
-
 		result = ResolveMeshBlock();
 		if (result != PackResult::Success)
 		{
@@ -718,12 +737,6 @@ PackResult PackFile::ReadFile(std::istream& stream) noexcept
 		{
 			return result;
 		}
-
-		result = ExtractAnimationsFromBlock();
-		if (result != PackResult::Success)
-		{
-			return result;
-		}
 	}
 
 	// Sound pack
@@ -740,6 +753,41 @@ PackResult PackFile::ReadFile(std::istream& stream) noexcept
 		// {
 		// 	return result;
 		// }
+	}
+
+	return PackResult::Success;
+}
+
+PackResult PackFile::ReadData(std::span<const uint8_t> data) noexcept
+{
+	PackResult result;
+
+	result = ReadIndex(data);
+	if (result != PackResult::Success)
+	{
+		return result;
+	}
+
+	if (HasBlock("INFO"))
+	{
+		result = ExtractTexturesFromBlock();
+		if (result != PackResult::Success)
+		{
+			return result;
+		}
+	}
+
+	if (HasBlock("Body"))
+	{
+		result = ExtractAnimationsFromBlock();
+		if (result != PackResult::Success)
+		{
+			return result;
+		}
+	}
+
+	if (HasBlock("LHAudioBankSampleTable"))
+	{
 		result = ExtractSoundsFromBlock();
 		if (result != PackResult::Success)
 		{
@@ -752,8 +800,38 @@ PackResult PackFile::ReadFile(std::istream& stream) noexcept
 	return PackResult::Success;
 }
 
+void PackFile::ReadBuffer(std::istream& stream) noexcept
+{
+	std::size_t fsize = 0;
+	if (stream.seekg(0, std::ios_base::end))
+	{
+		fsize = static_cast<std::size_t>(stream.tellg());
+		stream.seekg(0);
+	}
+
+	_buffer.resize(fsize);
+	stream.read(reinterpret_cast<char*>(_buffer.data()), static_cast<std::streamsize>(_buffer.size()));
+}
+
+PackResult PackFile::ReadFile(std::istream& stream) noexcept
+{
+	assert(!_isLoaded);
+
+	ReadBuffer(stream);
+
+	return ReadData(_buffer);
+}
+
 PackResult PackFile::Open(const std::filesystem::path& filepath) noexcept
 {
+	assert(!_isLoaded);
+
+	_mapping = mapped::MappedFile::Map(filepath, mapped::Access::Whole);
+	if (_mapping != nullptr)
+	{
+		return ReadData(_mapping->GetData());
+	}
+
 	std::ifstream stream(filepath, std::ios::binary);
 
 	if (!stream.is_open())
@@ -764,13 +842,42 @@ PackResult PackFile::Open(const std::filesystem::path& filepath) noexcept
 	return ReadFile(stream);
 }
 
+PackResult PackFile::OpenIndex(const std::filesystem::path& filepath) noexcept
+{
+	assert(!_isLoaded);
+
+	_mapping = mapped::MappedFile::Map(filepath, mapped::Access::Whole);
+	if (_mapping == nullptr)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+
+		if (!stream.is_open())
+		{
+			return PackResult::ErrCantOpen;
+		}
+
+		ReadBuffer(stream);
+	}
+
+	const auto result = ReadIndex(_mapping != nullptr ? _mapping->GetData() : std::span<const uint8_t>(_buffer));
+	if (result != PackResult::Success)
+	{
+		return result;
+	}
+
+	_isLoaded = true;
+	_isIndexOnly = true;
+
+	return PackResult::Success;
+}
+
 PackResult PackFile::Open(const std::vector<uint8_t>& buffer) noexcept
 {
 	assert(!_isLoaded);
 
-	imemstream stream(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(buffer[0]));
+	_buffer = buffer;
 
-	return ReadFile(stream);
+	return ReadData(_buffer);
 }
 
 PackResult PackFile::Write(const std::filesystem::path& filepath) noexcept
@@ -789,6 +896,98 @@ PackResult PackFile::Write(const std::filesystem::path& filepath) noexcept
 
 std::unique_ptr<std::istream> PackFile::GetBlockAsStream(const std::string& name) const noexcept
 {
-	const auto& data = GetBlock(name);
+	const auto data = GetBlock(name);
 	return std::make_unique<imemstream>(reinterpret_cast<const char*>(data.data()), data.size());
 }
+
+PackResult PackFile::LoadTexture(uint32_t index, G3DTexture& texture) const noexcept
+{
+	if (index >= _infoBlockLookup.size())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	return ExtractTexture(_infoBlockLookup[index], texture);
+}
+
+PackResult PackFile::LoadTexture(const std::string& name, G3DTexture& texture) const noexcept
+{
+	if (const auto iter = _textures.find(name); iter != _textures.end())
+	{
+		texture = iter->second;
+		return PackResult::Success;
+	}
+
+	// Texture names are the hexadecimal block id
+	uint32_t blockId;
+	const auto [end, error] = std::from_chars(name.data(), name.data() + name.size(), blockId, 16);
+	if (error != std::errc() || end != name.data() + name.size())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	const auto item = std::find_if(_infoBlockLookup.begin(), _infoBlockLookup.end(),
+	                               [blockId](const auto& lookup) { return lookup.blockId == blockId; });
+	if (item == _infoBlockLookup.end())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	return ExtractTexture(*item, texture);
+}
+
+PackResult PackFile::LoadMesh(uint32_t index, std::span<const uint8_t>& mesh) const noexcept
+{
+	if (index >= _meshes.size())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	mesh = _meshes[index];
+
+	return PackResult::Success;
+}
+
+PackResult PackFile::LoadAnimation(uint32_t index, std::vector<uint8_t>& animation) const noexcept
+{
+	if (index >= _bodyBlockLookup.size())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	AnimationView view;
+	if (index < _animations.size())
+	{
+		view = _animations[index];
+	}
+	else
+	{
+		const auto result = ExtractAnimation(index, view);
+		if (result != PackResult::Success)
+		{
+			return result;
+		}
+	}
+
+	animation.resize(view.header.size() + view.body.size());
+	std::memcpy(animation.data(), view.header.data(), view.header.size());
+	std::memcpy(animation.data() + view.header.size(), view.body.data(), view.body.size());
+
+	return PackResult::Success;
+}
+
+PackResult PackFile::LoadAudioSample(uint32_t index, std::span<const uint8_t>& sample) const noexcept
+{
+	if (index >= _audioSampleHeaders.size())
+	{
+		return PackResult::ErrAssetNotFound;
+	}
+
+	if (index < _audioSampleData.size())
+	{
+		sample = _audioSampleData[index];
+		return PackResult::Success;
+	}
+
+	return ExtractSound(index, sample);
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "AnimationPalette.h"
+
+#include <cstring>
+
+#include <algorithm>
+
+#include <bgfx/bgfx.h>
+#include <glm/gtc/matrix_access.hpp>
+#include <spdlog/spdlog.h>
+
+#include "3D/L3DAnim.h"
+#include "3D/L3DMesh.h"
+#include "Graphics/Texture2D.h"
+#include "Locator.h"
+#include "Resources/ResourcesInterface.h"
+
+using namespace openblack::graphics;
+
+AnimationPalette::AnimationPalette() noexcept = default;
+AnimationPalette::~AnimationPalette() noexcept = default;
+
+std::optional<uint32_t> AnimationPalette::Register(entt::id_type meshId, entt::id_type animationId)
+{
+	const auto key = std::make_pair(meshId, animationId);
+	if (auto iter = _offsets.find(key); iter != _offsets.end())
+	{
+		return iter->second != k_Invalid ? std::make_optional(iter->second) : std::nullopt;
+	}
+
+	auto& resources = Locator::resources::value();
+	if (!resources.GetMeshes().Contains(meshId) || !resources.GetAnimations().Contains(animationId))
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("graphics"), "Cannot bake animation {} for mesh {}: resource not loaded", animationId,
+		                    meshId);
+		_offsets.emplace(key, k_Invalid);
+		return std::nullopt;
+	}
+
+	const auto mesh = resources.GetMeshes().Handle(meshId);
+	const auto animation = resources.GetAnimations().Handle(animationId);
+	const auto& boneParents = mesh->GetBoneParents();
+	const auto& frames = animation->GetFrames();
+	if (!mesh->IsBoned() || frames.empty() || frames[0].bones.size() != boneParents.size())
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("graphics"), "Animation {} does not match the skeleton of mesh {}",
+		                    animation->GetName(), mesh->GetDebugName());
+		_offsets.emplace(key, k_Invalid);
+		return std::nullopt;
+	}
+
+	const auto boneCount = static_cast<uint32_t>(boneParents.size());
+	// The last frame is sampled at the end of the animation, which the one before is less than k_FrameDuration away from
+	const auto duration = std::max(1u, animation->GetDuration());
+	const auto frameCount = (duration + k_FrameDuration - 1) / k_FrameDuration + 1;
+
+	const auto offset = static_cast<uint32_t>(_texels.size());
+	_texels.reserve(_texels.size() + 1 + frameCount * boneCount * k_TexelsPerBone);
+	_texels.emplace_back(boneCount, frameCount, k_FrameDuration, duration);
+	std::vector<glm::mat4> bones(boneCount);
+	L3DAnim::SampleCursor cursor;
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		// Concatenate parents the same way the renderer does for the bind pose
+		animation->SampleBoneMatrices(std::min(frame * k_FrameDuration, duration), bones, &cursor);
+		for (uint32_t i = 0; i < boneCount; ++i)
+		{
+			if (boneParents[i] != std::numeric_limits<uint32_t>::max())
+			{
+				bones[i] = bones[boneParents[i]] * bones[i];
+			}
+			for (uint32_t row = 0; row < k_TexelsPerBone; ++row)
+			{
+				_texels.emplace_back(glm::row(bones[i], row));
+			}
+		}
+	}
+
+	_offsets.emplace(key, offset);
+	_dirty = true;
+
+	SPDLOG_LOGGER_DEBUG(spdlog::get("graphics"), "Baked animation {} for {} with {} frames of {} bones at texel {}",
+	                    animation->GetName(), mesh->GetDebugName(), frameCount, boneCount, offset);
+
+	return offset;
+}
+
+void AnimationPalette::Upload()
+{
+	if (!_dirty)
+	{
+		return;
+	}
+	_dirty = false;
+
+	const size_t height = (_texels.size() + k_Width - 1) / k_Width;
+	if (height > bgfx::getCaps()->limits.maxTextureSize)
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("graphics"), "Animation palette of {} texels exceeds the maximum texture size",
+		                    _texels.size());
+		return;
+	}
+
+	// Copied so that later animations can be baked while bgfx still uploads this one, padded to a full rectangle
+	const auto size = static_cast<uint32_t>(height * k_Width * sizeof(_texels[0]));
+	const auto* memory = bgfx::alloc(size);
+	const auto texelsSize = _texels.size() * sizeof(_texels[0]);
+	std::memcpy(memory->data, _texels.data(), texelsSize);
+	std::memset(memory->data + texelsSize, 0, size - texelsSize);
+
+	_texture = std::make_unique<Texture2D>("AnimationPalette");
+	_texture->Create(k_Width, static_cast<uint16_t>(height), 1, Format::RGBA32F, Wrapping::ClampEdge, Filter::Nearest,
+	                 memory);
+}
+
+glm::vec4 AnimationPalette::GetTextureSize() const
+{
+	if (_texture == nullptr)
+	{
+		return glm::vec4(0.0f);
+	}
+	const auto width = static_cast<float>(_texture->GetWidth());
+	const auto height = static_cast<float>(_texture->GetHeight());
+	return {width, height, 1.0f / width, 1.0f / height};
+}
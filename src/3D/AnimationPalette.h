@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <entt/fwd.hpp>
+#include <glm/vec4.hpp>
+
+namespace openblack::graphics
+{
+class Texture2D;
+
+/// Bakes the model space bone matrices of animations into a single float texture so that boned meshes can be skinned
+/// in the vertex shader and drawn instanced.
+///
+/// Every baked (mesh, animation) pair is a block of texels starting with a header texel holding the bone count, the
+/// frame count, the frame duration and the duration of the animation, followed by 3 texels per bone per frame holding
+/// the rows of the bone's affine transform. Frames are sampled every frame duration and at the end of the animation.
+/// The index of the header texel identifies the animation in instance data.
+class AnimationPalette
+{
+public:
+	static constexpr uint16_t k_Width = 1024;
+	static constexpr uint32_t k_FrameDuration = 33; ///< Sampling interval of baked frames in milliseconds
+	static constexpr uint32_t k_TexelsPerBone = 3;
+
+	AnimationPalette() noexcept;
+	~AnimationPalette() noexcept;
+
+	/// Bake an animation for the skeleton of a mesh if it hasn't been baked already.
+	/// @return Index of the header texel of the baked animation or nullopt if the animation doesn't fit the mesh.
+	std::optional<uint32_t> Register(entt::id_type meshId, entt::id_type animationId);
+	/// Recreate the palette texture if animations were baked since the last upload.
+	void Upload();
+
+	[[nodiscard]] const Texture2D* GetTexture() const { return _texture.get(); }
+	/// Width, height and their reciprocals for addressing texels from shaders
+	[[nodiscard]] glm::vec4 GetTextureSize() const;
+	[[nodiscard]] uint32_t GetTexelCount() const { return static_cast<uint32_t>(_texels.size()); }
+
+private:
+	static constexpr uint32_t k_Invalid = std::numeric_limits<uint32_t>::max();
+
+	std::map<std::pair<entt::id_type, entt::id_type>, uint32_t> _offsets;
+	std::vector<glm::vec4> _texels;
+	std::unique_ptr<Texture2D> _texture;
+	bool _dirty {false};
+};
+
+} // namespace openblack::graphics
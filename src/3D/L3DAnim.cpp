@@ -9,10 +9,13 @@
 
 #include "L3DAnim.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <stdexcept>
 
 #include <ANMFile.h>
+#include <BakedFile.h>
+#include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/matrix_interpolation.hpp>
 #include <spdlog/spdlog.h>
 
@@ -23,36 +26,76 @@ using namespace openblack;
 
 void L3DAnim::Load(const anm::ANMFile& anm) noexcept
 {
-	_name = std::string(anm.GetHeader().name.data(), anm.GetHeader().name.size());
-	_unknown_0x20 = anm.GetHeader().unknown0x20;
-	_unknown_0x24 = anm.GetHeader().unknown0x24;
-	_unknown_0x28 = anm.GetHeader().unknown0x28;
-	_unknown_0x2C = anm.GetHeader().unknown0x2C;
-	_unknown_0x30 = anm.GetHeader().unknown0x30;
-	_unknown_0x34 = anm.GetHeader().unknown0x34;
-	assert(anm.GetHeader().frameCount == anm.GetKeyframes().size());
-	_unknown_0x3C = anm.GetHeader().unknown0x3C;
-	_duration = anm.GetHeader().animationDuration;
-	_unknown_0x44 = anm.GetHeader().unknown0x44;
-	_unknown_0x48 = anm.GetHeader().unknown0x48;
-	_unknown_0x50 = anm.GetHeader().unknown0x50;
-
-	_frames.reserve(anm.GetKeyframes().size());
-	for (const auto& keyframe : anm.GetKeyframes())
+	baked::BakedFile baked;
+	const auto result = baked.BakeAnimation(anm, {});
+	if (result != baked::BakedResult::Success)
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to bake animation: {}", baked::ResultToStr(result));
+		return;
+	}
+
+	Load(baked);
+}
+
+void L3DAnim::Load(const baked::BakedFile& baked) noexcept
+{
+	const auto& animation = baked.GetAnimationHeader();
+	const auto& header = animation.header;
+	_name = std::string(header.name.data(), header.name.size());
+	_unknown_0x20 = header.unknown0x20;
+	_unknown_0x24 = header.unknown0x24;
+	_unknown_0x28 = header.unknown0x28;
+	_unknown_0x2C = header.unknown0x2C;
+	_unknown_0x30 = header.unknown0x30;
+	_unknown_0x34 = header.unknown0x34;
+	assert(header.frameCount == animation.keyframes.count);
+	_unknown_0x3C = header.unknown0x3C;
+	_duration = header.animationDuration;
+	_unknown_0x44 = header.unknown0x44;
+	_unknown_0x48 = header.unknown0x48;
+	_unknown_0x50 = header.unknown0x50;
+
+	const auto keyframes = baked.Get<baked::BakedKeyframe>(animation.keyframes);
+	_frames.clear();
+	_frames.reserve(keyframes.size());
+	for (const auto& keyframe : keyframes)
 	{
 		auto& frame = _frames.emplace_back();
 		frame.time = keyframe.time;
-		frame.bones.resize(keyframe.bones.size());
-		for (uint32_t i = 0; i < keyframe.bones.size(); ++i)
+		const auto bones = baked.Get<baked::BakedMatrix>(keyframe.bones);
+		frame.bones.reserve(bones.size());
+		for (const auto& bone : bones)
 		{
-			// clang-format off
-			auto matrix = glm::mat4(keyframe.bones[i].matrix[0], keyframe.bones[i].matrix[1], keyframe.bones[i].matrix[2], 0.0f,
-			                        keyframe.bones[i].matrix[3], keyframe.bones[i].matrix[4], keyframe.bones[i].matrix[5], 0.0f,
-			                        keyframe.bones[i].matrix[6], keyframe.bones[i].matrix[7], keyframe.bones[i].matrix[8], 0.0f,
-			                        keyframe.bones[i].matrix[9], keyframe.bones[i].matrix[10], keyframe.bones[i].matrix[11], 1.0f);
-			// clang-format on
-			frame.bones[i] = matrix;
+			frame.bones.emplace_back(glm::make_mat4(bone.data()));
 		}
+		if (bones.size() != animation.boneCount)
+		{
+			SPDLOG_LOGGER_WARN(spdlog::get("game"), "Animation {} has frames with different bone counts", _name);
+		}
+	}
+
+	// Rotations and translations were decomposed from the matrices when baking, for interpolation
+	_boneCount = animation.boneCount;
+	const auto times = baked.Get<uint32_t>(animation.times);
+	_times.assign(times.begin(), times.end());
+	const auto rotations = baked.Get<std::array<float, 4>>(animation.rotations);
+	_rotations.clear();
+	_rotations.reserve(rotations.size());
+	for (const auto& [x, y, z, w] : rotations)
+	{
+		_rotations.emplace_back(w, x, y, z);
+	}
+	const auto translations = baked.Get<std::array<float, 3>>(animation.translations);
+	_translations.clear();
+	_translations.reserve(translations.size());
+	for (const auto& translation : translations)
+	{
+		_translations.emplace_back(glm::make_vec3(translation.data()));
+	}
+	_rigid = animation.rigid != 0;
+	if (!_rigid)
+	{
+		SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Animation {} is not rigid, falling back to matrix interpolation", _name);
 	}
 }
 
@@ -78,7 +121,9 @@ bool L3DAnim::LoadFromFile(const std::filesystem::path& path) noexcept
 	SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading L3DAnim from file: {}", path.generic_string());
 	anm::ANMFile anm;
 
-	const auto result = anm.Open(Locator::filesystem::value().FindPath(path));
+	// Read through the file system so that files in mounted archives are found
+	auto& fileSystem = Locator::filesystem::value();
+	const auto result = fileSystem.Exists(path) ? anm.Open(fileSystem.ReadAll(path)) : anm::ANMResult::ErrCantOpen;
 	if (result != anm::ANMResult::Success)
 	{
 		SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to open l3d mesh from filesystem {}: {}", path.generic_string(),
@@ -110,54 +155,107 @@ bool L3DAnim::LoadFromBuffer(const std::vector<uint8_t>& data) noexcept
 
 std::vector<glm::mat4> L3DAnim::GetBoneMatrices(uint32_t time) const noexcept
 {
-	if (_frames.empty())
+	std::vector<glm::mat4> bones(_boneCount);
+	SampleBoneMatrices(time, bones);
+	return bones;
+}
+
+uint32_t L3DAnim::FindFrame(uint32_t animationTime, SampleCursor* cursor) const noexcept
+{
+	const auto frameCount = static_cast<uint32_t>(_times.size());
+
+	// Playing forward usually lands on the cached keyframe or the one after it
+	if (cursor != nullptr && cursor->frame < frameCount)
 	{
-		return {};
+		for (uint32_t index = cursor->frame; index < std::min(cursor->frame + 2, frameCount); ++index)
+		{
+			const bool afterPrevious = index == 0 || _times[index - 1] < animationTime;
+			if (afterPrevious && animationTime <= _times[index])
+			{
+				cursor->frame = index;
+				return index;
+			}
+		}
 	}
-	if (_duration == 0)
+
+	const auto index =
+	    static_cast<uint32_t>(std::distance(_times.begin(), std::lower_bound(_times.begin(), _times.end(), animationTime)));
+	if (cursor != nullptr)
 	{
-		return _frames[0].bones;
+		cursor->frame = index;
 	}
-	uint32_t animationTime = time % _duration;
-	uint32_t index = 0;
-	uint32_t previousTime = 0;
-	for (const auto& frame : _frames)
+	return index;
+}
+
+void L3DAnim::SampleFrame(uint32_t animationTime, uint32_t index, std::span<glm::mat4> bones) const noexcept
+{
+	assert(bones.size() >= _boneCount);
+
+	// No interpolation needed
+	if (index == 0 || index >= _times.size())
 	{
-		if (frame.time < animationTime)
-		{
-			previousTime = frame.time;
-			index++;
-		}
-		else
+		const auto& frame = _frames[std::min(index, static_cast<uint32_t>(_frames.size() - 1))];
+		std::copy_n(frame.bones.begin(), std::min(frame.bones.size(), bones.size()), bones.begin());
+		return;
+	}
+
+	const uint32_t previousTime = _times[index - 1];
+	const float t = static_cast<float>(animationTime - previousTime) / static_cast<float>(_times[index] - previousTime);
+
+	if (_rigid)
+	{
+		const auto* rotations0 = &_rotations[(index - 1) * _boneCount];
+		const auto* rotations1 = &_rotations[index * _boneCount];
+		const auto* translations0 = &_translations[(index - 1) * _boneCount];
+		const auto* translations1 = &_translations[index * _boneCount];
+		for (uint32_t i = 0; i < _boneCount; ++i)
 		{
-			break;
+			auto bone = glm::mat4_cast(glm::slerp(rotations0[i], rotations1[i], t));
+			bone[3] = glm::vec4(glm::mix(translations0[i], translations1[i], t), 1.0f);
+			bones[i] = bone;
 		}
+		return;
 	}
-	// No interpolation needed
-	if (index == 0)
+
+	// Matrices with scale or shear can't be decomposed, interpolate them directly
+	const auto& previous = _frames[index - 1].bones;
+	const auto& next = _frames[index].bones;
+	for (uint32_t i = 0; i < std::min({static_cast<uint32_t>(bones.size()), static_cast<uint32_t>(previous.size()),
+	                                   static_cast<uint32_t>(next.size())});
+	     ++i)
 	{
-		return _frames[0].bones;
+		bones[i] = glm::mat4(glm::mix(previous[i][0], next[i][0], t), glm::mix(previous[i][1], next[i][1], t),
+		                     glm::mix(previous[i][2], next[i][2], t), glm::mix(previous[i][3], next[i][3], t));
 	}
-	if (index >= _frames.size())
+}
+
+void L3DAnim::SampleBoneMatrices(uint32_t time, std::span<glm::mat4> bones, SampleCursor* cursor) const noexcept
+{
+	if (_frames.empty())
+	{
+		return;
+	}
+	if (_duration == 0)
 	{
-		return _frames[_frames.size() - 1].bones;
+		SampleFrame(0, 0, bones);
+		return;
 	}
-	float t = static_cast<float>(animationTime - previousTime) / (_frames[index].time - previousTime);
+	const uint32_t animationTime = time % _duration;
+	SampleFrame(animationTime, FindFrame(animationTime, cursor), bones);
+}
 
-	// Interpolate
-	std::vector<glm::mat4> bones;
-	bones.resize(_frames[index].bones.size());
-	for (uint32_t i = 0; i < bones.size(); ++i)
+void L3DAnim::SampleBoneMatrices(std::span<const uint32_t> times, std::span<glm::mat4> bones) const noexcept
+{
+	assert(bones.size() >= times.size() * _boneCount);
+	if (_frames.empty())
 	{
-		// Doing matrix interpolation is not ideal. Would prefer quaternions but
-		// extracting a quaternion from a glm::mat4 does not reconstruct the
-		// same matrix from the quaternion.
-		bones[i] = glm::mat4(glm::mix(_frames[index - 1].bones[i][0], _frames[index].bones[i][0], t),
-		                     glm::mix(_frames[index - 1].bones[i][1], _frames[index].bones[i][1], t),
-		                     glm::mix(_frames[index - 1].bones[i][2], _frames[index].bones[i][2], t),
-		                     glm::mix(_frames[index - 1].bones[i][3], _frames[index].bones[i][3], t));
+		return;
 	}
 
-	// assert(index < _frames.size());
-	return bones;
+	// Instances are usually close in time so reuse one cursor for all of them
+	SampleCursor cursor;
+	for (size_t i = 0; i < times.size(); ++i)
+	{
+		SampleBoneMatrices(times[i], bones.subspan(i * _boneCount, _boneCount), &cursor);
+	}
 }
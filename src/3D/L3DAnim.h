@@ -12,9 +12,12 @@
 #include <cstdint>
 
 #include <filesystem>
+#include <span>
 #include <vector>
 
-#include <glm/fwd.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
 
 namespace openblack
 {
@@ -23,6 +26,11 @@ namespace anm
 class ANMFile;
 } // namespace anm
 
+namespace baked
+{
+class BakedFile;
+} // namespace baked
+
 namespace debug::gui
 {
 class MeshViewer;
@@ -37,10 +45,19 @@ class L3DAnim
 		std::vector<glm::mat4> bones;
 	};
 
+	/// Remembers the keyframe found by the last sample so that playing forward doesn't need to search the keyframes.
+	/// A cursor is only valid for the animation it was used with.
+	struct SampleCursor
+	{
+		uint32_t frame {0};
+	};
+
 	L3DAnim() noexcept = default;
 	virtual ~L3DAnim() noexcept = default;
 
+	/// Bake the animation in memory and load it
 	void Load(const anm::ANMFile& anm) noexcept;
+	void Load(const baked::BakedFile& baked) noexcept;
 	bool LoadFromFilesystem(const std::filesystem::path& path) noexcept;
 	bool LoadFromFile(const std::filesystem::path& path) noexcept;
 	bool LoadFromBuffer(const std::vector<uint8_t>& data) noexcept;
@@ -48,9 +65,21 @@ class L3DAnim
 	[[nodiscard]] const std::string& GetName() const noexcept { return _name; }
 	[[nodiscard]] uint32_t GetDuration() const noexcept { return _duration; }
 	[[nodiscard]] const std::vector<Frame>& GetFrames() const noexcept { return _frames; }
+	[[nodiscard]] uint32_t GetBoneCount() const noexcept { return _boneCount; }
 	[[nodiscard]] std::vector<glm::mat4> GetBoneMatrices(uint32_t time) const noexcept;
+	/// Interpolate the local bone matrices at a time without allocating.
+	/// @param bones Output span of at least \ref GetBoneCount matrices.
+	/// @param cursor Optional keyframe cache for callers which sample the same animation repeatedly.
+	void SampleBoneMatrices(uint32_t time, std::span<glm::mat4> bones, SampleCursor* cursor = nullptr) const noexcept;
+	/// Sample many instances of this animation in one call.
+	/// @param bones Output span of at least times.size() * \ref GetBoneCount matrices, one block of bones per time.
+	void SampleBoneMatrices(std::span<const uint32_t> times, std::span<glm::mat4> bones) const noexcept;
 
 private:
+	/// Index of the first keyframe at or after the animation time, equal to the frame count past the last keyframe.
+	[[nodiscard]] uint32_t FindFrame(uint32_t animationTime, SampleCursor* cursor) const noexcept;
+	void SampleFrame(uint32_t animationTime, uint32_t index, std::span<glm::mat4> bones) const noexcept;
+
 	std::string _name;
 	uint32_t _unknown_0x20; // TODO(#471): Seems to be a uint16_t padded
 	float _unknown_0x24;    // TODO(#471)
@@ -66,6 +95,15 @@ class L3DAnim
 
 	std::vector<Frame> _frames;
 
+	// Keyframes as structures of arrays, bone i of frame f is at f * _boneCount + i
+	uint32_t _boneCount {0};
+	std::vector<uint32_t> _times;
+	std::vector<glm::quat> _rotations;
+	std::vector<glm::vec3> _translations;
+	/// False if any bone matrix has scale or shear which a rotation and translation can't reproduce, in which case
+	/// the matrices in _frames are interpolated instead.
+	bool _rigid {true};
+
 	friend debug::gui::MeshViewer; // TODO(#471): Remove me once the unknowns are known and replace with getters
 };
 
@@ -12,6 +12,7 @@
 #include <filesystem>
 #include <stdexcept>
 
+#include <BakedFile.h>
 #include <BulletCollision/CollisionShapes/btConvexHullShape.h>
 #include <L3DFile.h>
 #include <glm/gtc/type_ptr.hpp>
@@ -36,114 +37,96 @@ L3DMesh::L3DMesh(std::string debugName) noexcept
 
 L3DMesh::~L3DMesh() noexcept = default;
 
+const bgfx::Memory* openblack::graphics::MakeBakedRef(const std::shared_ptr<const baked::BakedFile>& baked, const void* data,
+                                                      size_t size)
+{
+	// Released by bgfx once uploaded, which can be after the owner of the buffer was destroyed
+	auto* owner = new std::shared_ptr<const baked::BakedFile>(baked);
+	return bgfx::makeRef(
+	    data, static_cast<uint32_t>(size),
+	    [](void* /*unused*/, void* userData) { delete static_cast<std::shared_ptr<const baked::BakedFile>*>(userData); },
+	    owner);
+}
+
 bool L3DMesh::Load(const l3d::L3DFile& l3d) noexcept
+{
+	auto baked = std::make_shared<baked::BakedFile>();
+	const auto result = baked->BakeMesh(l3d, {});
+	if (result != baked::BakedResult::Success)
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to bake l3d mesh {}: {}", _debugName, baked::ResultToStr(result));
+		return false;
+	}
+
+	return Load(std::move(baked));
+}
+
+bool L3DMesh::Load(std::shared_ptr<const baked::BakedFile> baked) noexcept
 {
 	bool result = true;
 
-	_flags = static_cast<l3d::L3DMeshFlags>(l3d.GetHeader().flags);
-	_nameData = l3d.GetNameData();
-	for (const auto& skin : l3d.GetSkins())
+	const auto& header = baked->GetMeshHeader();
+	_flags = static_cast<l3d::L3DMeshFlags>(header.flags);
+	const auto nameData = baked->Get<char>(header.nameData);
+	_nameData = std::string(nameData.begin(), nameData.end());
+	for (const auto& skin : baked->Get<baked::BakedSkin>(header.skins))
 	{
 		_skins[skin.id] = std::make_unique<Texture2D>(_debugName.c_str());
 		_skins[skin.id]->Create(l3d::L3DTexture::k_Width, l3d::L3DTexture::k_Height, 1, Format::BGRA4, Wrapping::Repeat,
-		                        Filter::Linear, skin.texels.data(),
-		                        static_cast<uint32_t>(skin.texels.size() * sizeof(skin.texels[0])));
+		                        Filter::Linear, MakeBakedRef(baked, baked->Get<uint16_t>(skin.texels)));
 	}
 
-	if (HasDoorPosition() && !l3d.GetExtraPoints().empty())
+	if (header.hasDoorPosition != 0)
 	{
-		_doorPos = glm::vec3(l3d.GetExtraPoints()[0].x, l3d.GetExtraPoints()[0].y, l3d.GetExtraPoints()[0].z);
+		_doorPos = glm::make_vec3(header.doorPosition.data());
 	}
 
-	if (ContainsLandscapeFeature() && l3d.GetFootprint().has_value())
+	const auto footprints = baked->Get<baked::BakedFootprint>(header.footprints);
+	if (!footprints.empty())
 	{
-		struct FootprintVertex
-		{
-			glm::vec2 pos;
-			glm::vec2 texCoord;
-		};
 		VertexDecl decl;
-		decl.reserve(1);
+		decl.reserve(2);
 		decl.emplace_back(VertexAttrib::Attribute::Position, static_cast<uint8_t>(2), VertexAttrib::Type::Float);
 		decl.emplace_back(VertexAttrib::Attribute::TexCoord0, static_cast<uint8_t>(2), VertexAttrib::Type::Float);
 
-		const auto& footprint = *l3d.GetFootprint();
-
 		// TODO (#749) use use std::views::enumerate
-		for (uint32_t i = 1; const auto& entry : footprint.entries)
+		for (uint32_t i = 1; const auto& footprint : footprints)
 		{
 			auto texture = std::make_unique<Texture2D>("footprints/texture/" + _debugName + "/" + std::to_string(i));
 			++i;
-			texture->Create(static_cast<uint16_t>(footprint.header.width), static_cast<uint16_t>(footprint.header.height), 1,
-			                graphics::Format::BGRA4, Wrapping::ClampEdge, Filter::Linear, entry.pixels.data(),
-			                static_cast<uint32_t>(entry.pixels.size() * sizeof(entry.pixels[0])));
-
-			const bgfx::Memory* verticesMem =
-			    bgfx::alloc(static_cast<uint32_t>(sizeof(FootprintVertex) * entry.triangles.size() * 3));
-			auto* vertices = reinterpret_cast<FootprintVertex*>(verticesMem->data);
-			// TODO (#749) Maybe use std::views::enumerate
-			for (uint8_t j = 0; const auto& t : entry.triangles)
-			{
-				for (uint8_t k = 0; k < 3; ++k)
-				{
-					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index): access is bound to size
-					auto& vertex = vertices[j];
-					++j;
-
-					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index): access is bound to size
-					const auto& world = t.world[k];
-					// NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index): access is bound to size
-					const auto& uv = t.texture[k];
-
-					vertex.pos.x = world.x;
-					vertex.pos.y = world.y;
-					vertex.texCoord.x = uv.x / footprint.header.width;
-					vertex.texCoord.y = uv.y / footprint.header.height;
-				}
-			}
-
-			auto* vertexBuffer = new VertexBuffer("footprints/quad/" + _debugName + "/" + std::to_string(i), verticesMem, decl);
+			texture->Create(static_cast<uint16_t>(footprint.width), static_cast<uint16_t>(footprint.height), 1,
+			                graphics::Format::BGRA4, Wrapping::ClampEdge, Filter::Linear,
+			                MakeBakedRef(baked, baked->Get<uint16_t>(footprint.pixels)));
+
+			auto* vertexBuffer =
+			    new VertexBuffer("footprints/quad/" + _debugName + "/" + std::to_string(i),
+			                     MakeBakedRef(baked, baked->Get<baked::BakedFootprintVertex>(footprint.vertices)), decl);
 			auto mesh = std::make_unique<Mesh>(vertexBuffer);
 			_footprints.emplace_back(Footprint {std::move(texture), std::move(mesh)});
 		}
 	}
 
-	if (ContainsExtraMetrics() && !l3d.GetExtraMetrics().empty())
+	const auto extraMetrics = baked->Get<baked::BakedMatrix>(header.extraMetrics);
+	_extraMetrics.reserve(extraMetrics.size());
+	for (const auto& e : extraMetrics)
 	{
-		const auto& extraMetrics = l3d.GetExtraMetrics();
-		_extraMetrics.reserve(extraMetrics.size());
-		for (const auto& e : extraMetrics)
-		{
-			_extraMetrics.emplace_back(static_cast<glm::mat4>(glm::make_mat4x3(e.data())));
-		}
+		_extraMetrics.emplace_back(glm::make_mat4(e.data()));
 	}
 
-	std::map<uint32_t, glm::mat4> matrices;
-	const auto& bones = l3d.GetBones();
-	_bonesParents.resize(bones.size());
-	for (uint32_t i = 0; i < bones.size(); ++i)
+	const auto boneParents = baked->Get<uint32_t>(header.boneParents);
+	_bonesParents.assign(boneParents.begin(), boneParents.end());
+	const auto boneMatrices = baked->Get<baked::BakedMatrix>(header.boneMatrices);
+	_bonesDefaultMatrices.reserve(boneMatrices.size());
+	for (const auto& matrix : boneMatrices)
 	{
-		const auto& bone = bones[i];
-		// clang-format off
-		auto matrix = glm::mat4(bone.orientation[0], bone.orientation[1], bone.orientation[2], 0.0f,
-		                        bone.orientation[3], bone.orientation[4], bone.orientation[5], 0.0f,
-		                        bone.orientation[6], bone.orientation[7], bone.orientation[8], 0.0f,
-		                        bone.position.x, bone.position.y, bone.position.z, 1.0f);
-		// clang-format on
-		_bonesParents[i] = bone.parent;
-		if (bone.parent != std::numeric_limits<uint32_t>::max())
-		{
-			matrix = matrices[bone.parent] * matrix;
-		}
-		_bonesDefaultMatrices.emplace_back(matrix);
-		matrices.emplace(i, matrix);
+		_bonesDefaultMatrices.emplace_back(glm::make_mat4(matrix.data()));
 	}
 
-	auto submeshCount = l3d.GetSubmeshHeaders().size();
-	for (uint32_t i = 0; i < submeshCount; ++i)
+	const auto submeshes = baked->Get<baked::BakedSubmesh>(header.submeshes);
+	for (uint32_t i = 0; i < submeshes.size(); ++i)
 	{
 		auto subMesh = std::make_unique<L3DSubMesh>(*this);
-		if (!subMesh->Load(l3d, i))
+		if (!subMesh->Load(baked, i))
 		{
 			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to open L3DSubMesh");
 			result = false;
@@ -151,10 +134,9 @@ bool L3DMesh::Load(const l3d::L3DFile& l3d) noexcept
 		}
 		if (subMesh->GetFlags().isPhysics)
 		{
-			const auto& verticesSpan = l3d.GetVertexSpan(i);
-			auto* physicsMesh =
-			    new btConvexHullShape(reinterpret_cast<const btScalar*>(verticesSpan.data()),
-			                          static_cast<int>(verticesSpan.size()), static_cast<int>(sizeof(verticesSpan[0])));
+			const auto vertices = baked->Get<baked::BakedVertex>(submeshes[i].vertices);
+			auto* physicsMesh = new btConvexHullShape(reinterpret_cast<const btScalar*>(vertices.data()),
+			                                          static_cast<int>(vertices.size()), static_cast<int>(sizeof(vertices[0])));
 			physicsMesh->optimizeConvexHull();
 			_physicsMesh.reset(physicsMesh);
 			// FIXME(bwrsandman): Some meshes have multiple physics meshes
@@ -168,7 +150,8 @@ bool L3DMesh::Load(const l3d::L3DFile& l3d) noexcept
 	// TODO(bwrsandman): if no physics mesh was found, make physics mesh the bounding box
 
 	// TODO(bwrsandman): store vertex and index buffers at mesh level
-	bgfx::frame();
+	// GPU memory is referenced from the baked file which bgfx keeps alive, so meshes can be loaded in the middle of a frame
+	// without a flush
 
 	return result;
 }
@@ -198,7 +181,9 @@ bool L3DMesh::LoadFromFile(const std::filesystem::path& path) noexcept
 	SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading L3DMesh from file: {}", path.generic_string());
 	l3d::L3DFile l3d;
 
-	const auto result = l3d.Open(Locator::filesystem::value().FindPath(path));
+	// Read through the file system so that files in mounted archives are found
+	auto& fileSystem = Locator::filesystem::value();
+	const auto result = fileSystem.Exists(path) ? l3d.Open(fileSystem.ReadAll(path)) : l3d::L3DResult::ErrCantOpen;
 	if (result != l3d::L3DResult::Success)
 	{
 		SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to open l3d mesh from filesystem {}: {}", path.generic_string(),
@@ -215,7 +200,7 @@ bool L3DMesh::LoadFromFile(const std::filesystem::path& path) noexcept
 	return true;
 }
 
-bool L3DMesh::LoadFromBuffer(const std::vector<uint8_t>& data) noexcept
+bool L3DMesh::LoadFromBuffer(std::span<const uint8_t> data) noexcept
 {
 	l3d::L3DFile l3d;
 
@@ -11,7 +11,9 @@
 
 #include <filesystem>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <span>
 #include <unordered_map>
 #include <vector>
 
@@ -24,8 +26,18 @@
 
 class btConvexShape;
 
+namespace bgfx
+{
+struct Memory;
+}
+
 namespace openblack
 {
+namespace baked
+{
+class BakedFile;
+}
+
 namespace l3d
 {
 class L3DFile;
@@ -80,6 +92,15 @@ inline l3d::L3DMeshFlags operator&(l3d::L3DMeshFlags a, l3d::L3DMeshFlags b)
 	                                      static_cast<std::underlying_type<l3d::L3DMeshFlags>::type>(b));
 }
 
+/// Reference baked data in an upload instead of copying it, the file is kept alive until bgfx is done with the data
+const bgfx::Memory* MakeBakedRef(const std::shared_ptr<const baked::BakedFile>& baked, const void* data, size_t size);
+
+template <typename T>
+const bgfx::Memory* MakeBakedRef(const std::shared_ptr<const baked::BakedFile>& baked, std::span<const T> data)
+{
+	return MakeBakedRef(baked, data.data(), data.size_bytes());
+}
+
 class L3DMesh
 {
 public:
@@ -91,10 +112,13 @@ class L3DMesh
 	explicit L3DMesh(std::string debugName = "") noexcept;
 	virtual ~L3DMesh() noexcept;
 
+	/// Bake the mesh in memory and load it
 	bool Load(const l3d::L3DFile& l3d) noexcept;
+	/// Create the buffers of a baked mesh, they reference the data of the file rather than copying it
+	bool Load(std::shared_ptr<const baked::BakedFile> baked) noexcept;
 	bool LoadFromFilesystem(const std::filesystem::path& path) noexcept;
 	bool LoadFromFile(const std::filesystem::path& path) noexcept;
-	bool LoadFromBuffer(const std::vector<uint8_t>& data) noexcept;
+	bool LoadFromBuffer(std::span<const uint8_t> data) noexcept;
 
 	[[nodiscard]] uint8_t GetNumSubMeshes() const { return static_cast<uint8_t>(_subMeshes.size()); }
 	[[nodiscard]] const std::vector<std::unique_ptr<L3DSubMesh>>& GetSubMeshes() const { return _subMeshes; }
@@ -9,6 +9,9 @@
 
 #include "L3DSubMesh.h"
 
+#include <cstring>
+
+#include <BakedFile.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/component_wise.hpp>
 #include <glm/gtx/vec_swizzle.hpp>
@@ -24,14 +27,6 @@ using namespace openblack::graphics;
 namespace openblack
 {
 
-struct EnhancedL3DVertex
-{
-	glm::vec3 pos;
-	glm::vec2 uv;
-	glm::vec3 norm;
-	glm::i16vec2 index;
-};
-
 L3DSubMesh::L3DSubMesh(L3DMesh& mesh) noexcept
     : _l3dMesh(mesh)
 {
@@ -39,117 +34,24 @@ L3DSubMesh::L3DSubMesh(L3DMesh& mesh) noexcept
 
 L3DSubMesh::~L3DSubMesh() noexcept = default;
 
-bool L3DSubMesh::Load(const l3d::L3DFile& l3d, uint32_t meshIndex) noexcept
+bool L3DSubMesh::Load(const std::shared_ptr<const baked::BakedFile>& baked, uint32_t meshIndex) noexcept
 {
-	const auto& header = l3d.GetSubmeshHeaders()[meshIndex];
-	const auto primitiveSpan = l3d.GetPrimitiveSpan(meshIndex);
-	const auto& verticesSpan = l3d.GetVertexSpan(meshIndex);
-	const auto& indexSpan = l3d.GetIndexSpan(meshIndex);
-	const auto& vertexGroupSpans = l3d.GetVertexGroupSpan(meshIndex);
-	const auto& boneSpans = l3d.GetBoneSpan(meshIndex);
-
-	_flags = header.flags;
-
-	// Count vertices and indices
-	uint32_t nVertices = 0;
-	uint32_t nIndices = 0;
-	for (auto& primitive : primitiveSpan)
-	{
-		nVertices += primitive.numVertices;
-		nIndices += primitive.numTriangles * 3;
-	}
+	const auto& submesh = baked->Get<baked::BakedSubmesh>(baked->GetMeshHeader().submeshes)[meshIndex];
+	const auto vertices = baked->Get<baked::BakedVertex>(submesh.vertices);
+	const auto indices = baked->Get<uint16_t>(submesh.indices);
 
-	// Construct bounding box
-	_boundingBox.maxima = glm::vec3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
-	_boundingBox.minima = glm::vec3(FLT_MAX, FLT_MAX, FLT_MAX);
-	if (_flags.hasBones)
-	{
-		for (auto& primitive : primitiveSpan)
-		{
-			uint32_t vertexOffset = 0;
-			for (uint32_t i = 0; i < primitive.numGroups; ++i)
-			{
-				auto matrix = glm::identity<glm::mat4>();
-				for (uint32_t parent = vertexGroupSpans[i].boneIndex; parent != std::numeric_limits<uint32_t>::max();
-				     parent = boneSpans[parent].parent)
-				{
-					const auto& bone = boneSpans[parent];
-					const auto orientation = glm::make_mat3(bone.orientation.data());
-					const auto translation = glm::make_vec3(&bone.position.x) * orientation;
-					const auto local = glm::translate(glm::mat4(orientation), translation);
-					matrix = local * matrix;
-				}
-
-				for (uint32_t j = 0; j < vertexGroupSpans[i].vertexCount; ++j)
-				{
-					const auto& vertex = verticesSpan[vertexOffset + j];
-					const auto position = glm::xyz(matrix * glm::vec4(glm::make_vec3(&vertex.position.x), 1.0f));
-					_boundingBox.maxima = glm::max(_boundingBox.maxima, position);
-					_boundingBox.minima = glm::min(_boundingBox.minima, position);
-				}
-				vertexOffset += vertexGroupSpans[i].vertexCount;
-			}
-		}
-	}
-	else
-	{
-		for (uint32_t i = 0; i < nVertices; i++)
-		{
-			const auto position = glm::make_vec3(&verticesSpan[i].position.x);
-			_boundingBox.maxima = glm::max(_boundingBox.maxima, position);
-			_boundingBox.minima = glm::min(_boundingBox.minima, position);
-		}
-	}
+	static_assert(sizeof(_flags) == sizeof(submesh.flags));
+	std::memcpy(&_flags, &submesh.flags, sizeof(_flags));
+	_boundingBox.minima = glm::make_vec3(submesh.minima.data());
+	_boundingBox.maxima = glm::make_vec3(submesh.maxima.data());
 
-	if (nVertices == 0)
+	if (vertices.empty() || indices.empty())
 	{
 		return false;
 	}
 
-	// Get vertices
-	const bgfx::Memory* verticesMem = bgfx::alloc(sizeof(EnhancedL3DVertex) * nVertices);
-	auto* verticesMemAccess = reinterpret_cast<EnhancedL3DVertex*>(verticesMem->data);
-	for (uint32_t i = 0; i < nVertices; ++i)
-	{
-		verticesMemAccess[i].pos = glm::make_vec3(&verticesSpan[i].position.x);
-		verticesMemAccess[i].uv = glm::make_vec2(&verticesSpan[i].texCoord.x);
-		// TODO(bwrsandman): build normals from mesh
-		verticesMemAccess[i].norm = glm::make_vec3(&verticesSpan[i].normal.x);
-		verticesMemAccess[i].index.x = -1;
-		verticesMemAccess[i].index.y = -1;
-	}
-
-	if (nIndices == 0)
+	for (const auto& primitive : baked->Get<baked::BakedPrimitive>(submesh.primitives))
 	{
-		return false;
-	}
-
-	// Get Indices
-	const bgfx::Memory* indicesMem = bgfx::alloc(sizeof(uint16_t) * nIndices);
-	auto* indices = reinterpret_cast<uint16_t*>(indicesMem->data);
-
-	// Fill bone index
-	uint32_t vertexIndex = 0;
-	for (auto& vertexGroupSpan : vertexGroupSpans)
-	{
-		for (uint32_t i = 0; i < vertexGroupSpan.vertexCount; ++i)
-		{
-			verticesMemAccess[vertexIndex].index[0] = vertexGroupSpan.boneIndex;
-			verticesMemAccess[vertexIndex].index[1] = -1;
-			vertexIndex++;
-		}
-	}
-
-	uint16_t startIndex = 0;
-	uint16_t startVertex = 0;
-	for (auto& primitive : primitiveSpan)
-	{
-		// Fix indices for merged vertex buffer
-		for (uint32_t j = 0; j < primitive.numTriangles * 3; j++)
-		{
-			indices[startIndex + j] = indexSpan[startIndex + j] + startVertex;
-		}
-
 		struct MaterialTypeLutEntry
 		{
 			bool depthWrite;
@@ -181,25 +83,22 @@ bool L3DSubMesh::Load(const l3d::L3DFile& l3d, uint32_t meshIndex) noexcept
 		        {true, true, L3DSubMesh::Primitive::BlendMode::Standard, false, true},    // ChromaJustZ
 		    }};
 
-		assert(static_cast<uint32_t>(primitive.material.type) != 0xe);
-		assert(static_cast<uint32_t>(primitive.material.type) != 0x11);
-		const auto& lutEntry = materialTypeLut.at(static_cast<uint32_t>(primitive.material.type));
+		assert(primitive.materialType != 0xe);
+		assert(primitive.materialType != 0x11);
+		const auto& lutEntry = materialTypeLut.at(primitive.materialType);
 
 		// TODO(bwrsandman): Interpret cull mode, color byte ordering and render mode, then store in primitive
 		_primitives.emplace_back(Primitive {
-		    primitive.material.skinID,
-		    startIndex,
-		    primitive.numTriangles * 3,
+		    primitive.skinId,
+		    primitive.indicesOffset,
+		    primitive.indicesCount,
 		    lutEntry.depthWrite,
 		    lutEntry.alphaTest,
 		    lutEntry.blend,
 		    lutEntry.modulateAlpha,
 		    lutEntry.thresholdAlpha,
-		    primitive.material.alphaCutoutThreshold / 255.0f,
+		    primitive.alphaCutoutThreshold,
 		});
-
-		startVertex += static_cast<uint16_t>(primitive.numVertices);
-		startIndex += static_cast<uint16_t>(primitive.numTriangles * 3);
 	}
 
 	VertexDecl decl;
@@ -209,13 +108,16 @@ bool L3DSubMesh::Load(const l3d::L3DFile& l3d, uint32_t meshIndex) noexcept
 	decl.emplace_back(VertexAttrib::Attribute::Normal, static_cast<uint8_t>(3), VertexAttrib::Type::Float);
 	decl.emplace_back(VertexAttrib::Attribute::Indices, static_cast<uint8_t>(2), VertexAttrib::Type::Int16);
 
+	static_assert(sizeof(baked::BakedVertex) == (3 + 2 + 3) * sizeof(float) + 2 * sizeof(int16_t),
+	              "Vertices are uploaded as baked");
+
 	// build our buffers
-	auto* vertexBuffer = new VertexBuffer(_l3dMesh.GetDebugName(), verticesMem, decl);
-	auto* indexBuffer = new IndexBuffer(_l3dMesh.GetDebugName(), indicesMem, IndexBuffer::Type::Uint16);
+	auto* vertexBuffer = new VertexBuffer(_l3dMesh.GetDebugName(), MakeBakedRef(baked, vertices), decl);
+	auto* indexBuffer = new IndexBuffer(_l3dMesh.GetDebugName(), MakeBakedRef(baked, indices), IndexBuffer::Type::Uint16);
 	_mesh = std::make_unique<graphics::Mesh>(vertexBuffer, indexBuffer);
 
 	SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "{} submesh {} with {} verts and {} indices", _l3dMesh.GetDebugName(), meshIndex,
-	                    nVertices, nIndices);
+	                    vertices.size(), indices.size());
 	return true;
 }
 
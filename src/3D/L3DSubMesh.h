@@ -21,6 +21,11 @@
 
 #include "../Graphics/RenderPass.h"
 
+namespace openblack::baked
+{
+class BakedFile;
+}
+
 namespace openblack::graphics
 {
 class L3DMesh;
@@ -29,6 +34,7 @@ class ShaderProgram;
 
 class L3DSubMesh
 {
+public:
 	struct Primitive
 	{
 		enum class BlendMode : uint8_t
@@ -49,11 +55,10 @@ class L3DSubMesh
 		float alphaCutoutThreshold;
 	};
 
-public:
 	explicit L3DSubMesh(graphics::L3DMesh& mesh) noexcept;
 	~L3DSubMesh() noexcept;
 
-	bool Load(const l3d::L3DFile& l3d, uint32_t meshIndex) noexcept;
+	bool Load(const std::shared_ptr<const baked::BakedFile>& baked, uint32_t meshIndex) noexcept;
 
 	[[nodiscard]] openblack::l3d::L3DSubmeshHeader::Flags GetFlags() const { return _flags; }
 	[[nodiscard]] bool IsPhysics() const { return _flags.isPhysics; }
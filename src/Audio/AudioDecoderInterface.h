@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
 
@@ -19,7 +20,7 @@ namespace openblack::audio
 class AudioDecoderInterface
 {
 public:
-	virtual bool Open(const std::vector<uint8_t>& buffer) = 0;
+	virtual bool Open(std::span<const uint8_t> buffer) = 0;
 	virtual void Read(std::vector<int16_t>& buffer) = 0;
 	[[nodiscard]] virtual ChannelLayout GetChannelLayout() = 0;
 };
@@ -11,9 +11,13 @@
 
 #include "AudioManager.h"
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
+#include <span>
 
 #include <PackFile.h>
+#include <glm/geometric.hpp>
 #include <glm/gtc/constants.hpp>
 #include <spdlog/spdlog.h>
 
@@ -22,9 +26,7 @@
 #include "ECS/Registry.h"
 #include "FileSystem/FileSystemInterface.h"
 #include "Locator.h"
-#include "MpegAudioDecoder.h"
 #include "Resources/Resources.h"
-#include "WavAudioDecoder.h"
 
 using namespace openblack::ecs::components;
 
@@ -35,21 +37,17 @@ AudioManager::AudioManager()
     : _audioPlayer(new AudioPlayer())
 {
 	_audioPlayer->Initialize();
+	_pcmCache = std::make_unique<PcmCache>(*_audioPlayer, PcmCache::GetDefaultThreadCount());
+	_audioThread = std::make_unique<AudioThread>(*_audioPlayer);
+	_lastUpdate = std::chrono::steady_clock::now();
 }
 
 AudioManager::~AudioManager()
 {
 	auto& registry = Locator::entitiesRegistry::value();
-	registry.Each<Transform, AudioEmitter>([this](entt::entity entity, const Transform&, const AudioEmitter& emitter) {
-		DestroyEmitter(entity);
-		auto sound = Locator::resources::value().GetSounds().Handle(emitter.soundId);
-		_audioPlayer->DeleteBuffer(sound->bufferId);
-	});
-
-	if (registry.Valid(_musicEntity))
-	{
-		DestroyEmitter(_musicEntity);
-	}
+	registry.Each<Transform, AudioEmitter>(
+	    [this](entt::entity entity, const Transform&, const AudioEmitter&) { DestroyEmitter(entity); });
+	_audioThread.reset();
 }
 
 void AudioManager::Stop()
@@ -62,36 +60,208 @@ void AudioManager::Stop()
 
 void AudioManager::Update()
 {
+	const auto now = std::chrono::steady_clock::now();
+	const auto deltaTime = std::chrono::duration<float>(now - _lastUpdate).count();
+	_lastUpdate = now;
+
+	// Sounds whose buffers were created since the last update can now be acquired
+	while (const auto uploaded = _audioThread->PollUploaded())
+	{
+		--_uploadsInFlight;
+		if (!_pcmCache->Uploaded(uploaded->sound, uploaded->buffer))
+		{
+			_audioThread->Send(AudioThread::DeleteBuffer {uploaded->buffer});
+		}
+	}
+
 	auto& camera = Locator::camera::value();
 	auto pos = camera.GetOrigin();
 	auto vel = camera.GetOriginVelocity();
 	auto forward = camera.GetForward();
 	auto top = camera.GetUp();
-	_audioPlayer->UpdateListener(pos, vel, forward, top);
+
+	// Rank the emitters which want to play, only the highest ranked get a voice
 	auto& registry = Locator::entitiesRegistry::value();
+	_finished.clear();
+	_candidates.clear();
 	registry.Each<Transform, AudioEmitter>(
-	    [this](entt::entity entity, const Transform& transform, const AudioEmitter& emitter) {
-		    auto volume = _globalVolume * emitter.volume;
-		    if (entity == _musicEntity)
+	    [this, deltaTime, pos](entt::entity entity, const Transform& transform, AudioEmitter& emitter) {
+		    if (emitter.state == AudioStatus::Stopped)
+		    {
+			    _finished.push_back(entity);
+			    return;
+		    }
+		    if (emitter.bufferId == 0 && !AcquireSoundBuffer(emitter))
 		    {
-			    volume *= _musicVolume;
+			    if (_pcmCache->HasFailed(emitter.soundId))
+			    {
+				    _finished.push_back(entity);
+			    }
+			    return;
 		    }
-		    else
+		    if (emitter.state != AudioStatus::Playing)
 		    {
-			    volume *= _sfxVolume;
+			    return;
 		    }
-		    _audioPlayer->UpdateSource(emitter.sourceId, transform.position, volume, emitter.loop == PlayType::Repeat);
-		    auto audioStatus = _audioPlayer->GetStatus(emitter.sourceId);
-		    if (audioStatus == AudioStatus::Stopped)
+
+		    emitter.elapsed += deltaTime;
+		    if (emitter.loop == PlayType::Repeat && emitter.duration > 0.0f)
 		    {
-			    DestroyEmitter(entity);
+			    emitter.elapsed = std::fmod(emitter.elapsed, emitter.duration);
 		    }
+		    // Voiced emitters are stopped by their source instead, the elapsed time only estimates where they are
+		    if (emitter.voice < 0 && emitter.loop != PlayType::Repeat && emitter.elapsed >= emitter.duration)
+		    {
+			    _finished.push_back(entity);
+			    return;
+		    }
+		    const auto distance =
+		        emitter.relative ? glm::length(transform.position) : glm::distance(transform.position, pos);
+		    _candidates.push_back({entity, emitter.priority, emitter.volume / (1.0f + distance)});
 	    });
+
+	// Buffers are only ever created by the audio thread
+	for (auto& upload : _pcmCache->TakeUploads(AudioThread::k_MaxUploadsInFlight - _uploadsInFlight))
+	{
+		++_uploadsInFlight;
+		_audioThread->Send(AudioThread::UploadBuffer {upload.id, upload.layout, std::move(upload.pcm), upload.sampleRate});
+	}
+
+	const auto voiceCount = std::min(_candidates.size(), _voices.size());
+	std::partial_sort(_candidates.begin(), _candidates.begin() + static_cast<std::ptrdiff_t>(voiceCount), _candidates.end(),
+	                  [](const VoiceCandidate& a, const VoiceCandidate& b) {
+		                  return a.priority != b.priority ? a.priority > b.priority : a.audibility > b.audibility;
+	                  });
+	const auto voiced = std::span(_candidates).first(voiceCount);
+	const auto isVoiced = [voiced](entt::entity entity) {
+		return std::any_of(voiced.begin(), voiced.end(),
+		                   [entity](const VoiceCandidate& candidate) { return candidate.entity == entity; });
+	};
+	for (auto& voice : _voices)
+	{
+		if (voice.emitter != entt::null && !isVoiced(voice.emitter))
+		{
+			Virtualise(voice);
+		}
+	}
+	for (const auto& candidate : voiced)
+	{
+		if (registry.Get<AudioEmitter>(candidate.entity).voice < 0)
+		{
+			AssignVoice(candidate.entity);
+		}
+	}
+
+	// Only the voices are passed on to the audio thread, which applies the whole frame at once
+	auto& frame = _audioThread->GetFrame();
+	frame.listenerPosition = pos;
+	frame.listenerVelocity = vel;
+	frame.listenerForward = forward;
+	frame.listenerUp = top;
+	frame.musicVolume = _globalVolume * _musicVolume;
+	// Only read once, a newer status may be published over the one which was read before
+	const auto& status = _audioThread->GetStatus();
+	const auto applied = status.applied;
+	for (size_t i = 0; i < _voices.size(); ++i)
+	{
+		const auto& voice = _voices[i];
+		if (voice.emitter == entt::null)
+		{
+			// The buffer holds a frame from two publishes ago, clear it rather than pass on its parameters. Generation 0
+			// is never played.
+			frame.voices[i] = {};
+			continue;
+		}
+		frame.voices[i] = GetVoiceParameters(voice.emitter, voice.generation);
+		// A status of an earlier play of the voice says nothing about this one
+		const auto& voiceStatus = status.voices[i];
+		if (voiceStatus.generation == voice.generation && voiceStatus.status == AudioStatus::Stopped)
+		{
+			_finished.push_back(voice.emitter);
+		}
+	}
+	_audioThread->PublishFrame();
+
+	for (const auto entity : _finished)
+	{
+		DestroyEmitter(entity);
+	}
+
+	_voiceStats.voices = static_cast<uint32_t>(_voices.size());
+	_voiceStats.audible = static_cast<uint32_t>(voiceCount);
+	_voiceStats.virtualised = static_cast<uint32_t>(_candidates.size() - voiceCount);
+
+	const auto released = std::partition(_pendingReleases.begin(), _pendingReleases.end(),
+	                                     [applied](const PendingRelease& release) {
+		                                     return release.sentCount > applied;
+	                                     });
+	for (auto iter = released; iter != _pendingReleases.end(); ++iter)
+	{
+		_pcmCache->Release(iter->soundId);
+	}
+	_pendingReleases.erase(released, _pendingReleases.end());
+
+	// Sounds which have been dropped have to be decoded again before they next play
+	auto& sounds = Locator::resources::value().GetSounds();
+	for (const auto& dropped : _pcmCache->Trim())
+	{
+		if (dropped.buffer != 0)
+		{
+			_audioThread->Send(AudioThread::DeleteBuffer {dropped.buffer});
+		}
+		if (sounds.Contains(dropped.id))
+		{
+			sounds.Handle(dropped.id)->bufferId = 0;
+		}
+	}
 }
 
-BufferId AudioManager::CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate)
+void AudioManager::AssignVoice(entt::entity entity)
 {
-	return _audioPlayer->CreateBuffer(layout, buffer, sampleRate);
+	auto voice = std::find_if(_voices.begin(), _voices.end(), [](const Voice& v) { return v.emitter == entt::null; });
+	if (voice == _voices.end())
+	{
+		return;
+	}
+
+	auto& registry = Locator::entitiesRegistry::value();
+	auto& emitter = registry.Get<AudioEmitter>(entity);
+	const auto index = static_cast<uint32_t>(std::distance(_voices.begin(), voice));
+	voice->emitter = entity;
+	++voice->generation;
+	emitter.voice = static_cast<int>(index);
+	const auto sizeInBytes = Locator::resources::value().GetSounds().Handle(emitter.soundId)->sizeInBytes;
+	// Carry on from where the emitter got to while it had no voice
+	const auto offset = emitter.duration > 0.0f ? std::fmod(emitter.elapsed, emitter.duration) : 0.0f;
+	_audioThread->Send(AudioThread::PlayVoice {index, emitter.bufferId, sizeInBytes, emitter.relative, offset,
+	                                           GetVoiceParameters(entity, voice->generation)});
+}
+
+void AudioManager::Virtualise(Voice& voice)
+{
+	auto& registry = Locator::entitiesRegistry::value();
+	_audioThread->Send(AudioThread::StopVoice {static_cast<uint32_t>(std::distance(_voices.data(), &voice))});
+	registry.Get<AudioEmitter>(voice.emitter).voice = -1;
+	voice.emitter = entt::null;
+}
+
+AudioThread::VoiceParameters AudioManager::GetVoiceParameters(entt::entity entity, uint32_t generation) const
+{
+	auto& registry = Locator::entitiesRegistry::value();
+	const auto& emitter = registry.Get<AudioEmitter>(entity);
+	const auto& transform = registry.Get<Transform>(entity);
+	const auto volume = _globalVolume * emitter.volume * _sfxVolume;
+	return {generation, transform.position, volume, emitter.loop == PlayType::Repeat};
+}
+
+const AudioThread::VoiceStatus* AudioManager::FindVoiceStatus(const AudioEmitter& emitter)
+{
+	if (emitter.voice < 0)
+	{
+		return nullptr;
+	}
+	const auto& status = _audioThread->GetStatus().voices[static_cast<size_t>(emitter.voice)];
+	return status.generation == _voices[static_cast<size_t>(emitter.voice)].generation ? &status : nullptr;
 }
 
 void AudioManager::PlayEmitter(entt::entity emitter)
@@ -99,8 +269,16 @@ void AudioManager::PlayEmitter(entt::entity emitter)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(emitter));
 	auto& emitterComponent = registry.Get<AudioEmitter>(emitter);
-	auto& transform = registry.Get<Transform>(emitter);
-	_audioPlayer->PlaySource(emitterComponent.sourceId, transform.position, 1.f, emitterComponent.loop == PlayType::Repeat);
+	emitterComponent.state = AudioStatus::Playing;
+	if (emitterComponent.voice >= 0)
+	{
+		_audioThread->Send(AudioThread::ResumeVoice {static_cast<uint32_t>(emitterComponent.voice)});
+	}
+	else if (emitterComponent.bufferId != 0)
+	{
+		// Start right away if a voice is free, otherwise Update decides whether it deserves one
+		AssignVoice(emitter);
+	}
 }
 
 void AudioManager::PauseEmitter(entt::entity emitter)
@@ -108,7 +286,11 @@ void AudioManager::PauseEmitter(entt::entity emitter)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(emitter));
 	auto& component = registry.Get<AudioEmitter>(emitter);
-	_audioPlayer->PauseSource(component.sourceId);
+	component.state = AudioStatus::Paused;
+	if (component.voice >= 0)
+	{
+		_audioThread->Send(AudioThread::PauseVoice {static_cast<uint32_t>(component.voice)});
+	}
 }
 
 void AudioManager::StopEmitter(entt::entity emitter)
@@ -116,7 +298,11 @@ void AudioManager::StopEmitter(entt::entity emitter)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(emitter));
 	auto& component = registry.Get<AudioEmitter>(emitter);
-	_audioPlayer->StopSource(component.sourceId);
+	component.state = AudioStatus::Stopped;
+	if (component.voice >= 0)
+	{
+		_audioThread->Send(AudioThread::StopVoice {static_cast<uint32_t>(component.voice)});
+	}
 }
 
 void AudioManager::DestroyEmitter(entt::entity emitter)
@@ -124,7 +310,17 @@ void AudioManager::DestroyEmitter(entt::entity emitter)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(emitter));
 	auto& component = registry.Get<AudioEmitter>(emitter);
-	_audioPlayer->DeleteSource(component.sourceId);
+	if (component.voice >= 0)
+	{
+		auto& voice = _voices[static_cast<size_t>(component.voice)];
+		assert(voice.emitter == emitter);
+		Virtualise(voice);
+	}
+	if (component.bufferId != 0)
+	{
+		// The buffer may still be on a source until the audio thread has caught up
+		_pendingReleases.push_back({_audioThread->GetSentCount(), component.soundId});
+	}
 	registry.Destroy(emitter);
 }
 
@@ -134,55 +330,30 @@ entt::entity AudioManager::CreateEmitter(entt::id_type id, PlayType playType, gl
 	auto sound = Locator::resources::value().GetSounds().Handle(id);
 	auto& registry = Locator::entitiesRegistry::value();
 	auto entity = registry.Create();
-	auto sourceId = _audioPlayer->CreateSource(static_cast<float>(sound->pitch), relative);
-	if (!sound->buffer.empty())
-	{
-		CreateBuffer(sound);
-	}
-	_audioPlayer->QueueBuffer(sourceId, sound->bufferId);
-	registry.Assign<AudioEmitter>(entity, sourceId, id, 0, position, direction, radius, volume, playType, status, relative);
+	// Emitters have no source of their own, they are given one of the voices while they are among the most audible
+	auto& emitter = registry.Assign<AudioEmitter>(entity, -1, id, sound->priority, position, direction, radius,
+	                                              volume, playType, status, relative);
 	registry.Assign<Transform>(entity, glm::zero<glm::vec3>(), glm::one<glm::mat4>(), glm::one<glm::vec3>());
+	// Usually ready when the sound's group was prefetched, otherwise the decode is queued ahead of prefetches
+	AcquireSoundBuffer(emitter);
 	return entity;
 }
 
-void AudioManager::CreateBuffer(Sound& sound)
+bool AudioManager::AcquireSoundBuffer(AudioEmitter& emitter)
 {
-	std::vector<int16_t> decodeBuffer;
-	for (auto& buffer : sound.buffer)
+	auto sound = Locator::resources::value().GetSounds().Handle(emitter.soundId);
+	const auto buffer = _pcmCache->Acquire(emitter.soundId, *sound);
+	if (!buffer.has_value())
 	{
-		bool success;
-		std::vector<int16_t> decoded;
-		{
-			auto decoder = audio::MpegAudioDecoder();
-			success = decoder.Open(buffer);
-			if (success)
-			{
-				decoder.Read(decoded);
-				sound.channelLayout = decoder.GetChannelLayout();
-			}
-		}
-		if (!success)
-		{
-			auto decoder = audio::WavAudioDecoder();
-			success = decoder.Open(buffer);
-			if (success)
-			{
-				decoder.Read(decoded);
-				sound.channelLayout = decoder.GetChannelLayout();
-			}
-		}
-		if (success)
-		{
-			decodeBuffer.insert(decodeBuffer.end(), decoded.begin(), decoded.end());
-		}
-		else
-		{
-			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to decode sound");
-		}
+		return false;
 	}
-	sound.bufferId = CreateBuffer(sound.channelLayout, decodeBuffer, sound.sampleRate);
-	sound.duration = _audioPlayer->GetDuration(sound.bufferId);
-	sound.sizeInBytes = decodeBuffer.size() * sizeof(decodeBuffer[0]);
+	sound->bufferId = buffer->id;
+	sound->channelLayout = buffer->layout;
+	sound->sizeInBytes = buffer->sizeInBytes;
+	sound->duration = buffer->duration;
+	emitter.bufferId = buffer->id;
+	emitter.duration = sound->duration;
+	return true;
 }
 
 bool AudioManager::EmitterExists(entt::entity emitter)
@@ -196,8 +367,11 @@ float AudioManager::GetProgress(entt::entity entity)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(entity));
 	auto& emitter = registry.Get<AudioEmitter>(entity);
-	auto sizeInBytes = Locator::resources::value().GetSounds().Handle(emitter.soundId)->sizeInBytes;
-	return _audioPlayer->GetProgress(sizeInBytes, emitter.sourceId);
+	if (const auto* status = FindVoiceStatus(emitter))
+	{
+		return status->progress;
+	}
+	return emitter.duration > 0.0f ? std::fmod(emitter.elapsed, emitter.duration) / emitter.duration : 0.0f;
 }
 
 AudioStatus AudioManager::GetStatus(entt::entity emitter)
@@ -205,7 +379,9 @@ AudioStatus AudioManager::GetStatus(entt::entity emitter)
 	auto& registry = Locator::entitiesRegistry::value();
 	assert(registry.AnyOf<AudioEmitter>(emitter));
 	auto& component = registry.Get<AudioEmitter>(emitter);
-	return _audioPlayer->GetStatus(component.sourceId);
+	// Virtual emitters, and those whose play the audio thread hasn't started yet, are as good as playing
+	const auto* status = FindVoiceStatus(component);
+	return status != nullptr ? status->status : component.state;
 }
 
 const Sound& AudioManager::GetSound(entt::id_type id)
@@ -223,6 +399,11 @@ void AudioManager::PlaySound(entt::id_type id, PlayType playType)
 	PlayEmitter(entity);
 }
 
+VoiceStats AudioManager::GetVoiceStats() const
+{
+	return _voiceStats;
+}
+
 void AudioManager::CreateSoundGroup(const std::string& name)
 {
 	_soundGroups[name] = SoundGroup();
@@ -238,6 +419,20 @@ void AudioManager::AddToSoundGroup(const std::string& name, entt::id_type id)
 	_soundGroups[name].sounds.emplace_back(id);
 }
 
+void AudioManager::PrefetchSoundGroup(const std::string& name)
+{
+	const auto iter = _soundGroups.find(name);
+	if (iter == _soundGroups.end())
+	{
+		return;
+	}
+	auto& sounds = Locator::resources::value().GetSounds();
+	for (const auto id : iter->second.sounds)
+	{
+		_pcmCache->Prefetch(id, *sounds.Handle(id));
+	}
+}
+
 const SoundGroup& AudioManager::GetSoundGroup(const std::string& name)
 {
 	return _soundGroups[name];
@@ -251,39 +446,29 @@ const std::map<std::string, SoundGroup>& AudioManager::GetSoundGroups()
 void AudioManager::PlayMusic(const std::string& packPath, PlayType type)
 {
 	StopMusic();
-	const entt::id_type id = entt::hashed_string(fmt::format("{}", packPath).c_str());
-	if (!Locator::resources::value().GetSounds().Contains(packPath))
+	auto musicPack = std::make_shared<pack::PackFile>();
+	const auto result = musicPack->Open(packPath);
+	if (result != pack::PackResult::Success)
 	{
-		pack::PackFile soundPack;
-		soundPack.Open(packPath);
-		const auto& audioHeaders = soundPack.GetAudioSampleHeaders();
-		const auto& audioData = soundPack.GetAudioSamplesData();
-		Locator::resources::value().GetSounds().Load(id, resources::SoundLoader::FromBufferTag {}, audioHeaders[0], audioData);
+		SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to open music pack {}: {}", packPath, pack::ResultToStr(result));
+		return;
 	}
-	auto sound = Locator::resources::value().GetSounds().Handle(id);
-	auto position = glm::one<glm::vec3>();
-	auto direction = glm::zero<glm::vec3>();
-	auto radius = glm::zero<glm::vec3>();
-	_musicEntity = CreateEmitter(id, type, position, direction, radius, sound->volume, AudioStatus::Playing, true);
-	PlayEmitter(_musicEntity);
+	// The tracks are decoded as they play, so the pack is mapped for as long as the music plays
+	_audioThread->Send(AudioThread::PlayMusic {std::move(musicPack), type == PlayType::Repeat});
 }
 
 void AudioManager::StopMusic()
 {
-	auto& registry = Locator::entitiesRegistry::value();
-	if (!EmitterExists(_musicEntity))
-	{
-		return;
-	}
-	auto& emitter = registry.Get<AudioEmitter>(_musicEntity);
-	// Clean up the audio player's music resources
-	_audioPlayer->StopSource(emitter.sourceId);
-	_audioPlayer->DeleteSource(emitter.sourceId);
-	[[maybe_unused]] auto music = Locator::resources::value().GetSounds().Handle(emitter.soundId);
-	//	Erase the music resource as it is no longer being played
-	Locator::resources::value().GetSounds().Erase(emitter.soundId);
-	//	Remove the entity
-	registry.Destroy(_musicEntity);
-	_musicEntity = entt::null;
+	_audioThread->Send(AudioThread::StopMusic {});
+}
+
+void AudioManager::SeekMusic(float seconds)
+{
+	_audioThread->Send(AudioThread::SeekMusic {seconds});
+}
+
+float AudioManager::GetMusicPosition() const
+{
+	return _audioThread->GetStatus().musicPosition;
 }
 } // namespace openblack::audio
@@ -9,6 +9,8 @@
 
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <map>
 #include <string>
 #include <type_traits>
@@ -21,6 +23,8 @@
 #include "AudioDecoderInterface.h"
 #include "AudioManagerInterface.h"
 #include "AudioPlayer.h"
+#include "AudioThread.h"
+#include "PcmCache.h"
 #include "SoundGroup.h"
 
 #if !defined(LOCATOR_IMPLEMENTATIONS)
@@ -40,8 +44,6 @@ class AudioManager final: public AudioManagerInterface
 public:
 	AudioManager();
 	~AudioManager();
-	BufferId CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate) override;
-	void CreateBuffer(Sound& sound) override;
 	void PlayEmitter(entt::entity emitter) override;
 	void PauseEmitter(entt::entity emitter) override;
 	void StopEmitter(entt::entity emitter) override;
@@ -53,6 +55,8 @@ class AudioManager final: public AudioManagerInterface
 	[[nodiscard]] AudioStatus GetStatus(entt::entity emitter) override;
 	void PlayMusic(const std::string& packPath, PlayType type) override;
 	void StopMusic() override;
+	void SeekMusic(float seconds) override;
+	[[nodiscard]] float GetMusicPosition() const override;
 	const Sound& GetSound(entt::id_type id) override;
 	void PlaySound(entt::id_type id, PlayType type) override;
 	void SetGlobalVolume(float volume) override { _globalVolume = volume; }
@@ -66,20 +70,70 @@ class AudioManager final: public AudioManagerInterface
 	void CreateSoundGroup(const std::string& name) override;
 	void AddMusicEntry(const std::string& name) override;
 	[[nodiscard]] const std::vector<std::string>& GetMusicTracks() const override { return _music; }
+	[[nodiscard]] VoiceStats GetVoiceStats() const override;
 	void AddToSoundGroup(const std::string& name, entt::id_type id) override;
 	const SoundGroup& GetSoundGroup(const std::string& name) override;
+	void PrefetchSoundGroup(const std::string& name) override;
 	const std::map<std::string, SoundGroup>& GetSoundGroups() override;
 
+	/// Sources shared by the emitters, the rest play silently until they are among the most important
+	static constexpr size_t k_VoiceCount = AudioThread::k_VoiceCount;
+
 private:
+	struct Voice
+	{
+		entt::entity emitter {entt::null};
+		/// Of the latest play of the voice, to tell its status from that of earlier ones
+		uint32_t generation {0};
+	};
+
+	/// A buffer can only be given back to the cache once the audio thread has taken it off its source
+	struct PendingRelease
+	{
+		uint64_t sentCount;
+		entt::id_type soundId;
+	};
+
+	struct VoiceCandidate
+	{
+		entt::entity entity;
+		/// Sound::priority, higher is more important
+		int priority;
+		/// Volume attenuated by distance, to rank emitters of the same priority
+		float audibility;
+	};
+
+	/// Returns false while the sound is being decoded
+	bool AcquireSoundBuffer(ecs::components::AudioEmitter& emitter);
+	/// Does nothing if all voices are taken
+	void AssignVoice(entt::entity entity);
+	/// Stop the voice and leave its emitter to play silently
+	void Virtualise(Voice& voice);
+	[[nodiscard]] AudioThread::VoiceParameters GetVoiceParameters(entt::entity entity, uint32_t generation) const;
+	/// The status of the emitter's voice, if the audio thread has started its latest play
+	[[nodiscard]] const AudioThread::VoiceStatus* FindVoiceStatus(const ecs::components::AudioEmitter& emitter);
+
 	std::unique_ptr<AudioPlayerInterface> _audioPlayer;
+	/// Decoded sounds, destroyed before the player as it deletes its buffers
+	std::unique_ptr<PcmCache> _pcmCache;
 	/// All sounds are loaded
 	std::map<std::string, SoundGroup> _soundGroups;
-	/// Music resources are loaded on demand to avoid storing large audio buffers. There are no resource IDs yet
+	/// Paths of the music packs, which are streamed from their pack when they play
 	std::vector<std::string> _music;
 	float _globalVolume {1.0f};
 	float _musicVolume {1.0f};
 	float _sfxVolume {1.0f};
-	entt::entity _musicEntity {entt::null};
+	std::array<Voice, k_VoiceCount> _voices;
+	/// Reused between updates
+	std::vector<VoiceCandidate> _candidates;
+	std::vector<entt::entity> _finished;
+	std::vector<PendingRelease> _pendingReleases;
+	/// UploadBuffer commands whose buffers have not been polled yet
+	size_t _uploadsInFlight {0};
+	VoiceStats _voiceStats {};
+	std::chrono::steady_clock::time_point _lastUpdate;
+	/// Plays the voices and the music, destroyed first as it uses the player and the buffers of the cache
+	std::unique_ptr<AudioThread> _audioThread;
 };
 
 } // namespace openblack::audio
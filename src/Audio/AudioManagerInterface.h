@@ -25,13 +25,21 @@ namespace openblack
 namespace audio
 {
 
+struct VoiceStats
+{
+	/// Sources shared by the emitters
+	uint32_t voices;
+	/// Emitters playing on a voice
+	uint32_t audible;
+	/// Emitters which are playing but too quiet or unimportant to have a voice
+	uint32_t virtualised;
+};
+
 class AudioManagerInterface
 {
 public:
 	virtual void Stop() = 0;
 	virtual void Update() = 0;
-	virtual BufferId CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate) = 0;
-	virtual void CreateBuffer(Sound& sound) = 0;
 	virtual void PlayEmitter(entt::entity emitter) = 0;
 	virtual void PauseEmitter(entt::entity emitter) = 0;
 	virtual void StopEmitter(entt::entity emitter) = 0;
@@ -49,14 +57,20 @@ class AudioManagerInterface
 	[[nodiscard]] virtual float GetMusicVolume() = 0;
 	virtual void PlayMusic(const std::string& packPath, PlayType type) = 0;
 	virtual void StopMusic() = 0;
+	/// Seconds from the start of the music pack
+	virtual void SeekMusic(float seconds) = 0;
+	[[nodiscard]] virtual float GetMusicPosition() const = 0;
 	virtual void PlaySound(entt::id_type id, PlayType type) = 0;
 	virtual const Sound& GetSound(entt::id_type id) = 0;
 	virtual void CreateSoundGroup(const std::string& name) = 0;
 	virtual void AddToSoundGroup(const std::string& name, entt::id_type id) = 0;
 	virtual const SoundGroup& GetSoundGroup(const std::string& name) = 0;
+	/// Decode the sounds of a group in the background so that they are ready when they are first played
+	virtual void PrefetchSoundGroup(const std::string& name) = 0;
 	virtual const std::map<std::string, SoundGroup>& GetSoundGroups() = 0;
 	virtual void AddMusicEntry(const std::string& name) = 0;
 	[[nodiscard]] virtual const std::vector<std::string>& GetMusicTracks() const = 0;
+	[[nodiscard]] virtual VoiceStats GetVoiceStats() const = 0;
 };
 } // namespace audio
 } // namespace openblack
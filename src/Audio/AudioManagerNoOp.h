@@ -21,12 +21,6 @@ namespace openblack::audio
 class AudioManagerNoOp final: public AudioManagerInterface
 {
 public:
-	BufferId CreateBuffer([[maybe_unused]] ChannelLayout layout, [[maybe_unused]] const std::vector<int16_t>& buffer,
-	                      [[maybe_unused]] int sampleRate) override
-	{
-		return 0;
-	}
-	void CreateBuffer([[maybe_unused]] Sound& sound) override {}
 	void PlayEmitter([[maybe_unused]] entt::entity emitter) override {}
 	void PauseEmitter([[maybe_unused]] entt::entity emitter) override {}
 	void StopEmitter([[maybe_unused]] entt::entity emitter) override {}
@@ -43,6 +37,8 @@ class AudioManagerNoOp final: public AudioManagerInterface
 	[[nodiscard]] AudioStatus GetStatus([[maybe_unused]] entt::entity emitter) override { return {}; }
 	void PlayMusic([[maybe_unused]] const std::string& packPath, [[maybe_unused]] PlayType type) override {}
 	void StopMusic() override {}
+	void SeekMusic([[maybe_unused]] float seconds) override {}
+	[[nodiscard]] float GetMusicPosition() const override { return 0.0f; }
 	const Sound& GetSound([[maybe_unused]] entt::id_type id) override
 	{
 		static const Sound result {};
@@ -64,12 +60,14 @@ class AudioManagerNoOp final: public AudioManagerInterface
 		static const std::vector<std::string> result;
 		return result;
 	}
+	[[nodiscard]] VoiceStats GetVoiceStats() const override { return {}; }
 	void AddToSoundGroup([[maybe_unused]] const std::string& name, [[maybe_unused]] entt::id_type id) override {}
 	const SoundGroup& GetSoundGroup([[maybe_unused]] const std::string& name) override
 	{
 		static const SoundGroup result;
 		return result;
 	}
+	void PrefetchSoundGroup([[maybe_unused]] const std::string& name) override {}
 	const std::map<std::string, SoundGroup>& GetSoundGroups() override
 	{
 		static const std::map<std::string, SoundGroup> result;
@@ -111,6 +111,20 @@ void AudioPlayer::UpdateListener(glm::vec3 pos, glm::vec3 vel, glm::vec3 front,
 }
 
 BufferId AudioPlayer::CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate)
+{
+	const auto id = CreateBuffer();
+	FillBuffer(id, layout, buffer, sampleRate);
+	return id;
+}
+
+BufferId AudioPlayer::CreateBuffer()
+{
+	BufferId id;
+	alCheckCall(alGenBuffers(1, &id));
+	return id;
+}
+
+void AudioPlayer::FillBuffer(BufferId id, ChannelLayout layout, std::span<const int16_t> buffer, int sampleRate)
 {
 	int playerLayout;
 	if (layout == ChannelLayout::Mono)
@@ -125,11 +139,8 @@ BufferId AudioPlayer::CreateBuffer(ChannelLayout layout, const std::vector<int16
 	{
 		throw std::runtime_error("Unknown channel layout");
 	}
-	BufferId id;
-	alCheckCall(alGenBuffers(1, &id));
-	auto bufferSize = static_cast<ALsizei>(buffer.size() * sizeof(buffer[0]));
+	auto bufferSize = static_cast<ALsizei>(buffer.size_bytes());
 	alCheckCall(alBufferData(id, playerLayout, buffer.data(), bufferSize, sampleRate));
-	return id;
 }
 
 void AudioPlayer::QueueBuffer(SourceId sourceId, BufferId bufferId)
@@ -137,6 +148,32 @@ void AudioPlayer::QueueBuffer(SourceId sourceId, BufferId bufferId)
 	alCheckCall(alSourceQueueBuffers(sourceId, 1, &bufferId));
 }
 
+void AudioPlayer::SetSourceBuffer(SourceId sourceId, BufferId buffer)
+{
+	alCheckCall(alSourcei(sourceId, AL_BUFFER, static_cast<ALint>(buffer)));
+}
+
+BufferId AudioPlayer::UnqueueBuffer(SourceId sourceId)
+{
+	BufferId id;
+	alCheckCall(alSourceUnqueueBuffers(sourceId, 1, &id));
+	return id;
+}
+
+uint32_t AudioPlayer::GetProcessedBufferCount(SourceId sourceId) const
+{
+	ALint count;
+	alCheckCall(alGetSourcei(sourceId, AL_BUFFERS_PROCESSED, &count));
+	return static_cast<uint32_t>(count);
+}
+
+uint32_t AudioPlayer::GetSampleOffset(SourceId sourceId) const
+{
+	ALint offset;
+	alCheckCall(alGetSourcei(sourceId, AL_SAMPLE_OFFSET, &offset));
+	return static_cast<uint32_t>(offset);
+}
+
 void AudioPlayer::DeleteBuffer(BufferId id)
 {
 	alCheckCall(alDeleteBuffers(1, &id));
@@ -171,6 +208,26 @@ void AudioPlayer::UpdateSource(SourceId id, float volume, bool loop)
 	alCheckCall(alSourcef(id, AL_PITCH, 1.f));
 }
 
+void AudioPlayer::SetSourceRelative(SourceId id, bool relative)
+{
+	alCheckCall(alSourcei(id, AL_SOURCE_RELATIVE, relative));
+}
+
+void AudioPlayer::SetSourceOffset(SourceId id, float seconds)
+{
+	alCheckCall(alSourcef(id, AL_SEC_OFFSET, seconds));
+}
+
+void AudioPlayer::BeginUpdates()
+{
+	alcSuspendContext(_context.get());
+}
+
+void AudioPlayer::EndUpdates()
+{
+	alcProcessContext(_context.get());
+}
+
 float AudioPlayer::GetDuration(BufferId id)
 {
 	ALint sizeInBytes;
@@ -27,11 +27,21 @@ class AudioPlayer final: public AudioPlayerInterface
 	void Initialize() override;
 	void UpdateListener(glm::vec3 pos, glm::vec3 vel, glm::vec3 front, glm::vec3 up) const override;
 	BufferId CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate) override;
+	BufferId CreateBuffer() override;
+	void FillBuffer(BufferId id, ChannelLayout layout, std::span<const int16_t> buffer, int sampleRate) override;
 	void QueueBuffer(SourceId sourceId, BufferId buffer) override;
+	void SetSourceBuffer(SourceId sourceId, BufferId buffer) override;
+	BufferId UnqueueBuffer(SourceId sourceId) override;
+	[[nodiscard]] uint32_t GetProcessedBufferCount(SourceId sourceId) const override;
+	[[nodiscard]] uint32_t GetSampleOffset(SourceId sourceId) const override;
 	void DeleteBuffer(BufferId id) override;
 	void DeleteSource(SourceId id) override;
 	void UpdateSource(SourceId id, glm::vec3 pos, float volume, bool loop) override;
 	void UpdateSource(SourceId id, float volume, bool loop) override;
+	void SetSourceRelative(SourceId id, bool relative) override;
+	void SetSourceOffset(SourceId id, float seconds) override;
+	void BeginUpdates() override;
+	void EndUpdates() override;
 	float GetDuration(BufferId id) override;
 	SourceId CreateSource(float pitch, bool relative) override;
 	void PlaySource(SourceId id, glm::vec3 pos, float volume, bool loop) override;
@@ -16,6 +16,7 @@ extern "C" {
 
 #include <filesystem>
 #include <queue>
+#include <span>
 #include <vector>
 
 #include <glm/vec3.hpp>
@@ -32,12 +33,27 @@ class AudioPlayerInterface
 	virtual void Initialize() = 0;
 	virtual void UpdateListener(glm::vec3 pos, glm::vec3 vel, glm::vec3 front, glm::vec3 up) const = 0;
 	[[nodiscard]] virtual BufferId CreateBuffer(ChannelLayout layout, const std::vector<int16_t>& buffer, int sampleRate) = 0;
+	/// Create a buffer which is filled later, for streaming
+	[[nodiscard]] virtual BufferId CreateBuffer() = 0;
+	virtual void FillBuffer(BufferId id, ChannelLayout layout, std::span<const int16_t> buffer, int sampleRate) = 0;
 	virtual void QueueBuffer(SourceId sourceId, BufferId buffer) = 0;
+	/// Replace the buffers of the source by one, or by none with 0
+	virtual void SetSourceBuffer(SourceId sourceId, BufferId buffer) = 0;
+	/// Remove the oldest buffer which the source has finished playing from its queue
+	virtual BufferId UnqueueBuffer(SourceId sourceId) = 0;
+	[[nodiscard]] virtual uint32_t GetProcessedBufferCount(SourceId sourceId) const = 0;
+	/// Frames played of the buffer at the front of the source's queue
+	[[nodiscard]] virtual uint32_t GetSampleOffset(SourceId sourceId) const = 0;
 	virtual void DeleteBuffer(BufferId id) = 0;
 	[[nodiscard]] virtual SourceId CreateSource(float pitch, bool relative) = 0;
 	virtual void DeleteSource(SourceId id) = 0;
 	virtual void UpdateSource(SourceId id, glm::vec3 pos, float volume, bool loop) = 0;
 	virtual void UpdateSource(SourceId id, float volume, bool loop) = 0;
+	virtual void SetSourceRelative(SourceId id, bool relative) = 0;
+	virtual void SetSourceOffset(SourceId id, float seconds) = 0;
+	/// Changes to sources between these calls are applied together
+	virtual void BeginUpdates() = 0;
+	virtual void EndUpdates() = 0;
 	[[nodiscard]] virtual float GetDuration(BufferId id) = 0;
 	virtual void PlaySource(SourceId id, glm::vec3 pos, float volume, bool loop) = 0;
 	virtual void PlaySource(SourceId id, float volume, bool loop) = 0;
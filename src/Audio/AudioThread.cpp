@@ -0,0 +1,178 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "AudioThread.h"
+
+#include <cassert>
+
+#include <algorithm>
+
+#include <PackFile.h>
+
+#include "AudioPlayerInterface.h"
+#include "MusicStream.h"
+
+using namespace openblack::audio;
+
+namespace
+{
+template <class... Ts>
+struct Overloaded: Ts...
+{
+	using Ts::operator()...;
+};
+} // namespace
+
+AudioThread::AudioThread(AudioPlayerInterface& player)
+    : _player(player)
+{
+	for (auto& source : _sources)
+	{
+		source = _player.CreateSource(1.0f, true);
+	}
+	_thread = std::thread(&AudioThread::Run, this);
+}
+
+AudioThread::~AudioThread()
+{
+	_stop = true;
+	_thread.join();
+
+	// Commands sent after the last period still hold buffers which are about to be deleted, only deletes are applied
+	while (auto command = _commands.TryPop())
+	{
+		if (const auto* deleteBuffer = std::get_if<DeleteBuffer>(&*command))
+		{
+			_player.DeleteBuffer(deleteBuffer->buffer);
+		}
+	}
+	// Buffers which were never polled have no other owner
+	while (const auto uploaded = _uploaded.TryPop())
+	{
+		_player.DeleteBuffer(uploaded->buffer);
+	}
+	_musicStream.reset();
+	for (const auto source : _sources)
+	{
+		_player.StopSource(source);
+		_player.DeleteSource(source);
+	}
+}
+
+void AudioThread::Send(Command command)
+{
+	while (!_commands.TryPush(std::move(command)))
+	{
+		std::this_thread::yield();
+	}
+	++_sent;
+}
+
+void AudioThread::Apply(Command& command)
+{
+	std::visit(Overloaded {
+	               [this](const PlayVoice& play) {
+		               const auto source = _sources[play.voice];
+		               _player.StopSource(source);
+		               _player.SetSourceBuffer(source, play.buffer);
+		               _player.SetSourceRelative(source, play.relative);
+		               _player.SetSourceOffset(source, play.offset);
+		               _parameters[play.voice] = play.parameters;
+		               _sizes[play.voice] = play.sizeInBytes;
+		               _active[play.voice] = true;
+		               const auto& parameters = play.parameters;
+		               _player.PlaySource(source, parameters.position, parameters.volume, parameters.loop);
+	               },
+	               [this](const PauseVoice& pause) { _player.PauseSource(_sources[pause.voice]); },
+	               [this](const ResumeVoice& resume) {
+		               const auto& parameters = _parameters[resume.voice];
+		               _player.PlaySource(_sources[resume.voice], parameters.position, parameters.volume, parameters.loop);
+	               },
+	               [this](const StopVoice& stop) {
+		               const auto source = _sources[stop.voice];
+		               _player.StopSource(source);
+		               _player.SetSourceBuffer(source, 0);
+		               _active[stop.voice] = false;
+	               },
+	               [this](PlayMusic& play) {
+		               _musicStream.reset();
+		               _musicStream = std::make_unique<MusicStream>(_player, std::move(play.pack), play.loop);
+		               _musicStream->Play(_frames.Read().musicVolume);
+	               },
+	               [this](const StopMusic&) { _musicStream.reset(); },
+	               [this](const SeekMusic& seek) {
+		               if (_musicStream != nullptr)
+		               {
+			               _musicStream->Seek(seek.seconds);
+		               }
+	               },
+	               [this](const UploadBuffer& upload) {
+		               const auto buffer = _player.CreateBuffer(upload.layout, upload.pcm, upload.sampleRate);
+		               // The game thread keeps no more than the capacity in flight, so this never fails
+		               [[maybe_unused]] const auto pushed = _uploaded.TryPush({upload.sound, buffer});
+		               assert(pushed);
+	               },
+	               [this](const DeleteBuffer& deleteBuffer) { _player.DeleteBuffer(deleteBuffer.buffer); },
+	           },
+	           command);
+}
+
+void AudioThread::Run()
+{
+	auto next = std::chrono::steady_clock::now();
+	while (!_stop)
+	{
+		uint64_t applied = 0;
+		while (auto command = _commands.TryPop())
+		{
+			Apply(*command);
+			++applied;
+		}
+
+		const auto& frame = _frames.Read();
+		auto& status = _statuses.GetWriteBuffer();
+		_applied += applied;
+		status.applied = _applied;
+
+		_player.BeginUpdates();
+		_player.UpdateListener(frame.listenerPosition, frame.listenerVelocity, frame.listenerForward, frame.listenerUp);
+		for (size_t i = 0; i < k_VoiceCount; ++i)
+		{
+			auto& parameters = _parameters[i];
+			auto& voice = status.voices[i];
+			voice.generation = parameters.generation;
+			if (!_active[i])
+			{
+				voice.status = AudioStatus::Stopped;
+				voice.progress = 0.0f;
+				continue;
+			}
+			// The frame may be older than the play
+			if (frame.voices[i].generation == parameters.generation)
+			{
+				parameters = frame.voices[i];
+			}
+			_player.UpdateSource(_sources[i], parameters.position, parameters.volume, parameters.loop);
+			voice.status = _player.GetStatus(_sources[i]);
+			voice.progress = _player.GetProgress(_sizes[i], _sources[i]);
+		}
+		_player.EndUpdates();
+
+		if (_musicStream != nullptr && !_musicStream->Update(frame.musicVolume))
+		{
+			_musicStream.reset();
+		}
+		status.musicPosition = _musicStream != nullptr ? _musicStream->GetPosition() : 0.0f;
+		_statuses.Publish();
+
+		// Don't try to catch up on periods which were missed, such as when the process was suspended
+		next = std::max(next + k_Period, std::chrono::steady_clock::now());
+		std::this_thread::sleep_until(next);
+	}
+}
@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include <glm/vec3.hpp>
+
+#include "Common/SpscQueue.h"
+#include "Common/TripleBuffer.h"
+#include "Sound.h"
+
+namespace openblack::pack
+{
+class PackFile;
+}
+
+namespace openblack::audio
+{
+
+class AudioPlayerInterface;
+class MusicStream;
+
+/// Plays the sources of the player on a thread of its own, so that playback keeps up when a frame takes long.
+///
+/// The thread is the only one to use the player while it runs. OpenAL reports errors per context rather than per thread,
+/// so an error checked on one thread could otherwise be that of a call made by another. The game thread sends it
+/// commands through a lock free queue, and publishes the listener and the parameters of the voices once per frame as a
+/// snapshot. The thread publishes the status of the voices and of the music back the same way, and the buffers it
+/// created for uploads through a second queue.
+class AudioThread
+{
+public:
+	static constexpr size_t k_VoiceCount = 32;
+	/// Latency of commands and of refilling the music buffers
+	static constexpr std::chrono::milliseconds k_Period {5};
+	/// Uploads which may be sent before their buffers are polled, so that the thread never waits to hand them back
+	static constexpr size_t k_MaxUploadsInFlight = 256;
+
+	struct VoiceParameters
+	{
+		/// Generation of the play the parameters are for, those of an earlier play are ignored
+		uint32_t generation;
+		glm::vec3 position;
+		float volume;
+		bool loop;
+	};
+
+	/// Voices are numbered, each play of a voice has a new generation so that statuses of earlier plays are ignored
+	struct PlayVoice
+	{
+		uint32_t voice;
+		BufferId buffer;
+		size_t sizeInBytes;
+		bool relative;
+		/// Seconds into the buffer to start from
+		float offset;
+		/// Until a frame which has the play is read
+		VoiceParameters parameters;
+	};
+	struct PauseVoice
+	{
+		uint32_t voice;
+	};
+	struct ResumeVoice
+	{
+		uint32_t voice;
+	};
+	struct StopVoice
+	{
+		uint32_t voice;
+	};
+	struct PlayMusic
+	{
+		std::shared_ptr<const pack::PackFile> pack;
+		bool loop;
+	};
+	struct StopMusic
+	{
+	};
+	struct SeekMusic
+	{
+		float seconds;
+	};
+	/// Create a buffer holding the PCM, it is handed back through PollUploaded
+	struct UploadBuffer
+	{
+		entt::id_type sound;
+		ChannelLayout layout;
+		std::vector<int16_t> pcm;
+		int sampleRate;
+	};
+	struct DeleteBuffer
+	{
+		BufferId buffer;
+	};
+	using Command = std::variant<PlayVoice, PauseVoice, ResumeVoice, StopVoice, PlayMusic, StopMusic, SeekMusic,
+	                             UploadBuffer, DeleteBuffer>;
+
+	struct UploadedBuffer
+	{
+		entt::id_type sound;
+		BufferId buffer;
+	};
+
+	/// Published by the game thread every frame
+	struct Frame
+	{
+		glm::vec3 listenerPosition;
+		glm::vec3 listenerVelocity;
+		glm::vec3 listenerForward;
+		glm::vec3 listenerUp;
+		std::array<VoiceParameters, k_VoiceCount> voices;
+		float musicVolume;
+	};
+
+	struct VoiceStatus
+	{
+		/// Generation of the play the status is of
+		uint32_t generation;
+		AudioStatus status;
+		float progress;
+	};
+
+	/// Published by the audio thread after each period
+	struct Status
+	{
+		/// Number of commands which have been applied, to compare with GetSentCount
+		uint64_t applied;
+		std::array<VoiceStatus, k_VoiceCount> voices;
+		float musicPosition;
+	};
+
+	/// Creates the sources of the voices and starts the thread
+	explicit AudioThread(AudioPlayerInterface& player);
+	/// Stops the thread and deletes the sources
+	~AudioThread();
+	AudioThread(const AudioThread&) = delete;
+	AudioThread& operator=(const AudioThread&) = delete;
+
+	/// Game thread only, waits if the audio thread has fallen far behind
+	void Send(Command command);
+	/// Game thread only, all commands sent so far have been applied once Status::applied reaches it
+	[[nodiscard]] uint64_t GetSentCount() const noexcept { return _sent; }
+	/// Game thread only, every field of the frame has to be written before it is published
+	[[nodiscard]] Frame& GetFrame() { return _frames.GetWriteBuffer(); }
+	void PublishFrame() { _frames.Publish(); }
+	/// Game thread only, the latest status the audio thread published
+	[[nodiscard]] const Status& GetStatus() { return _statuses.Read(); }
+	/// Game thread only, the next buffer created for an UploadBuffer command
+	[[nodiscard]] std::optional<UploadedBuffer> PollUploaded() { return _uploaded.TryPop(); }
+
+private:
+	void Run();
+	void Apply(Command& command);
+
+	AudioPlayerInterface& _player;
+	std::array<SourceId, k_VoiceCount> _sources;
+
+	SpscQueue<Command, 256> _commands;
+	SpscQueue<UploadedBuffer, k_MaxUploadsInFlight> _uploaded;
+	TripleBuffer<Frame> _frames;
+	TripleBuffer<Status> _statuses;
+
+	// Owned by the audio thread
+	std::array<VoiceParameters, k_VoiceCount> _parameters {};
+	std::array<size_t, k_VoiceCount> _sizes {};
+	std::array<bool, k_VoiceCount> _active {};
+	std::unique_ptr<MusicStream> _musicStream;
+	uint64_t _applied {0};
+
+	// Owned by the game thread
+	uint64_t _sent {0};
+
+	std::atomic<bool> _stop {false};
+	std::thread _thread;
+};
+
+} // namespace openblack::audio
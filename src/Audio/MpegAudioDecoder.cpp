@@ -27,7 +27,7 @@ extern "C" {
 
 using namespace openblack::audio;
 
-bool MpegAudioDecoder::Open(const std::vector<uint8_t>& buffer)
+bool MpegAudioDecoder::Open(std::span<const uint8_t> buffer)
 {
 	const auto status = drmp3_init_memory(&_mp3, buffer.data(), buffer.size(), nullptr);
 	return static_cast<bool>(status);
@@ -19,7 +19,7 @@ namespace openblack::audio
 class MpegAudioDecoder final: public AudioDecoderInterface
 {
 public:
-	bool Open(const std::vector<uint8_t>& buffer) override;
+	bool Open(std::span<const uint8_t> buffer) override;
 	void Read(std::vector<int16_t>& buffer) override;
 	[[nodiscard]] ChannelLayout GetChannelLayout() override;
 
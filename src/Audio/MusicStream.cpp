@@ -0,0 +1,280 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "MusicStream.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <chrono>
+
+#include <PackFile.h>
+#include <spdlog/spdlog.h>
+
+#include "AudioPlayerInterface.h"
+
+using namespace openblack::audio;
+
+MusicStream::MusicStream(AudioPlayerInterface& player, std::shared_ptr<const pack::PackFile> pack, bool loop)
+    : _player(player)
+    , _pack(std::move(pack))
+    , _loop(loop)
+    , _sourceId(player.CreateSource(1.0f, true))
+    , _pcm(static_cast<size_t>(k_FramesPerBuffer) * 2)
+    , _trackDurationScan(std::async(std::launch::async, [this]() { return ScanTrackDurations(*_pack, _cancelScan); }))
+{
+	_free.reserve(k_BufferCount);
+	for (size_t i = 0; i < k_BufferCount; ++i)
+	{
+		_free.push_back(_player.CreateBuffer());
+	}
+	OpenTrack(0, 0.0f);
+}
+
+MusicStream::~MusicStream()
+{
+	// The scan is waited for when it is destroyed, it only finishes the track it is in
+	_cancelScan = true;
+	Unqueue();
+	_player.DeleteSource(_sourceId);
+	for (const auto id : _free)
+	{
+		_player.DeleteBuffer(id);
+	}
+	CloseTrack();
+}
+
+bool MusicStream::OpenTrack(size_t track, float start)
+{
+	CloseTrack();
+
+	// A track which can't be decoded is skipped, like one without frames, up to a full pass over the pack
+	const auto& tracks = _pack->GetAudioSamplesData();
+	for (size_t attempt = 0; attempt < tracks.size(); ++attempt, ++track)
+	{
+		if (track >= tracks.size())
+		{
+			if (!_loop)
+			{
+				return false;
+			}
+			track = 0;
+			start = 0.0f;
+		}
+
+		const auto data = tracks[track];
+		if (drmp3_init_memory(&_mp3, data.data(), data.size(), nullptr) == DRMP3_FALSE)
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to decode music track {}, skipping it", track);
+			continue;
+		}
+		if (_mp3.channels != 1 && _mp3.channels != 2)
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unsupported channel layout of music track {}, skipping it", track);
+			drmp3_uninit(&_mp3);
+			continue;
+		}
+
+		_isOpen = true;
+		_track = track;
+		_trackStart = start;
+		_trackFrame = 0;
+		return true;
+	}
+	return false;
+}
+
+void MusicStream::CloseTrack()
+{
+	if (_isOpen)
+	{
+		drmp3_uninit(&_mp3);
+		_isOpen = false;
+	}
+}
+
+bool MusicStream::Fill(BufferId id)
+{
+	if (!_isOpen)
+	{
+		return false;
+	}
+
+	auto frames = drmp3_read_pcm_frames_s16(&_mp3, k_FramesPerBuffer, _pcm.data());
+	// A looping pack would otherwise be cycled forever if none of its tracks decode to any frames
+	const auto trackCount = _pack->GetAudioSamplesData().size();
+	for (size_t emptyTracks = 0; frames == 0; ++emptyTracks)
+	{
+		if (emptyTracks == trackCount)
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "None of the music tracks have any frames to play");
+			CloseTrack();
+			return false;
+		}
+		const auto next = _trackStart + static_cast<float>(_trackFrame) / static_cast<float>(_mp3.sampleRate);
+		if (!OpenTrack(_track + 1, next))
+		{
+			return false;
+		}
+		frames = drmp3_read_pcm_frames_s16(&_mp3, k_FramesPerBuffer, _pcm.data());
+	}
+
+	const auto sampleRate = static_cast<int>(_mp3.sampleRate);
+	const auto layout = _mp3.channels == 1 ? ChannelLayout::Mono : ChannelLayout::Stereo;
+	_player.FillBuffer(id, layout, std::span<const int16_t>(_pcm.data(), static_cast<size_t>(frames) * _mp3.channels),
+	                   sampleRate);
+	_player.QueueBuffer(_sourceId, id);
+	_queued.push_back({id, _trackStart + static_cast<float>(_trackFrame) / static_cast<float>(sampleRate), sampleRate});
+	_trackFrame += frames;
+	return true;
+}
+
+void MusicStream::FillAll()
+{
+	while (!_free.empty() && Fill(_free.back()))
+	{
+		_free.pop_back();
+	}
+}
+
+void MusicStream::Unqueue()
+{
+	// All of the buffers of a stopped source count as processed
+	_player.StopSource(_sourceId);
+	for (auto count = _player.GetProcessedBufferCount(_sourceId); count > 0; --count)
+	{
+		_free.push_back(_player.UnqueueBuffer(_sourceId));
+	}
+	_queued.clear();
+}
+
+void MusicStream::Play(float volume)
+{
+	_volume = volume;
+	FillAll();
+	_player.PlaySource(_sourceId, _volume, false);
+	_playing = true;
+}
+
+void MusicStream::Pause()
+{
+	_player.PauseSource(_sourceId);
+	_playing = false;
+}
+
+bool MusicStream::Update(float volume)
+{
+	_volume = volume;
+	_player.UpdateSource(_sourceId, _volume, false);
+
+	for (auto count = _player.GetProcessedBufferCount(_sourceId); count > 0; --count)
+	{
+		[[maybe_unused]] const auto id = _player.UnqueueBuffer(_sourceId);
+		assert(!_queued.empty() && _queued.front().id == id);
+		_queued.pop_front();
+		_free.push_back(id);
+	}
+	FillAll();
+
+	if (_queued.empty())
+	{
+		return false;
+	}
+	// A source which runs out of buffers stops, such as after a long frame
+	if (_playing && _player.GetStatus(_sourceId) == AudioStatus::Stopped)
+	{
+		_player.PlaySource(_sourceId, _volume, false);
+	}
+	return true;
+}
+
+std::vector<float> MusicStream::ScanTrackDurations(const pack::PackFile& pack, const std::atomic<bool>& cancel)
+{
+	const auto& tracks = pack.GetAudioSamplesData();
+	std::vector<float> durations(tracks.size(), 0.0f);
+	for (size_t track = 0; track < tracks.size() && !cancel; ++track)
+	{
+		// Tracks which can't be decoded are skipped when playing, they take no time
+		drmp3 mp3;
+		if (drmp3_init_memory(&mp3, tracks[track].data(), tracks[track].size(), nullptr) == DRMP3_TRUE)
+		{
+			const auto frames = drmp3_get_pcm_frame_count(&mp3);
+			durations[track] = static_cast<float>(frames) / static_cast<float>(mp3.sampleRate);
+			drmp3_uninit(&mp3);
+		}
+	}
+	return durations;
+}
+
+void MusicStream::Seek(float seconds)
+{
+	Unqueue();
+
+	if (_trackDurations.empty() && _trackDurationScan.valid() &&
+	    _trackDurationScan.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		_trackDurations = _trackDurationScan.get();
+	}
+
+	size_t track = 0;
+	float start = 0.0f;
+	if (_trackDurations.empty())
+	{
+		// The tracks before the current one can't be skipped over without their lengths
+		SPDLOG_LOGGER_DEBUG(spdlog::get("audio"), "Music track lengths are not known yet, seeking in the current track");
+		track = _track;
+		start = _trackStart;
+		seconds = std::max(seconds, start);
+	}
+	else
+	{
+		for (; track < _trackDurations.size(); ++track)
+		{
+			if (seconds < start + _trackDurations[track])
+			{
+				break;
+			}
+			start += _trackDurations[track];
+		}
+		if (track == _trackDurations.size())
+		{
+			// Past the end, start over
+			track = 0;
+			start = 0.0f;
+			seconds = 0.0f;
+		}
+	}
+
+	if (!OpenTrack(track, start))
+	{
+		return;
+	}
+	// The track may have been skipped for one after it, which is played from its start
+	const auto frame = _track != track ? 0 : static_cast<uint64_t>((seconds - start) * static_cast<float>(_mp3.sampleRate));
+	if (drmp3_seek_to_pcm_frame(&_mp3, frame) == DRMP3_TRUE)
+	{
+		_trackFrame = frame;
+	}
+
+	FillAll();
+	if (_playing)
+	{
+		_player.PlaySource(_sourceId, _volume, false);
+	}
+}
+
+float MusicStream::GetPosition() const
+{
+	if (_queued.empty())
+	{
+		return _trackStart;
+	}
+	const auto& front = _queued.front();
+	return front.start + static_cast<float>(_player.GetSampleOffset(_sourceId)) / static_cast<float>(front.sampleRate);
+}
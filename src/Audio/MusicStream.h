@@ -0,0 +1,107 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include <dr_mp3.h>
+
+#include "Sound.h"
+
+namespace openblack::pack
+{
+class PackFile;
+}
+
+namespace openblack::audio
+{
+
+class AudioPlayerInterface;
+
+/// Plays the tracks of a music pack one after the other, decoding them a few buffers ahead of the source rather than
+/// all at once.
+///
+/// The buffers which the source has played are refilled by Update, which must be called more often than it takes to
+/// play all of them.
+class MusicStream
+{
+public:
+	static constexpr size_t k_BufferCount = 4;
+	/// About 0.4 seconds at 44.1kHz
+	static constexpr uint32_t k_FramesPerBuffer = 16384;
+
+	MusicStream(AudioPlayerInterface& player, std::shared_ptr<const pack::PackFile> pack, bool loop);
+	~MusicStream();
+	MusicStream(const MusicStream&) = delete;
+	MusicStream& operator=(const MusicStream&) = delete;
+
+	void Play(float volume);
+	void Pause();
+	/// Refill the buffers which have been played, returns false once the last track has finished playing
+	bool Update(float volume);
+	/// Restart from a position from the start of the first track. Until the lengths of the tracks have been worked out in
+	/// the background, only the current track can be seeked in.
+	void Seek(float seconds);
+
+	/// Seconds from the start of the first track
+	[[nodiscard]] float GetPosition() const;
+	[[nodiscard]] SourceId GetSourceId() const noexcept { return _sourceId; }
+
+private:
+	struct Queued
+	{
+		BufferId id;
+		/// Seconds from the start of the first track the buffer starts at
+		float start;
+		int sampleRate;
+	};
+
+	/// Open the track which starts at the given seconds, or the first one after it which can be decoded. Past the last
+	/// track, wraps around to the first one when looping and returns false otherwise.
+	bool OpenTrack(size_t track, float start);
+	void CloseTrack();
+	/// Returns false if there was nothing left to decode
+	bool Fill(BufferId id);
+	void FillAll();
+	/// Stop the source and take back all of its buffers
+	void Unqueue();
+	/// Read through the frame headers of every track, which takes too long to be done on the audio thread
+	[[nodiscard]] static std::vector<float> ScanTrackDurations(const pack::PackFile& pack, const std::atomic<bool>& cancel);
+
+	AudioPlayerInterface& _player;
+	std::shared_ptr<const pack::PackFile> _pack;
+	const bool _loop;
+	SourceId _sourceId;
+	std::vector<BufferId> _free;
+	std::deque<Queued> _queued;
+	std::vector<int16_t> _pcm;
+
+	drmp3 _mp3 {};
+	bool _isOpen {false};
+	size_t _track {0};
+	/// Seconds from the start of the first track the current track starts at
+	float _trackStart {0.0f};
+	/// Frames decoded from the current track
+	uint64_t _trackFrame {0};
+	/// Empty until the scan is over
+	std::vector<float> _trackDurations;
+	std::atomic<bool> _cancelScan {false};
+	std::future<std::vector<float>> _trackDurationScan;
+	bool _playing {false};
+	float _volume {1.0f};
+};
+
+} // namespace openblack::audio
@@ -0,0 +1,308 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "PcmCache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "AudioPlayerInterface.h"
+#include "MpegAudioDecoder.h"
+#include "WavAudioDecoder.h"
+
+using namespace openblack::audio;
+
+namespace
+{
+/// Samples which are neither mp3 nor wav can't be decoded, returns false if there are none to read.
+/// Runs on the workers, where an exception would end the program.
+bool Decode(std::span<const uint8_t> encoded, std::vector<int16_t>& pcm, ChannelLayout& layout) noexcept
+{
+	try
+	{
+		bool success;
+		{
+			auto decoder = MpegAudioDecoder();
+			success = decoder.Open(encoded);
+			if (success)
+			{
+				decoder.Read(pcm);
+				layout = decoder.GetChannelLayout();
+			}
+		}
+		if (!success)
+		{
+			auto decoder = WavAudioDecoder();
+			if (decoder.Open(encoded))
+			{
+				decoder.Read(pcm);
+				layout = decoder.GetChannelLayout();
+			}
+		}
+	}
+	catch (const std::exception& e)
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to decode sound: {}", e.what());
+		pcm.clear();
+	}
+	return !pcm.empty();
+}
+
+float GetDuration(size_t samples, ChannelLayout layout, int sampleRate)
+{
+	const size_t channels = layout == ChannelLayout::Stereo ? 2 : 1;
+	return sampleRate > 0 ? static_cast<float>(samples / channels) / static_cast<float>(sampleRate) : 0.0f;
+}
+} // namespace
+
+uint32_t PcmCache::GetDefaultThreadCount() noexcept
+{
+	// Sounds are decoded from memory, so this is fine on every platform
+	return 2;
+}
+
+PcmCache::PcmCache(AudioPlayerInterface& player, uint32_t threadCount, uint64_t budget)
+    : _player(player)
+    , _budget(budget)
+{
+	_threads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		_threads.emplace_back(&PcmCache::Work, this);
+	}
+}
+
+PcmCache::~PcmCache()
+{
+	{
+		const std::lock_guard lock(_mutex);
+		_stop = true;
+	}
+	_workAvailable.notify_all();
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+
+	// The audio thread has stopped by now, so the buffers can be deleted from here
+	for (const auto& [id, entry] : _entries)
+	{
+		if (entry.state == State::Uploaded)
+		{
+			_player.DeleteBuffer(entry.buffer.id);
+		}
+	}
+}
+
+PcmCache::Entry& PcmCache::Queue(entt::id_type id, const Sound& sound, bool urgent)
+{
+	auto [iter, inserted] = _entries.try_emplace(id);
+	auto& entry = iter->second;
+	if (inserted)
+	{
+		entry.state = State::Queued;
+		entry.urgent = urgent;
+		entry.sampleRate = sound.sampleRate;
+		entry.owner = sound.bufferOwner;
+		entry.encoded = sound.buffer;
+		entry.buffer = {};
+		entry.users = 0;
+		entry.lru = _lru.end();
+		(urgent ? _urgent : _prefetch).push_back(id);
+	}
+	else if (entry.state == State::Queued && urgent && !entry.urgent)
+	{
+		// Jump ahead of the prefetches
+		_prefetch.erase(std::find(_prefetch.begin(), _prefetch.end(), id));
+		_urgent.push_back(id);
+		entry.urgent = true;
+	}
+	else
+	{
+		return entry;
+	}
+
+	if (_threads.empty())
+	{
+		// Nobody else would decode it
+		(urgent ? _urgent : _prefetch).pop_back();
+		if (Decode(entry.encoded, entry.pcm, entry.buffer.layout))
+		{
+			entry.state = State::Decoded;
+			entry.buffer.sizeInBytes = entry.pcm.size() * sizeof(entry.pcm[0]);
+			entry.buffer.duration = GetDuration(entry.pcm.size(), entry.buffer.layout, entry.sampleRate);
+			entry.lru = _lru.insert(_lru.end(), id);
+			_cachedBytes += entry.buffer.sizeInBytes;
+		}
+		else
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to decode sound {}", id);
+			entry.state = State::Failed;
+		}
+		entry.owner.reset();
+		entry.encoded = {};
+	}
+	else
+	{
+		_workAvailable.notify_one();
+	}
+	return entry;
+}
+
+void PcmCache::Prefetch(entt::id_type id, const Sound& sound)
+{
+	const std::lock_guard lock(_mutex);
+	Queue(id, sound, false);
+}
+
+std::optional<PcmCache::Buffer> PcmCache::Acquire(entt::id_type id, const Sound& sound)
+{
+	const std::lock_guard lock(_mutex);
+	auto& entry = Queue(id, sound, true);
+	switch (entry.state)
+	{
+	case State::Decoded:
+		// The buffer is created by the audio thread, which is the only one to use the player
+		entry.state = State::Uploading;
+		_uploads.push_back(id);
+		return std::nullopt;
+	case State::Uploaded:
+		break;
+	default:
+		return std::nullopt;
+	}
+
+	++entry.users;
+	_lru.splice(_lru.end(), _lru, entry.lru);
+	return entry.buffer;
+}
+
+std::vector<PcmCache::Upload> PcmCache::TakeUploads(size_t count)
+{
+	const std::lock_guard lock(_mutex);
+	std::vector<Upload> uploads;
+	while (!_uploads.empty() && uploads.size() < count)
+	{
+		const auto id = _uploads.front();
+		_uploads.pop_front();
+		auto& entry = _entries.at(id);
+		uploads.push_back({id, entry.buffer.layout, std::move(entry.pcm), entry.sampleRate});
+		entry.pcm = {};
+	}
+	return uploads;
+}
+
+bool PcmCache::Uploaded(entt::id_type id, BufferId buffer)
+{
+	const std::lock_guard lock(_mutex);
+	auto iter = _entries.find(id);
+	if (iter == _entries.end() || iter->second.state != State::Uploading)
+	{
+		return false;
+	}
+	iter->second.buffer.id = buffer;
+	iter->second.state = State::Uploaded;
+	return true;
+}
+
+void PcmCache::Release(entt::id_type id)
+{
+	const std::lock_guard lock(_mutex);
+	auto iter = _entries.find(id);
+	if (iter != _entries.end() && iter->second.users > 0)
+	{
+		--iter->second.users;
+	}
+}
+
+void PcmCache::Drop(entt::id_type id, Entry& entry)
+{
+	_cachedBytes -= entry.buffer.sizeInBytes;
+	_lru.erase(entry.lru);
+	_entries.erase(id);
+}
+
+std::vector<PcmCache::Dropped> PcmCache::Trim()
+{
+	const std::lock_guard lock(_mutex);
+	std::vector<Dropped> dropped;
+	for (auto iter = _lru.begin(); iter != _lru.end() && _cachedBytes > _budget;)
+	{
+		const auto id = *iter++;
+		auto& entry = _entries.at(id);
+		// A buffer which is queued on a source can't be deleted, nor can one which is being created
+		if (entry.users > 0 || entry.state == State::Uploading)
+		{
+			continue;
+		}
+		dropped.push_back({id, entry.state == State::Uploaded ? entry.buffer.id : 0});
+		Drop(id, entry);
+	}
+	return dropped;
+}
+
+bool PcmCache::HasFailed(entt::id_type id) const
+{
+	const std::lock_guard lock(_mutex);
+	const auto iter = _entries.find(id);
+	return iter != _entries.end() && iter->second.state == State::Failed;
+}
+
+uint64_t PcmCache::GetCachedBytes() const
+{
+	const std::lock_guard lock(_mutex);
+	return _cachedBytes;
+}
+
+void PcmCache::Work()
+{
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		_workAvailable.wait(lock, [this]() { return _stop || !_urgent.empty() || !_prefetch.empty(); });
+		if (_stop)
+		{
+			return;
+		}
+
+		auto& queue = !_urgent.empty() ? _urgent : _prefetch;
+		const auto id = queue.front();
+		queue.pop_front();
+		// Entries which are being decoded are never erased, so the reference stays valid while unlocked
+		auto& entry = _entries.at(id);
+		entry.state = State::Decoding;
+		const auto owner = std::move(entry.owner);
+		const auto encoded = std::exchange(entry.encoded, {});
+
+		lock.unlock();
+		std::vector<int16_t> pcm;
+		ChannelLayout layout {};
+		const bool success = Decode(encoded, pcm, layout);
+		if (!success)
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("audio"), "Unable to decode sound {}", id);
+		}
+		lock.lock();
+
+		if (!success)
+		{
+			entry.state = State::Failed;
+			continue;
+		}
+		entry.buffer.layout = layout;
+		entry.buffer.sizeInBytes = pcm.size() * sizeof(pcm[0]);
+		entry.buffer.duration = GetDuration(pcm.size(), layout, entry.sampleRate);
+		entry.pcm = std::move(pcm);
+		entry.state = State::Decoded;
+		entry.lru = _lru.insert(_lru.end(), id);
+		_cachedBytes += entry.buffer.sizeInBytes;
+	}
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/fwd.hpp>
+
+#include "Sound.h"
+
+namespace openblack::audio
+{
+
+class AudioPlayerInterface;
+
+/// Decodes sounds on worker threads and keeps their PCM within a budget.
+///
+/// A sound is decoded when it is first acquired or when it is prefetched, acquired sounds are decoded ahead of
+/// prefetched ones. Decoded PCM is handed over to be uploaded the first time the sound is acquired after its decode
+/// finished. The cache never uses the player itself while the audio thread runs, since OpenAL reports errors per
+/// context rather than per thread, so uploads are taken with TakeUploads and their buffers handed back to Uploaded.
+/// Sounds whose PCM is in memory or in a buffer count towards the budget, the least recently acquired of those which
+/// no source is playing are dropped once it is exceeded.
+class PcmCache
+{
+public:
+	static constexpr uint64_t k_DefaultBudget = 64 * 1024 * 1024;
+
+	struct Buffer
+	{
+		BufferId id;
+		ChannelLayout layout;
+		size_t sizeInBytes;
+		/// Seconds, worked out from the PCM so that the buffer never has to be queried
+		float duration;
+	};
+
+	/// PCM of an acquired sound which is waiting for a buffer
+	struct Upload
+	{
+		entt::id_type id;
+		ChannelLayout layout;
+		std::vector<int16_t> pcm;
+		int sampleRate;
+	};
+
+	/// A sound which was dropped, along with its buffer to delete if it had been uploaded
+	struct Dropped
+	{
+		entt::id_type id;
+		BufferId buffer;
+	};
+
+	/// Threads used when none are specified
+	static uint32_t GetDefaultThreadCount() noexcept;
+
+	PcmCache(AudioPlayerInterface& player, uint32_t threadCount, uint64_t budget = k_DefaultBudget);
+	/// Waits for the decodes which have started and deletes all buffers, which must no longer be used by another thread
+	~PcmCache();
+	PcmCache(const PcmCache&) = delete;
+	PcmCache& operator=(const PcmCache&) = delete;
+
+	/// Queue a sound to be decoded in the background, does nothing if it is already decoded or queued
+	void Prefetch(entt::id_type id, const Sound& sound);
+	/// Returns the buffer of the sound, or nothing while it is being decoded or uploaded or if it could not be decoded.
+	/// A buffer which is returned is kept until it is released.
+	[[nodiscard]] std::optional<Buffer> Acquire(entt::id_type id, const Sound& sound);
+	/// Take up to count of the acquired sounds which need a buffer, their PCM is moved out
+	[[nodiscard]] std::vector<Upload> TakeUploads(size_t count);
+	/// The buffer of an upload was created, returns false if the sound is unknown and the buffer should be deleted
+	bool Uploaded(entt::id_type id, BufferId buffer);
+	/// The buffer is no longer queued on a source
+	void Release(entt::id_type id);
+	/// Drop the least recently used sounds until the budget is met, the buffers of those returned have to be deleted
+	std::vector<Dropped> Trim();
+	/// True if the sound was decoded and held no samples which could be read
+	[[nodiscard]] bool HasFailed(entt::id_type id) const;
+
+	[[nodiscard]] uint64_t GetBudget() const noexcept { return _budget; }
+	[[nodiscard]] uint64_t GetCachedBytes() const;
+
+private:
+	enum class State : uint8_t
+	{
+		Queued,
+		Decoding,
+		Decoded,
+		/// Taken by TakeUploads and waiting for its buffer
+		Uploading,
+		Uploaded,
+		Failed,
+	};
+
+	struct Entry
+	{
+		State state;
+		bool urgent;
+		int sampleRate;
+		/// Keeps the encoded samples alive while they are queued
+		std::shared_ptr<const void> owner;
+		std::span<const uint8_t> encoded;
+		std::vector<int16_t> pcm;
+		Buffer buffer;
+		/// Sources the buffer is queued on
+		uint32_t users;
+		std::list<entt::id_type>::iterator lru;
+	};
+
+	Entry& Queue(entt::id_type id, const Sound& sound, bool urgent);
+	void Work();
+	void Drop(entt::id_type id, Entry& entry);
+
+	AudioPlayerInterface& _player;
+	const uint64_t _budget;
+	mutable std::mutex _mutex;
+	std::condition_variable _workAvailable;
+	std::unordered_map<entt::id_type, Entry> _entries;
+	std::deque<entt::id_type> _urgent;
+	std::deque<entt::id_type> _prefetch;
+	/// Acquired sounds whose PCM has yet to be taken by TakeUploads
+	std::deque<entt::id_type> _uploads;
+	/// Decoded and uploaded sounds, least recently acquired first
+	std::list<entt::id_type> _lru;
+	uint64_t _cachedBytes {0};
+	std::vector<std::thread> _threads;
+	bool _stop {false};
+};
+
+} // namespace openblack::audio
@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <memory>
 #include <queue>
+#include <span>
 #include <string>
 #include <vector>
 
@@ -230,7 +232,10 @@ class Sound
 	PlayType playType;
 	BufferId bufferId;
 	float duration;
-	std::vector<std::vector<uint8_t>> buffer;
+	/// Keeps the memory viewed by buffer alive, usually the sound pack the samples are in
+	std::shared_ptr<const void> bufferOwner;
+	/// Encoded samples, viewed in place rather than copied out of their pack. They are only decoded for upload.
+	std::span<const uint8_t> buffer;
 	size_t sizeInBytes;
 };
 } // namespace openblack::audio
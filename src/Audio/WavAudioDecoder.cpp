@@ -18,7 +18,7 @@ extern "C" {
 
 using namespace openblack::audio;
 
-bool WavAudioDecoder::Open(const std::vector<uint8_t>& buffer)
+bool WavAudioDecoder::Open(std::span<const uint8_t> buffer)
 {
 	const auto status = drwav_init_memory(&_wav, buffer.data(), buffer.size(), nullptr);
 	return static_cast<bool>(status);
@@ -17,6 +17,7 @@
 #include <unordered_set>
 
 #include <LHVM.h>
+#include <LHVMNative.h>
 #include <LHVMTypes.h>
 #include <entt/entity/entity.hpp>
 #include <entt/entity/fwd.hpp>
@@ -34,6 +35,33 @@
 #include "Locator.h"
 #include "ScriptHeaders/ScriptEnums.h"
 
+namespace openblack::lhvm
+{
+
+/// Vectors are pushed as their three components, x first
+template <>
+struct NativeArgument<glm::vec3>
+{
+	static constexpr int32_t k_StackSize = 3;
+
+	static glm::vec3 Pop(LHVM& vm)
+	{
+		const auto z = vm.Popf();
+		const auto y = vm.Popf();
+		const auto x = vm.Popf();
+		return {x, y, z};
+	}
+
+	static void Push(LHVM& vm, const glm::vec3& value)
+	{
+		vm.Pushv(value.x);
+		vm.Pushv(value.y);
+		vm.Pushv(value.z);
+	}
+};
+
+} // namespace openblack::lhvm
+
 namespace openblack::chlapi
 {
 
@@ -47,9 +75,16 @@ using openblack::lhvm::DataType;
 using openblack::lhvm::VMValue;
 using openblack::script::ObjectType;
 
-#define CREATE_FUNCTION_BINDING(NAME, STACKIN, STACKOUT, FUNCTION)       \
-	{                                                                    \
-		_functionsTable.emplace_back(FUNCTION, STACKIN, STACKOUT, NAME); \
+#define CREATE_FUNCTION_BINDING(NAME, STACKIN, STACKOUT, FUNCTION)                                         \
+	{                                                                                                      \
+		_functionsTable.emplace_back([](lhvm::LHVM& /*unused*/) { FUNCTION(); }, STACKIN, STACKOUT, NAME); \
+	}
+
+// Natives with typed arguments and result, whose stack sizes are checked against the ones of the table
+#define CREATE_TYPED_FUNCTION_BINDING(NAME, STACKIN, STACKOUT, FUNCTION)                                                   \
+	{                                                                                                                      \
+		static_assert(lhvm::Native<FUNCTION>::k_StackIn == (STACKIN) && lhvm::Native<FUNCTION>::k_StackOut == (STACKOUT)); \
+		_functionsTable.emplace_back(lhvm::MakeNative<FUNCTION>(NAME));                                                    \
 	}
 
 const std::vector<lhvm::NativeFunction>& CHLApi::GetFunctionsTable()
@@ -400,12 +435,9 @@ void SetPosition() // 024 SET_POSITION
 	}
 }
 
-void GetDistance() // 025 GET_DISTANCE
+float GetDistance(glm::vec3 p0, glm::vec3 p1) // 025 GET_DISTANCE
 {
-	const auto p1 = PopVec();
-	const auto p0 = PopVec();
-	const auto distance = glm::length(p1 - p0);
-	Pushf(distance);
+	return glm::length(p1 - p0);
 }
 
 void Call() // 026 CALL
@@ -430,12 +462,9 @@ void Create() // 027 CREATE
 	Pusho(static_cast<uint32_t>(object));
 }
 
-void Random() // 028 RANDOM
+float Random(float min, float max) // 028 RANDOM
 {
-	const auto max = Popf();
-	const auto min = Popf();
-	const float random = min + (max - min) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-	Pushf(random);
+	return min + (max - min) * static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
 }
 
 void DllGettime() // 029 DLL_GETTIME
@@ -1456,14 +1485,10 @@ void GetInclusionDistance() // 150 GET_INCLUSION_DISTANCE
 	Pushf(0.0f);
 }
 
-void GetLandHeight() // 151 GET_LAND_HEIGHT
+float GetLandHeight(glm::vec3 position) // 151 GET_LAND_HEIGHT
 {
-	const auto position = PopVec();
-
 	const auto& island = Locator::terrainSystem::value();
-	const auto elevation = island.GetHeightAt(glm::vec2(position.x, position.z));
-
-	Pushf(elevation);
+	return island.GetHeightAt(glm::vec2(position.x, position.z));
 }
 
 void LoadMap() // 152 LOAD_MAP
@@ -3588,15 +3613,14 @@ void CreatureFightQueueHits() // 396 CREATURE_FIGHT_QUEUE_HITS
 	Pushf(0.0f);
 }
 
-void SquareRoot() // 397 SQUARE_ROOT
+float SquareRoot(float value) // 397 SQUARE_ROOT
 {
-	const auto value = Popf();
 	auto root = 0.0f;
 	if (value > 0.0f)
 	{
 		root = std::sqrt(value);
 	}
-	Pushf(root);
+	return root;
 }
 
 void GetPlayerAlly() // 398 GET_PLAYER_ALLY
@@ -4157,10 +4181,10 @@ void CHLApi::InitFunctionsTable0()
 	CREATE_FUNCTION_BINDING("SET_PROPERTY", 3, 0, SetProperty);
 	CREATE_FUNCTION_BINDING("GET_POSITION", 1, 3, GetPosition);
 	CREATE_FUNCTION_BINDING("SET_POSITION", 4, 0, SetPosition);
-	CREATE_FUNCTION_BINDING("GET_DISTANCE", 6, 1, GetDistance);
+	CREATE_TYPED_FUNCTION_BINDING("GET_DISTANCE", 6, 1, GetDistance);
 	CREATE_FUNCTION_BINDING("CALL", 6, 1, Call);
 	CREATE_FUNCTION_BINDING("CREATE", 5, 1, Create);
-	CREATE_FUNCTION_BINDING("RANDOM", 2, 1, Random);
+	CREATE_TYPED_FUNCTION_BINDING("RANDOM", 2, 1, Random);
 	CREATE_FUNCTION_BINDING("DLL_GETTIME", 0, 1, DllGettime);
 	CREATE_FUNCTION_BINDING("START_CAMERA_CONTROL", 0, 1, StartCameraControl);
 	CREATE_FUNCTION_BINDING("END_CAMERA_CONTROL", 0, 0, EndCameraControl);
@@ -4288,7 +4312,7 @@ void CHLApi::InitFunctionsTable1()
 	CREATE_FUNCTION_BINDING("GET_TIMER_TIME_SINCE_SET", 1, 1, GetTimerTimeSinceSet);
 	CREATE_FUNCTION_BINDING("MOVE_MUSIC", 2, 0, MoveMusic);
 	CREATE_FUNCTION_BINDING("GET_INCLUSION_DISTANCE", 0, 1, GetInclusionDistance);
-	CREATE_FUNCTION_BINDING("GET_LAND_HEIGHT", 3, 1, GetLandHeight);
+	CREATE_TYPED_FUNCTION_BINDING("GET_LAND_HEIGHT", 3, 1, GetLandHeight);
 	CREATE_FUNCTION_BINDING("LOAD_MAP", 1, 0, LoadMap);
 	CREATE_FUNCTION_BINDING("STOP_ALL_SCRIPTS_EXCLUDING", 1, 0, StopAllScriptsExcluding);
 	CREATE_FUNCTION_BINDING("STOP_ALL_SCRIPTS_IN_FILES_EXCLUDING", 1, 0, StopAllScriptsInFilesExcluding);
@@ -4542,7 +4566,7 @@ void CHLApi::InitFunctionsTable3()
 	CREATE_FUNCTION_BINDING("SET_CREATURE_QUEUE_FIGHT_STEP", 2, 0, SetCreatureQueueFightStep);
 	CREATE_FUNCTION_BINDING("GET_CREATURE_FIGHT_ACTION", 1, 1, GetCreatureFightAction);
 	CREATE_FUNCTION_BINDING("CREATURE_FIGHT_QUEUE_HITS", 1, 1, CreatureFightQueueHits);
-	CREATE_FUNCTION_BINDING("SQUARE_ROOT", 1, 1, SquareRoot);
+	CREATE_TYPED_FUNCTION_BINDING("SQUARE_ROOT", 1, 1, SquareRoot);
 	CREATE_FUNCTION_BINDING("GET_PLAYER_ALLY", 2, 1, GetPlayerAlly);
 	CREATE_FUNCTION_BINDING("SET_PLAYER_WIND_RESISTANCE", 2, 1, SetPlayerWindResistance);
 }
@@ -0,0 +1,60 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace openblack
+{
+
+/// Fixed capacity queue which one thread pushes to and one other thread pops from, without locks.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+	/// Producer only, returns false and leaves the value alone if the queue is full
+	bool TryPush(T&& value)
+	{
+		const auto head = _head.load(std::memory_order_relaxed);
+		if (head - _tail.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		_slots[head % Capacity] = std::move(value);
+		_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Consumer only
+	std::optional<T> TryPop()
+	{
+		const auto tail = _tail.load(std::memory_order_relaxed);
+		if (tail == _head.load(std::memory_order_acquire))
+		{
+			return std::nullopt;
+		}
+		std::optional<T> value = std::move(_slots[tail % Capacity]);
+		_tail.store(tail + 1, std::memory_order_release);
+		return value;
+	}
+
+private:
+	// On separate cache lines so that the threads don't contend for them
+	alignas(64) std::atomic<size_t> _head {0};
+	alignas(64) std::atomic<size_t> _tail {0};
+	std::array<T, Capacity> _slots {};
+};
+
+} // namespace openblack
@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace openblack
+{
+
+/// Hands the latest snapshot of a value from one thread to another without locks.
+///
+/// The writer fills its buffer and publishes it, the reader always sees the latest published snapshot. A third buffer
+/// sits between them so that neither ever waits for the other.
+template <typename T>
+class TripleBuffer
+{
+public:
+	/// Writer only, holds an older snapshot which must be overwritten entirely
+	T& GetWriteBuffer() { return _buffers[_write]; }
+
+	/// Writer only
+	void Publish() { _write = _shared.exchange(_write | k_Fresh, std::memory_order_acq_rel) & k_Index; }
+
+	/// Reader only, the reference stays valid until the next call
+	const T& Read()
+	{
+		if ((_shared.load(std::memory_order_relaxed) & k_Fresh) != 0)
+		{
+			_read = _shared.exchange(_read, std::memory_order_acq_rel) & k_Index;
+		}
+		return _buffers[_read];
+	}
+
+private:
+	static constexpr uint8_t k_Index = 0b011;
+	static constexpr uint8_t k_Fresh = 0b100;
+
+	std::array<T, 3> _buffers {};
+	uint8_t _write {0};
+	std::atomic<uint8_t> _shared {1};
+	uint8_t _read {2};
+};
+
+} // namespace openblack
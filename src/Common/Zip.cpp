@@ -11,15 +11,16 @@
 
 #include <cassert>
 
+#include <algorithm>
 #include <limits>
 #include <stdexcept>
 
 #include <fmt/format.h>
 #include <zlib.h>
 
-constexpr auto k_MaxBufferSize = std::numeric_limits<decltype(z_stream::avail_out)>::max();
+constexpr size_t k_MaxBufferSize = std::numeric_limits<decltype(z_stream::avail_out)>::max();
 
-std::string GetZlibError(int statusCode)
+std::string openblack::zip::GetErrorString(int statusCode)
 {
 	switch (statusCode)
 	{
@@ -42,38 +43,52 @@ std::string GetZlibError(int statusCode)
 	}
 }
 
+namespace
+{
 /*
  * More information found here https://www.zlib.net/zlib_how.html
  */
-std::vector<uint8_t> openblack::zip::Inflate(const std::vector<uint8_t>& deflatedData, size_t inflatedSize)
+std::vector<uint8_t> InflateWithWindowBits(std::span<const uint8_t> deflatedData, size_t inflatedSize, int windowBits)
 {
-	auto deflatedSize = deflatedData.size();
 	auto inflatedData = std::vector<uint8_t>(inflatedSize);
 	int returnStatus;
 
-	if (deflatedSize > k_MaxBufferSize || inflatedSize > k_MaxBufferSize)
-	{
-		throw std::runtime_error("Data is too large to inflate");
-	}
-
 	z_stream strm;
 	strm.zalloc = Z_NULL;
 	strm.zfree = Z_NULL;
 	strm.opaque = Z_NULL;
 	strm.avail_in = 0;
 	strm.next_in = Z_NULL;
-	returnStatus = inflateInit(&strm);
+	strm.avail_out = 0;
+	strm.next_out = Z_NULL;
+	returnStatus = inflateInit2(&strm, windowBits);
 
 	if (returnStatus != Z_OK)
 	{
-		throw std::runtime_error(fmt::format("Failed to initialise: {}", GetZlibError(returnStatus)));
+		throw std::runtime_error(fmt::format("Failed to initialise: {}", openblack::zip::GetErrorString(returnStatus)));
 	}
 
-	strm.avail_in = static_cast<decltype(z_stream::avail_in)>(deflatedSize);
-	strm.avail_out = static_cast<decltype(z_stream::avail_out)>(inflatedSize);
-	strm.next_in = const_cast<uint8_t*>(deflatedData.data());
-	strm.next_out = inflatedData.data();
-	returnStatus = inflate(&strm, Z_NO_FLUSH);
+	// zlib counts in 32 bits, larger buffers are fed to it in pieces
+	size_t consumed = 0;
+	size_t produced = 0;
+	do
+	{
+		if (strm.avail_in == 0 && consumed < deflatedData.size())
+		{
+			const auto size = std::min(deflatedData.size() - consumed, k_MaxBufferSize);
+			strm.next_in = const_cast<uint8_t*>(deflatedData.data() + consumed);
+			strm.avail_in = static_cast<decltype(z_stream::avail_in)>(size);
+			consumed += size;
+		}
+		if (strm.avail_out == 0 && produced < inflatedSize)
+		{
+			const auto size = std::min(inflatedSize - produced, k_MaxBufferSize);
+			strm.next_out = inflatedData.data() + produced;
+			strm.avail_out = static_cast<decltype(z_stream::avail_out)>(size);
+			produced += size;
+		}
+		returnStatus = inflate(&strm, Z_NO_FLUSH);
+	} while (returnStatus == Z_OK);
 
 	switch (returnStatus)
 	{
@@ -81,9 +96,21 @@ std::vector<uint8_t> openblack::zip::Inflate(const std::vector<uint8_t>& deflate
 	case Z_DATA_ERROR:
 	case Z_MEM_ERROR:
 		inflateEnd(&strm);
-		throw std::runtime_error(fmt::format("Failed to inflate: {}", GetZlibError(returnStatus)));
+		throw std::runtime_error(fmt::format("Failed to inflate: {}", openblack::zip::GetErrorString(returnStatus)));
 	}
 
 	inflateEnd(&strm);
 	return inflatedData;
 }
+} // namespace
+
+std::vector<uint8_t> openblack::zip::Inflate(std::span<const uint8_t> deflatedData, size_t inflatedSize)
+{
+	return InflateWithWindowBits(deflatedData, inflatedSize, MAX_WBITS);
+}
+
+std::vector<uint8_t> openblack::zip::InflateRaw(std::span<const uint8_t> deflatedData, size_t inflatedSize)
+{
+	// Negative window bits for data without a zlib header
+	return InflateWithWindowBits(deflatedData, inflatedSize, -MAX_WBITS);
+}
@@ -12,11 +12,18 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <span>
+#include <string>
 #include <vector>
 
 namespace openblack::zip
 {
 
-[[nodiscard]] std::vector<uint8_t> Inflate(const std::vector<uint8_t>& deflatedData, size_t inflatedSize);
+[[nodiscard]] std::string GetErrorString(int statusCode);
+
+/// Inflate a whole buffer, use filesystem::InflateStream to inflate data as it is read from a file instead
+[[nodiscard]] std::vector<uint8_t> Inflate(std::span<const uint8_t> deflatedData, size_t inflatedSize);
+/// Inflate deflate data without a zlib header, as stored in zip archives
+[[nodiscard]] std::vector<uint8_t> InflateRaw(std::span<const uint8_t> deflatedData, size_t inflatedSize);
 
 } // namespace openblack::zip
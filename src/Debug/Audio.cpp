@@ -9,6 +9,8 @@
 
 #include "Audio.h"
 
+#include <algorithm>
+
 #include <imgui.h>
 
 #include "ECS/Registry.h"
@@ -139,6 +141,24 @@ void Audio::Music() noexcept
 		Locator::audio::value().PlayMusic(_selectedMusicPack, _playType);
 	}
 	ImGui::SameLine();
+	if (ImGui::Button("Stop"))
+	{
+		Locator::audio::value().StopMusic();
+	}
+	ImGui::SameLine();
+	const auto position = Locator::audio::value().GetMusicPosition();
+	if (ImGui::Button("-10s"))
+	{
+		Locator::audio::value().SeekMusic(std::max(position - 10.0f, 0.0f));
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("+10s"))
+	{
+		Locator::audio::value().SeekMusic(position + 10.0f);
+	}
+	ImGui::SameLine();
+	ImGui::Text("%.1f s", position);
+	ImGui::SameLine();
 	auto currentCombo = static_cast<int>(_playType);
 	ImGui::Combo("PlayType", &currentCombo, k_AudioBankLoopStrings.data(), static_cast<int>(k_AudioBankLoopStrings.size()));
 	_playType = static_cast<PlayType>(currentCombo);
@@ -184,6 +204,10 @@ void Audio::AudioSettings() noexcept
 	                  ImGuiChildFlags_Border);
 	ImGui::Text("Audio handler settings");
 	ImGui::Separator();
+	const auto voiceStats = soundManager.GetVoiceStats();
+	ImGui::Text("Voices: %u audible of %u, %u virtual emitters", voiceStats.audible, voiceStats.voices,
+	            voiceStats.virtualised);
+	ImGui::Separator();
 	ImGui::Text("Active Emitters");
 	ImGui::Separator();
 	ImGui::Columns(5, "PlayingEmitters", true);
@@ -191,7 +215,7 @@ void Audio::AudioSettings() noexcept
 	ImGui::NextColumn();
 	ImGui::Text("Sound Name");
 	ImGui::NextColumn();
-	ImGui::Text("Audio source ID");
+	ImGui::Text("Voice");
 	ImGui::NextColumn();
 	ImGui::Text("3D?");
 	ImGui::NextColumn();
@@ -200,17 +224,17 @@ void Audio::AudioSettings() noexcept
 	ImGui::Separator();
 	Locator::entitiesRegistry::value().Each<ecs::components::AudioEmitter>(
 	    [this](entt::entity entity, const AudioEmitter& emitter) {
-		    if (ImGui::Selectable(("##" + std::to_string(emitter.sourceId)).c_str(), _selectedEmitter == entity,
+		    if (ImGui::Selectable(("##" + std::to_string(entt::to_integral(entity))).c_str(), _selectedEmitter == entity,
 		                          ImGuiSelectableFlags_SpanAllColumns))
 		    {
 			    _selectedEmitter = entity;
 		    }
 		    ImGui::SameLine();
-		    ImGui::Text("%u", emitter.sourceId);
+		    ImGui::Text("%u", entt::to_integral(entity));
 		    ImGui::NextColumn();
 		    ImGui::Text("%s", Locator::audio::value().GetSound(emitter.soundId).name.c_str());
 		    ImGui::NextColumn();
-		    ImGui::Text("%d", emitter.sourceId);
+		    ImGui::Text("%d", emitter.voice);
 		    ImGui::NextColumn();
 		    ImGui::Text("%s", emitter.relative ? "Yes" : "No");
 		    ImGui::NextColumn();
@@ -266,7 +290,7 @@ void Audio::AudioSettings() noexcept
 	}
 	ImGui::Separator();
 	ImGui::Columns(5, "PlayingSounds", true);
-	ImGui::Text("Audio Source ID");
+	ImGui::Text("Voice");
 	ImGui::NextColumn();
 	ImGui::Text("Current Audio Buffer ID");
 	ImGui::NextColumn();
@@ -279,14 +303,14 @@ void Audio::AudioSettings() noexcept
 	ImGui::Separator();
 	Locator::entitiesRegistry::value().Each<ecs::components::AudioEmitter>(
 	    [this](entt::entity entity, const AudioEmitter& emitter) {
-		    if (ImGui::Selectable(("##" + std::to_string(emitter.sourceId)).c_str(), _selectedEmitter == entity,
+		    if (ImGui::Selectable(("##" + std::to_string(entt::to_integral(entity))).c_str(), _selectedEmitter == entity,
 		                          ImGuiSelectableFlags_SpanAllColumns))
 		    {
 			    _selectedEmitter = entity;
 		    }
 		    const auto& sound = Locator::audio::value().GetSound(emitter.soundId);
 		    ImGui::SameLine();
-		    ImGui::Text("%u", emitter.sourceId);
+		    ImGui::Text("%d", emitter.voice);
 		    ImGui::NextColumn();
 		    ImGui::Text("%u", sound.bufferId);
 		    ImGui::NextColumn();
@@ -316,7 +316,7 @@ void LHVMViewer::DrawScriptDisassembly(const openblack::lhvm::LHVM& lhvm, openbl
 	ImGui::PopStyleColor(4);
 }
 
-void LHVMViewer::DrawTasksTab(const lhvm::LHVM& lhvm) noexcept
+void LHVMViewer::DrawTasksTab(lhvm::LHVM& lhvm) noexcept
 {
 	const auto& tasks = lhvm.GetTasks();
 
@@ -330,7 +330,7 @@ void LHVMViewer::DrawTasksTab(const lhvm::LHVM& lhvm) noexcept
 		{
 			auto const& task = taskEntry.second;
 
-			if (ImGui::Selectable(task.name.c_str(), task.id == selectedTaskID))
+			if (ImGui::Selectable(lhvm.GetScript(task).name.c_str(), task.id == selectedTaskID))
 			{
 				SelectTask(task.id);
 			}
@@ -349,6 +349,7 @@ void LHVMViewer::DrawTasksTab(const lhvm::LHVM& lhvm) noexcept
 	if (tasks.contains(selectedTaskID))
 	{
 		auto task = tasks.at(selectedTaskID);
+		const auto& script = lhvm.GetScript(task);
 
 		ImGui::BeginChild("##task");
 		ImGui::Text("Task ID: %d", task.id);
@@ -364,12 +365,12 @@ void LHVMViewer::DrawTasksTab(const lhvm::LHVM& lhvm) noexcept
 
 		ImGui::Text("Name: ");
 		ImGui::SameLine();
-		if (ImGui::TextButtonColored(Disassembly_ColorFuncName, task.name.c_str()))
+		if (ImGui::TextButtonColored(Disassembly_ColorFuncName, script.name.c_str()))
 		{
 			SelectScript(task.scriptId);
 		}
 
-		ImGui::Text("File: %s", task.filename.c_str());
+		ImGui::Text("File: %s", script.filename.c_str());
 		ImGui::Text("Variables offset: 0x%04x", task.variablesOffset);
 		ImGui::Text("Instruction address: 0x%04x", task.instructionAddress);
 		ImGui::Text("Prev instruction address: 0x%04x", task.pevInstructionAddress);
@@ -394,9 +395,10 @@ void LHVMViewer::DrawTasksTab(const lhvm::LHVM& lhvm) noexcept
 		{
 			if (ImGui::BeginTabItem("Local Variables"))
 			{
-				for (const auto& var : task.localVars)
+				for (size_t i = 0; i < task.localVars.size(); i++)
 				{
-					ImGui::Text("%s = %s", var.name.c_str(), DataToString(var.value, var.type).c_str());
+					const auto& var = task.localVars[i];
+					ImGui::Text("%s = %s", script.variables.at(i).c_str(), DataToString(var.value, var.type).c_str());
 				}
 				ImGui::EndTabItem();
 			}
@@ -34,7 +34,7 @@ class LHVMViewer final: public Window
 	void DrawVariable(const lhvm::LHVM&, lhvm::VMScript&, uint32_t idx) noexcept;
 	void SelectScript(uint32_t idx) noexcept;
 
-	void DrawTasksTab(const lhvm::LHVM& lhvm) noexcept;
+	void DrawTasksTab(lhvm::LHVM& lhvm) noexcept;
 	void DrawStack(const lhvm::VMStack& stack) noexcept;
 	void DrawExceptionHandlers(const std::vector<uint32_t>& exceptionHandlerIps) noexcept;
 	void SelectTask(uint32_t idx) noexcept;
@@ -88,7 +88,12 @@ void MeshViewer::Draw() noexcept
 		}
 	});
 	ImGui::EndChild();
-	ImGui::Text("%u meshes", displayedMeshes);
+	ImGui::Text("%u meshes, %zu not loaded", displayedMeshes, meshes.PendingSize());
+	ImGui::SameLine();
+	if (ImGui::SmallButton("Load all"))
+	{
+		meshes.LoadPending();
+	}
 	ImGui::EndChild();
 
 	ImGui::SameLine();
@@ -357,6 +362,7 @@ void MeshViewer::Update() noexcept
 			desc.matrixCount = static_cast<uint8_t>(bones.size());
 		}
 		renderer.DrawMesh(*mesh, desc, static_cast<uint8_t>(_selectedSubMesh));
+		renderer.FlushMeshes();
 		if (_viewBoundingBox)
 		{
 			auto box = mesh->GetBoundingBox();
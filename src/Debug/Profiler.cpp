@@ -18,6 +18,7 @@
 #include "ECS/Components/Tree.h"
 #include "ECS/Registry.h"
 #include "EngineConfig.h"
+#include "Graphics/RenderQueue.h"
 #include "Graphics/RendererInterface.h"
 #include "Locator.h"
 
@@ -102,6 +103,11 @@ void Profiler::Draw() noexcept
 
 	ImGui::Columns(1);
 
+	const auto& queueStats = Locator::rendererInterface::value().GetRenderQueueStats();
+	ImGui::Text("Render Queue Submits %u, Texture Binds %u (skipped %u), Uniforms %u (skipped %u), States %u (skipped %u)",
+	            queueStats.submits, queueStats.textureBinds, queueStats.textureBindsSkipped, queueStats.uniformUpdates,
+	            queueStats.uniformUpdatesSkipped, queueStats.stateChanges, queueStats.stateChangesSkipped);
+
 	const auto& profiler = Locator::profiler::value();
 	const auto& entry = profiler.GetEntries().at(profiler.GetEntryIndex(-1));
 
@@ -11,6 +11,7 @@
 
 #include "Debug/ImGuiUtils.h"
 #include "Graphics/Texture2D.h"
+#include "Graphics/TextureResidency.h"
 #include "Locator.h"
 #include "Resources/ResourcesInterface.h"
 
@@ -25,7 +26,25 @@ TextureViewer::TextureViewer() noexcept
 void TextureViewer::Draw() noexcept
 {
 	float fontSize = ImGui::GetFontSize();
-	const auto& textures = Locator::resources::value().GetTextures();
+	auto& resources = Locator::resources::value();
+	const auto& textures = resources.GetTextures();
+	auto& residency = resources.GetTextureResidency();
+
+	{
+		constexpr float k_MiB = 1024.0f * 1024.0f;
+		const auto& stats = residency.GetStats();
+		ImGui::Text("Resident: %u/%u textures (%u pinned), %.2f/%.2f MiB of %.2f MiB budget", stats.resident, stats.managed,
+		            stats.pinned, static_cast<float>(stats.residentBytes) / k_MiB, static_cast<float>(stats.managedBytes) / k_MiB,
+		            static_cast<float>(stats.budgetBytes) / k_MiB);
+		ImGui::Text("Last frame: %u uploads, %u evictions, %u placeholders. Total: %lu uploads, %lu evictions", stats.uploads,
+		            stats.evictions, stats.placeholderRequests, static_cast<unsigned long>(stats.totalUploads),
+		            static_cast<unsigned long>(stats.totalEvictions));
+		int budget = static_cast<int>(residency.GetBudget() / (1024 * 1024));
+		if (ImGui::SliderInt("Budget (MiB)", &budget, 1, 1024))
+		{
+			residency.SetBudget(static_cast<uint64_t>(budget) * 1024 * 1024);
+		}
+	}
 
 	_filter.Draw();
 
@@ -34,12 +53,23 @@ void TextureViewer::Draw() noexcept
 	ImGui::BeginChild("texturesSelect", ImVec2(textureSize.x - 5, textureSize.y - ImGui::GetTextLineHeight() - 5), true);
 	uint32_t displayedTexture = 0;
 
-	textures.Each([this, &displayedTexture](entt::id_type id, const graphics::Texture2D& texture) {
+	textures.Each([this, &displayedTexture, &residency](entt::id_type id, const graphics::Texture2D& texture) {
 		if (_filter.PassFilter(texture.GetName().c_str()))
 		{
 			displayedTexture++;
 
-			if (ImGui::Selectable(texture.GetName().c_str(), id == _selectedTexture))
+			// Dim textures which are not on the GPU
+			const bool dimmed = residency.IsManaged(texture) && !residency.IsResident(texture);
+			if (dimmed)
+			{
+				ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+			}
+			const bool selected = ImGui::Selectable(texture.GetName().c_str(), id == _selectedTexture);
+			if (dimmed)
+			{
+				ImGui::PopStyleColor();
+			}
+			if (selected)
 			{
 				_selectedTexture = id;
 			}
@@ -72,7 +102,12 @@ void TextureViewer::Draw() noexcept
 			formatStr = "RGB8";
 		}
 		ImGui::Text("width: %u, height: %u, format: %s", texture->GetWidth(), texture->GetHeight(), formatStr.c_str());
-		ImGui::Image(texture->GetNativeHandle(), ImVec2(512, 512));
+		ImGui::Text("size: %u bytes, %s", texture->GetStorageSize(),
+		            !residency.IsManaged(*texture) ? "always resident"
+		            : residency.IsResident(*texture) ? "resident"
+		                                             : "not resident");
+		// Previews must not upload textures and evict those in use, so textures which are not resident show the placeholder
+		ImGui::Image(residency.Peek(*texture).GetNativeHandle(), ImVec2(512, 512));
 	}
 
 	ImGui::EndChild();
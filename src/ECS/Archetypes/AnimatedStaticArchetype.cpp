@@ -13,6 +13,7 @@
 #include <glm/gtx/euler_angles.hpp>
 
 #include "ECS/Components/AnimatedStatic.h"
+#include "ECS/Components/Animation.h"
 #include "ECS/Components/Fixed.h"
 #include "ECS/Components/Mesh.h"
 #include "ECS/Components/Transform.h"
@@ -43,6 +44,10 @@ entt::entity AnimatedStaticArchetype::Create(const glm::vec3& position, Animated
 	registry.Assign<Mesh>(entity, resourceId, static_cast<int8_t>(0), static_cast<int8_t>(1));
 
 	registry.Assign<AnimatedStatic>(entity, type);
+	if (static_cast<int>(info.defaultAnim) >= 0)
+	{
+		registry.Assign<Animation>(entity, static_cast<entt::id_type>(info.defaultAnim), 0u);
+	}
 
 	return entity;
 }
@@ -13,6 +13,7 @@
 #include "ECS/Components/Sprite.h"
 #include "ECS/Registry.h"
 #include "Graphics/Texture2D.h"
+#include "Graphics/TextureResidency.h"
 #include "Locator.h"
 #include "Resources/ResourcesInterface.h"
 
@@ -23,11 +24,14 @@ using namespace openblack::ecs::components;
 std::array<entt::entity, 8> CameraBookmarkArchetype::CreateAll()
 {
 	auto& registry = Locator::entitiesRegistry::value();
-	auto texture = Locator::resources::value().GetTextures().Handle(entt::hashed_string("raw/misc0a"));
+	auto& resources = Locator::resources::value();
+	auto texture = resources.GetTextures().Handle(entt::hashed_string("raw/misc0a"));
 	if (!texture)
 	{
 		throw std::runtime_error("Failed to get Camera Bookmark sprite: misc0a");
 	}
+	// Sprites keep the native handle so the texture cannot be evicted
+	resources.GetTextureResidency().Pin(*texture);
 
 	auto result = std::array<entt::entity, 8>();
 
@@ -17,6 +17,7 @@
 #include "ECS/Components/Transform.h"
 #include "ECS/Registry.h"
 #include "Graphics/Texture2D.h"
+#include "Graphics/TextureResidency.h"
 #include "Locator.h"
 #include "Resources/ResourcesInterface.h"
 
@@ -26,7 +27,10 @@ using namespace openblack::ecs::components;
 
 std::array<entt::entity, 2> GlowArchetype::Create(const LightEmitter& emitter, components::TempleRoom room)
 {
-	auto texture = Locator::resources::value().GetTextures().Handle(entt::hashed_string("raw/ATMOS"));
+	auto& resources = Locator::resources::value();
+	auto texture = resources.GetTextures().Handle(entt::hashed_string("raw/ATMOS"));
+	// Sprites keep the native handle so the texture cannot be evicted
+	resources.GetTextureResidency().Pin(*texture);
 	auto& registry = Locator::entitiesRegistry::value();
 	const auto extent = glm::vec2 {1.0f / 8.0f, 1.0f / 8.0f};
 
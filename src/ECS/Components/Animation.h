@@ -0,0 +1,27 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <entt/fwd.hpp>
+
+namespace openblack::ecs::components
+{
+/// Plays an animation on the boned mesh of an entity. Entities with this component are skinned on the GPU
+/// from the baked \ref graphics::AnimationPalette instead of being drawn with their mesh's bind pose.
+struct Animation
+{
+	entt::id_type id;
+	uint32_t timeOffset; ///< Milliseconds added to the scene time so that instances don't play in lockstep
+	float speed {1.0f};
+};
+
+} // namespace openblack::ecs::components
@@ -19,7 +19,8 @@ namespace openblack::ecs::components
 {
 struct AudioEmitter
 {
-	audio::SourceId sourceId;
+	/// Index of the voice the emitter plays on, -1 while it is virtual
+	int voice = -1;
 	entt::id_type soundId;
 	int priority = 0;
 	glm::vec3 position;
@@ -29,5 +30,10 @@ struct AudioEmitter
 	audio::PlayType loop = audio::PlayType::Once;
 	audio::AudioStatus state = audio::AudioStatus::Playing;
 	bool relative;
+	/// 0 while the sound is being decoded, the emitter starts playing once it has its buffer
+	audio::BufferId bufferId = 0;
+	float duration = 0;
+	/// Seconds played, also counted while the emitter has no voice so that it carries on from there if it gets one
+	float elapsed = 0;
 };
 } // namespace openblack::ecs::components
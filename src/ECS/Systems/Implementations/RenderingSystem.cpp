@@ -14,6 +14,7 @@
 #include <glm/gtx/transform.hpp>
 
 #include "3D/L3DMesh.h"
+#include "ECS/Components/Animation.h"
 #include "ECS/Components/Mesh.h"
 #include "ECS/Components/MorphWithTerrain.h"
 #include "ECS/Components/Stream.h"
@@ -45,9 +46,10 @@ void RenderingSystem::PrepareDrawDescs(bool drawBoundingBox)
 	};
 
 	registry.Each<const Mesh, const Transform>([&prep](const Mesh& mesh, const Transform& /*unused*/) { prep(mesh, false); },
-	                                           entt::exclude<MorphWithTerrain, TempleInteriorPart>);
+	                                           entt::exclude<MorphWithTerrain, TempleInteriorPart, Animation>);
 	registry.Each<const Mesh, const Transform, const MorphWithTerrain>(
-	    [&prep](const Mesh& mesh, const Transform& /*unused*/, const MorphWithTerrain& /*unused*/) { prep(mesh, true); });
+	    [&prep](const Mesh& mesh, const Transform& /*unused*/, const MorphWithTerrain& /*unused*/) { prep(mesh, true); },
+	    entt::exclude<Animation>);
 
 	if (drawBoundingBox)
 	{
@@ -111,7 +113,7 @@ void RenderingSystem::PrepareDrawUploadUniforms(bool drawBoundingBox)
 		    }
 		    offset.first->second++;
 	    },
-	    entt::exclude<TempleInteriorPart>);
+	    entt::exclude<TempleInteriorPart, Animation>);
 
 	if (!_renderContext.instanceUniforms.empty())
 	{
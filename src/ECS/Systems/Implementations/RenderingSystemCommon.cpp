@@ -13,7 +13,9 @@
 
 #include <glm/gtx/transform.hpp>
 
+#include "3D/AnimationPalette.h"
 #include "3D/L3DMesh.h"
+#include "ECS/Components/Animation.h"
 #include "ECS/Components/Mesh.h"
 #include "ECS/Components/MorphWithTerrain.h"
 #include "ECS/Components/Stream.h"
@@ -30,10 +32,17 @@ using namespace openblack::ecs::components;
 
 RenderContext::RenderContext()
     : instanceUniformBuffer(BGFX_INVALID_HANDLE)
+    , skinnedInstanceUniformBuffer(BGFX_INVALID_HANDLE)
+    , animationPalette(std::make_unique<graphics::AnimationPalette>())
 {
 }
 RenderContext::~RenderContext()
 {
+	if (bgfx::isValid(skinnedInstanceUniformBuffer))
+	{
+		bgfx::destroy(skinnedInstanceUniformBuffer);
+	}
+	animationPalette.reset();
 	if (bgfx::isValid(instanceUniformBuffer))
 	{
 		bgfx::destroy(instanceUniformBuffer);
@@ -56,6 +65,8 @@ void RenderingSystemCommon::PrepareDraw(bool drawBoundingBox, bool drawFootpaths
 	if (_renderContext.dirty || _renderContext.hasBoundingBoxes != drawBoundingBox ||
 	    (_renderContext.footpaths != nullptr) != drawFootpaths || (_renderContext.streams != nullptr) != drawStreams)
 	{
+		// Skinned first, entities whose animation can't be baked are drawn with the others in their bind pose
+		PrepareDrawSkinned();
 		PrepareDrawDescs(drawBoundingBox);
 		PrepareDrawUploadUniforms(drawBoundingBox);
 
@@ -125,3 +136,79 @@ void RenderingSystemCommon::PrepareDraw(bool drawBoundingBox, bool drawFootpaths
 		_renderContext.hasBoundingBoxes = drawBoundingBox;
 	}
 }
+
+void RenderingSystemCommon::PrepareDrawSkinned()
+{
+	auto& registry = Locator::entitiesRegistry::value();
+	auto& palette = *_renderContext.animationPalette;
+
+	// Group instances by mesh, baking animations which haven't been played before
+	std::map<entt::id_type, std::vector<RenderContext::SkinnedInstanceUniform>> meshInstances;
+	std::vector<entt::entity> unplayable;
+	registry.Each<const Mesh, const Transform, const Animation>(
+	    [&palette, &meshInstances, &unplayable](entt::entity entity, const Mesh& mesh, const Transform& transform,
+	                                            const Animation& animation) {
+		    const auto paletteOffset = palette.Register(mesh.id, animation.id);
+		    if (!paletteOffset.has_value())
+		    {
+			    unplayable.push_back(entity);
+			    return;
+		    }
+
+		    auto modelMatrix = glm::mat4(transform.rotation);
+		    modelMatrix = glm::translate(modelMatrix, transform.position * transform.rotation);
+		    modelMatrix = glm::scale(modelMatrix, transform.scale);
+
+		    const auto animationData = glm::vec4(static_cast<float>(*paletteOffset), static_cast<float>(animation.timeOffset),
+		                                         animation.speed, 0.0f);
+		    meshInstances[mesh.id].push_back({modelMatrix, animationData});
+	    },
+	    entt::exclude<TempleInteriorPart>);
+	for (const auto entity : unplayable)
+	{
+		registry.Remove<Animation>(entity);
+	}
+	palette.Upload();
+
+	_renderContext.skinnedDrawDescs.clear();
+	_renderContext.skinnedInstanceUniforms.clear();
+	for (const auto& [meshId, instances] : meshInstances)
+	{
+		const auto offset = static_cast<uint32_t>(_renderContext.skinnedInstanceUniforms.size());
+		const auto count = static_cast<uint32_t>(instances.size());
+		_renderContext.skinnedDrawDescs.emplace(std::piecewise_construct, std::forward_as_tuple(meshId),
+		                                        std::forward_as_tuple(offset, count, false));
+		_renderContext.skinnedInstanceUniforms.insert(_renderContext.skinnedInstanceUniforms.end(), instances.begin(),
+		                                              instances.end());
+	}
+
+	if (_renderContext.skinnedInstanceUniforms.empty())
+	{
+		return;
+	}
+
+	// Recreate instancing uniform buffer if it is too small, it will never shrink
+	const auto instanceCount = static_cast<uint32_t>(_renderContext.skinnedInstanceUniforms.size());
+	if (_skinnedInstanceCapacity < instanceCount)
+	{
+		if (bgfx::isValid(_renderContext.skinnedInstanceUniformBuffer))
+		{
+			bgfx::destroy(_renderContext.skinnedInstanceUniformBuffer);
+		}
+		bgfx::VertexLayout layout;
+		layout.begin()
+		    .add(bgfx::Attrib::TexCoord7, 4, bgfx::AttribType::Float)
+		    .add(bgfx::Attrib::TexCoord6, 4, bgfx::AttribType::Float)
+		    .add(bgfx::Attrib::TexCoord5, 4, bgfx::AttribType::Float)
+		    .add(bgfx::Attrib::TexCoord4, 4, bgfx::AttribType::Float)
+		    .add(bgfx::Attrib::TexCoord3, 4, bgfx::AttribType::Float)
+		    .end();
+		_renderContext.skinnedInstanceUniformBuffer = bgfx::createDynamicVertexBuffer(instanceCount, layout);
+		_skinnedInstanceCapacity = instanceCount;
+	}
+
+	const auto size = static_cast<uint32_t>(_renderContext.skinnedInstanceUniforms.size() *
+	                                        sizeof(RenderContext::SkinnedInstanceUniform));
+	bgfx::update(_renderContext.skinnedInstanceUniformBuffer, 0,
+	             bgfx::makeRef(_renderContext.skinnedInstanceUniforms.data(), size));
+}
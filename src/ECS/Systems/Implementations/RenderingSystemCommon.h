@@ -36,6 +36,10 @@ class RenderingSystemCommon: public RenderingSystemInterface
 private:
 	virtual void PrepareDrawDescs(bool drawBoundingBox) = 0;
 	virtual void PrepareDrawUploadUniforms(bool drawBoundingBox) = 0;
+	/// Collect entities with an Animation component, these are drawn with GPU skinning instead of instancedDrawDescs
+	void PrepareDrawSkinned();
+
+	uint32_t _skinnedInstanceCapacity {0};
 
 protected:
 	RenderContext _renderContext;
@@ -17,6 +17,11 @@
 
 #include "Graphics/Mesh.h"
 
+namespace openblack::graphics
+{
+class AnimationPalette;
+}
+
 namespace openblack::ecs::systems
 {
 struct RenderContext
@@ -58,6 +63,19 @@ struct RenderContext
 	/// the instances of entities and their bounding boxes.
 	bgfx::DynamicVertexBufferHandle instanceUniformBuffer;
 
+	/// Per instance data of meshes skinned on the GPU, laid out as i_data0 to i_data4 in shaders.
+	struct SkinnedInstanceUniform
+	{
+		glm::mat4 model;
+		glm::vec4 animation; ///< Palette texel of the baked animation, time offset, speed and padding
+	};
+	/// Same as \ref instanceUniforms for entities with an Animation component.
+	std::vector<SkinnedInstanceUniform> skinnedInstanceUniforms;
+	std::map<entt::id_type, const InstancedDrawDesc> skinnedDrawDescs;
+	bgfx::DynamicVertexBufferHandle skinnedInstanceUniformBuffer;
+	/// Bone matrices of all animations played by skinned instances, baked as they are first encountered.
+	std::unique_ptr<graphics::AnimationPalette> animationPalette;
+
 	bool dirty {true};
 	bool hasBoundingBoxes {false};
 };
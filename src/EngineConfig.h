@@ -9,6 +9,9 @@
 
 #pragma once
 
+#include <filesystem>
+#include <vector>
+
 #include <bgfx/bgfx.h>
 
 #include "Windowing/WindowingInterface.h"
@@ -48,6 +51,11 @@ struct EngineConfig
 	float cameraFarClip {static_cast<float>(0x10000)};
 
 	float guiScale {1.0f};
+	uint32_t textureBudget {256}; ///< GPU memory in MiB for textures which are created on demand
+	/// Directory of baked meshes and animations, empty when not used
+	std::filesystem::path bakedCachePath;
+	/// Zip archives mounted ahead of the game directory, the last one first
+	std::vector<std::filesystem::path> mountedArchives;
 
 	bgfx::RendererType::Enum rendererType {bgfx::RendererType::Noop};
 	glm::u16vec2 resolution {256, 256};
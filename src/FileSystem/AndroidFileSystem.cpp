@@ -158,17 +158,16 @@ std::unique_ptr<Stream> AndroidFileSystem::Open(const std::filesystem::path& pat
 	return value;
 }
 
+void AndroidFileSystem::Mount(const std::filesystem::path& archive, [[maybe_unused]] int priority)
+{
+	// Archives are memory mapped, which files read through the Storage Access Framework can't be
+	throw std::runtime_error(fmt::format("Mounting archives is not supported on Android: '{}'", archive.string()));
+}
+
 bool AndroidFileSystem::Exists(const std::filesystem::path& path) const
 {
-	try
-	{
-		[[maybe_unused]] auto realPath = FindPath(path);
-		return true;
-	}
-	catch (std::exception&)
-	{
-		return false;
-	}
+	// FindPath only rejects empty paths
+	return !path.empty();
 }
 
 std::vector<uint8_t> AndroidFileSystem::ReadAll(const std::filesystem::path& path)
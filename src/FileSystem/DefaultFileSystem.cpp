@@ -11,15 +11,23 @@
 
 #include "DefaultFileSystem.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <ios>
 #include <istream>
 #include <memory>
+#include <streambuf>
+#include <sstream>
 #include <system_error>
+#include <unordered_set>
 
+#include "Common/StringUtils.h"
 #include "FileStream.h"
+#include "MemoryStream.h"
+#include "ViewStream.h"
 #include "fmt/format.h"
+#include "spdlog/spdlog.h"
 
 #ifdef _WIN32
 // clang-format off
@@ -29,9 +37,60 @@
 // clang-format on
 #endif
 
+using namespace openblack;
 using namespace openblack::filesystem;
 
-// todo: exceptions need to be replaced with real exceptions
+namespace
+{
+/// Read only buffer over memory which outlives it, like the members of a mounted archive
+class ViewBuffer: public std::streambuf
+{
+public:
+	explicit ViewBuffer(std::span<const uint8_t> data)
+	{
+		// Never written through, the get area just isn't const
+		auto* begin = const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+		setg(begin, begin, begin + data.size());
+	}
+
+protected:
+	pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+	{
+		off_type base = 0;
+		if (direction == std::ios_base::cur)
+		{
+			base = gptr() - eback();
+		}
+		else if (direction == std::ios_base::end)
+		{
+			base = egptr() - eback();
+		}
+		const auto target = base + offset;
+		if ((which & std::ios_base::in) == 0 || target < 0 || target > egptr() - eback())
+		{
+			return {off_type(-1)};
+		}
+		setg(eback(), eback() + target, egptr());
+		return {target};
+	}
+
+	pos_type seekpos(pos_type position, std::ios_base::openmode which) override
+	{
+		return seekoff(off_type(position), std::ios_base::beg, which);
+	}
+};
+
+/// The buffer is a base so that it is constructed before the stream which reads from it
+class ViewInputStream final: private ViewBuffer, public std::istream
+{
+public:
+	explicit ViewInputStream(std::span<const uint8_t> data)
+	    : ViewBuffer(data)
+	    , std::istream(this)
+	{
+	}
+};
+} // namespace
 
 std::filesystem::path DefaultFileSystem::FindPath(const std::filesystem::path& path) const
 {
@@ -40,39 +99,140 @@ std::filesystem::path DefaultFileSystem::FindPath(const std::filesystem::path& p
 		throw std::invalid_argument("empty path");
 	}
 
+	if (auto found = Resolve(path))
+	{
+		return *std::move(found);
+	}
+
+	throw std::runtime_error("File " + path.string() + " not found");
+}
+
+std::optional<std::filesystem::path> DefaultFileSystem::Resolve(const std::filesystem::path& path) const noexcept
+{
+	if (path.empty())
+	{
+		return std::nullopt;
+	}
+
 	// try absolute first
 	if (path.is_absolute())
 	{
-		if (std::filesystem::exists(path))
+		std::error_code ec;
+		if (std::filesystem::exists(path, ec))
 		{
 			return path;
 		}
+		return std::nullopt;
 	}
-	else
+
+	// try relative to current directory
+	if (auto found = ResolveUnder({}, path))
+	{
+		return found;
+	}
+
+	// try relative to game directory
+	if (auto found = ResolveUnder(_gamePath, path))
 	{
-		// try relative to current directory
-		if (std::filesystem::exists(path))
+		return found;
+	}
+
+	// try relative to additional paths
+	for (const auto& p : _additionalPaths)
+	{
+		if (auto found = ResolveUnder(p, path))
 		{
-			return path;
+			return found;
 		}
+	}
+
+	return std::nullopt;
+}
 
-		// try relative to game directory
-		if (std::filesystem::exists(_gamePath / path))
+std::optional<std::filesystem::path> DefaultFileSystem::ResolveUnder(const std::filesystem::path& root,
+                                                                     const std::filesystem::path& path) const noexcept
+{
+	const std::lock_guard lock(_indexMutex);
+
+	// Names are matched ignoring case as the original game refers to its files with inconsistent casing
+	auto result = root;
+	for (const auto& component : path)
+	{
+		const auto name = component.string();
+		if (name.empty() || name == ".")
+		{
+			continue;
+		}
+		if (name == "..")
 		{
-			return _gamePath / path;
+			result /= component;
+			continue;
 		}
 
-		// try relative to additional paths
-		for (const auto& p : _additionalPaths)
+		const auto* index = GetDirectoryIndex(result);
+		if (index != nullptr)
 		{
-			if (std::filesystem::exists(p / path))
+			auto entry = index->find(name);
+			if (entry == index->end())
+			{
+				entry = index->find(string_utils::LowerCase(name));
+			}
+			if (entry != index->end())
 			{
-				return p / path;
+				result /= entry->second;
+				continue;
 			}
 		}
+
+		// The entry may have been created after the directory was listed, in which case the listing is out of date
+		std::error_code ec;
+		if (!std::filesystem::exists(std::filesystem::status(result / component, ec)))
+		{
+			return std::nullopt;
+		}
+		_directoryIndices.erase(result.generic_string());
+		result /= component;
 	}
+	return result;
+}
 
-	throw std::runtime_error("File " + path.string() + " not found");
+const DefaultFileSystem::DirectoryIndex*
+DefaultFileSystem::GetDirectoryIndex(const std::filesystem::path& directory) const noexcept
+{
+	auto [iter, inserted] = _directoryIndices.try_emplace(directory.generic_string());
+	if (inserted)
+	{
+		std::error_code ec;
+		std::filesystem::directory_iterator entries {directory.empty() ? "." : directory, ec};
+		if (!ec)
+		{
+			auto& index = iter->second.emplace();
+			for (; entries != std::filesystem::end(entries); entries.increment(ec))
+			{
+				if (ec)
+				{
+					break;
+				}
+				// Exact names take precedence over other entries which only differ in case
+				const auto name = entries->path().filename().string();
+				index[name] = name;
+				index.try_emplace(string_utils::LowerCase(name), name);
+			}
+		}
+	}
+	return iter->second.has_value() ? &*iter->second : nullptr;
+}
+
+void DefaultFileSystem::InvalidateIndex(const std::filesystem::path& directory) const noexcept
+{
+	const std::lock_guard lock(_indexMutex);
+	_directoryIndices.erase(directory.generic_string());
+}
+
+void DefaultFileSystem::ClearIndex() noexcept
+{
+	const std::lock_guard lock(_indexMutex);
+	_directoryIndices.clear();
 }
 
 bool DefaultFileSystem::IsPathValid(const std::filesystem::path& path)
@@ -90,26 +250,70 @@ bool DefaultFileSystem::IsPathValid(const std::filesystem::path& path)
 	return true;
 }
 
-std::unique_ptr<Stream> DefaultFileSystem::Open(const std::filesystem::path& path, Stream::Mode mode)
+const ZipArchive* DefaultFileSystem::FindArchive(const std::filesystem::path& path) const noexcept
 {
-	return std::unique_ptr<Stream>(new FileStream(FindPath(path), mode));
+	if (_archives.empty())
+	{
+		return nullptr;
+	}
+
+	const auto find = [this, &path](bool beforeDirectories) -> const ZipArchive* {
+		for (const auto& [priority, archive] : _archives)
+		{
+			if ((priority >= 0) == beforeDirectories && archive->Contains(path))
+			{
+				return archive.get();
+			}
+		}
+		return nullptr;
+	};
+	if (const auto* archive = find(true))
+	{
+		return archive;
+	}
+	return Resolve(path).has_value() ? nullptr : find(false);
 }
 
-bool DefaultFileSystem::Exists(const std::filesystem::path& path) const
+std::unique_ptr<Stream> DefaultFileSystem::Open(const std::filesystem::path& path, Stream::Mode mode)
 {
-	try
+	if (mode == Stream::Mode::Read)
 	{
-		[[maybe_unused]] auto realPath = FindPath(path);
-		return true;
+		if (const auto* archive = FindArchive(path))
+		{
+			// Stored members are read straight from the mapping of the archive
+			const auto view = archive->GetView(path);
+			if (!view.empty())
+			{
+				return std::make_unique<ViewStream>(view);
+			}
+			return std::make_unique<MemoryStream>(archive->Read(path));
+		}
 	}
-	catch (std::exception&)
+
+	if (mode == Stream::Mode::Read)
 	{
-		return false;
+		return std::unique_ptr<Stream>(new FileStream(FindPath(path), mode));
 	}
+
+	// Files which are written may not exist yet, the listing of their directory has to pick them up
+	const auto resolved = Resolve(path).value_or(path);
+	auto stream = std::unique_ptr<Stream>(new FileStream(resolved, mode));
+	InvalidateIndex(resolved.parent_path());
+	return stream;
+}
+
+bool DefaultFileSystem::Exists(const std::filesystem::path& path) const
+{
+	return FindArchive(path) != nullptr || Resolve(path).has_value();
 }
 
 std::vector<uint8_t> DefaultFileSystem::ReadAll(const std::filesystem::path& path)
 {
+	if (const auto* archive = FindArchive(path))
+	{
+		return archive->Read(path);
+	}
+
 	auto file = Open(path, Stream::Mode::Read);
 	const std::size_t size = file->Size();
 
@@ -122,26 +326,80 @@ std::vector<uint8_t> DefaultFileSystem::ReadAll(const std::filesystem::path& pat
 void DefaultFileSystem::Iterate(const std::filesystem::path& path, bool recursive,
                                 const std::function<void(const std::filesystem::path&)>& function) const
 {
-	const auto fixedPath = FindPath(path);
-	if (recursive)
-	{
-		for (const auto& f : std::filesystem::recursive_directory_iterator {fixedPath})
+	// Files shadowed by a layer which is looked in first are skipped
+	std::unordered_set<std::string> listed;
+	bool found = false;
+	const auto iterateArchives = [&](bool beforeDirectories) {
+		for (const auto& [priority, archive] : _archives)
 		{
-			function(f);
+			if ((priority >= 0) != beforeDirectories)
+			{
+				continue;
+			}
+			archive->Iterate(path, recursive, [&](const std::filesystem::path& f) {
+				found = true;
+				if (listed.insert(ZipArchive::GetKey(f)).second)
+				{
+					function(f);
+				}
+			});
 		}
-	}
-	else
+	};
+
+	iterateArchives(true);
+	if (const auto fixedPath = Resolve(path))
 	{
-		for (const auto& f : std::filesystem::directory_iterator {fixedPath})
+		found = true;
+		const auto visit = [&](const std::filesystem::path& f) {
+			if (_archives.empty() || listed.insert(ZipArchive::GetKey(path / f.lexically_relative(*fixedPath))).second)
+			{
+				function(f);
+			}
+		};
+		if (recursive)
 		{
-			function(f);
+			for (const auto& f : std::filesystem::recursive_directory_iterator {*fixedPath})
+			{
+				visit(f);
+			}
+		}
+		else
+		{
+			for (const auto& f : std::filesystem::directory_iterator {*fixedPath})
+			{
+				visit(f);
+			}
 		}
 	}
+	iterateArchives(false);
+
+	if (!found)
+	{
+		throw std::runtime_error("File " + path.string() + " not found");
+	}
+}
+
+void DefaultFileSystem::Mount(const std::filesystem::path& archive, int priority)
+{
+	auto mounted = std::make_unique<ZipArchive>(FindPath(archive));
+	SPDLOG_LOGGER_INFO(spdlog::get("game"), "Mounted {} with {} files at priority {}", mounted->GetPath().generic_string(),
+	                   mounted->GetMemberCount(), priority);
+
+	const auto position = std::find_if(_archives.begin(), _archives.end(),
+	                                   [priority](const MountedArchive& other) { return other.priority <= priority; });
+	_archives.insert(position, {priority, std::move(mounted)});
+}
+
+void DefaultFileSystem::AddAdditionalPath(const std::filesystem::path& path)
+{
+	_additionalPaths.push_back(path);
+	ClearIndex();
 }
 
 void DefaultFileSystem::SetGamePath(const std::filesystem::path& path)
 {
 	_gamePath = path;
+	ClearIndex();
 
 #if defined(unix) || defined(__unix__) || defined(__unix)
 	if (_gamePath.string().size() >= 2 && _gamePath.string().c_str()[0] == '~' && _gamePath.string().c_str()[1] == '/')
@@ -178,5 +436,16 @@ void DefaultFileSystem::SetGamePath(const std::filesystem::path& path)
 }
 std::unique_ptr<std::istream> DefaultFileSystem::GetData(const std::filesystem::path& path)
 {
+	if (const auto* archive = FindArchive(path))
+	{
+		const auto view = archive->GetView(path);
+		if (!view.empty())
+		{
+			return std::make_unique<ViewInputStream>(view);
+		}
+		const auto data = archive->Read(path);
+		return std::make_unique<std::istringstream>(std::string(data.begin(), data.end()), std::ios::binary);
+	}
+
 	return std::make_unique<std::ifstream>(FindPath(path), std::ios::binary);
 }
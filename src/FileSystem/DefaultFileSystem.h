@@ -10,9 +10,14 @@
 #pragma once
 
 #include <iosfwd>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "FileSystemInterface.h"
+#include "ZipArchive.h"
 
 #if !defined(LOCATOR_IMPLEMENTATIONS)
 #error "Locator interface implementations should only be included in Locator.cpp"
@@ -24,6 +29,7 @@ namespace openblack::filesystem
 class DefaultFileSystem: public FileSystemInterface
 {
 public:
+	/// Real path of a file in a directory, files in mounted archives have none
 	[[nodiscard]] std::filesystem::path FindPath(const std::filesystem::path& path) const override;
 	[[nodiscard]] bool IsPathValid(const std::filesystem::path& path) override;
 	std::unique_ptr<Stream> Open(const std::filesystem::path& path, Stream::Mode mode) override;
@@ -31,14 +37,45 @@ class DefaultFileSystem: public FileSystemInterface
 	[[nodiscard]] bool Exists(const std::filesystem::path& path) const override;
 	void SetGamePath(const std::filesystem::path& path) override;
 	[[nodiscard]] const std::filesystem::path& GetGamePath() const override { return _gamePath; }
-	void AddAdditionalPath(const std::filesystem::path& path) override { _additionalPaths.push_back(path); }
+	void AddAdditionalPath(const std::filesystem::path& path) override;
+	void Mount(const std::filesystem::path& archive, int priority) override;
 	std::vector<uint8_t> ReadAll(const std::filesystem::path& path) override;
 	void Iterate(const std::filesystem::path& path, bool recursive,
 	             const std::function<void(const std::filesystem::path&)>& function) const override;
 
 private:
+	struct MountedArchive
+	{
+		int priority;
+		std::unique_ptr<ZipArchive> archive;
+	};
+
+	/// Archive the path should be read from, nullptr if it is in none or a directory takes precedence
+	[[nodiscard]] const ZipArchive* FindArchive(const std::filesystem::path& path) const noexcept;
+
+	/// Lower case names of the entries of a directory to their names on disk
+	using DirectoryIndex = std::unordered_map<std::string, std::string>;
+
+	/// Resolve a path without throwing, nullopt when it isn't found
+	[[nodiscard]] std::optional<std::filesystem::path> Resolve(const std::filesystem::path& path) const noexcept;
+	/// Find a relative path under a root by looking up each component in the index of its directory, ignoring case
+	[[nodiscard]] std::optional<std::filesystem::path> ResolveUnder(const std::filesystem::path& root,
+	                                                                const std::filesystem::path& path) const noexcept;
+	/// Index of a directory, listed the first time it is looked in. The caller holds _indexMutex.
+	const DirectoryIndex* GetDirectoryIndex(const std::filesystem::path& directory) const noexcept;
+	/// Forget the listing of a directory, for when an entry is added to it
+	void InvalidateIndex(const std::filesystem::path& directory) const noexcept;
+	void ClearIndex() noexcept;
+
 	std::filesystem::path _gamePath;
 	std::vector<std::filesystem::path> _additionalPaths;
+	/// Highest priority first, the same priority in reverse order of mounting
+	std::vector<MountedArchive> _archives;
+
+	/// Directories are indexed lazily, paths are resolved from worker threads while assets load. The listings are only a
+	/// cache, entries created since are found on disk when they are missing from them.
+	mutable std::mutex _indexMutex;
+	mutable std::unordered_map<std::string, std::optional<DirectoryIndex>> _directoryIndices;
 };
 
 } // namespace openblack::filesystem
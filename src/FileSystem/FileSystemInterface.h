@@ -117,6 +117,9 @@ class FileSystemInterface
 	virtual void SetGamePath(const std::filesystem::path& path) = 0;
 	[[nodiscard]] virtual const std::filesystem::path& GetGamePath() const = 0;
 	virtual void AddAdditionalPath(const std::filesystem::path& path) = 0;
+	/// Mount a zip archive as a read-only layer. Archives with a priority of 0 or more are looked in before the game and
+	/// additional paths, those with a negative priority after them. Higher priorities are looked in first.
+	virtual void Mount(const std::filesystem::path& archive, int priority) = 0;
 	virtual std::vector<uint8_t> ReadAll(const std::filesystem::path& path) = 0;
 	virtual void Iterate(const std::filesystem::path& path, bool recursive,
 	                     const std::function<void(const std::filesystem::path&)>& function) const = 0;
@@ -0,0 +1,182 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "InflateStream.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+#include <zlib.h>
+
+#include "Common/Zip.h"
+
+using namespace openblack::filesystem;
+
+namespace
+{
+constexpr std::size_t k_ChunkSize = 64 * 1024;
+} // namespace
+
+InflateStream::InflateStream(std::unique_ptr<Stream> source, std::size_t inflatedSize)
+    : _source(std::move(source))
+    , _sourceStart(_source->Position())
+    , _inflatedSize(inflatedSize)
+    , _stream(std::make_unique<z_stream>())
+    , _chunk(k_ChunkSize)
+{
+	_stream->zalloc = Z_NULL;
+	_stream->zfree = Z_NULL;
+	_stream->opaque = Z_NULL;
+	_stream->avail_in = 0;
+	_stream->next_in = Z_NULL;
+	const auto status = inflateInit(_stream.get());
+	if (status != Z_OK)
+	{
+		throw std::runtime_error(fmt::format("Failed to initialise: {}", zip::GetErrorString(status)));
+	}
+}
+
+InflateStream::~InflateStream()
+{
+	inflateEnd(_stream.get());
+}
+
+std::size_t InflateStream::Position() const
+{
+	return _position;
+}
+
+std::size_t InflateStream::Size() const
+{
+	return _inflatedSize;
+}
+
+void InflateStream::Seek(std::size_t position, SeekMode seek)
+{
+	std::size_t target = position;
+	switch (seek)
+	{
+	case SeekMode::Begin:
+		break;
+	case SeekMode::Current:
+		target = _position + position;
+		break;
+	case SeekMode::End:
+		target = _inflatedSize + position;
+		break;
+	}
+	if (target > _inflatedSize)
+	{
+		throw std::runtime_error(fmt::format("Seek to {} past the end of {} bytes of inflated data", target, _inflatedSize));
+	}
+
+	if (target < _position)
+	{
+		Restart();
+	}
+	while (_position < target)
+	{
+		Inflate(_chunk.data() + _chunk.size() / 2, std::min(target - _position, _chunk.size() / 2));
+	}
+}
+
+Stream& InflateStream::Read(uint8_t* buffer, std::size_t length)
+{
+	if (length > _inflatedSize - _position)
+	{
+		throw std::runtime_error(fmt::format("Error while reading inflated data"));
+	}
+	Inflate(buffer, length);
+	return *this;
+}
+
+Stream& InflateStream::Write([[maybe_unused]] const uint8_t* buffer, [[maybe_unused]] std::size_t length)
+{
+	throw std::runtime_error("Inflated data can't be written to");
+}
+
+std::string InflateStream::GetLine()
+{
+	std::string line;
+	while (!IsEndOfFile())
+	{
+		uint8_t character;
+		Inflate(&character, 1);
+		if (character == '\n')
+		{
+			break;
+		}
+		line.push_back(static_cast<char>(character));
+	}
+	return line;
+}
+
+bool InflateStream::IsEndOfFile() const
+{
+	return _position >= _inflatedSize;
+}
+
+void InflateStream::Restart()
+{
+	inflateReset(_stream.get());
+	_stream->avail_in = 0;
+	_source->Seek(_sourceStart, SeekMode::Begin);
+	_position = 0;
+}
+
+/*
+ * More information found here https://www.zlib.net/zlib_how.html
+ */
+void InflateStream::Inflate(uint8_t* buffer, std::size_t length)
+{
+	// Compressed data is read into the first half of the chunk, the second half is scratch space for seeks
+	const auto inputSize = _chunk.size() / 2;
+	while (length > 0)
+	{
+		if (_stream->avail_in == 0)
+		{
+			const auto size = std::min(_source->Size() - _source->Position(), inputSize);
+			if (size == 0)
+			{
+				throw std::runtime_error("Failed to inflate: compressed data ends early");
+			}
+			_source->Read(_chunk.data(), size);
+			_stream->next_in = _chunk.data();
+			_stream->avail_in = static_cast<uInt>(size);
+		}
+
+		const auto outputSize = std::min<std::size_t>(length, std::numeric_limits<uInt>::max());
+		_stream->next_out = buffer;
+		_stream->avail_out = static_cast<uInt>(outputSize);
+		const auto status = inflate(_stream.get(), Z_NO_FLUSH);
+		const auto inflated = outputSize - _stream->avail_out;
+		switch (status)
+		{
+		case Z_NEED_DICT:
+		case Z_DATA_ERROR:
+		case Z_MEM_ERROR:
+		case Z_STREAM_ERROR:
+			throw std::runtime_error(fmt::format("Failed to inflate: {}", zip::GetErrorString(status)));
+		case Z_STREAM_END:
+			if (inflated < length)
+			{
+				throw std::runtime_error("Failed to inflate: inflated data ends early");
+			}
+			break;
+		default:
+			break;
+		}
+
+		buffer += inflated;
+		length -= inflated;
+		_position += inflated;
+	}
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <memory>
+#include <vector>
+
+#include "Stream.h"
+
+struct z_stream_s;
+
+namespace openblack::filesystem
+{
+
+/// Read only stream which inflates zlib data from another stream as it is read.
+///
+/// Only a chunk of the compressed data is held at a time. Seeking forward inflates and discards the data in between,
+/// seeking backward starts inflating again from the beginning.
+class InflateStream final: public Stream
+{
+public:
+	/// The compressed data starts at the current position of the source
+	InflateStream(std::unique_ptr<Stream> source, std::size_t inflatedSize);
+	~InflateStream() override;
+
+	[[nodiscard]] std::size_t Position() const override;
+	[[nodiscard]] std::size_t Size() const override;
+	void Seek(std::size_t position, SeekMode seek) override;
+
+	Stream& Read(uint8_t* buffer, std::size_t length) override;
+	Stream& Write(const uint8_t* buffer, std::size_t length) override;
+
+	std::string GetLine() override;
+
+	bool IsEndOfFile() const override;
+
+private:
+	void Restart();
+	void Inflate(uint8_t* buffer, std::size_t length);
+
+	std::unique_ptr<Stream> _source;
+	std::size_t _sourceStart;
+	std::size_t _inflatedSize;
+	std::size_t _position {0};
+	std::unique_ptr<z_stream_s> _stream;
+	std::vector<uint8_t> _chunk;
+};
+
+} // namespace openblack::filesystem
@@ -0,0 +1,151 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "ReadQueue.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <spdlog/fmt/fmt.h>
+
+#include "FileSystemInterface.h"
+
+using namespace openblack::filesystem;
+
+uint32_t ReadQueue::GetDefaultThreadCount() noexcept
+{
+#ifdef __ANDROID__
+	// Files are read through JNI which is bound to the main thread
+	return 0;
+#else
+	// Reads spend their time waiting on the disk, a couple of threads keep it busy without competing with the loaders
+	return 2;
+#endif
+}
+
+ReadQueue::ReadQueue(FileSystemInterface& fileSystem, uint32_t threadCount)
+    : _fileSystem(fileSystem)
+{
+	_threads.reserve(threadCount);
+	for (uint32_t i = 0; i < threadCount; ++i)
+	{
+		_threads.emplace_back([this]() { Work(); });
+	}
+}
+
+ReadQueue::~ReadQueue()
+{
+	{
+		const std::lock_guard lock(_mutex);
+		_stop = true;
+		for (auto& queue : _pending)
+		{
+			for (auto& pending : queue)
+			{
+				pending.promise.set_exception(std::make_exception_ptr(
+				    std::runtime_error(fmt::format("Read of {} was cancelled", pending.path.generic_string()))));
+			}
+			queue.clear();
+		}
+	}
+	_workAvailable.notify_all();
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+ReadQueue::Request ReadQueue::Read(const std::filesystem::path& path, Priority priority)
+{
+	Pending pending {0, path, {}};
+	Request request {0, pending.promise.get_future()};
+
+	if (_threads.empty())
+	{
+		{
+			const std::lock_guard lock(_mutex);
+			request.id = _nextId++;
+		}
+		Serve(pending);
+		return request;
+	}
+
+	{
+		const std::lock_guard lock(_mutex);
+		request.id = pending.id = _nextId++;
+		_pending[static_cast<size_t>(priority)].push_back(std::move(pending));
+	}
+	_workAvailable.notify_one();
+	return request;
+}
+
+bool ReadQueue::Cancel(RequestId id)
+{
+	const std::lock_guard lock(_mutex);
+	for (auto& queue : _pending)
+	{
+		auto iter = std::find_if(queue.begin(), queue.end(), [id](const Pending& pending) { return pending.id == id; });
+		if (iter != queue.end())
+		{
+			iter->promise.set_exception(std::make_exception_ptr(
+			    std::runtime_error(fmt::format("Read of {} was cancelled", iter->path.generic_string()))));
+			queue.erase(iter);
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t ReadQueue::GetPendingCount() const
+{
+	const std::lock_guard lock(_mutex);
+	size_t count = 0;
+	for (const auto& queue : _pending)
+	{
+		count += queue.size();
+	}
+	return count;
+}
+
+void ReadQueue::Work()
+{
+	std::unique_lock lock(_mutex);
+	while (true)
+	{
+		// Highest priority first
+		auto queue = _pending.rend();
+		_workAvailable.wait(lock, [this, &queue]() {
+			queue = std::find_if(_pending.rbegin(), _pending.rend(), [](const auto& q) { return !q.empty(); });
+			return _stop || queue != _pending.rend();
+		});
+		if (_stop)
+		{
+			return;
+		}
+
+		auto pending = std::move(queue->front());
+		queue->pop_front();
+
+		lock.unlock();
+		Serve(pending);
+		lock.lock();
+	}
+}
+
+void ReadQueue::Serve(Pending& pending) noexcept
+{
+	try
+	{
+		pending.promise.set_value(_fileSystem.ReadAll(pending.path));
+	}
+	catch (...)
+	{
+		pending.promise.set_exception(std::current_exception());
+	}
+}
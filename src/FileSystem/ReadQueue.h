@@ -0,0 +1,88 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace openblack::filesystem
+{
+
+class FileSystemInterface;
+
+/// Reads whole files on I/O threads so that reading can overlap with parsing and rendering.
+///
+/// Requests are served highest priority first, and in the order they were made within a priority. A request which has
+/// not started can be cancelled, its future then holds an exception. Files are read through the file system, so files
+/// in mounted archives are found as well.
+class ReadQueue
+{
+public:
+	enum class Priority : uint8_t
+	{
+		Background,
+		Normal,
+		Urgent,
+
+		_Count
+	};
+
+	using RequestId = uint64_t;
+
+	struct Request
+	{
+		RequestId id;
+		std::future<std::vector<uint8_t>> data;
+	};
+
+	/// Threads used when none are specified, 0 on platforms where the file system must be accessed from one thread
+	static uint32_t GetDefaultThreadCount() noexcept;
+
+	/// Without threads, files are read as they are requested
+	ReadQueue(FileSystemInterface& fileSystem, uint32_t threadCount);
+	/// Cancels the requests which have not started and waits for the others
+	~ReadQueue();
+	ReadQueue(const ReadQueue&) = delete;
+	ReadQueue& operator=(const ReadQueue&) = delete;
+
+	[[nodiscard]] Request Read(const std::filesystem::path& path, Priority priority = Priority::Normal);
+	/// Returns false if the request has started or there is no such request
+	bool Cancel(RequestId id);
+	[[nodiscard]] size_t GetPendingCount() const;
+
+private:
+	struct Pending
+	{
+		RequestId id;
+		std::filesystem::path path;
+		std::promise<std::vector<uint8_t>> promise;
+	};
+
+	void Work();
+	void Serve(Pending& pending) noexcept;
+
+	FileSystemInterface& _fileSystem;
+	mutable std::mutex _mutex;
+	std::condition_variable _workAvailable;
+	std::array<std::deque<Pending>, static_cast<size_t>(Priority::_Count)> _pending;
+	std::vector<std::thread> _threads;
+	RequestId _nextId {0};
+	bool _stop {false};
+};
+
+} // namespace openblack::filesystem
@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "ViewStream.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace openblack::filesystem;
+
+ViewStream::ViewStream(std::span<const uint8_t> data)
+    : _data(data)
+{
+}
+
+std::size_t ViewStream::Position() const
+{
+	return _position;
+}
+
+std::size_t ViewStream::Size() const
+{
+	return _data.size();
+}
+
+void ViewStream::Seek(std::size_t position, SeekMode seek)
+{
+	switch (seek)
+	{
+	case SeekMode::Begin:
+		_position = position;
+		break;
+	case SeekMode::Current:
+		_position += position;
+		break;
+	case SeekMode::End:
+		_position = _data.size() + position;
+		break;
+	}
+}
+
+Stream& ViewStream::Read(uint8_t* buffer, std::size_t length)
+{
+	if (_position > _data.size() || length > _data.size() - _position)
+	{
+		throw std::runtime_error("Error while reading past the end of the data");
+	}
+	std::copy_n(_data.data() + _position, length, buffer);
+	_position += length;
+	return *this;
+}
+
+Stream& ViewStream::Write([[maybe_unused]] const uint8_t* buffer, [[maybe_unused]] std::size_t length)
+{
+	throw std::runtime_error("Viewed data can't be written to");
+}
+
+std::string ViewStream::GetLine()
+{
+	const auto begin = _data.begin() + static_cast<std::ptrdiff_t>(std::min(_position, _data.size()));
+	const auto it = std::find(begin, _data.end(), '\n');
+
+	std::string line(begin, it);
+	_position = static_cast<std::size_t>(std::distance(_data.begin(), it)) + (it != _data.end() ? 1 : 0);
+	return line;
+}
+
+bool ViewStream::IsEndOfFile() const
+{
+	return _position >= _data.size();
+}
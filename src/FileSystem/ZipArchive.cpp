@@ -0,0 +1,219 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "ZipArchive.h"
+
+#include <cstring>
+
+#include <stdexcept>
+
+#include <MappedFile.h>
+#include <spdlog/fmt/fmt.h>
+
+#include "Common/StringUtils.h"
+#include "Common/Zip.h"
+
+using namespace openblack;
+using namespace openblack::filesystem;
+
+/*
+ * Layout from https://pkware.cachefly.net/webdocs/casestudies/APPNOTE.TXT, zip64 archives are not supported.
+ * The end of central directory record is found by scanning back from the end of the file, past the archive comment.
+ */
+
+namespace
+{
+constexpr uint32_t k_EndOfCentralDirectorySignature = 0x06054b50;
+constexpr uint32_t k_CentralDirectorySignature = 0x02014b50;
+constexpr uint32_t k_LocalHeaderSignature = 0x04034b50;
+constexpr size_t k_EndOfCentralDirectorySize = 22;
+constexpr size_t k_CentralDirectoryHeaderSize = 46;
+constexpr size_t k_LocalHeaderSize = 30;
+constexpr size_t k_MaxCommentSize = 0xFFFF;
+constexpr uint16_t k_MethodStored = 0;
+constexpr uint16_t k_MethodDeflated = 8;
+constexpr uint16_t k_FlagEncrypted = 1;
+
+/// Generic path without leading "./" or trailing separators
+std::string Normalize(const std::filesystem::path& path)
+{
+	auto name = path.lexically_normal().generic_string();
+	while (name.starts_with("./"))
+	{
+		name.erase(0, 2);
+	}
+	while (!name.empty() && name.back() == '/')
+	{
+		name.pop_back();
+	}
+	return name == "." ? std::string() : name;
+}
+
+template <typename T>
+T ReadValue(std::span<const uint8_t> data, size_t offset)
+{
+	T value;
+	std::memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+} // namespace
+
+ZipArchive::ZipArchive(const std::filesystem::path& path)
+    : _path(path)
+    , _mapping(mapped::MappedFile::Map(path, mapped::Access::Random))
+{
+	if (_mapping == nullptr)
+	{
+		throw std::runtime_error(fmt::format("Failed to map archive '{}'", path.string()));
+	}
+	const auto data = _mapping->GetData();
+	const auto fail = [&path](std::string_view reason) {
+		return std::runtime_error(fmt::format("Failed to read archive '{}': {}", path.string(), reason));
+	};
+
+	if (data.size() < k_EndOfCentralDirectorySize)
+	{
+		throw fail("too small");
+	}
+	size_t end = data.size() - k_EndOfCentralDirectorySize;
+	const size_t lowest = end > k_MaxCommentSize ? end - k_MaxCommentSize : 0;
+	while (ReadValue<uint32_t>(data, end) != k_EndOfCentralDirectorySignature)
+	{
+		if (end == lowest)
+		{
+			throw fail("no end of central directory");
+		}
+		--end;
+	}
+
+	const auto count = ReadValue<uint16_t>(data, end + 10);
+	const auto directorySize = ReadValue<uint32_t>(data, end + 12);
+	const auto directoryOffset = ReadValue<uint32_t>(data, end + 16);
+	if (static_cast<size_t>(directoryOffset) + directorySize > end)
+	{
+		throw fail("central directory out of bounds");
+	}
+
+	_members.reserve(count);
+	size_t offset = directoryOffset;
+	for (uint16_t i = 0; i < count; ++i)
+	{
+		if (offset + k_CentralDirectoryHeaderSize > end || ReadValue<uint32_t>(data, offset) != k_CentralDirectorySignature)
+		{
+			throw fail("bad central directory header");
+		}
+		const auto flags = ReadValue<uint16_t>(data, offset + 8);
+		const auto method = ReadValue<uint16_t>(data, offset + 10);
+		const auto compressedSize = ReadValue<uint32_t>(data, offset + 20);
+		const auto size = ReadValue<uint32_t>(data, offset + 24);
+		const auto nameSize = ReadValue<uint16_t>(data, offset + 28);
+		const auto extraSize = ReadValue<uint16_t>(data, offset + 30);
+		const auto commentSize = ReadValue<uint16_t>(data, offset + 32);
+		const auto localOffset = ReadValue<uint32_t>(data, offset + 42);
+		if (offset + k_CentralDirectoryHeaderSize + nameSize > end)
+		{
+			throw fail("bad central directory header");
+		}
+		std::string name(reinterpret_cast<const char*>(data.data() + offset + k_CentralDirectoryHeaderSize), nameSize);
+		offset += k_CentralDirectoryHeaderSize + nameSize + extraSize + commentSize;
+
+		if (name.empty() || name.back() == '/')
+		{
+			continue;
+		}
+		if ((flags & k_FlagEncrypted) != 0 || (method != k_MethodStored && method != k_MethodDeflated))
+		{
+			throw fail(fmt::format("member '{}' is encrypted or uses an unsupported compression method", name));
+		}
+
+		// The local header repeats the name and may have a different extra field
+		if (static_cast<size_t>(localOffset) + k_LocalHeaderSize > data.size() ||
+		    ReadValue<uint32_t>(data, localOffset) != k_LocalHeaderSignature)
+		{
+			throw fail(fmt::format("bad local header for '{}'", name));
+		}
+		const auto dataOffset = static_cast<size_t>(localOffset) + k_LocalHeaderSize +
+		                        ReadValue<uint16_t>(data, localOffset + 26) + ReadValue<uint16_t>(data, localOffset + 28);
+		if (dataOffset + compressedSize > data.size() || (method == k_MethodStored && compressedSize != size))
+		{
+			throw fail(fmt::format("member '{}' out of bounds", name));
+		}
+
+		name = Normalize(name);
+		auto key = string_utils::LowerCase(name);
+		_members.insert_or_assign(std::move(key),
+		                          Member {std::move(name), method, data.subspan(dataOffset, compressedSize), size});
+	}
+}
+
+ZipArchive::~ZipArchive() = default;
+
+std::string ZipArchive::GetKey(const std::filesystem::path& path)
+{
+	return string_utils::LowerCase(Normalize(path));
+}
+
+const ZipArchive::Member* ZipArchive::Find(const std::filesystem::path& path) const noexcept
+{
+	const auto iter = _members.find(GetKey(path));
+	return iter != _members.end() ? &iter->second : nullptr;
+}
+
+bool ZipArchive::Contains(const std::filesystem::path& path) const noexcept
+{
+	return Find(path) != nullptr;
+}
+
+std::span<const uint8_t> ZipArchive::GetView(const std::filesystem::path& path) const noexcept
+{
+	const auto* member = Find(path);
+	if (member == nullptr || member->method != k_MethodStored)
+	{
+		return {};
+	}
+	return member->data;
+}
+
+std::vector<uint8_t> ZipArchive::Read(const std::filesystem::path& path) const
+{
+	const auto* member = Find(path);
+	if (member == nullptr)
+	{
+		throw std::runtime_error("File " + path.string() + " not found in " + _path.string());
+	}
+	if (member->method == k_MethodStored)
+	{
+		return {member->data.begin(), member->data.end()};
+	}
+	return zip::InflateRaw(member->data, member->size);
+}
+
+void ZipArchive::Iterate(const std::filesystem::path& directory, bool recursive,
+                         const std::function<void(const std::filesystem::path&)>& function) const
+{
+	auto prefix = GetKey(directory);
+	if (!prefix.empty())
+	{
+		prefix += '/';
+	}
+
+	for (const auto& [key, member] : _members)
+	{
+		if (!key.starts_with(prefix))
+		{
+			continue;
+		}
+		const auto relative = member.name.substr(prefix.size());
+		if (!recursive && relative.find('/') != std::string::npos)
+		{
+			continue;
+		}
+		function(directory / relative);
+	}
+}
@@ -0,0 +1,76 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace openblack::mapped
+{
+class MappedFile;
+}
+
+namespace openblack::filesystem
+{
+
+/// Read-only zip archive which is mounted in the file system.
+///
+/// The archive is mapped and its central directory read into a table of members when it is opened. Stored members are
+/// viewed straight from the mapping and deflated members are inflated when read. Member names are matched ignoring
+/// case, like the files of the game directory.
+class ZipArchive
+{
+public:
+	/// Throws std::runtime_error if the archive can't be mapped or isn't a zip archive
+	explicit ZipArchive(const std::filesystem::path& path);
+	~ZipArchive();
+	ZipArchive(const ZipArchive&) = delete;
+	ZipArchive& operator=(const ZipArchive&) = delete;
+
+	[[nodiscard]] const std::filesystem::path& GetPath() const noexcept { return _path; }
+	[[nodiscard]] size_t GetMemberCount() const noexcept { return _members.size(); }
+
+	[[nodiscard]] bool Contains(const std::filesystem::path& path) const noexcept;
+	/// Data of a member which is stored uncompressed, empty if the member is missing or compressed
+	[[nodiscard]] std::span<const uint8_t> GetView(const std::filesystem::path& path) const noexcept;
+	/// Copy or inflate a member, throws std::runtime_error if it is missing or can't be inflated
+	[[nodiscard]] std::vector<uint8_t> Read(const std::filesystem::path& path) const;
+	/// Call function with the path under directory of each member in it, directories themselves are not listed
+	void Iterate(const std::filesystem::path& directory, bool recursive,
+	             const std::function<void(const std::filesystem::path&)>& function) const;
+
+	/// Name used to look up a path in the archive
+	[[nodiscard]] static std::string GetKey(const std::filesystem::path& path);
+
+private:
+	struct Member
+	{
+		/// Name as stored in the archive
+		std::string name;
+		uint16_t method;
+		std::span<const uint8_t> data;
+		uint32_t size;
+	};
+
+	[[nodiscard]] const Member* Find(const std::filesystem::path& path) const noexcept;
+
+	std::filesystem::path _path;
+	std::unique_ptr<mapped::MappedFile> _mapping;
+	std::unordered_map<std::string, Member> _members;
+};
+
+} // namespace openblack::filesystem
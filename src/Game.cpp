@@ -9,6 +9,7 @@
 
 #include "Game.h"
 
+#include <optional>
 #include <string>
 
 #include <LHVM.h>
@@ -47,13 +48,16 @@
 #include "ECS/Systems/RenderingSystemInterface.h"
 #include "EngineConfig.h"
 #include "FileSystem/FileSystemInterface.h"
+#include "FileSystem/ReadQueue.h"
 #include "Graphics/FrameBuffer.h"
+#include "Graphics/RenderQueue.h"
 #include "Graphics/RendererInterface.h"
 #include "Input/GameActionMapInterface.h"
 #include "LHScriptX/Script.h"
 #include "Locator.h"
 #include "Parsers/InfoFile.h"
 #include "Profiler.h"
+#include "Resources/LoadGraph.h"
 #include "Resources/Loaders.h"
 #include "Resources/ResourcesInterface.h"
 #include "Serializer/FotFile.h"
@@ -68,6 +72,21 @@ using namespace std::chrono_literals;
 
 const std::string k_WindowTitle = "openblack";
 
+namespace
+{
+pack::PackResult OpenPack(pack::PackFile& pack, const std::filesystem::path& path)
+{
+	auto& fileSystem = Locator::filesystem::value();
+	// Map the pack straight from disk, files which only exist behind a stream (Android assets) are read into memory
+	auto result = pack.Open(fileSystem.FindPath(path));
+	if (result == pack::PackResult::ErrCantOpen)
+	{
+		result = pack.ReadFile(*fileSystem.GetData(path));
+	}
+	return result;
+}
+} // namespace
+
 Game* Game::sInstance = nullptr;
 
 Game::Game(Arguments&& args) noexcept
@@ -114,6 +133,12 @@ Game::Game(Arguments&& args) noexcept
 	config.rendererType = args.rendererType;
 	config.vsync = args.vsync;
 	config.guiScale = args.guiScale;
+	if (args.textureBudget.has_value())
+	{
+		config.textureBudget = *args.textureBudget;
+	}
+	config.bakedCachePath = args.bakedCachePath;
+	config.mountedArchives = args.mountedArchives;
 }
 
 Game::~Game() noexcept
@@ -473,6 +498,21 @@ bool Game::Initialize() noexcept
 
 	SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "The GamePath is \"{}\".", fileSystem.GetGamePath().generic_string());
 
+	const auto& mountedArchives = config.mountedArchives;
+	for (size_t i = 0; i < mountedArchives.size(); ++i)
+	{
+		try
+		{
+			fileSystem.Mount(mountedArchives[i], static_cast<int>(i));
+		}
+		catch (std::runtime_error& err)
+		{
+			SPDLOG_LOGGER_CRITICAL(spdlog::get("game"), "Failed to mount {}: {}", mountedArchives[i].generic_string(),
+			                       err.what());
+			return false;
+		}
+	}
+
 	if (std::filesystem::path(_startMap).is_absolute())
 	{
 		if (std::find(_startMap.begin(), _startMap.end(), "Scripts") != _startMap.end())
@@ -508,25 +548,43 @@ bool Game::Initialize() noexcept
 	auto& soundManager = resources.GetSounds();
 	auto& glowManager = resources.GetGlows();
 
+	resources.GetTextureResidency().SetBudget(static_cast<uint64_t>(Locator::config::value().textureBudget) * 1024 * 1024);
+	resources.GetBakedAssets().SetDirectory(Locator::config::value().bakedCachePath);
+
+	// Files are read and parsed on worker threads, the results are added to the resource managers and uploaded here
+	resources::LoadGraph loadGraph;
+	using Commit = resources::LoadGraph::Commit;
+	bool loadFailed = false;
+
+	const auto addMeshTask = [&loadGraph, &meshManager](std::string name, std::filesystem::path path) {
+		loadGraph.Add(name, [&meshManager, name, path]() -> Commit {
+			try
+			{
+				auto baked = resources::L3DLoader::Parse(path);
+				return [&meshManager, name, debugName = path.stem().string(), baked = std::move(baked)]() {
+					meshManager.Load(name, resources::L3DLoader::FromParsedTag {}, debugName, baked);
+				};
+			}
+			catch (std::runtime_error& err)
+			{
+				SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+				return {};
+			}
+		});
+	};
+
 	fileSystem.Iterate(
-	    fileSystem.GetPath<Path::Citadel>() / "OutsideMeshes", false, [&meshManager](const std::filesystem::path& f) {
+	    fileSystem.GetPath<Path::Citadel>() / "OutsideMeshes", false, [&addMeshTask](const std::filesystem::path& f) {
 		    if (f.extension() == ".zzz")
 		    {
 			    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading temple mesh: {}", f.stem().string());
-			    try
-			    {
-				    meshManager.Load(fmt::format("temple/{}", f.stem().string()), resources::L3DLoader::FromDiskTag {}, f);
-			    }
-			    catch (std::runtime_error& err)
-			    {
-				    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-			    }
+			    addMeshTask(fmt::format("temple/{}", f.stem().string()), f);
 		    }
 	    });
 
 	fileSystem.Iterate( //
 	    fileSystem.GetPath<filesystem::Path::Citadel>() / "engine", false,
-	    [&meshManager, &glowManager](const std::filesystem::path& f) {
+	    [&loadGraph, &addMeshTask, &glowManager](const std::filesystem::path& f) {
 		    if (f.extension() == ".zzz")
 		    {
 			    if (f.stem().string().ends_with("lo_l3d"))
@@ -537,242 +595,319 @@ bool Game::Initialize() noexcept
 				    return;
 			    }
 			    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading interior temple mesh: {}", f.stem().string());
-			    try
-			    {
-				    meshManager.Load(fmt::format("temple/interior/{}", f.stem().string()), resources::L3DLoader::FromDiskTag {},
-				                     f);
-			    }
-			    catch (std::runtime_error& err)
-			    {
-				    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-			    }
+			    addMeshTask(fmt::format("temple/interior/{}", f.stem().string()), f);
 		    }
 		    else if (f.extension() == ".glw")
 		    {
 			    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading interior temple glows: {}", f.stem().string());
-			    try
-			    {
-				    glowManager.Load(fmt::format("temple/interior/glow/{}", f.stem().string()),
-				                     resources::LightLoader::FromDiskTag {}, f);
-			    }
-			    catch (std::runtime_error& err)
-			    {
-				    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-			    }
+			    auto name = fmt::format("temple/interior/glow/{}", f.stem().string());
+			    loadGraph.Add(name, [&glowManager, name, f]() -> Commit {
+				    try
+				    {
+					    auto lights = resources::LightLoader {}(resources::LightLoader::FromDiskTag {}, f);
+					    return [&glowManager, name, lights = std::move(lights)]() { glowManager.Insert(name, lights); };
+				    }
+				    catch (std::runtime_error& err)
+				    {
+					    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+					    return {};
+				    }
+			    });
 		    }
 	    });
 
-	pack::PackFile pack;
-
-	auto packResult = pack.ReadFile(*fileSystem.GetData(fileSystem.GetPath<Path::Data>() / "AllMeshes.g3d"));
-	if (packResult != pack::PackResult::Success)
-	{
-		SPDLOG_LOGGER_CRITICAL(spdlog::get("game"), "Unable to load AllMeshes.g3d: {}", pack::ResultToStr(packResult));
-		return false;
-	}
-
-	const auto& meshes = pack.GetMeshes();
-	// TODO (#749) use std::views::enumerate
-	for (size_t i = 0; const auto& mesh : meshes)
-	{
-		const auto meshId = static_cast<MeshId>(i);
-		meshManager.Load(meshId, resources::L3DLoader::FromBufferTag {}, k_MeshNames.at(i), mesh);
-		++i;
-	}
-
-	const auto& textures = pack.GetTextures();
-	for (auto const& [name, g3dTexture] : textures)
-	{
-		textureManager.Load(g3dTexture.header.id, resources::Texture2DLoader::FromPackTag {}, name, g3dTexture);
-	}
-
-	pack::PackFile animationPack;
-	packResult = animationPack.ReadFile(*fileSystem.GetData(fileSystem.GetPath<Path::Data>() / "AllAnims.anm"));
-	if (packResult != pack::PackResult::Success)
-	{
-		SPDLOG_LOGGER_CRITICAL(spdlog::get("game"), "Unable to load AllAnims.anm: {}", pack::ResultToStr(packResult));
-		return false;
-	}
+	auto meshPack = std::make_shared<pack::PackFile>();
+	const auto meshPackTask = loadGraph.Add("AllMeshes.g3d", [&loadFailed, &meshManager, meshPack]() -> Commit {
+		const auto result = OpenPack(*meshPack, Locator::filesystem::value().GetPath<Path::Data>() / "AllMeshes.g3d");
+		return [&loadFailed, &meshManager, meshPack, result]() {
+			if (result != pack::PackResult::Success)
+			{
+				SPDLOG_LOGGER_CRITICAL(spdlog::get("game"), "Unable to load AllMeshes.g3d: {}", pack::ResultToStr(result));
+				loadFailed = true;
+				return;
+			}
 
-	const auto& animations = animationPack.GetAnimations();
-	// TODO (#749) use std::views::enumerate
-	for (size_t i = 0; i < animations.size(); i++)
-	{
-		animationManager.Load(i, resources::L3DAnimLoader::FromBufferTag {}, animations[i]);
-	}
+			// Meshes are decoded and uploaded the first time they are used, the pack is kept alive until then
+			const auto sharedMeshPack = std::shared_ptr<const pack::PackFile>(meshPack);
+			for (size_t i = 0; i < meshPack->GetMeshes().size(); ++i)
+			{
+				const auto meshId = static_cast<MeshId>(i);
+				meshManager.LoadLazy(meshId, resources::L3DLoader::FromPackTag {}, k_MeshNames.at(i), sharedMeshPack, i);
+			}
+		};
+	});
 
-	fileSystem.Iterate(fileSystem.GetPath<Path::CreatureMesh>(), false, [&meshManager](const std::filesystem::path& f) {
-		const auto& fileName = f.stem().string();
-		SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading creature mesh: {}", fileName);
-		try
+	// The texels are described on a worker and stay in the pack, only the registration is left for the commit
+	loadGraph.Add(
+	    "AllMeshes.g3d textures",
+	    [&textureManager, meshPack]() -> Commit {
+		    const auto sharedMeshPack = std::shared_ptr<const pack::PackFile>(meshPack);
+		    std::vector<std::tuple<uint32_t, std::string, graphics::TextureResidency::Source>> sources;
+		    for (auto const& [name, g3dTexture] : meshPack->GetTextures())
+		    {
+			    sources.emplace_back(g3dTexture.header.id, name,
+			                         resources::Texture2DLoader::MakeSource(sharedMeshPack, g3dTexture));
+		    }
+		    return [&textureManager, sources = std::move(sources)]() mutable {
+			    for (auto& [id, name, source] : sources)
+			    {
+				    textureManager.Load(id, resources::Texture2DLoader::FromSourceTag {}, name, std::move(source));
+			    }
+		    };
+	    },
+	    {meshPackTask});
+
+	loadGraph.Add("AllAnims.anm", [&loadFailed, &animationManager]() -> Commit {
+		pack::PackFile animationPack;
+		const auto result = OpenPack(animationPack, Locator::filesystem::value().GetPath<Path::Data>() / "AllAnims.anm");
+		std::vector<resources::L3DAnimLoader::result_type> animations;
+		if (result == pack::PackResult::Success)
 		{
-			if (string_utils::BeginsWith(fileName, "Hand"))
+			// Animations are identified by their index in the pack, a broken one leaves a gap rather than shifting the rest
+			animations.resize(animationPack.GetAnimationCount());
+			std::vector<uint8_t> animation;
+			for (uint32_t i = 0; i < animationPack.GetAnimationCount(); i++)
 			{
+				const auto animationResult = animationPack.LoadAnimation(i, animation);
+				if (animationResult != pack::PackResult::Success)
+				{
+					SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Unable to load animation {} of AllAnims.anm: {}", i,
+					                    pack::ResultToStr(animationResult));
+					continue;
+				}
+				animations[i] = resources::L3DAnimLoader {}(resources::L3DAnimLoader::FromBufferTag {}, animation);
+			}
+		}
+		return [&loadFailed, &animationManager, result, animations = std::move(animations)]() {
+			if (result != pack::PackResult::Success)
+			{
+				SPDLOG_LOGGER_CRITICAL(spdlog::get("game"), "Unable to load AllAnims.anm: {}", pack::ResultToStr(result));
+				loadFailed = true;
 				return;
 			}
 
-			const auto meshId = creature::GetIdFromMeshName(fileName);
-			meshManager.Load(meshId, resources::L3DLoader::FromDiskTag {}, f);
-		}
-		catch (std::runtime_error& err)
-		{
-			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-		}
+			for (size_t i = 0; i < animations.size(); i++)
+			{
+				if (animations[i] != nullptr)
+				{
+					animationManager.Insert(i, animations[i]);
+				}
+			}
+		};
+	});
+
+	loadGraph.Add("Creature meshes", [&meshManager]() -> Commit {
+		std::vector<std::pair<entt::id_type, std::filesystem::path>> meshes;
+		Locator::filesystem::value().Iterate(
+		    Locator::filesystem::value().GetPath<Path::CreatureMesh>(), false, [&meshes](const std::filesystem::path& f) {
+			    const auto& fileName = f.stem().string();
+			    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Registering creature mesh: {}", fileName);
+			    try
+			    {
+				    if (string_utils::BeginsWith(fileName, "Hand"))
+				    {
+					    return;
+				    }
+
+				    meshes.emplace_back(creature::GetIdFromMeshName(fileName), f);
+			    }
+			    catch (std::runtime_error& err)
+			    {
+				    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+			    }
+		    });
+		return [&meshManager, meshes = std::move(meshes)]() {
+			for (const auto& [meshId, path] : meshes)
+			{
+				meshManager.LoadLazy(meshId, resources::L3DLoader::FromDiskTag {}, path);
+			}
+		};
 	});
 
 	// Load loose one-off assets
 	{
-		using AFromDiskTag = resources::L3DAnimLoader::FromDiskTag;
-		animationManager.Load("coffre", AFromDiskTag {}, fileSystem.GetPath<Path::Misc>() / "coffre.anm");
-
-		using LFromDiskTag = resources::L3DLoader::FromDiskTag;
-		meshManager.Load("hand", LFromDiskTag {}, fileSystem.GetPath<Path::CreatureMesh>() / "Hand_Boned_Base2.l3d");
-		meshManager.Load("coffre", LFromDiskTag {}, fileSystem.GetPath<Path::Misc>() / "coffre.l3d");
-		meshManager.Load("cone", LFromDiskTag {}, fileSystem.GetPath<Path::Data>() / "cone.l3d");
-		meshManager.Load("marker", LFromDiskTag {}, fileSystem.GetPath<Path::Data>() / "marker.l3d");
-		meshManager.Load("river", LFromDiskTag {}, fileSystem.GetPath<Path::Data>() / "river.l3d");
-		meshManager.Load("river2", LFromDiskTag {}, fileSystem.GetPath<Path::Data>() / "river2.l3d");
-		meshManager.Load("metre_sphere", LFromDiskTag {}, fileSystem.GetPath<Path::Data>() / "metre_sphere.l3d");
+		loadGraph.Add("coffre.anm", [&animationManager, path = fileSystem.GetPath<Path::Misc>() / "coffre.anm"]() -> Commit {
+			auto animation = resources::L3DAnimLoader {}(resources::L3DAnimLoader::FromDiskTag {}, path);
+			return [&animationManager, animation = std::move(animation)]() { animationManager.Insert("coffre", animation); };
+		});
+
+		addMeshTask("hand", fileSystem.GetPath<Path::CreatureMesh>() / "Hand_Boned_Base2.l3d");
+		addMeshTask("coffre", fileSystem.GetPath<Path::Misc>() / "coffre.l3d");
+		addMeshTask("cone", fileSystem.GetPath<Path::Data>() / "cone.l3d");
+		addMeshTask("marker", fileSystem.GetPath<Path::Data>() / "marker.l3d");
+		addMeshTask("river", fileSystem.GetPath<Path::Data>() / "river.l3d");
+		addMeshTask("river2", fileSystem.GetPath<Path::Data>() / "river2.l3d");
+		addMeshTask("metre_sphere", fileSystem.GetPath<Path::Data>() / "metre_sphere.l3d");
 	}
 
+	const auto addLevelTask = [&loadGraph, &levelManager](std::string name, std::filesystem::path path,
+	                                                      Level::LandType landType) {
+		loadGraph.Add(name, [&levelManager, name, path, landType]() -> Commit {
+			try
+			{
+				if (!Level::IsLevelFile(path))
+				{
+					return {};
+				}
+				auto level = resources::LevelLoader {}(resources::LevelLoader::FromDiskTag {}, path, landType);
+				return [&levelManager, name, level = std::move(level)]() { levelManager.Insert(name, level); };
+			}
+			catch (std::runtime_error& err)
+			{
+				SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+				return {};
+			}
+		});
+	};
+
 	// TODO(raffclar): #400: Parse level files within the resource loader
 	// TODO(raffclar): #405: Determine campaign levels from the challenge script file
 	// Load the campaign levels
-	fileSystem.Iterate(fileSystem.GetPath<Path::Scripts>(), false, [&levelManager](const std::filesystem::path& f) {
+	fileSystem.Iterate(fileSystem.GetPath<Path::Scripts>(), false, [&addLevelTask](const std::filesystem::path& f) {
 		const auto& name = f.stem().string();
 		if (f.extension() != ".txt" || name.rfind("InfoScript", 0) != std::string::npos)
 		{
 			return;
 		}
 		SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading campaign level: {}", f.stem().string());
-		try
-		{
-			if (Level::IsLevelFile(f))
-			{
-				levelManager.Load(fmt::format("campaign/{}", name), resources::LevelLoader::FromDiskTag {}, f,
-				                  Level::LandType::Campaign);
-			}
-		}
-		catch (std::runtime_error& err)
-		{
-			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-		}
+		addLevelTask(fmt::format("campaign/{}", name), f, Level::LandType::Campaign);
 	});
 	// Load Playgrounds
 	// Attempt to load additional levels as playgrounds
-	fileSystem.Iterate(fileSystem.GetPath<Path::Playgrounds>(), false, [&levelManager](const std::filesystem::path& f) {
-		if (f.extension() != ".txt")
-		{
-			return;
-		}
-		const auto& name = f.stem().string();
-		if (levelManager.Contains(fmt::format("playgrounds/{}", name)))
-		{
-			// Already added
-			return;
-		}
-
-		SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading custom level: {}", f.stem().string());
-		try
-		{
-			if (Level::IsLevelFile(f))
-			{
-				levelManager.Load(fmt::format("playgrounds/{}", name), resources::LevelLoader::FromDiskTag {}, f,
-				                  Level::LandType::Skirmish);
-			}
-		}
-		catch (std::runtime_error& err)
-		{
-			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
-		}
-	});
-
-	// Load all sound packs in the Audio directory
-	auto& audioManager = Locator::audio::value();
 	fileSystem.Iterate(
-	    fileSystem.GetPath<Path::Audio>(), true, [&audioManager, &soundManager, &fileSystem](const std::filesystem::path& f) {
-		    if (f.extension() != ".sad")
+	    fileSystem.GetPath<Path::Playgrounds>(), false, [&addLevelTask, &levelManager](const std::filesystem::path& f) {
+		    if (f.extension() != ".txt")
 		    {
 			    return;
 		    }
-
-		    pack::PackFile soundPack;
-		    SPDLOG_LOGGER_DEBUG(spdlog::get("audio"), "Opening sound pack {}", f.filename().string());
-		    const auto result = soundPack.ReadFile(*fileSystem.GetData(f));
-		    if (result != pack::PackResult::Success)
+		    const auto& name = f.stem().string();
+		    if (levelManager.Contains(fmt::format("playgrounds/{}", name)))
 		    {
-			    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Unable to load sound pack {}: {}", f.filename().string(),
-			                        pack::ResultToStr(result));
+			    // Already added
 			    return;
 		    }
-		    const auto& audioHeaders = soundPack.GetAudioSampleHeaders();
-		    const auto& audioData = soundPack.GetAudioSamplesData();
-		    auto soundName = std::filesystem::path(audioHeaders[0].name.data());
 
-		    if (audioHeaders.empty())
+		    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading custom level: {}", f.stem().string());
+		    addLevelTask(fmt::format("playgrounds/{}", name), f, Level::LandType::Skirmish);
+	    });
+
+	// Load all sound packs in the Audio directory
+	auto& audioManager = Locator::audio::value();
+	fileSystem.Iterate(
+	    fileSystem.GetPath<Path::Audio>(), true, [&loadGraph, &audioManager, &soundManager](const std::filesystem::path& f) {
+		    if (f.extension() != ".sad")
 		    {
-			    SPDLOG_LOGGER_WARN(spdlog::get("audio"), "Empty sound pack found for {}. Skipping", f.filename().string());
 			    return;
 		    }
 
-		    auto groupName = f.filename().string();
+		    loadGraph.Add(f.filename().string(), [&audioManager, &soundManager, f]() -> Commit {
+			    // Shared by the sounds, which view their samples in the pack rather than copying them out
+			    auto soundPack = std::make_shared<pack::PackFile>();
+			    SPDLOG_LOGGER_DEBUG(spdlog::get("audio"), "Opening sound pack {}", f.filename().string());
+			    const auto result = OpenPack(*soundPack, f);
+			    if (result != pack::PackResult::Success)
+			    {
+				    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Unable to load sound pack {}: {}", f.filename().string(),
+				                        pack::ResultToStr(result));
+				    return {};
+			    }
+			    const auto& audioHeaders = soundPack->GetAudioSampleHeaders();
+			    const auto& audioData = soundPack->GetAudioSamplesData();
 
-		    // A hacky way of detecting if the sound is music as all music sounds end with "mpg"
-		    if (soundName.extension() == ".mpg")
-		    {
-			    auto buffers = std::queue<std::vector<uint8_t>>();
-			    auto packName = f.string();
-			    audioManager.AddMusicEntry(packName);
-		    }
-		    else
-		    {
-			    audioManager.CreateSoundGroup(groupName);
+			    if (audioHeaders.empty())
+			    {
+				    SPDLOG_LOGGER_WARN(spdlog::get("audio"), "Empty sound pack found for {}. Skipping", f.filename().string());
+				    return {};
+			    }
+
+			    auto groupName = f.filename().string();
+
+			    // A hacky way of detecting if the sound is music as all music sounds end with "mpg"
+			    if (std::filesystem::path(audioHeaders[0].name.data()).extension() == ".mpg")
+			    {
+				    return [&audioManager, packName = f.string()]() { audioManager.AddMusicEntry(packName); };
+			    }
+
+			    std::vector<std::pair<entt::id_type, resources::SoundLoader::result_type>> sounds;
 			    for (size_t i = 0; i < audioHeaders.size(); i++)
 			    {
-				    soundName = std::filesystem::path(audioHeaders[i].name.data());
+				    const auto soundName = std::filesystem::path(audioHeaders[i].name.data());
 				    if (audioData[i].empty())
 				    {
 					    SPDLOG_LOGGER_WARN(spdlog::get("audio"), "Empty sound buffer found for {}. Skipping",
 					                       soundName.string());
-					    return;
+					    break;
 				    }
 
 				    const auto stringId = fmt::format("{}/{}", groupName, audioHeaders[i].id);
 				    const entt::id_type id = entt::hashed_string(stringId.c_str());
-				    const std::vector<std::vector<uint8_t>> buffer = {audioData[i]};
 				    SPDLOG_LOGGER_DEBUG(spdlog::get("audio"), "Loading sound {}: {}", stringId, audioHeaders[i].name.data());
-				    soundManager.Load(id, resources::SoundLoader::FromBufferTag {}, audioHeaders[i], buffer);
-				    audioManager.AddToSoundGroup(groupName, id);
+				    sounds.emplace_back(id, resources::SoundLoader {}(resources::SoundLoader::FromBufferTag {}, audioHeaders[i],
+				                                                      audioData[i], soundPack));
 			    }
-		    }
+			    return [&audioManager, &soundManager, groupName, sounds = std::move(sounds)]() {
+				    audioManager.CreateSoundGroup(groupName);
+				    for (const auto& [id, sound] : sounds)
+				    {
+					    soundManager.Insert(id, sound);
+					    audioManager.AddToSoundGroup(groupName, id);
+				    }
+			    };
+		    });
 	    });
 
-	{
+	std::unique_ptr<const InfoConstants> infoConstants;
+	loadGraph.Add("info.dat", [&loadFailed, &infoConstants]() -> Commit {
 		InfoFile infoFile;
-		auto result = infoFile.LoadFromFile(Locator::filesystem::value().GetPath<filesystem::Path::Scripts>() / "info.dat");
-		if (!result)
-		{
-			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to load game info data.");
-			return false;
-		}
-		Locator::infoConstants::reset(result.release());
-	}
-
-	fileSystem.Iterate(fileSystem.GetPath<Path::Textures>(), false, [&textureManager](const std::filesystem::path& f) {
-		if (string_utils::LowerCase(f.extension().string()) == ".raw")
-		{
-			SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading raw texture: {}", f.stem().string());
-			try
-			{
-				textureManager.Load(fmt::format("raw/{}", f.stem().string()), resources::Texture2DLoader::FromDiskTag {}, f);
-			}
-			catch (std::runtime_error& err)
+		infoConstants = infoFile.LoadFromFile(Locator::filesystem::value().GetPath<filesystem::Path::Scripts>() / "info.dat");
+		return [&loadFailed, &infoConstants]() {
+			if (!infoConstants)
 			{
-				SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+				SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to load game info data.");
+				loadFailed = true;
+				return;
 			}
-		}
+			Locator::infoConstants::reset(infoConstants.release());
+		};
 	});
 
+	fileSystem.Iterate(
+	    fileSystem.GetPath<Path::Textures>(), false, [&loadGraph, &textureManager](const std::filesystem::path& f) {
+		    if (string_utils::LowerCase(f.extension().string()) == ".raw")
+		    {
+			    SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading raw texture: {}", f.stem().string());
+			    auto name = fmt::format("raw/{}", f.stem().string());
+			    loadGraph.Add(name, [&textureManager, name, f]() -> Commit {
+				    try
+				    {
+					    auto source = resources::Texture2DLoader::ReadRawSource(f);
+					    return [&textureManager, name, textureName = ("raw" / f.stem()).string(),
+					            source = std::move(source)]() mutable {
+						    textureManager.Load(name, resources::Texture2DLoader::FromSourceTag {}, textureName,
+						                        std::move(source));
+					    };
+				    }
+				    catch (std::runtime_error& err)
+				    {
+					    SPDLOG_LOGGER_ERROR(spdlog::get("game"), "{}", err.what());
+					    return {};
+				    }
+			    });
+		    }
+	    });
+
+	loadGraph.Run(resources::LoadGraph::GetDefaultWorkerCount());
+	loadGraph.LogTimings();
+	if (resources.GetBakedAssets().IsEnabled())
+	{
+		SPDLOG_LOGGER_INFO(spdlog::get("game"), "Baked asset cache: {} hits, {} misses", resources.GetBakedAssets().GetHits(),
+		                   resources.GetBakedAssets().GetMisses());
+	}
+	if (loadFailed)
+	{
+		return false;
+	}
+
 	return true;
 }
 
@@ -904,6 +1039,18 @@ bool Game::Run() noexcept
 		_frameCount++;
 	}
 
+	// Runs of a fixed number of frames are how the state changes saved by the render queue are measured on a map
+	if (config.numFramesToSimulate != 0)
+	{
+		const auto& queueStats = Locator::rendererInterface::value().GetRenderQueueStats();
+		SPDLOG_LOGGER_INFO(spdlog::get("graphics"),
+		                   "Render queue on the last frame: {} submits, {} texture binds (skipped {}), "
+		                   "{} uniforms (skipped {}), {} states (skipped {})",
+		                   queueStats.submits, queueStats.textureBinds, queueStats.textureBindsSkipped,
+		                   queueStats.uniformUpdates, queueStats.uniformUpdatesSkipped, queueStats.stateChanges,
+		                   queueStats.stateChangesSkipped);
+	}
+
 	return true;
 }
 
@@ -920,6 +1067,16 @@ bool Game::LoadMap(const std::filesystem::path& path) noexcept
 	const auto data = fileSystem.ReadAll(path);
 	const auto source = std::string(reinterpret_cast<const char*>(data.data()), data.size());
 
+	// Each released map comes with an optional .fot file which contains the footpath information for the map
+	const auto stem = string_utils::LowerCase(path.stem().generic_string());
+	const auto fotPath = fileSystem.GetPath<filesystem::Path::Landscape>() / fmt::format("{}.fot", stem);
+	// It is read while the script loads the landscape
+	std::optional<filesystem::ReadQueue::Request> fotRequest;
+	if (fileSystem.Exists(fotPath))
+	{
+		fotRequest = Locator::readQueue::value().Read(fotPath, filesystem::ReadQueue::Priority::Urgent);
+	}
+
 	// Reset everything. Deletes all entities and their components
 	Locator::entitiesRegistry::value().Reset();
 	// TODO(#661): split entities that are permanent from map entities and move hand and camera to init
@@ -932,17 +1089,16 @@ bool Game::LoadMap(const std::filesystem::path& path) noexcept
 	Locator::camera::value().SetProjectionMatrixPerspective(config.cameraXFov, aspect, config.cameraNearClip,
 	                                                        config.cameraFarClip);
 
+	// The in game sounds are decoded while the script loads the map so that they don't hitch the first time they play
+	Locator::audio::value().PrefetchSoundGroup("InGame.sad");
+
 	Script script;
 	script.Load(source);
 
-	// Each released map comes with an optional .fot file which contains the footpath information for the map
-	const auto stem = string_utils::LowerCase(path.stem().generic_string());
-	const auto fotPath = fileSystem.GetPath<filesystem::Path::Landscape>() / fmt::format("{}.fot", stem);
-
-	if (fileSystem.Exists(fotPath))
+	if (fotRequest.has_value())
 	{
 		FotFile fotFile(*this);
-		fotFile.Load(fotPath);
+		fotFile.Load(fotRequest->data.get());
 	}
 	else
 	{
@@ -14,6 +14,7 @@
 #include <memory>
 #include <optional>
 #include <string>
+#include <vector>
 
 #include <bgfx/bgfx.h>
 #include <glm/mat4x4.hpp>
@@ -64,6 +65,9 @@ struct Arguments
 	std::array<spdlog::level::level_enum, k_LoggingSubsystemStrs.size()> logLevels;
 	std::string startLevel;
 	std::optional<std::pair</* frame number */ uint32_t, /* output */ std::filesystem::path>> requestScreenshot;
+	std::optional</* MiB */ uint32_t> textureBudget;
+	std::filesystem::path bakedCachePath;
+	std::vector<std::filesystem::path> mountedArchives;
 };
 
 class Game
@@ -0,0 +1,238 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+#include "IndexBuffer.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "Texture2D.h"
+#include "VertexBuffer.h"
+
+using namespace openblack::graphics;
+
+namespace
+{
+// Key layout, most significant bits first:
+//   opaque:      view (8) | 0 (1) | program (11) | blend (2) | texture (12) | mesh (12) | depth (18)
+//   translucent: view (8) | 1 (1) | inverted depth (24) | program (11) | blend (2) | texture (12) | unused (6)
+constexpr uint64_t k_ViewShift = 56;
+constexpr uint64_t k_TranslucentShift = 55;
+constexpr uint64_t k_ProgramBits = 11;
+constexpr uint64_t k_BlendBits = 2;
+constexpr uint64_t k_TextureBits = 12;
+constexpr uint64_t k_MeshBits = 12;
+constexpr uint64_t k_OpaqueDepthBits = 18;
+constexpr uint64_t k_TranslucentDepthBits = 24;
+// Depth is quantized in steps of a quarter unit which covers a full island with the translucent range
+constexpr float k_DepthScale = 4.0f;
+
+constexpr uint64_t Mask(uint64_t bits)
+{
+	return (uint64_t {1} << bits) - 1;
+}
+
+uint64_t QuantizeDepth(float depth, uint64_t bits)
+{
+	const auto maximum = static_cast<float>(Mask(bits));
+	return static_cast<uint64_t>(std::clamp(depth * k_DepthScale, 0.0f, maximum));
+}
+} // namespace
+
+uint64_t RenderQueue::MakeSortKey(graphics::RenderPass viewId, bool translucent, const ShaderProgram& program, uint8_t blend,
+                                  const Texture2D* texture, uint16_t mesh, float depth) noexcept
+{
+	const uint64_t programIdx = program.GetRawHandle().idx & Mask(k_ProgramBits);
+	const uint64_t blendIdx = blend & Mask(k_BlendBits);
+	const uint64_t textureIdx = (texture != nullptr ? texture->GetNativeHandle().idx : 0) & Mask(k_TextureBits);
+
+	uint64_t key = static_cast<uint64_t>(viewId) << k_ViewShift;
+	if (translucent)
+	{
+		// Back-to-front: farther draws get lower keys
+		const uint64_t invertedDepth = Mask(k_TranslucentDepthBits) - QuantizeDepth(depth, k_TranslucentDepthBits);
+		key |= uint64_t {1} << k_TranslucentShift;
+		key |= invertedDepth << (k_ProgramBits + k_BlendBits + k_TextureBits + 6);
+		key |= programIdx << (k_BlendBits + k_TextureBits + 6);
+		key |= blendIdx << (k_TextureBits + 6);
+		key |= textureIdx << 6;
+	}
+	else
+	{
+		key |= programIdx << (k_BlendBits + k_TextureBits + k_MeshBits + k_OpaqueDepthBits);
+		key |= blendIdx << (k_TextureBits + k_MeshBits + k_OpaqueDepthBits);
+		key |= textureIdx << (k_MeshBits + k_OpaqueDepthBits);
+		key |= (mesh & Mask(k_MeshBits)) << k_OpaqueDepthBits;
+		key |= QuantizeDepth(depth, k_OpaqueDepthBits);
+	}
+	return key;
+}
+
+void RenderQueue::Push(const Item& item)
+{
+	_items.push_back(item);
+}
+
+void RenderQueue::Flush()
+{
+	// Stable so that primitives with equal keys keep the order they were authored in
+	std::stable_sort(_items.begin(), _items.end(),
+	                 [](const Item& lhs, const Item& rhs) { return lhs.sortKey < rhs.sortKey; });
+
+	// Uniform values are only assumed to persist while the same program is used in the same view.
+	// The views the queue fills are sequential, bgfx submits the draws in this order.
+	std::array<DrawUniform, k_MaxUniforms * 2> lastUniforms;
+	size_t lastUniformCount = 0;
+
+	uint8_t skip = Mesh::SkipState::SkipNone;
+	bool keepTransform = false;
+	bool keepBindings = false;
+	for (auto it = _items.cbegin(); it != _items.cend(); ++it)
+	{
+		const auto& item = *it;
+		const auto* prev = it != _items.cbegin() ? &*std::prev(it) : nullptr;
+		const auto* next = std::next(it) != _items.cend() ? &*std::next(it) : nullptr;
+
+		if (prev == nullptr || prev->viewId != item.viewId || prev->program != item.program)
+		{
+			lastUniformCount = 0;
+		}
+
+		if (!keepTransform && item.modelMatrices != nullptr && item.matrixCount > 0)
+		{
+			bgfx::setTransform(item.modelMatrices, item.matrixCount);
+		}
+
+		const uint32_t bindingCount = (item.texture != nullptr ? 1 : 0) + (item.heightMap != nullptr ? 1 : 0) +
+		                              (item.animationPalette != nullptr ? 1 : 0);
+		if (keepBindings)
+		{
+			_stats.textureBindsSkipped += bindingCount;
+		}
+		else
+		{
+			if (item.texture != nullptr)
+			{
+				item.program->SetTextureSampler("s_diffuse", 0, *item.texture);
+			}
+			if (item.heightMap != nullptr)
+			{
+				item.program->SetTextureSampler("s_heightmap", 1, *item.heightMap); // vs
+			}
+			if (item.animationPalette != nullptr)
+			{
+				item.program->SetTextureSampler("s_animationPalette", 2, *item.animationPalette); // vs
+			}
+			_stats.textureBinds += bindingCount;
+		}
+
+		for (uint8_t i = 0; i < item.uniformCount; ++i)
+		{
+			const auto& uniform = item.uniforms[i];
+			const auto lastEnd = lastUniforms.begin() + lastUniformCount;
+			const auto last = std::find_if(lastUniforms.begin(), lastEnd,
+			                               [&uniform](const DrawUniform& value) { return value.name == uniform.name; });
+			if (last != lastEnd && last->value == uniform.value)
+			{
+				++_stats.uniformUpdatesSkipped;
+				continue;
+			}
+
+			// Names are literals, which are null terminated
+			item.program->SetUniformValue(uniform.name.data(), &uniform.value);
+			++_stats.uniformUpdates;
+			if (last != lastEnd)
+			{
+				last->value = uniform.value;
+			}
+			else if (lastUniformCount < lastUniforms.size())
+			{
+				lastUniforms[lastUniformCount++] = uniform;
+			}
+		}
+
+		if (item.instanceBuffer != nullptr)
+		{
+			bgfx::setInstanceDataBuffer(*item.instanceBuffer, item.instanceStart, item.instanceCount);
+		}
+		if (item.mesh->IsIndexed())
+		{
+			item.mesh->GetIndexBuffer().Bind(item.indicesCount, item.indicesOffset);
+		}
+		if ((skip & Mesh::SkipState::SkipVertexBuffer) == 0)
+		{
+			item.mesh->GetVertexBuffer().Bind();
+		}
+		if ((skip & Mesh::SkipState::SkipRenderState) == 0)
+		{
+			bgfx::setState(item.state, item.rgba);
+			++_stats.stateChanges;
+		}
+		else
+		{
+			++_stats.stateChangesSkipped;
+		}
+
+		// Decide what the next draw can inherit from this one
+		uint8_t discard = BGFX_DISCARD_ALL;
+		skip = Mesh::SkipState::SkipNone;
+		keepTransform = false;
+		keepBindings = false;
+		if (next != nullptr && next->viewId == item.viewId && next->program == item.program)
+		{
+			discard = BGFX_DISCARD_INDEX_BUFFER | BGFX_DISCARD_INSTANCE_DATA;
+			if (next->modelMatrices == item.modelMatrices && next->matrixCount == item.matrixCount)
+			{
+				keepTransform = true;
+			}
+			else
+			{
+				discard |= BGFX_DISCARD_TRANSFORM;
+			}
+			if (next->texture == item.texture && next->heightMap == item.heightMap &&
+			    next->animationPalette == item.animationPalette)
+			{
+				keepBindings = true;
+			}
+			else
+			{
+				discard |= BGFX_DISCARD_BINDINGS;
+			}
+			if (next->mesh == item.mesh)
+			{
+				skip |= Mesh::SkipState::SkipVertexBuffer;
+			}
+			else
+			{
+				discard |= BGFX_DISCARD_VERTEX_STREAMS;
+			}
+			if (next->state == item.state && next->rgba == item.rgba)
+			{
+				skip |= Mesh::SkipState::SkipRenderState;
+			}
+			else
+			{
+				discard |= BGFX_DISCARD_STATE;
+			}
+		}
+
+		bgfx::submit(static_cast<bgfx::ViewId>(item.viewId), item.program->GetRawHandle(), 0, discard);
+		++_stats.submits;
+	}
+
+	_items.clear();
+}
+
+void RenderQueue::EndFrame() noexcept
+{
+	_lastFrameStats = _stats;
+	_stats = {};
+}
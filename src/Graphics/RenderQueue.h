@@ -0,0 +1,104 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <array>
+#include <string_view>
+#include <vector>
+
+#include <bgfx/bgfx.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+
+#include "RenderPass.h"
+
+namespace openblack::graphics
+{
+class Mesh;
+class ShaderProgram;
+class Texture2D;
+
+/// Counters of the state changes issued by a \ref RenderQueue.
+/// The skipped counters are the calls which would have been made by submitting each primitive independently.
+struct RenderQueueStats
+{
+	uint32_t submits;
+	uint32_t textureBinds;
+	uint32_t textureBindsSkipped;
+	uint32_t uniformUpdates;
+	uint32_t uniformUpdatesSkipped;
+	uint32_t stateChanges;
+	uint32_t stateChangesSkipped;
+};
+
+/// Value of a vec4 uniform of the program of a draw, set with the draw when the queue is flushed
+struct DrawUniform
+{
+	std::string_view name;
+	glm::vec4 value;
+};
+
+/// Collects mesh primitive draws, sorts them by a 64 bit key and submits them to bgfx while dropping state which is
+/// identical between consecutive draws.
+///
+/// Opaque draws are grouped by program, blend mode, texture and mesh and ordered front-to-back within a group.
+/// Translucent draws are submitted after all opaque draws of the same view, ordered back-to-front. The views must be in
+/// bgfx::ViewMode::Sequential, bgfx would sort the draws again otherwise.
+class RenderQueue
+{
+public:
+	/// Uniforms of a single draw, the island extent, sky alpha threshold and those given by the caller
+	static constexpr size_t k_MaxUniforms = 4;
+
+	struct Item
+	{
+		uint64_t sortKey;
+		graphics::RenderPass viewId;
+		const ShaderProgram* program;
+		uint64_t state;
+		uint32_t rgba;
+		const Mesh* mesh;
+		uint32_t indicesOffset;
+		uint32_t indicesCount;
+		const Texture2D* texture;
+		const glm::mat4* modelMatrices;
+		uint8_t matrixCount;
+		const bgfx::DynamicVertexBufferHandle* instanceBuffer;
+		uint32_t instanceStart;
+		uint32_t instanceCount;
+		const Texture2D* heightMap;        ///< Only set for meshes which morph with terrain
+		const Texture2D* animationPalette; ///< Only set for meshes skinned in the vertex shader
+		std::array<DrawUniform, k_MaxUniforms> uniforms;
+		uint8_t uniformCount;
+	};
+
+	/// Pack the draw properties into a key where lower values are submitted first.
+	/// @param mesh An ordinal identifying the mesh in the current batch, only the lower 12 bits are used.
+	/// @param depth Distance from the camera, negative or unknown values are treated as 0.
+	static uint64_t MakeSortKey(graphics::RenderPass viewId, bool translucent, const ShaderProgram& program, uint8_t blend,
+	                            const Texture2D* texture, uint16_t mesh, float depth) noexcept;
+
+	void Push(const Item& item);
+	/// Sort all pushed items and submit them to bgfx. The queue is empty afterwards.
+	void Flush();
+
+	/// Swap the counters of the current frame out and start counting for the next frame.
+	void EndFrame() noexcept;
+	[[nodiscard]] const RenderQueueStats& GetStats() const noexcept { return _lastFrameStats; }
+
+private:
+	std::vector<Item> _items;
+	RenderQueueStats _stats {};
+	RenderQueueStats _lastFrameStats {};
+};
+
+} // namespace openblack::graphics
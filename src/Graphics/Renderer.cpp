@@ -21,6 +21,7 @@
 #include <glm/gtx/transform.hpp>
 #include <spdlog/spdlog.h>
 
+#include "3D/AnimationPalette.h"
 #include "3D/L3DAnim.h"
 #include "3D/L3DMesh.h"
 #include "3D/L3DSubMesh.h"
@@ -38,7 +39,9 @@
 #include "Graphics/FrameBuffer.h"
 #include "Graphics/IndexBuffer.h"
 #include "Graphics/Primitive.h"
+#include "Graphics/RenderQueue.h"
 #include "Graphics/ShaderManager.h"
+#include "Graphics/TextureResidency.h"
 #include "Graphics/VertexBuffer.h"
 #include "Locator.h"
 #include "Profiler.h"
@@ -242,6 +245,7 @@ std::unique_ptr<RendererInterface> RendererInterface::Create(bgfx::RendererType:
 
 Renderer::Renderer(uint32_t bgfxReset, std::unique_ptr<BgfxCallback>&& bgfxCallback) noexcept
     : _shaderManager(std::make_unique<ShaderManager>())
+    , _renderQueue(std::make_unique<RenderQueue>())
     , _bgfxCallback(std::move(bgfxCallback))
     , _bgfxReset(bgfxReset)
 {
@@ -257,6 +261,12 @@ Renderer::Renderer(uint32_t bgfxReset, std::unique_ptr<BgfxCallback>&& bgfxCallb
 		bgfx::setViewName(i, name.data());
 		++i;
 	}
+
+	// The render queue orders the meshes itself, which bgfx would undo by sorting the draws on program
+	for (const auto viewId : {RenderPass::Reflection, RenderPass::Main, RenderPass::MeshViewer})
+	{
+		bgfx::setViewMode(static_cast<bgfx::ViewId>(viewId), bgfx::ViewMode::Sequential);
+	}
 }
 
 Renderer::~Renderer() noexcept
@@ -284,6 +294,11 @@ graphics::ShaderManager& Renderer::GetShaderManager() const noexcept
 	return *_shaderManager;
 }
 
+const graphics::RenderQueueStats& Renderer::GetRenderQueueStats() const noexcept
+{
+	return _renderQueue->GetStats();
+}
+
 void Renderer::UpdateDebugCrossUniforms(const glm::mat4& pose) noexcept
 {
 	_debugCrossPose = pose;
@@ -291,7 +306,8 @@ void Renderer::UpdateDebugCrossUniforms(const glm::mat4& pose) noexcept
 
 const Texture2D* GetTexture(uint32_t skinID, const std::unordered_map<SkinId, std::unique_ptr<graphics::Texture2D>>& meshSkins)
 {
-	const auto& textureManager = Locator::resources::value().GetTextures();
+	auto& resources = Locator::resources::value();
+	const auto& textureManager = resources.GetTextures();
 
 	const Texture2D* texture = nullptr;
 
@@ -303,7 +319,7 @@ const Texture2D* GetTexture(uint32_t skinID, const std::unordered_map<SkinId, st
 		}
 		else if (textureManager.Contains(skinID))
 		{
-			texture = &*textureManager.Handle(skinID);
+			texture = &resources.GetTextureResidency().Request(*textureManager.Handle(skinID));
 		}
 		else
 		{
@@ -314,8 +330,21 @@ const Texture2D* GetTexture(uint32_t skinID, const std::unordered_map<SkinId, st
 	return texture;
 }
 
-void Renderer::DrawSubMesh(const graphics::L3DMesh& mesh, const graphics::L3DSubMesh& subMesh, const L3DMeshSubmitDesc& desc,
-                           bool preserveState) const
+/// Distance from the camera to the nearest of a batch of instances, whose model matrices are stride bytes apart
+float NearestInstanceDistance(const glm::vec3& cameraOrigin, const glm::mat4* models, uint32_t count, size_t stride)
+{
+	float nearest = std::numeric_limits<float>::max();
+	const auto* bytes = reinterpret_cast<const uint8_t*>(models);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const auto& model = *reinterpret_cast<const glm::mat4*>(bytes + i * stride);
+		nearest = std::min(nearest, glm::distance(cameraOrigin, glm::vec3(model[3])));
+	}
+	return count != 0 ? nearest : 0.0f;
+}
+
+void Renderer::EnqueueSubMesh(const graphics::L3DMesh& mesh, const graphics::L3DSubMesh& subMesh,
+                              const L3DMeshSubmitDesc& desc, uint16_t meshOrdinal) const
 {
 	assert(&subMesh.GetMesh());
 	// We don't draw physics meshes, we haven't implemented statuses (building and graves) and modern GPUs can handle high lod
@@ -331,78 +360,56 @@ void Renderer::DrawSubMesh(const graphics::L3DMesh& mesh, const graphics::L3DSub
 	const auto& heightMap = island.GetHeightMap();
 
 	auto const& skins = mesh.GetSkins();
-	bool lastPreserveState = false;
-	const auto& primitives = subMesh.GetPrimitives();
-	for (auto it = primitives.begin(); it != primitives.end(); ++it)
+	for (const auto& prim : subMesh.GetPrimitives())
 	{
-		const auto& prim = *it;
-
-		const bool hasNext = std::next(it) != primitives.end();
-
-		const Texture2D* texture = GetTexture(prim.skinID, skins);
-		const Texture2D* nextTexture = !hasNext ? nullptr : GetTexture(std::next(it)->skinID, skins);
-
-		const bool primitivePreserveState = texture != nullptr && texture == nextTexture && (preserveState || hasNext);
-
-		uint32_t skip = Mesh::SkipState::SkipNone;
-		if (!lastPreserveState)
+		const Texture2D* texture = desc.texture != nullptr ? desc.texture : GetTexture(prim.skinID, skins);
+		const bool translucent = prim.blend != L3DSubMesh::Primitive::BlendMode::Disabled;
+
+		RenderQueue::Item item = {};
+		item.sortKey = RenderQueue::MakeSortKey(desc.viewId, translucent, *desc.program, static_cast<uint8_t>(prim.blend),
+		                                        texture, meshOrdinal, desc.depth);
+		item.viewId = desc.viewId;
+		item.program = desc.program;
+		item.state = desc.state;
+		item.rgba = desc.rgba;
+		item.mesh = &subMesh.GetMesh();
+		item.indicesOffset = prim.indicesOffset;
+		item.indicesCount = prim.indicesCount;
+		item.texture = texture;
+		item.modelMatrices = desc.modelMatrices;
+		item.matrixCount = desc.matrixCount;
+		item.instanceBuffer = desc.instanceBuffer;
+		item.instanceStart = desc.instanceStart;
+		item.instanceCount = desc.instanceCount;
+		item.animationPalette = desc.animationPalette;
+		if (desc.morphWithTerrain)
 		{
-			if (desc.modelMatrices != nullptr && desc.matrixCount > 0)
-			{
-				bgfx::setTransform(desc.modelMatrices, desc.matrixCount);
-			}
-			if (texture != nullptr)
-			{
-				desc.program->SetTextureSampler("s_diffuse", 0, *texture);
-			}
-			if (desc.morphWithTerrain)
-			{
-				desc.program->SetTextureSampler("s_heightmap", 1, heightMap);   // vs
-				desc.program->SetUniformValue("u_islandExtent", &islandExtent); // vs
-			}
-			if (!desc.isSky)
-			{
-				const glm::vec4 u_skyAlphaThreshold = {
-				    Locator::skySystem::value().GetCurrentSkyType(),
-				    prim.thresholdAlpha ? prim.alphaCutoutThreshold : 0.0f,
-				    0.0f,
-				    0.0f,
-				};
-				desc.program->SetUniformValue("u_skyAlphaThreshold", &u_skyAlphaThreshold);
-			}
+			item.heightMap = &heightMap;
+			item.uniforms[item.uniformCount++] = {"u_islandExtent", islandExtent}; // vs
 		}
-		else
+		if (!desc.isSky)
 		{
-			skip |= Mesh::SkipState::SkipRenderState;
-			skip |= Mesh::SkipState::SkipVertexBuffer;
+			item.uniforms[item.uniformCount++] = {
+			    "u_skyAlphaThreshold",
+			    {
+			        Locator::skySystem::value().GetCurrentSkyType(),
+			        prim.thresholdAlpha ? prim.alphaCutoutThreshold : 0.0f,
+			        0.0f,
+			        0.0f,
+			    },
+			};
 		}
-
+		assert(item.uniformCount + desc.uniformCount <= item.uniforms.size());
+		for (uint8_t i = 0; i < desc.uniformCount; ++i)
 		{
-			if (desc.instanceBuffer != nullptr && (skip & Mesh::SkipState::SkipInstanceBuffer) == 0)
-			{
-				bgfx::setInstanceDataBuffer(*desc.instanceBuffer, desc.instanceStart, desc.instanceCount);
-			}
-			if (subMesh.GetMesh().IsIndexed() && (skip & Mesh::SkipState::SkipIndexBuffer) == 0)
-			{
-				subMesh.GetMesh().GetIndexBuffer().Bind(prim.indicesCount, prim.indicesOffset);
-			}
-			if ((skip & Mesh::SkipState::SkipVertexBuffer) == 0)
-			{
-				subMesh.GetMesh().GetVertexBuffer().Bind();
-			}
-			if ((skip & Mesh::SkipState::SkipRenderState) == 0)
-			{
-				bgfx::setState(desc.state, desc.rgba);
-			}
-
-			bgfx::submit(static_cast<bgfx::ViewId>(desc.viewId), desc.program->GetRawHandle(), 0,
-			             primitivePreserveState ? BGFX_DISCARD_NONE : BGFX_DISCARD_ALL);
+			item.uniforms[item.uniformCount++] = desc.uniforms[i];
 		}
-		lastPreserveState = primitivePreserveState;
+		_renderQueue->Push(item);
 	}
 }
 
-void Renderer::DrawMesh(const graphics::L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex) const noexcept
+void Renderer::EnqueueMesh(const graphics::L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex,
+                           uint16_t meshOrdinal) const
 {
 	if (mesh.GetNumSubMeshes() == 0)
 	{
@@ -420,17 +427,27 @@ void Renderer::DrawMesh(const graphics::L3DMesh& mesh, const L3DMeshSubmitDesc&
 			                   mesh.GetNumSubMeshes());
 		}
 
-		DrawSubMesh(mesh, *subMeshes[subMeshIndex], desc, false);
+		EnqueueSubMesh(mesh, *subMeshes[subMeshIndex], desc, meshOrdinal);
 		return;
 	}
 
-	for (auto it = subMeshes.begin(); it != subMeshes.end(); ++it)
+	for (const auto& subMesh : subMeshes)
 	{
-		const L3DSubMesh& subMesh = **it;
-		DrawSubMesh(mesh, subMesh, desc, std::next(it) != subMeshes.end());
+		EnqueueSubMesh(mesh, *subMesh, desc, meshOrdinal);
 	}
 }
 
+void Renderer::DrawMesh(const graphics::L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex) const noexcept
+{
+	EnqueueMesh(mesh, desc, subMeshIndex, _meshOrdinal++);
+}
+
+void Renderer::FlushMeshes() const noexcept
+{
+	_renderQueue->Flush();
+	_meshOrdinal = 0;
+}
+
 void Renderer::DrawFootprintPass(const DrawSceneDesc& drawDesc) const
 {
 	const auto viewId = graphics::RenderPass::Footprint;
@@ -532,6 +549,7 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 	const auto* debugShaderInstanced = _shaderManager->GetShader("DebugLineInstanced");
 	const auto* objectShaderInstanced = _shaderManager->GetShader("ObjectInstanced");
 	const auto* objectShaderHeightMapInstanced = _shaderManager->GetShader("ObjectHeightMapInstanced");
+	const auto* objectShaderSkinnedInstanced = _shaderManager->GetShader("ObjectSkinnedInstanced");
 
 	const auto skyType = Locator::skySystem::value().GetCurrentSkyType();
 
@@ -540,11 +558,11 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 		                                                                          : Profiler::Stage::MainPassDrawSky);
 		if (desc.drawSky)
 		{
-			const auto modelMatrix = glm::mat4(1.0f);
-			const glm::vec4 u_typeAlignment = {skyType, Locator::config::value().skyAlignment + 1.0f, 0.0f, 0.0f};
-
-			skyShader->SetTextureSampler("s_diffuse", 0, Locator::skySystem::value().GetTexture());
-			skyShader->SetUniformValue("u_typeAlignment", &u_typeAlignment);
+			const static auto modelMatrix = glm::mat4(1.0f);
+			const DrawUniform u_typeAlignment = {
+			    "u_typeAlignment",
+			    {skyType, Locator::config::value().skyAlignment + 1.0f, 0.0f, 0.0f},
+			};
 
 			L3DMeshSubmitDesc submitDesc = {};
 			submitDesc.viewId = desc.viewId;
@@ -557,6 +575,9 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 			}
 			submitDesc.modelMatrices = &modelMatrix;
 			submitDesc.matrixCount = 1;
+			submitDesc.texture = &Locator::skySystem::value().GetTexture();
+			submitDesc.uniforms = &u_typeAlignment;
+			submitDesc.uniformCount = 1;
 			submitDesc.isSky = true;
 
 			DrawMesh(Locator::skySystem::value().GetMesh(), submitDesc, 0);
@@ -573,10 +594,12 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 			mesh.GetIndexBuffer().Bind(mesh.GetIndexBuffer().GetCount(), 0);
 			mesh.GetVertexBuffer().Bind();
 			bgfx::setState(k_BgfxDefaultStateInvertedZ);
-			auto diffuse = Locator::resources::value().GetTextures().Handle(ocean.GetDiffuseTexture());
-			auto alpha = Locator::resources::value().GetTextures().Handle(ocean.GetAlphaTexture());
-			waterShader->SetTextureSampler("s_diffuse", 0, *diffuse);
-			waterShader->SetTextureSampler("s_alpha", 1, *alpha);
+			auto& resources = Locator::resources::value();
+			auto& residency = resources.GetTextureResidency();
+			auto diffuse = resources.GetTextures().Handle(ocean.GetDiffuseTexture());
+			auto alpha = resources.GetTextures().Handle(ocean.GetAlphaTexture());
+			waterShader->SetTextureSampler("s_diffuse", 0, residency.Request(*diffuse));
+			waterShader->SetTextureSampler("s_alpha", 1, residency.Request(*alpha));
 			waterShader->SetTextureSampler("s_reflection", 2, ocean.GetReflectionFramebuffer().GetColorAttachment());
 			const glm::vec4 u_sky = {skyType, 0.0f, 0.0f, 0.0f};
 			waterShader->SetUniformValue("u_sky", &u_sky); // fs
@@ -592,12 +615,13 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 			auto& island = Locator::terrainSystem::value();
 			auto islandExtent = glm::vec4(island.GetExtent().minimum, island.GetExtent().maximum);
 
-			auto texture = Locator::resources::value().GetTextures().Handle(LandIslandInterface::k_SmallBumpTextureId);
+			auto& resources = Locator::resources::value();
+			auto texture = resources.GetTextures().Handle(LandIslandInterface::k_SmallBumpTextureId);
 			const glm::vec4 u_skyAndBump = {skyType, desc.bumpMapStrength, desc.smallBumpMapStrength, 0.0f};
 
 			terrainShader->SetTextureSampler("s0_materials", 0, island.GetAlbedoArray());
 			terrainShader->SetTextureSampler("s1_bump", 1, island.GetBump());
-			terrainShader->SetTextureSampler("s2_smallBump", 2, *texture);
+			terrainShader->SetTextureSampler("s2_smallBump", 2, resources.GetTextureResidency().Request(*texture));
 			terrainShader->SetTextureSampler("s3_footprints", 3, island.GetFootprintFramebuffer().GetColorAttachment());
 
 			terrainShader->SetUniformValue("u_skyAndBump", &u_skyAndBump);
@@ -649,8 +673,10 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 			                   | BGFX_STATE_MSAA               //
 			    ;
 			const auto& renderCtx = Locator::rendereringSystem::value().GetContext();
+			const auto cameraOrigin = desc.camera->GetOrigin();
 
-			// Instance meshes
+			// Instance meshes are collected in the render queue and submitted with the other meshes of the view, sorted by
+			// state and by the distance to their nearest instance
 			for (const auto& [meshId, placers] : renderCtx.instancedDrawDescs)
 			{
 				auto mesh = meshManager.Handle(meshId);
@@ -673,9 +699,40 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 				submitDesc.isSky = false;
 				submitDesc.morphWithTerrain = placers.morphWithTerrain;
 				submitDesc.program = submitDesc.morphWithTerrain ? objectShaderHeightMapInstanced : objectShaderInstanced;
+				submitDesc.depth = NearestInstanceDistance(cameraOrigin, renderCtx.instanceUniforms.data() + placers.offset,
+				                                           placers.count, sizeof(glm::mat4));
 
 				// TODO(bwrsandman): choose the correct LOD
-				DrawMesh(*mesh, submitDesc, std::numeric_limits<uint8_t>::max());
+				EnqueueMesh(*mesh, submitDesc, std::numeric_limits<uint8_t>::max(), _meshOrdinal++);
+			}
+
+			// Animated meshes sample their bones from the animation palette
+			const auto* animationPalette = renderCtx.animationPalette->GetTexture();
+			if (animationPalette != nullptr && !renderCtx.skinnedDrawDescs.empty())
+			{
+				const std::array<DrawUniform, 2> skinnedUniforms = {{
+				    {"u_animationPaletteSize", renderCtx.animationPalette->GetTextureSize()},     // vs
+				    {"u_animationTime", {static_cast<float>(desc.time), 0.0f, 0.0f, 0.0f}}, // vs
+				}};
+
+				submitDesc.program = objectShaderSkinnedInstanced;
+				submitDesc.instanceBuffer = &renderCtx.skinnedInstanceUniformBuffer;
+				submitDesc.modelMatrices = nullptr;
+				submitDesc.matrixCount = 0;
+				submitDesc.animationPalette = animationPalette;
+				submitDesc.uniforms = skinnedUniforms.data();
+				submitDesc.uniformCount = static_cast<uint8_t>(skinnedUniforms.size());
+				submitDesc.isSky = false;
+				submitDesc.morphWithTerrain = false;
+				for (const auto& [meshId, placers] : renderCtx.skinnedDrawDescs)
+				{
+					submitDesc.instanceStart = placers.offset;
+					submitDesc.instanceCount = placers.count;
+					submitDesc.depth =
+					    NearestInstanceDistance(cameraOrigin, &renderCtx.skinnedInstanceUniforms[placers.offset].model,
+					                            placers.count, sizeof(RenderContext::SkinnedInstanceUniform));
+					EnqueueMesh(*meshManager.Handle(meshId), submitDesc, std::numeric_limits<uint8_t>::max(), _meshOrdinal++);
+				}
 			}
 
 			// Debug
@@ -713,6 +770,43 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 			}
 		}
 
+		if (desc.drawTestModel)
+		{
+			L3DMeshSubmitDesc submitDesc = {};
+			submitDesc.viewId = desc.viewId;
+			submitDesc.program = _shaderManager->GetShader("Object");
+			// clang-format off
+			submitDesc.state = 0u
+				| BGFX_STATE_WRITE_MASK
+				| BGFX_STATE_DEPTH_TEST_GREATER
+				| BGFX_STATE_CULL_CCW
+				| BGFX_STATE_MSAA
+			;
+			// clang-format on
+			const auto& mesh = meshManager.Handle(entt::hashed_string("coffre"));
+			const auto& testAnimation = Locator::resources::value().GetAnimations().Handle(entt::hashed_string("coffre"));
+			const std::vector<uint32_t>& boneParents = mesh->GetBoneParents();
+			auto& bones = _testModelBones;
+			bones.resize(testAnimation->GetBoneCount());
+			testAnimation->SampleBoneMatrices(desc.time, bones, &_testModelCursor);
+			for (uint32_t i = 0; i < bones.size(); ++i)
+			{
+				if (boneParents[i] != std::numeric_limits<uint32_t>::max())
+				{
+					bones[i] = bones[boneParents[i]] * bones[i];
+				}
+			}
+			submitDesc.modelMatrices = bones.data();
+			submitDesc.matrixCount = static_cast<uint8_t>(bones.size());
+			submitDesc.depth = bones.empty() ? 0.0f : glm::distance(desc.camera->GetOrigin(), glm::vec3(bones[0][3]));
+			submitDesc.isSky = false;
+			DrawMesh(*mesh, submitDesc, 0);
+		}
+
+		// The views draw in the order of submission, the meshes go before the sprites which are blended over them without
+		// writing depth. All the meshes of the view are sorted together.
+		FlushMeshes();
+
 		{
 			auto subSection =
 			    profiler.BeginScoped(desc.viewId == RenderPass::Reflection ? Profiler::Stage::ReflectionDrawSprites
@@ -747,36 +841,6 @@ void Renderer::DrawPass(const DrawSceneDesc& desc) const
 				    });
 			}
 		}
-
-		if (desc.drawTestModel)
-		{
-			L3DMeshSubmitDesc submitDesc = {};
-			submitDesc.viewId = desc.viewId;
-			submitDesc.program = _shaderManager->GetShader("Object");
-			// clang-format off
-			submitDesc.state = 0u
-				| BGFX_STATE_WRITE_MASK
-				| BGFX_STATE_DEPTH_TEST_GREATER
-				| BGFX_STATE_CULL_CCW
-				| BGFX_STATE_MSAA
-			;
-			// clang-format on
-			const auto& mesh = meshManager.Handle(entt::hashed_string("coffre"));
-			const auto& testAnimation = Locator::resources::value().GetAnimations().Handle(entt::hashed_string("coffre"));
-			const std::vector<uint32_t>& boneParents = mesh->GetBoneParents();
-			auto bones = testAnimation->GetBoneMatrices(desc.time);
-			for (uint32_t i = 0; i < bones.size(); ++i)
-			{
-				if (boneParents[i] != std::numeric_limits<uint32_t>::max())
-				{
-					bones[i] = bones[boneParents[i]] * bones[i];
-				}
-			}
-			submitDesc.modelMatrices = bones.data();
-			submitDesc.matrixCount = static_cast<uint8_t>(bones.size());
-			submitDesc.isSky = false;
-			DrawMesh(*mesh, submitDesc, 0);
-		}
 	}
 
 	{
@@ -812,6 +876,8 @@ void Renderer::Frame() noexcept
 {
 	// Advance to next frame. Process submitted rendering primitives.
 	bgfx::frame();
+	_renderQueue->EndFrame();
+	Locator::resources::value().GetTextureResidency().EndFrame();
 }
 
 void Renderer::RequestScreenshot(const std::filesystem::path& filepath) noexcept
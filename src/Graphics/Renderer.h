@@ -23,6 +23,7 @@
 #include <glm/fwd.hpp>
 #include <glm/mat4x4.hpp>
 
+#include "3D/L3DAnim.h"
 #include "Graphics/RenderPass.h"
 #include "Graphics/RendererInterface.h"
 
@@ -44,6 +45,7 @@ namespace graphics
 {
 class L3DSubMesh;
 class Mesh;
+class RenderQueue;
 
 class Renderer final: public RendererInterface
 {
@@ -52,6 +54,7 @@ class Renderer final: public RendererInterface
 	~Renderer() noexcept final;
 
 	[[nodiscard]] ShaderManager& GetShaderManager() const noexcept final;
+	[[nodiscard]] const RenderQueueStats& GetRenderQueueStats() const noexcept final;
 
 	void UpdateDebugCrossUniforms(const glm::mat4& pose) noexcept final;
 
@@ -59,6 +62,7 @@ class Renderer final: public RendererInterface
 
 	void DrawScene(const DrawSceneDesc& drawDesc) const noexcept final;
 	void DrawMesh(const L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex) const noexcept final;
+	void FlushMeshes() const noexcept final;
 	void Frame() noexcept final;
 	void RequestScreenshot(const std::filesystem::path& filepath) noexcept final;
 	[[nodiscard]] bool GetDebug() const noexcept final { return _bgfxDebug; }
@@ -70,10 +74,15 @@ class Renderer final: public RendererInterface
 
 private:
 	void DrawFootprintPass(const DrawSceneDesc& drawDesc) const;
-	void DrawSubMesh(const L3DMesh& mesh, const L3DSubMesh& subMesh, const L3DMeshSubmitDesc& desc, bool preserveState) const;
+	void EnqueueSubMesh(const L3DMesh& mesh, const L3DSubMesh& subMesh, const L3DMeshSubmitDesc& desc,
+	                    uint16_t meshOrdinal) const;
+	void EnqueueMesh(const L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex, uint16_t meshOrdinal) const;
 	void DrawPass(const DrawSceneDesc& desc) const;
 
 	std::unique_ptr<ShaderManager> _shaderManager;
+	std::unique_ptr<RenderQueue> _renderQueue;
+	/// Ordinal of the next mesh queued before the queue is flushed
+	mutable uint16_t _meshOrdinal = 0;
 	std::unique_ptr<BgfxCallback> _bgfxCallback;
 	uint32_t _bgfxReset;
 	bool _bgfxDebug = false;
@@ -82,6 +91,10 @@ class Renderer final: public RendererInterface
 	std::unique_ptr<Mesh> _debugCross;
 	std::unique_ptr<Mesh> _plane;
 	glm::mat4 _debugCrossPose;
+
+	// Scratch space for sampling the test model's animation without allocating each frame
+	mutable std::vector<glm::mat4> _testModelBones;
+	mutable L3DAnim::SampleCursor _testModelCursor;
 };
 } // namespace graphics
 } // namespace openblack
@@ -34,6 +34,9 @@ class L3DMesh;
 class FrameBuffer;
 class ShaderManager;
 class ShaderProgram;
+class Texture2D;
+struct DrawUniform;
+struct RenderQueueStats;
 
 class RendererInterface
 {
@@ -71,6 +74,11 @@ class RendererInterface
 		const bgfx::DynamicVertexBufferHandle* instanceBuffer;
 		uint32_t instanceStart;
 		uint32_t instanceCount;
+		const graphics::Texture2D* animationPalette; ///< Bone matrices for meshes skinned in the vertex shader
+		const graphics::Texture2D* texture;          ///< Replaces the skins of the primitives when set
+		const graphics::DrawUniform* uniforms;       ///< Uniforms of the program, copied when the mesh is drawn
+		uint8_t uniformCount;
+		float depth; ///< Distance to the camera used to order draws, to the nearest instance for instanced draws
 		bool isSky;
 		bool drawAll; ///< For use in the mesh viewer
 		bool morphWithTerrain;
@@ -93,9 +101,15 @@ class RendererInterface
 	// TODO: Remove this function. All renderables should be specified through RenderingSystem with Components
 	virtual void UpdateDebugCrossUniforms(const glm::mat4& pose) noexcept = 0;
 	// TODO: Remove this function. All renderables should be drawn through RenderingSystem with Components
+	/// Queue the mesh, it is submitted with the other meshes of its view by \ref FlushMeshes.
+	/// The matrices of the description must live until then.
 	virtual void DrawMesh(const L3DMesh& mesh, const L3DMeshSubmitDesc& desc, uint8_t subMeshIndex) const noexcept = 0;
+	/// Sort the meshes queued by \ref DrawMesh and submit them, DrawScene does so once per view
+	virtual void FlushMeshes() const noexcept = 0;
 	// TODO: Should shader manager be available through Locator as a service?
 	[[nodiscard]] virtual graphics::ShaderManager& GetShaderManager() const noexcept = 0;
+	/// State changes issued and avoided by the mesh render queue during the last frame
+	[[nodiscard]] virtual const graphics::RenderQueueStats& GetRenderQueueStats() const noexcept = 0;
 };
 
 } // namespace openblack::graphics
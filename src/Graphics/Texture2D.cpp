@@ -88,10 +88,16 @@ Texture2D::Texture2D(std::string name)
 }
 
 Texture2D::~Texture2D()
+{
+	Destroy();
+}
+
+void Texture2D::Destroy() noexcept
 {
 	if (bgfx::isValid(_handle))
 	{
 		bgfx::destroy(_handle);
+		_handle = BGFX_INVALID_HANDLE;
 	}
 }
 
@@ -125,17 +131,16 @@ void Texture2D::Create(uint16_t width, uint16_t height, uint16_t layers, Format
 	}
 	_handle = bgfx::createTexture2D(width, height, false, layers, getBgfxTextureFormat(format), flags, memory);
 	bgfx::setName(_handle, _name.c_str());
-	bgfx::frame();
 
 	bgfx::calcTextureSize(_info, width, height, 1, false, false, layers, getBgfxTextureFormat(format));
-	bgfx::frame();
 }
 
 void Texture2D::Create(uint16_t width, uint16_t height, uint16_t layers, Format format, Wrapping wrapping, Filter filter,
                        const void* data, uint32_t size) noexcept
 {
-
 	Texture2D::Create(width, height, layers, format, wrapping, filter, bgfx::makeRef(data, size));
+	// The data is only referenced, flush so that the caller may release it
+	bgfx::frame();
 }
 
 void Texture2D::DumpTexture() const
@@ -96,6 +96,7 @@ enum class Wrapping : uint8_t
 bgfx::TextureFormat::Enum getBgfxTextureFormat(Format format);
 
 class FrameBuffer;
+class TextureResidency;
 
 class Texture2D
 {
@@ -107,8 +108,10 @@ class Texture2D
 	Texture2D(const Texture2D&) = delete;
 	Texture2D& operator=(const Texture2D&) = delete;
 
+	/// Create from memory owned by bgfx, such as from bgfx::alloc or bgfx::copy, without flushing the frame
 	void Create(uint16_t width, uint16_t height, uint16_t layers, Format format, Wrapping wrapping, Filter filter,
 	            const bgfx::Memory* memory) noexcept;
+	/// Create from memory which is referenced until the frame is flushed, which is done before returning
 	void Create(uint16_t width, uint16_t height, uint16_t layers, Format format = Format::RGBA8,
 	            Wrapping wrapping = Wrapping::ClampEdge, Filter filter = Filter::Linear, const void* data = nullptr,
 	            uint32_t size = 0) noexcept;
@@ -119,15 +122,20 @@ class Texture2D
 	[[nodiscard]] uint16_t GetHeight() const { return _info.height; }
 	[[nodiscard]] uint16_t GetLayerCount() const { return _info.numLayers; }
 	[[nodiscard]] bgfx::TextureFormat::Enum GetFormat() const { return _info.format; }
+	[[nodiscard]] uint32_t GetStorageSize() const { return _info.storageSize; }
+	[[nodiscard]] bool IsValid() const { return bgfx::isValid(_handle); }
 
 	void DumpTexture() const;
 
 protected:
+	void Destroy() noexcept;
+
 	std::string _name;
 	bgfx::TextureHandle _handle;
 	bgfx::TextureInfo _info;
 
 	friend FrameBuffer;
+	friend TextureResidency;
 };
 
 } // namespace openblack::graphics
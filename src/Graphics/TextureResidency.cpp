@@ -0,0 +1,214 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "TextureResidency.h"
+
+#include <cassert>
+
+#include <array>
+
+#include <spdlog/spdlog.h>
+
+using namespace openblack::graphics;
+
+TextureResidency::TextureResidency() noexcept = default;
+TextureResidency::~TextureResidency() noexcept = default;
+
+void TextureResidency::Register(std::shared_ptr<Texture2D> texture, Source source)
+{
+	assert(!texture->IsValid());
+
+	// Describe the texture up front so that its size is known without creating it
+	const auto format = getBgfxTextureFormat(source.format);
+	bgfx::calcTextureSize(texture->_info, source.width, source.height, 1, false, false, 1, format);
+	if (texture->_info.storageSize != source.data.size())
+	{
+		SPDLOG_LOGGER_WARN(spdlog::get("graphics"), "Texture {} has {} bytes of data for a size of {} bytes",
+		                   texture->GetName(), source.data.size(), texture->_info.storageSize);
+	}
+
+	const auto* key = texture.get();
+	auto [iter, inserted] = _entries.try_emplace(key);
+	if (!inserted)
+	{
+		SPDLOG_LOGGER_ERROR(spdlog::get("graphics"), "Texture {} is already registered", key->GetName());
+		return;
+	}
+	auto& entry = iter->second;
+	entry.texture = std::move(texture);
+	entry.source = std::move(source);
+	entry.lastUsedFrame = 0;
+	entry.pinned = false;
+	entry.lru = _lru.end();
+	_managedBytes += entry.texture->GetStorageSize();
+}
+
+const Texture2D& TextureResidency::Request(const Texture2D& texture)
+{
+	auto iter = _entries.find(&texture);
+	if (iter == _entries.end())
+	{
+		return texture;
+	}
+
+	auto& entry = iter->second;
+	entry.lastUsedFrame = _frame;
+	if (texture.IsValid())
+	{
+		if (!entry.pinned)
+		{
+			_lru.splice(_lru.end(), _lru, entry.lru);
+		}
+		return texture;
+	}
+
+	if (_stats.uploads > 0 && _uploadedBytes + texture.GetStorageSize() > k_UploadBytesPerFrame)
+	{
+		++_stats.placeholderRequests;
+		return GetPlaceholder();
+	}
+
+	MakeResident(entry);
+	return texture;
+}
+
+const Texture2D& TextureResidency::Peek(const Texture2D& texture)
+{
+	if (!_entries.contains(&texture) || texture.IsValid())
+	{
+		return texture;
+	}
+	return GetPlaceholder();
+}
+
+void TextureResidency::Pin(const Texture2D& texture)
+{
+	auto iter = _entries.find(&texture);
+	if (iter == _entries.end())
+	{
+		return;
+	}
+
+	auto& entry = iter->second;
+	entry.lastUsedFrame = _frame;
+	if (!entry.texture->IsValid())
+	{
+		MakeResident(entry);
+	}
+	if (!entry.pinned)
+	{
+		_lru.erase(entry.lru);
+		entry.lru = _lru.end();
+		entry.pinned = true;
+	}
+}
+
+bool TextureResidency::IsResident(const Texture2D& texture) const
+{
+	return _entries.contains(&texture) && texture.IsValid();
+}
+
+void TextureResidency::MakeResident(Entry& entry)
+{
+	auto& texture = *entry.texture;
+	const auto size = texture.GetStorageSize();
+	MakeRoom(size);
+	if (_residentBytes + size > _budget)
+	{
+		SPDLOG_LOGGER_WARN(spdlog::get("graphics"), "Texture {} exceeds the texture budget of {} bytes", texture.GetName(),
+		                   _budget);
+	}
+
+	// Copied so that clearing the entries cannot free memory which bgfx has yet to upload
+	const auto& source = entry.source;
+	texture.Create(source.width, source.height, 1, source.format, source.wrapping, source.filter,
+	               bgfx::copy(source.data.data(), static_cast<uint32_t>(source.data.size())));
+
+	_residentBytes += size;
+	_uploadedBytes += size;
+	++_stats.uploads;
+	++_stats.totalUploads;
+	entry.lru = _lru.insert(_lru.end(), &entry);
+}
+
+void TextureResidency::Evict(Entry& entry)
+{
+	if (!entry.texture->IsValid())
+	{
+		return;
+	}
+
+	entry.texture->Destroy();
+	_residentBytes -= entry.texture->GetStorageSize();
+	++_stats.evictions;
+	++_stats.totalEvictions;
+	if (entry.lru != _lru.end())
+	{
+		_lru.erase(entry.lru);
+		entry.lru = _lru.end();
+	}
+}
+
+void TextureResidency::MakeRoom(uint64_t size)
+{
+	while (!_lru.empty() && _residentBytes + size > _budget)
+	{
+		auto* oldest = _lru.front();
+		// Bindings of the current and previous frame may still be in flight
+		if (oldest->lastUsedFrame + 1 >= _frame)
+		{
+			break;
+		}
+		Evict(*oldest);
+	}
+}
+
+const Texture2D& TextureResidency::GetPlaceholder()
+{
+	if (_placeholder == nullptr)
+	{
+		// Mid grey so that a texture popping in does not flash
+		static constexpr std::array<uint8_t, 4> k_Pixel = {0x80, 0x80, 0x80, 0xFF};
+		_placeholder = std::make_unique<Texture2D>("TextureResidency/Placeholder");
+		_placeholder->Create(1, 1, 1, Format::RGBA8, Wrapping::Repeat, Filter::Nearest,
+		                     bgfx::copy(k_Pixel.data(), static_cast<uint32_t>(k_Pixel.size())));
+	}
+	return *_placeholder;
+}
+
+void TextureResidency::EndFrame() noexcept
+{
+	_stats.managed = static_cast<uint32_t>(_entries.size());
+	_stats.resident = 0;
+	_stats.pinned = 0;
+	for (const auto& [key, entry] : _entries)
+	{
+		_stats.resident += entry.texture->IsValid() ? 1 : 0;
+		_stats.pinned += entry.pinned ? 1 : 0;
+	}
+	_stats.managedBytes = _managedBytes;
+	_stats.residentBytes = _residentBytes;
+	_stats.budgetBytes = _budget;
+
+	_lastFrameStats = _stats;
+	_stats.uploads = 0;
+	_stats.evictions = 0;
+	_stats.placeholderRequests = 0;
+	_uploadedBytes = 0;
+	++_frame;
+}
+
+void TextureResidency::Clear()
+{
+	_lru.clear();
+	_entries.clear();
+	_placeholder.reset();
+	_managedBytes = 0;
+	_residentBytes = 0;
+}
@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <list>
+#include <memory>
+#include <span>
+#include <unordered_map>
+
+#include "Texture2D.h"
+
+namespace openblack::graphics
+{
+
+/// Counters of a \ref TextureResidency, the upload and eviction counts are those of the last frame.
+struct TextureResidencyStats
+{
+	uint32_t managed;
+	uint32_t resident;
+	uint32_t pinned;
+	uint64_t managedBytes;
+	uint64_t residentBytes;
+	uint64_t budgetBytes;
+	uint32_t uploads;
+	uint32_t evictions;
+	uint32_t placeholderRequests;
+	uint64_t totalUploads;
+	uint64_t totalEvictions;
+};
+
+/// Keeps a view of the pixel data of registered textures and only creates them on the GPU once they are requested.
+///
+/// Resident textures which have not been requested recently are destroyed when the budget would be exceeded by a new
+/// upload. Uploads are spread over frames, a placeholder is handed out until a texture is resident.
+class TextureResidency
+{
+public:
+	struct Source
+	{
+		uint16_t width;
+		uint16_t height;
+		Format format;
+		Wrapping wrapping;
+		Filter filter;
+		/// Keeps the memory viewed by data alive, usually the pack the texels are in
+		std::shared_ptr<const void> dataOwner;
+		/// Texels, viewed in place rather than copied out of their pack
+		std::span<const uint8_t> data;
+	};
+
+	static constexpr uint64_t k_DefaultBudget = 256 * 1024 * 1024;
+	/// Bytes uploaded in a frame before further requests get the placeholder, the first upload always goes through
+	static constexpr uint64_t k_UploadBytesPerFrame = 4 * 1024 * 1024;
+
+	TextureResidency() noexcept;
+	~TextureResidency() noexcept;
+
+	/// Take over the creation of the texture, which must not have been created yet
+	void Register(std::shared_ptr<Texture2D> texture, Source source);
+	/// Get the texture to bind for a draw this frame. Textures which are not managed are returned as is.
+	[[nodiscard]] const Texture2D& Request(const Texture2D& texture);
+	/// Get the texture if it is resident and the placeholder otherwise, without uploading it or counting it as used. For
+	/// inspecting textures without disturbing what is resident.
+	[[nodiscard]] const Texture2D& Peek(const Texture2D& texture);
+	/// Make the texture resident immediately and never evict it, for users which keep the native handle
+	void Pin(const Texture2D& texture);
+
+	[[nodiscard]] bool IsManaged(const Texture2D& texture) const { return _entries.contains(&texture); }
+	[[nodiscard]] bool IsResident(const Texture2D& texture) const;
+
+	void SetBudget(uint64_t bytes) noexcept { _budget = bytes; }
+	[[nodiscard]] uint64_t GetBudget() const noexcept { return _budget; }
+
+	/// Swap the counters of the current frame out and allow new uploads
+	void EndFrame() noexcept;
+	[[nodiscard]] const TextureResidencyStats& GetStats() const noexcept { return _lastFrameStats; }
+
+	void Clear();
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<Texture2D> texture;
+		Source source;
+		uint32_t lastUsedFrame;
+		bool pinned;
+		std::list<Entry*>::iterator lru;
+	};
+
+	void MakeResident(Entry& entry);
+	void Evict(Entry& entry);
+	/// Evict the least recently used textures until the size fits in the budget or only recently used ones remain
+	void MakeRoom(uint64_t size);
+	const Texture2D& GetPlaceholder();
+
+	std::unordered_map<const Texture2D*, Entry> _entries;
+	/// Resident textures which are not pinned, least recently used first
+	std::list<Entry*> _lru;
+	std::unique_ptr<Texture2D> _placeholder;
+	uint64_t _budget {k_DefaultBudget};
+	uint64_t _managedBytes {0};
+	uint64_t _residentBytes {0};
+	uint64_t _uploadedBytes {0};
+	uint32_t _frame {0};
+	TextureResidencyStats _stats {};
+	TextureResidencyStats _lastFrameStats {};
+};
+
+} // namespace openblack::graphics
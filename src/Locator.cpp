@@ -35,6 +35,7 @@
 #include "ECS/Systems/Implementations/PlayerSystem.h"
 #include "ECS/Systems/Implementations/RenderingSystem.h"
 #include "ECS/Systems/Implementations/TownSystem.h"
+#include "FileSystem/ReadQueue.h"
 #include "Graphics/RendererInterface.h"
 #include "Input/GameActionMap.h"
 #include "LHVM.h"
@@ -99,6 +100,7 @@ bool openblack::InitializeEngine(uint8_t rendererType, bool vsync) noexcept
 #else
 	Locator::filesystem::emplace<DefaultFileSystem>();
 #endif
+	Locator::readQueue::emplace(Locator::filesystem::value(), ReadQueue::GetDefaultThreadCount());
 	Locator::rng::emplace<RandomNumberManagerProduction>();
 	try
 	{
@@ -155,6 +157,7 @@ void openblack::ShutDownServices()
 	{
 		auto& resources = Locator::resources::value();
 		resources.GetMeshes().Clear();
+		resources.GetTextureResidency().Clear();
 		resources.GetTextures().Clear();
 		resources.GetAnimations().Clear();
 		resources.GetSounds().Clear();
@@ -174,6 +177,7 @@ void openblack::ShutDownServices()
 	Locator::handSystem::reset();
 	Locator::pathfindingSystem::reset();
 	Locator::terrainSystem::reset();
+	Locator::readQueue::reset();
 	Locator::filesystem::reset();
 	Locator::gameActionSystem::reset();
 
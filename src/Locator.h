@@ -52,6 +52,7 @@ class DebugGuiInterface;
 namespace filesystem
 {
 class FileSystemInterface;
+class ReadQueue;
 }
 
 namespace graphics
@@ -113,6 +114,7 @@ struct Locator
 	using windowing = entt::locator<windowing::WindowingInterface>;
 	using debugGui = entt::locator<debug::gui::DebugGuiInterface>;
 	using filesystem = entt::locator<filesystem::FileSystemInterface>;
+	using readQueue = entt::locator<filesystem::ReadQueue>;
 	using resources = entt::locator<resources::ResourcesInterface>;
 	using rng = entt::locator<RandomNumberManagerInterface>;
 	using terrainSystem = entt::locator<LandIslandInterface>;
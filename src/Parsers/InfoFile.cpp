@@ -23,7 +23,6 @@ std::unique_ptr<const InfoConstants> InfoFile::LoadFromFile(const std::filesyste
 	SPDLOG_LOGGER_DEBUG(spdlog::get("game"), "Loading Info Pack from file: {}", path.generic_string());
 
 	auto infos = std::make_unique<InfoConstants>();
-	std::vector<uint8_t> data;
 	pack::PackFile pack;
 	const auto result = pack.ReadFile(*Locator::filesystem::value().GetData(path));
 	if (result != pack::PackResult::Success)
@@ -32,7 +31,7 @@ std::unique_ptr<const InfoConstants> InfoFile::LoadFromFile(const std::filesyste
 		return nullptr;
 	}
 
-	data = pack.GetBlock("Info");
+	const auto data = pack.GetBlock("Info");
 	if (data.size() == sizeof(v100::InfoConstants))
 	{
 		auto oldInfos = std::make_unique<v100::InfoConstants>();
@@ -0,0 +1,51 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "BakedAssetCache.h"
+
+#include <BakedFile.h>
+#include <spdlog/spdlog.h>
+
+using namespace openblack::resources;
+
+std::shared_ptr<const openblack::baked::BakedFile> BakedAssetCache::Find(baked::BakedKind kind,
+                                                                          std::span<const uint8_t> source) const
+{
+	if (!IsEnabled())
+	{
+		return nullptr;
+	}
+
+	const auto hash = baked::HashSource(source);
+	const auto path = baked::GetCachePath(_directory, kind, hash);
+	auto file = std::make_shared<baked::BakedFile>();
+	const auto result = file->Open(path);
+	if (result != baked::BakedResult::Success)
+	{
+		// Files which were never baked are expected, others have to be baked again
+		if (result != baked::BakedResult::ErrCantOpen)
+		{
+			SPDLOG_LOGGER_WARN(spdlog::get("game"), "Ignoring baked asset {}: {}", path.generic_string(),
+			                   baked::ResultToStr(result));
+		}
+		++_misses;
+		return nullptr;
+	}
+
+	const auto& header = file->GetHeader();
+	if (header.kind != kind || header.sourceHash != hash || header.sourceSize != source.size())
+	{
+		SPDLOG_LOGGER_WARN(spdlog::get("game"), "Ignoring baked asset {}: Baked from another source", path.generic_string());
+		++_misses;
+		return nullptr;
+	}
+
+	++_hits;
+	return file;
+}
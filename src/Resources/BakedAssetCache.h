@@ -0,0 +1,49 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <span>
+
+namespace openblack::baked
+{
+class BakedFile;
+enum class BakedKind : uint32_t;
+} // namespace openblack::baked
+
+namespace openblack::resources
+{
+
+/// Looks up meshes and animations which were baked offline by l3dtool or packtool, by the hash of their source files.
+/// Lookups can be made from any thread once the directory is set.
+class BakedAssetCache
+{
+public:
+	/// An empty directory disables the cache
+	void SetDirectory(std::filesystem::path directory) { _directory = std::move(directory); }
+	[[nodiscard]] bool IsEnabled() const noexcept { return !_directory.empty(); }
+
+	/// Returns nullptr when the cache is disabled or has no baked file for this version of the source
+	[[nodiscard]] std::shared_ptr<const baked::BakedFile> Find(baked::BakedKind kind, std::span<const uint8_t> source) const;
+
+	[[nodiscard]] uint32_t GetHits() const noexcept { return _hits; }
+	[[nodiscard]] uint32_t GetMisses() const noexcept { return _misses; }
+
+private:
+	std::filesystem::path _directory;
+	mutable std::atomic<uint32_t> _hits {0};
+	mutable std::atomic<uint32_t> _misses {0};
+};
+
+} // namespace openblack::resources
@@ -0,0 +1,276 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include "LoadGraph.h"
+
+#include <cassert>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <fmt/ranges.h>
+#include <spdlog/spdlog.h>
+
+using namespace openblack::resources;
+
+namespace
+{
+double ToMilliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+} // namespace
+
+uint32_t LoadGraph::GetDefaultWorkerCount() noexcept
+{
+#ifdef __ANDROID__
+	// Files are read through JNI which is bound to the main thread
+	return 0;
+#else
+	// The main thread is kept for commits
+	return std::clamp(std::thread::hardware_concurrency(), 2u, 9u) - 1;
+#endif
+}
+
+LoadGraph::TaskId LoadGraph::Add(std::string name, Load load, std::vector<TaskId> dependencies)
+{
+	const auto id = static_cast<TaskId>(_tasks.size());
+	// Dependencies on earlier tasks only, so that there can be no cycles
+	assert(std::all_of(dependencies.begin(), dependencies.end(), [id](TaskId dependency) { return dependency < id; }));
+
+	auto& task = _tasks.emplace_back();
+	task.name = std::move(name);
+	task.load = std::move(load);
+	task.dependencies = std::move(dependencies);
+	return id;
+}
+
+void LoadGraph::RunLoad(Task& task) noexcept
+{
+	task.loadStart = Clock::now();
+	try
+	{
+		task.commit = task.load();
+	}
+	catch (...)
+	{
+		task.error = std::current_exception();
+	}
+	task.load = nullptr;
+	task.loadEnd = Clock::now();
+}
+
+std::vector<LoadGraph::TaskId> LoadGraph::RunCommit(Task& task)
+{
+	task.commitStart = Clock::now();
+	if (task.error)
+	{
+		std::rethrow_exception(task.error);
+	}
+	if (task.commit)
+	{
+		task.commit();
+		task.commit = nullptr;
+	}
+	task.commitEnd = Clock::now();
+
+	std::vector<TaskId> ready;
+	for (const auto dependent : task.dependents)
+	{
+		auto& next = _tasks[dependent];
+		if (--next.remainingDependencies == 0)
+		{
+			next.ready = task.commitEnd;
+			ready.push_back(dependent);
+		}
+	}
+	return ready;
+}
+
+void LoadGraph::Run(uint32_t workerCount)
+{
+	_workerCount = workerCount;
+	_start = Clock::now();
+
+	std::deque<TaskId> ready;
+	for (TaskId i = 0; i < _tasks.size(); ++i)
+	{
+		auto& task = _tasks[i];
+		task.remainingDependencies = static_cast<uint32_t>(task.dependencies.size());
+		for (const auto dependency : task.dependencies)
+		{
+			_tasks[dependency].dependents.push_back(i);
+		}
+		if (task.dependencies.empty())
+		{
+			task.ready = _start;
+			ready.push_back(i);
+		}
+	}
+
+	std::exception_ptr error;
+	if (workerCount == 0)
+	{
+		while (!ready.empty())
+		{
+			auto& task = _tasks[ready.front()];
+			ready.pop_front();
+			RunLoad(task);
+			try
+			{
+				const auto next = RunCommit(task);
+				ready.insert(ready.end(), next.begin(), next.end());
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+				break;
+			}
+		}
+	}
+	else
+	{
+		std::mutex mutex;
+		std::condition_variable workAvailable;
+		std::condition_variable loadFinished;
+		std::deque<TaskId> loaded;
+		bool stop = false;
+
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (uint32_t i = 0; i < workerCount; ++i)
+		{
+			workers.emplace_back([this, &mutex, &workAvailable, &loadFinished, &ready, &loaded, &stop]() {
+				std::unique_lock lock(mutex);
+				while (true)
+				{
+					workAvailable.wait(lock, [&ready, &stop]() { return stop || !ready.empty(); });
+					if (stop)
+					{
+						return;
+					}
+					const auto id = ready.front();
+					ready.pop_front();
+
+					lock.unlock();
+					RunLoad(_tasks[id]);
+					lock.lock();
+
+					loaded.push_back(id);
+					loadFinished.notify_one();
+				}
+			});
+		}
+
+		// Commits happen here as loads finish, in whichever order they do
+		for (size_t committed = 0; committed < _tasks.size(); ++committed)
+		{
+			TaskId id;
+			{
+				std::unique_lock lock(mutex);
+				loadFinished.wait(lock, [&loaded]() { return !loaded.empty(); });
+				id = loaded.front();
+				loaded.pop_front();
+			}
+
+			try
+			{
+				const auto next = RunCommit(_tasks[id]);
+				if (!next.empty())
+				{
+					const std::lock_guard lock(mutex);
+					ready.insert(ready.end(), next.begin(), next.end());
+				}
+				workAvailable.notify_all();
+			}
+			catch (...)
+			{
+				error = std::current_exception();
+				break;
+			}
+		}
+
+		{
+			const std::lock_guard lock(mutex);
+			stop = true;
+		}
+		workAvailable.notify_all();
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	_end = Clock::now();
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+}
+
+void LoadGraph::LogTimings() const
+{
+	if (_tasks.empty())
+	{
+		return;
+	}
+
+	const auto logger = spdlog::get("game");
+	Clock::duration work {};
+	for (const auto& task : _tasks)
+	{
+		SPDLOG_LOGGER_DEBUG(logger, "Load task {}: waited {:.2f} ms, load {:.2f} ms, commit {:.2f} ms", task.name,
+		                    ToMilliseconds(task.loadStart - task.ready), ToMilliseconds(task.loadEnd - task.loadStart),
+		                    ToMilliseconds(task.commitEnd - task.commitStart));
+		work += (task.loadEnd - task.loadStart) + (task.commitEnd - task.commitStart);
+	}
+
+	// Walk back from the last commit through the dependencies which held each task back the longest
+	const auto byCommitEnd = [this](TaskId a, TaskId b) { return _tasks[a].commitEnd < _tasks[b].commitEnd; };
+	std::vector<TaskId> ids(_tasks.size());
+	for (TaskId i = 0; i < ids.size(); ++i)
+	{
+		ids[i] = i;
+	}
+	std::vector<std::string> criticalPath;
+	Clock::duration criticalWork {};
+	auto id = *std::max_element(ids.begin(), ids.end(), byCommitEnd);
+	while (true)
+	{
+		const auto& task = _tasks[id];
+		criticalPath.push_back(task.name);
+		criticalWork += (task.loadEnd - task.loadStart) + (task.commitEnd - task.commitStart);
+		if (task.dependencies.empty())
+		{
+			break;
+		}
+		id = *std::max_element(task.dependencies.begin(), task.dependencies.end(), byCommitEnd);
+	}
+	std::reverse(criticalPath.begin(), criticalPath.end());
+
+	std::sort(ids.begin(), ids.end(), [this](TaskId a, TaskId b) {
+		return _tasks[a].loadEnd - _tasks[a].loadStart > _tasks[b].loadEnd - _tasks[b].loadStart;
+	});
+	std::vector<std::string> slowest;
+	for (size_t i = 0; i < std::min<size_t>(ids.size(), 3); ++i)
+	{
+		const auto& task = _tasks[ids[i]];
+		slowest.push_back(fmt::format("{} ({:.2f} ms)", task.name, ToMilliseconds(task.loadEnd - task.loadStart)));
+	}
+
+	SPDLOG_LOGGER_INFO(logger, "Loaded {} asset tasks in {:.2f} ms with {} workers for {:.2f} ms of work", _tasks.size(),
+	                   ToMilliseconds(_end - _start), _workerCount, ToMilliseconds(work));
+	SPDLOG_LOGGER_INFO(logger, "Critical path of {:.2f} ms: {}", ToMilliseconds(criticalWork),
+	                   fmt::join(criticalPath, " -> "));
+	SPDLOG_LOGGER_INFO(logger, "Slowest loads: {}", fmt::join(slowest, ", "));
+}
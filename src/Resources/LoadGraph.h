@@ -0,0 +1,77 @@
+/******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace openblack::resources
+{
+
+/// Runs the loading of assets on worker threads.
+///
+/// A task is made of a load function, which runs on a worker and parses files into CPU side objects, and of the commit
+/// function it returns, which runs on the thread calling Run. Commits add the results to the resource managers and
+/// create GPU resources, neither of which may be done from another thread. A task is started once all of its
+/// dependencies have been committed.
+class LoadGraph
+{
+public:
+	using TaskId = uint32_t;
+	using Commit = std::function<void()>;
+	/// May return an empty commit when there is nothing to add
+	using Load = std::function<Commit()>;
+
+	/// Workers used when none are specified, 0 on platforms where the file system must be accessed from one thread
+	static uint32_t GetDefaultWorkerCount() noexcept;
+
+	TaskId Add(std::string name, Load load, std::vector<TaskId> dependencies = {});
+
+	/// Run all tasks, loads run on the calling thread when there are no workers.
+	/// An exception thrown by a load or a commit is rethrown once the workers have stopped.
+	void Run(uint32_t workerCount);
+
+	/// Log the timings of each task and the chain of dependencies which ended last
+	void LogTimings() const;
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Task
+	{
+		std::string name;
+		Load load;
+		Commit commit;
+		std::exception_ptr error;
+		std::vector<TaskId> dependencies;
+		std::vector<TaskId> dependents;
+		uint32_t remainingDependencies;
+		Clock::time_point ready;
+		Clock::time_point loadStart;
+		Clock::time_point loadEnd;
+		Clock::time_point commitStart;
+		Clock::time_point commitEnd;
+	};
+
+	void RunLoad(Task& task) noexcept;
+	/// Returns the tasks which became ready
+	std::vector<TaskId> RunCommit(Task& task);
+
+	std::vector<Task> _tasks;
+	Clock::time_point _start;
+	Clock::time_point _end;
+	uint32_t _workerCount {0};
+};
+
+} // namespace openblack::resources
@@ -13,7 +13,9 @@
 #include <ranges>
 #include <utility>
 
+#include <BakedFile.h>
 #include <GLWFile.h>
+#include <L3DFile.h>
 #include <PackFile.h>
 #include <spdlog/spdlog.h>
 
@@ -21,65 +23,100 @@
 #include "3D/Light.h"
 #include "Audio/AudioManagerInterface.h"
 #include "Common/StringUtils.h"
-#include "Common/Zip.h"
 #include "FileSystem/FileSystemInterface.h"
+#include "FileSystem/InflateStream.h"
 #include "Graphics/Texture2D.h"
+#include "Graphics/TextureResidency.h"
 #include "Locator.h"
+#include "Resources/ResourcesInterface.h"
 
 using namespace openblack;
 using namespace openblack::filesystem;
 using namespace openblack::resources;
 
-L3DLoader::result_type L3DLoader::operator()(FromBufferTag, const std::string& debugName,
-                                             const std::vector<uint8_t>& data) const
+namespace
 {
-	auto mesh = std::make_shared<graphics::L3DMesh>(debugName);
-	if (!mesh->LoadFromBuffer(data))
+/// Map the baked file of a mesh from the cache or bake it in memory
+std::shared_ptr<const baked::BakedFile> BakeMesh(std::span<const uint8_t> source, const std::string& name)
+{
+	if (auto cached = Locator::resources::value().GetBakedAssets().Find(baked::BakedKind::Mesh, source))
 	{
-		throw std::runtime_error("Unable to load mesh");
+		return cached;
 	}
 
-	return mesh;
+	l3d::L3DFile l3d;
+	const auto result = l3d.Open(source);
+	if (result != l3d::L3DResult::Success)
+	{
+		throw std::runtime_error(fmt::format("Unable to load mesh {}: {}", name, l3d::ResultToStr(result)));
+	}
+
+	auto baked = std::make_shared<baked::BakedFile>();
+	const auto bakeResult = baked->BakeMesh(l3d, {});
+	if (bakeResult != baked::BakedResult::Success)
+	{
+		throw std::runtime_error(fmt::format("Unable to bake mesh {}: {}", name, baked::ResultToStr(bakeResult)));
+	}
+
+	return baked;
 }
+} // namespace
 
-L3DLoader::result_type L3DLoader::operator()(FromDiskTag, const std::filesystem::path& path) const
+L3DLoader::result_type L3DLoader::operator()(FromBufferTag, const std::string& debugName,
+                                             std::span<const uint8_t> data) const
+{
+	return (*this)(FromParsedTag {}, debugName, BakeMesh(data, debugName));
+}
+
+L3DLoader::result_type L3DLoader::operator()(FromPackTag, const std::string& debugName,
+                                             const std::shared_ptr<const pack::PackFile>& pack, size_t index) const
+{
+	return (*this)(FromBufferTag {}, debugName, pack->GetMeshes().at(index));
+}
+
+std::shared_ptr<const baked::BakedFile> L3DLoader::Parse(const std::filesystem::path& path)
 {
-	auto mesh = std::make_shared<graphics::L3DMesh>(path.stem().string());
 	auto pathExt = string_utils::LowerCase(path.extension().string());
 
-	if (pathExt == ".l3d")
+	if (pathExt == ".zzz")
 	{
-		if (!mesh->LoadFromFilesystem(path))
-		{
-			throw std::runtime_error("Unable to load mesh");
-		}
+		auto stream = Locator::filesystem::value().Open(path, Stream::Mode::Read);
+		const auto decompressedSize = stream->ReadValue<uint32_t>();
+		// Inflated as it is read from the file so that the compressed data is never held whole
+		InflateStream inflater(std::move(stream), decompressedSize);
+		auto buffer = std::vector<uint8_t>(decompressedSize);
+		inflater.Read(buffer.data(), buffer.size());
+		return BakeMesh(buffer, path.generic_string());
 	}
-	else if (pathExt == ".zzz")
+
+	return BakeMesh(Locator::filesystem::value().ReadAll(path), path.generic_string());
+}
+
+L3DLoader::result_type L3DLoader::operator()(FromParsedTag, const std::string& debugName,
+                                             std::shared_ptr<const baked::BakedFile> baked) const
+{
+	auto mesh = std::make_shared<graphics::L3DMesh>(debugName);
+	if (!mesh->Load(std::move(baked)))
 	{
-		auto stream = Locator::filesystem::value().Open(path, Stream::Mode::Read);
-		uint32_t decompressedSize = 0;
-		stream->Read(&decompressedSize);
-		auto buffer = std::vector<uint8_t>(stream->Size() - sizeof(decompressedSize));
-		stream->Read(buffer.data(), buffer.size());
-		auto decompressedBuffer = zip::Inflate(buffer, decompressedSize);
-		if (!mesh->LoadFromBuffer(decompressedBuffer))
-		{
-			throw std::runtime_error("Unable to load decompressed mesh");
-		}
+		SPDLOG_LOGGER_WARN(spdlog::get("game"), "Some issues were seen while loading l3d mesh {}.", debugName);
 	}
 
 	return mesh;
 }
 
-Texture2DLoader::result_type Texture2DLoader::operator()(FromPackTag, const std::string& name,
-                                                         const pack::G3DTexture& g3dTexture) const
+L3DLoader::result_type L3DLoader::operator()(FromDiskTag, const std::filesystem::path& path) const
+{
+	return (*this)(FromParsedTag {}, path.stem().string(), Parse(path));
+}
+
+graphics::TextureResidency::Source Texture2DLoader::MakeSource(const std::shared_ptr<const pack::PackFile>& pack,
+                                                               const pack::G3DTexture& g3dTexture)
 {
 	// some assumptions:
 	// - no mipmaps
 	// - no cubemap or volume textures
 	// - always dxt1 or dxt3
 	// - all are compressed
-	auto texture2D = std::make_shared<graphics::Texture2D>(name);
 	graphics::Format internalFormat;
 	if (g3dTexture.ddsHeader.format.fourCC.data() == std::string("DXT1"))
 	{
@@ -98,18 +135,23 @@ Texture2DLoader::result_type Texture2DLoader::operator()(FromPackTag, const std:
 		throw std::runtime_error("Unsupported compressed texture format");
 	}
 
-	texture2D->Create(static_cast<uint16_t>(g3dTexture.ddsHeader.width), static_cast<uint16_t>(g3dTexture.ddsHeader.height), 1,
-	                  internalFormat, graphics::Wrapping::Repeat, graphics::Filter::Linear, g3dTexture.ddsData.data(),
-	                  static_cast<uint32_t>(g3dTexture.ddsData.size()));
-	return texture2D;
+	return {
+	    .width = static_cast<uint16_t>(g3dTexture.ddsHeader.width),
+	    .height = static_cast<uint16_t>(g3dTexture.ddsHeader.height),
+	    .format = internalFormat,
+	    .wrapping = graphics::Wrapping::Repeat,
+	    .filter = graphics::Filter::Linear,
+	    .dataOwner = pack,
+	    .data = g3dTexture.ddsData,
+	};
 }
 
-Texture2DLoader::result_type Texture2DLoader::operator()(FromDiskTag, const std::filesystem::path& rawTexturePath) const
+graphics::TextureResidency::Source Texture2DLoader::ReadRawSource(const std::filesystem::path& rawTexturePath)
 {
 	bool found = false;
 	const std::array<uint16_t, 12> resolutions = {{1024, 512, 256, 128, 64, 40, 32, 14, 12, 6}};
 
-	const auto data = Locator::filesystem::value().ReadAll(rawTexturePath);
+	auto data = std::make_shared<const std::vector<uint8_t>>(Locator::filesystem::value().ReadAll(rawTexturePath));
 	graphics::Format format = graphics::Format::R8;
 	uint16_t width = 0;
 	uint16_t height = 0;
@@ -123,14 +165,14 @@ Texture2DLoader::result_type Texture2DLoader::operator()(FromDiskTag, const std:
 		width = res;
 		height = res;
 
-		const typename decltype(data)::size_type pixelCount = width * height;
+		const size_t pixelCount = width * height;
 
-		if (data.size() == pixelCount)
+		if (data->size() == pixelCount)
 		{
 			format = graphics::Format::R8;
 			found = true;
 		}
-		if (data.size() == 3 * pixelCount)
+		if (data->size() == 3 * pixelCount)
 		{
 			format = graphics::Format::RGB8;
 			found = true;
@@ -138,28 +180,65 @@ Texture2DLoader::result_type Texture2DLoader::operator()(FromDiskTag, const std:
 	}
 	if (!found)
 	{
-		throw std::runtime_error("Unable to load texture: Ambiguous size and format: " + std::to_string(data.size()));
+		throw std::runtime_error("Unable to load texture: Ambiguous size and format: " + std::to_string(data->size()));
 	}
 
-	auto texture = std::make_shared<graphics::Texture2D>(("raw" / rawTexturePath.stem()).string());
-	texture->Create(width, height, 1, format, graphics::Wrapping::Repeat, graphics::Filter::Linear, data.data(),
-	                static_cast<uint32_t>(data.size()));
+	return {
+	    .width = width,
+	    .height = height,
+	    .format = format,
+	    .wrapping = graphics::Wrapping::Repeat,
+	    .filter = graphics::Filter::Linear,
+	    .dataOwner = data,
+	    .data = *data,
+	};
+}
 
+Texture2DLoader::result_type Texture2DLoader::operator()(FromSourceTag, const std::string& name,
+                                                         graphics::TextureResidency::Source source) const
+{
+	// Created on the GPU once a mesh using it is drawn
+	auto texture = std::make_shared<graphics::Texture2D>(name);
+	Locator::resources::value().GetTextureResidency().Register(texture, std::move(source));
 	return texture;
 }
 
+Texture2DLoader::result_type Texture2DLoader::operator()(FromPackTag, const std::string& name,
+                                                         const std::shared_ptr<const pack::PackFile>& pack,
+                                                         const pack::G3DTexture& g3dTexture) const
+{
+	return (*this)(FromSourceTag {}, name, MakeSource(pack, g3dTexture));
+}
+
+Texture2DLoader::result_type Texture2DLoader::operator()(FromDiskTag, const std::filesystem::path& rawTexturePath) const
+{
+	return (*this)(FromSourceTag {}, ("raw" / rawTexturePath.stem()).string(), ReadRawSource(rawTexturePath));
+}
+
 L3DAnimLoader::result_type L3DAnimLoader::operator()(FromBufferTag, const std::vector<uint8_t>& data) const
 {
 	auto animation = std::make_shared<L3DAnim>();
+	if (const auto cached = Locator::resources::value().GetBakedAssets().Find(baked::BakedKind::Animation, data))
+	{
+		animation->Load(*cached);
+		return animation;
+	}
+
 	animation->LoadFromBuffer(data);
 	return animation;
 }
 
 L3DAnimLoader::result_type L3DAnimLoader::operator()(FromDiskTag, const std::filesystem::path& path) const
 {
+	const auto data = Locator::filesystem::value().ReadAll(path);
 	auto animation = std::make_shared<L3DAnim>();
+	if (const auto cached = Locator::resources::value().GetBakedAssets().Find(baked::BakedKind::Animation, data))
+	{
+		animation->Load(*cached);
+		return animation;
+	}
 
-	if (!animation->LoadFromFilesystem(path))
+	if (!animation->LoadFromBuffer(data))
 	{
 		throw std::runtime_error("Unable to load animation");
 	}
@@ -179,7 +258,8 @@ CreatureMindLoader::result_type CreatureMindLoader::operator()(FromDiskTag, cons
 
 SoundLoader::result_type SoundLoader::operator()(BaseLoader<audio::Sound>::FromBufferTag,
                                                  const pack::AudioBankSampleHeader& header,
-                                                 const std::vector<std::vector<uint8_t>>& buffer) const
+                                                 std::span<const uint8_t> buffer,
+                                                 std::shared_ptr<const void> owner) const
 {
 	auto sound = std::make_shared<audio::Sound>();
 	// Let's clean up the names as they're very difficult to read from the debug GUI
@@ -192,6 +272,7 @@ SoundLoader::result_type SoundLoader::operator()(BaseLoader<audio::Sound>::FromB
 	sound->pitch = header.pitch;
 	sound->pitchDeviation = header.pitchDeviation;
 	sound->playType = static_cast<audio::PlayType>(header.loopType);
+	sound->bufferOwner = std::move(owner);
 	sound->buffer = buffer;
 	return sound;
 }
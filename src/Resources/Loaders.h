@@ -17,6 +17,7 @@
 #include "3D/Light.h"
 #include "Audio/Sound.h"
 #include "Creature/CreatureMind.h"
+#include "Graphics/TextureResidency.h"
 #include "Level.h"
 
 namespace openblack::graphics
@@ -25,10 +26,16 @@ class L3DMesh;
 class Texture2D;
 } // namespace openblack::graphics
 
+namespace openblack::baked
+{
+class BakedFile;
+} // namespace openblack::baked
+
 namespace openblack::pack
 {
 struct AudioBankSampleHeader;
 struct G3DTexture;
+class PackFile;
 } // namespace openblack::pack
 
 namespace openblack::resources
@@ -49,7 +56,24 @@ struct BaseLoader
 
 struct L3DLoader final: BaseLoader<graphics::L3DMesh>
 {
-	[[nodiscard]] result_type operator()(FromBufferTag, const std::string& debugName, const std::vector<uint8_t>& data) const;
+	struct FromPackTag
+	{
+	};
+	struct FromParsedTag
+	{
+	};
+
+	/// Read and bake an l3d or zzz mesh, or map it from the baked asset cache, without creating GPU resources.
+	/// This can be called from any thread.
+	[[nodiscard]] static std::shared_ptr<const baked::BakedFile> Parse(const std::filesystem::path& path);
+
+	[[nodiscard]] result_type operator()(FromBufferTag, const std::string& debugName, std::span<const uint8_t> data) const;
+	/// Load a mesh of the pack, sharing ownership of the pack lets meshes be loaded after it has been read
+	[[nodiscard]] result_type operator()(FromPackTag, const std::string& debugName,
+	                                     const std::shared_ptr<const pack::PackFile>& pack, size_t index) const;
+	/// Create the GPU resources of a mesh returned by Parse
+	[[nodiscard]] result_type operator()(FromParsedTag, const std::string& debugName,
+	                                     std::shared_ptr<const baked::BakedFile> baked) const;
 	[[nodiscard]] result_type operator()(FromDiskTag, const std::filesystem::path& path) const;
 };
 
@@ -58,8 +82,20 @@ struct Texture2DLoader final: BaseLoader<graphics::Texture2D>
 	struct FromPackTag
 	{
 	};
+	struct FromSourceTag
+	{
+	};
+
+	/// Decode the pixel data of a texture without registering it, these can be called from any thread
+	[[nodiscard]] static graphics::TextureResidency::Source MakeSource(const std::shared_ptr<const pack::PackFile>& pack,
+	                                                                   const pack::G3DTexture& g3dTexture);
+	[[nodiscard]] static graphics::TextureResidency::Source ReadRawSource(const std::filesystem::path& rawTexturePath);
 
-	[[nodiscard]] result_type operator()(FromPackTag, const std::string& name, const pack::G3DTexture& g3dTexture) const;
+	[[nodiscard]] result_type operator()(FromSourceTag, const std::string& name,
+	                                     graphics::TextureResidency::Source source) const;
+	[[nodiscard]] result_type operator()(FromPackTag, const std::string& name,
+	                                     const std::shared_ptr<const pack::PackFile>& pack,
+	                                     const pack::G3DTexture& g3dTexture) const;
 	[[nodiscard]] result_type operator()(FromDiskTag, const std::filesystem::path& rawTexturePath) const;
 };
 
@@ -81,8 +117,9 @@ struct CreatureMindLoader final: BaseLoader<creature::CreatureMind>
 
 struct SoundLoader final: BaseLoader<audio::Sound>
 {
+	/// The sound views the buffer without copying it, owner is kept alive for as long as the sound is
 	[[nodiscard]] result_type operator()(FromBufferTag, const pack::AudioBankSampleHeader& header,
-	                                     const std::vector<std::vector<uint8_t>>& buffer) const;
+	                                     std::span<const uint8_t> buffer, std::shared_ptr<const void> owner) const;
 };
 
 struct LightLoader final: BaseLoader<Lights>
@@ -9,10 +9,18 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
 #include <entt/core/hashed_string.hpp>
 #include <entt/fwd.hpp>
 #include <entt/resource/cache.hpp>
 #include <fmt/format.h>
+#include <spdlog/spdlog.h>
 
 namespace openblack::resources
 {
@@ -33,6 +41,24 @@ template <typename T>
 	}
 }
 
+/// Forwards to a resource loader and additionally accepts resources which were constructed elsewhere
+template <typename ResourceLoader>
+struct InsertingLoader
+{
+	using result_type = typename ResourceLoader::result_type;
+	struct FromResourceTag
+	{
+	};
+
+	result_type operator()(FromResourceTag, result_type resource) const { return resource; }
+
+	template <typename... Args>
+	result_type operator()(Args&&... args) const
+	{
+		return ResourceLoader {}(std::forward<Args>(args)...);
+	}
+};
+
 template <typename ResourceLoader>
 class ResourceManager
 {
@@ -42,12 +68,34 @@ class ResourceManager
 	template <typename... Args>
 	[[maybe_unused]] decltype(auto) Load(entt::id_type identifier, Args&&... args)
 	{
+		_pending.erase(identifier);
 		return _resourceCache.load(identifier, std::forward<Args>(args)...);
 	}
 
+	/// Register a resource which is only loaded the first time it is accessed through Handle.
+	/// The arguments are kept by value until then. If loading fails, a default constructed resource takes its place.
+	template <typename... Args>
+	void LoadLazy(entt::id_type identifier, Args&&... args)
+	{
+		if (_resourceCache.contains(identifier))
+		{
+			return;
+		}
+		_pending.insert_or_assign(identifier, [identifier, ... args = std::forward<Args>(args)](Cache& cache) {
+			cache.load(identifier, args...);
+		});
+	}
+
+	/// Add a resource which was constructed outside of the loader, such as on a loading thread
+	[[maybe_unused]] decltype(auto) Insert(entt::id_type identifier, std::shared_ptr<ResourceType> resource)
+	{
+		return Load(identifier, typename InsertingLoader<ResourceLoader>::FromResourceTag {}, std::move(resource));
+	}
+
 	template <typename... Args>
 	[[maybe_unused]] decltype(auto) Erase(entt::id_type identifier, Args&&... args)
 	{
+		_pending.erase(identifier);
 		return _resourceCache.erase(identifier, std::forward<Args>(args)...);
 	}
 
@@ -57,17 +105,51 @@ class ResourceManager
 		return Load(HashIdentifier(identifier), std::forward<Args>(args)...);
 	}
 
+	template <typename T>
+	[[maybe_unused]] decltype(auto) Insert(T identifier, std::shared_ptr<ResourceType> resource)
+	{
+		return Insert(HashIdentifier(identifier), std::move(resource));
+	}
+
+	template <typename T, typename... Args>
+	void LoadLazy(T identifier, Args&&... args)
+	{
+		LoadLazy(HashIdentifier(identifier), std::forward<Args>(args)...);
+	}
+
 	template <typename T, typename... Args>
 	[[maybe_unused]] decltype(auto) Erase(T identifier, Args&&... args)
 	{
 		return Erase(HashIdentifier(identifier), std::forward<Args>(args)...);
 	}
 
-	[[nodiscard]] decltype(auto) Handle(entt::id_type identifier) { return _resourceCache[identifier]; }
+	[[nodiscard]] decltype(auto) Handle(entt::id_type identifier)
+	{
+		LoadPending(identifier);
+		return _resourceCache[identifier];
+	}
+
+	[[nodiscard]] decltype(auto) Handle(entt::id_type identifier) const
+	{
+		LoadPending(identifier);
+		return std::as_const(_resourceCache)[identifier];
+	}
+
+	[[nodiscard]] bool Contains(entt::id_type identifier) const
+	{
+		return _resourceCache.contains(identifier) || _pending.contains(identifier);
+	}
 
-	[[nodiscard]] decltype(auto) Handle(entt::id_type identifier) const { return _resourceCache[identifier]; }
+	[[nodiscard]] bool IsLoaded(entt::id_type identifier) const { return _resourceCache.contains(identifier); }
 
-	[[nodiscard]] bool Contains(entt::id_type identifier) const { return _resourceCache.contains(identifier); }
+	/// Load all resources registered with LoadLazy which have not been accessed yet
+	void LoadPending() const
+	{
+		while (!_pending.empty())
+		{
+			LoadPending(_pending.begin()->first);
+		}
+	}
 
 	template <typename T>
 	[[nodiscard]] bool Contains(T identifier) const
@@ -75,6 +157,7 @@ class ResourceManager
 		return Contains(HashIdentifier(identifier));
 	}
 
+	/// Iterate the loaded resources, resources registered with LoadLazy are skipped until they are accessed
 	template <typename Func>
 	void Each(Func func) const
 	{
@@ -90,10 +173,48 @@ class ResourceManager
 	}
 
 	[[nodiscard]] decltype(auto) Size() const { return _resourceCache.size(); }
+	[[nodiscard]] size_t PendingSize() const { return _pending.size(); }
 
-	void Clear() { _resourceCache.clear(); }
+	void Clear()
+	{
+		_pending.clear();
+		_resourceCache.clear();
+	}
 
 private:
-	entt::resource_cache<ResourceType, ResourceLoader> _resourceCache;
+	using Cache = entt::resource_cache<ResourceType, InsertingLoader<ResourceLoader>>;
+
+	void LoadPending(entt::id_type identifier) const
+	{
+		auto iter = _pending.find(identifier);
+		if (iter == _pending.end())
+		{
+			return;
+		}
+		auto load = std::move(iter->second);
+		_pending.erase(iter);
+		try
+		{
+			load(_resourceCache);
+		}
+		catch (std::exception& err)
+		{
+			SPDLOG_LOGGER_ERROR(spdlog::get("game"), "Failed to load resource {}: {}", identifier, err.what());
+		}
+
+		// Contains has reported the resource as present since LoadLazy, so callers expect a valid handle
+		if (!_resourceCache.contains(identifier))
+		{
+			if constexpr (std::is_default_constructible_v<ResourceType>)
+			{
+				_resourceCache.load(identifier, typename InsertingLoader<ResourceLoader>::FromResourceTag {},
+				                    std::make_shared<ResourceType>());
+			}
+		}
+	}
+
+	// Loading on first access is not an observable change of the manager
+	mutable Cache _resourceCache;
+	mutable std::unordered_map<entt::id_type, std::function<void(Cache&)>> _pending;
 };
 } // namespace openblack::resources
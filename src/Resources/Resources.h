@@ -9,6 +9,7 @@
 
 #pragma once
 
+#include "Graphics/TextureResidency.h"
 #include "ResourcesInterface.h"
 
 #if !defined(LOCATOR_IMPLEMENTATIONS)
@@ -22,19 +23,23 @@ class Resources final: public ResourcesInterface
 public:
 	MeshManager& GetMeshes() override { return _meshes; }
 	TextureManager& GetTextures() override { return _textures; }
+	graphics::TextureResidency& GetTextureResidency() override { return _textureResidency; }
 	AnimationManager& GetAnimations() override { return _animations; }
 	LevelManager& GetLevels() override { return _levels; }
 	CreatureMindManager& GetCreatureMinds() override { return _creatureMinds; }
 	SoundManager& GetSounds() override { return _sounds; }
 	GlowManager& GetGlows() override { return _glows; }
+	BakedAssetCache& GetBakedAssets() override { return _bakedAssets; }
 
 private:
 	MeshManager _meshes;
 	TextureManager _textures;
+	graphics::TextureResidency _textureResidency;
 	AnimationManager _animations;
 	LevelManager _levels;
 	CreatureMindManager _creatureMinds;
 	SoundManager _sounds;
 	GlowManager _glows;
+	BakedAssetCache _bakedAssets;
 };
 } // namespace openblack::resources
@@ -9,9 +9,15 @@
 
 #pragma once
 
+#include "BakedAssetCache.h"
 #include "Loaders.h"
 #include "ResourceManager.h"
 
+namespace openblack::graphics
+{
+class TextureResidency;
+}
+
 namespace openblack::resources
 {
 using MeshManager = ResourceManager<L3DLoader>;
@@ -27,11 +33,13 @@ class ResourcesInterface
 public:
 	virtual MeshManager& GetMeshes() = 0;
 	virtual TextureManager& GetTextures() = 0;
+	virtual graphics::TextureResidency& GetTextureResidency() = 0;
 	virtual AnimationManager& GetAnimations() = 0;
 	virtual LevelManager& GetLevels() = 0;
 	virtual CreatureMindManager& GetCreatureMinds() = 0;
 	virtual SoundManager& GetSounds() = 0;
 	virtual GlowManager& GetGlows() = 0;
+	virtual BakedAssetCache& GetBakedAssets() = 0;
 };
 
 } // namespace openblack::resources
@@ -15,6 +15,7 @@
 #include "ECS/Components/Footpath.h"
 #include "ECS/Registry.h"
 #include "FileSystem/FileSystemInterface.h"
+#include "FileSystem/MemoryStream.h"
 #include "GameThingSerializer.h"
 #include "Locator.h"
 
@@ -28,8 +29,13 @@ FotFile::FotFile(Game& game)
 
 void FotFile::Load(const std::filesystem::path& path)
 {
-	auto stream = Locator::filesystem::value().Open(path, Stream::Mode::Read);
-	serializer::GameThingSerializer serializer(*stream);
+	Load(Locator::filesystem::value().ReadAll(path));
+}
+
+void FotFile::Load(std::vector<uint8_t> data)
+{
+	MemoryStream stream(std::move(data));
+	serializer::GameThingSerializer serializer(stream);
 	auto footpathLinkSaves = serializer.DeserializeList<serializer::GameThingSerializer::FootpathLinkSave>();
 	auto footpaths = serializer.DeserializeList<serializer::GameThingSerializer::Footpath>();
 	auto& registry = Locator::entitiesRegistry::value();
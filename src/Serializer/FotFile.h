@@ -12,6 +12,7 @@
 #include <cstdint>
 
 #include <filesystem>
+#include <vector>
 
 namespace openblack
 {
@@ -24,6 +25,7 @@ class FotFile
 	explicit FotFile(Game& game);
 
 	void Load(const std::filesystem::path& path);
+	void Load(std::vector<uint8_t> data);
 
 private:
 	Game& _game;
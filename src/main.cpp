@@ -58,6 +58,9 @@ bool parseOptions(int argc, char** argv, openblack::Arguments& args, int& return
 		    cxxopts::value<std::vector<std::string>>()->default_value("all=debug"))
 		("screenshot-frame", "Request a screenshot of the backbuffer at a certain frame number.", cxxopts::value<uint32_t>())
 		("screenshot-path", "Path of the request a screenshot of the backbuffer.", cxxopts::value<std::filesystem::path>()->default_value("screenshot.png"))
+		("texture-budget", "GPU memory in MiB for textures which are created on demand.", cxxopts::value<uint32_t>())
+		("baked-cache", "Directory of meshes and animations baked by l3dtool or packtool, used instead of converting them.", cxxopts::value<std::filesystem::path>())
+		("mount", "Zip archive to read files from ahead of the game directory, later archives take precedence. Can be repeated.", cxxopts::value<std::vector<std::filesystem::path>>())
 	;
 	// clang-format on
 
@@ -183,6 +186,21 @@ bool parseOptions(int argc, char** argv, openblack::Arguments& args, int& return
 			                                        result["screenshot-path"].as<std::filesystem::path>());
 		}
 
+		if (result.count("texture-budget") != 0)
+		{
+			args.textureBudget = result["texture-budget"].as<uint32_t>();
+		}
+
+		if (result.count("baked-cache") != 0)
+		{
+			args.bakedCachePath = result["baked-cache"].as<std::filesystem::path>();
+		}
+
+		if (result.count("mount") != 0)
+		{
+			args.mountedArchives = result["mount"].as<std::vector<std::filesystem::path>>();
+		}
+
 		args.windowWidth = result["width"].as<uint16_t>();
 		args.windowHeight = result["height"].as<uint16_t>();
 		args.guiScale = result["ui-scale"].as<float>();
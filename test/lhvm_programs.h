@@ -0,0 +1,284 @@
+/*******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#pragma once
+
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <LHVM.h>
+#include <LHVMFile.h>
+#include <gtest/gtest.h>
+
+/// Random programs for the LHVM and the comparison of the states they leave the VM in
+namespace lhvm_test
+{
+using namespace openblack::lhvm;
+
+constexpr uint32_t k_Globals = 4;
+constexpr uint32_t k_Locals = 3;
+
+struct Program
+{
+	std::vector<std::string> globals;
+	std::vector<VMInstruction> instructions;
+	std::vector<VMScript> scripts;
+	std::vector<uint32_t> autostart;
+};
+
+/// Scripts of random instructions, each one looping back to its start and yielding every time
+inline Program Generate(std::mt19937& rng)
+{
+	const auto random = [&rng](uint32_t n) { return static_cast<uint32_t>(rng() % n); };
+	constexpr DataType k_Types[] = {DataType::Int, DataType::Float, DataType::Vector, DataType::Object, DataType::Boolean};
+	constexpr Opcode k_Operations[] = {Opcode::Add, Opcode::Sub, Opcode::Neg, Opcode::Mul, Opcode::Div,
+	                                   Opcode::Mod, Opcode::Not, Opcode::And, Opcode::Or,  Opcode::Eq,
+	                                   Opcode::Ne,  Opcode::Ge,  Opcode::Le,  Opcode::Gt,  Opcode::Lt};
+
+	Program program;
+	for (uint32_t i = 0; i < k_Globals; ++i)
+	{
+		program.globals.push_back("global" + std::to_string(i));
+	}
+	const auto scriptCount = 1 + random(4);
+	for (uint32_t script = 0; script < scriptCount; ++script)
+	{
+		const auto start = static_cast<uint32_t>(program.instructions.size());
+		const auto end = start + 16 + random(48);
+		const auto variable = [&]() { return random(2) != 0 ? 1 + random(k_Globals) : k_Globals + 1 + random(k_Locals); };
+		for (auto address = start; address < end; ++address)
+		{
+			VMInstruction instruction(Opcode::Line, VMMode::Immediate, k_Types[random(10) < 8 ? random(2) : random(5)],
+			                          VMValue(0u), address);
+			const auto kind = random(100);
+			if (kind < 25)
+			{
+				instruction.code = Opcode::Push;
+				instruction.mode = random(2) != 0 ? VMMode::Immediate : VMMode::Reference;
+				instruction.data = instruction.mode == VMMode::Reference ? VMValue(variable())
+				                   : instruction.type == DataType::Float  ? VMValue(static_cast<float>(random(7)) - 2.0f)
+				                                                          : VMValue(static_cast<int32_t>(random(5)) - 1);
+			}
+			else if (kind < 35)
+			{
+				instruction.code = Opcode::Pop;
+				instruction.mode = random(4) != 0 ? VMMode::Reference : VMMode::Immediate;
+				instruction.data = VMValue(variable());
+			}
+			else if (kind < 60)
+			{
+				instruction.code = k_Operations[random(std::size(k_Operations))];
+			}
+			else if (kind < 68)
+			{
+				// Backward jumps yield, so the scripts can't spin
+				const auto target = start + random(end - start + 1);
+				instruction.code = random(2) != 0 ? Opcode::Wait : Opcode::Jmp;
+				instruction.mode = target > address ? VMMode::Forward : VMMode::Backward;
+				instruction.data = VMValue(target);
+			}
+			else if (kind < 74)
+			{
+				instruction.code = Opcode::Sys;
+				instruction.data = VMValue(random(4));
+			}
+			else if (kind < 78)
+			{
+				instruction.code = Opcode::Cast;
+				instruction.mode = random(2) != 0 ? VMMode::Zero : VMMode::Cast;
+				instruction.data = VMValue(variable());
+			}
+			else if (kind < 80)
+			{
+				instruction.code = Opcode::Sleep;
+			}
+			else if (kind < 82)
+			{
+				instruction.code = Opcode::EndExcept;
+				instruction.mode = VMMode::Yield;
+			}
+			else if (kind == 82)
+			{
+				instruction.code = Opcode::End;
+			}
+			program.instructions.push_back(instruction);
+		}
+		program.instructions.emplace_back(Opcode::Jmp, VMMode::Backward, DataType::Int, VMValue(start), end);
+		program.instructions.emplace_back(Opcode::End, VMMode::Immediate, DataType::Int, VMValue(0u), end + 1);
+
+		std::vector<std::string> locals;
+		for (uint32_t i = 0; i < k_Locals; ++i)
+		{
+			locals.push_back("local" + std::to_string(i));
+		}
+		program.scripts.emplace_back("script" + std::to_string(script), "test.txt", ScriptType::Script, k_Globals, locals,
+		                             start, 0, script + 1);
+		program.autostart.push_back(script + 1);
+	}
+	return program;
+}
+
+/// Scripts which sleep the way "wait <seconds> seconds" is compiled, yield and run each other, so that their tasks spend
+/// most ticks sleeping or waiting for another task. The first script loops forever, the others end or loop.
+inline Program GenerateScheduling(std::mt19937& rng)
+{
+	const auto random = [&rng](uint32_t n) { return static_cast<uint32_t>(rng() % n); };
+	constexpr float k_Seconds[] = {0.0f, 0.1f, 0.3f, 1.0f, 2.5f, 7.0f};
+
+	Program program;
+	for (uint32_t i = 0; i < k_Globals; ++i)
+	{
+		program.globals.push_back("global" + std::to_string(i));
+	}
+	const auto emit = [&program](Opcode code, VMMode mode, DataType type, VMValue data) {
+		const auto address = static_cast<uint32_t>(program.instructions.size());
+		program.instructions.emplace_back(code, mode, type, data, address);
+	};
+	const auto scriptCount = 2 + random(4);
+	for (uint32_t script = 0; script < scriptCount; ++script)
+	{
+		const auto start = static_cast<uint32_t>(program.instructions.size());
+		const auto variable = [&]() { return random(2) != 0 ? 1 + random(k_Globals) : k_Globals + 1 + random(k_Locals); };
+		const auto blocks = 2 + random(6);
+		for (uint32_t block = 0; block < blocks; ++block)
+		{
+			const auto address = static_cast<uint32_t>(program.instructions.size());
+			const auto kind = random(10);
+			if (kind < 4)
+			{
+				emit(Opcode::Push, VMMode::Immediate, DataType::Float, VMValue(k_Seconds[random(std::size(k_Seconds))]));
+				emit(Opcode::Sleep, VMMode::Immediate, DataType::Int, VMValue(0u));
+				emit(Opcode::Wait, VMMode::Backward, DataType::Int, VMValue(address));
+			}
+			else if (kind < 6)
+			{
+				emit(Opcode::EndExcept, VMMode::Yield, DataType::Int, VMValue(0u));
+			}
+			else if (kind < 8 && script + 1 < scriptCount)
+			{
+				// Later scripts only, so that the tasks can't wait for each other in a cycle
+				const auto mode = random(3) != 0 ? VMMode::Sync : VMMode::Async;
+				emit(Opcode::Run, mode, DataType::Int, VMValue(script + 2 + random(scriptCount - script - 1)));
+			}
+			else
+			{
+				const auto target = variable();
+				emit(Opcode::Push, VMMode::Reference, DataType::Float, VMValue(target));
+				emit(Opcode::Push, VMMode::Immediate, DataType::Float, VMValue(1.0f));
+				emit(Opcode::Add, VMMode::Immediate, DataType::Float, VMValue(0u));
+				emit(Opcode::Pop, VMMode::Reference, DataType::Float, VMValue(target));
+			}
+		}
+		if (script == 0 || random(4) == 0)
+		{
+			emit(Opcode::Jmp, VMMode::Backward, DataType::Int, VMValue(start));
+		}
+		emit(Opcode::End, VMMode::Immediate, DataType::Int, VMValue(0u));
+
+		std::vector<std::string> locals;
+		for (uint32_t i = 0; i < k_Locals; ++i)
+		{
+			locals.push_back("local" + std::to_string(i));
+		}
+		const auto type = script > 0 && random(3) == 0 ? ScriptType::Help : ScriptType::Script;
+		program.scripts.emplace_back("script" + std::to_string(script), "test.txt", type, k_Globals, locals, start, 0,
+		                             script + 1);
+	}
+	program.autostart.push_back(1);
+	return program;
+}
+
+struct Machine
+{
+	LHVM vm;
+	std::vector<NativeFunction> natives;
+	std::vector<ErrorCode> errors;
+	int32_t references {0};
+};
+
+inline void Load(Machine& machine, InterpreterCore core, const Program& program)
+{
+	machine.natives.emplace_back(nullptr, 0, 0, "NONE");
+	machine.natives.emplace_back([](LHVM& vm) { vm.Pushf(vm.Popf() * 2.0f); }, 1, 1, "DOUBLE");
+	machine.natives.emplace_back([](LHVM& vm) { vm.Pushb(true); }, 0, 1, "TRUE");
+	machine.natives.emplace_back(
+	    [](LHVM& vm) {
+		    if (vm.Popf() > 50.0f)
+		    {
+			    throw std::runtime_error("Too large");
+		    }
+	    },
+	    1, 0, "CHECK");
+	machine.vm.Initialise(
+	    &machine.natives, nullptr, nullptr, nullptr,
+	    [&machine](ErrorCode code, const std::string& /*v0*/, uint32_t /*v1*/) { machine.errors.push_back(code); },
+	    [&machine](uint32_t /*objId*/) { ++machine.references; }, [&machine](uint32_t /*objId*/) { --machine.references; });
+	machine.vm.SetInterpreterCore(core);
+	const LHVMFile file(LHVMVersion::BlackAndWhite, program.globals, program.instructions, program.autostart,
+	                    program.scripts, std::vector<char>(4, 0));
+	ASSERT_EQ(machine.vm.LoadBinary(file), 0);
+}
+
+inline void ExpectSameStack(const VMStack& a, const VMStack& b)
+{
+	ASSERT_EQ(a.count, b.count);
+	EXPECT_EQ(a.pushCount, b.pushCount);
+	EXPECT_EQ(a.popCount, b.popCount);
+	for (uint32_t i = 0; i < a.count; ++i)
+	{
+		EXPECT_EQ(a.types[i], b.types[i]);
+		EXPECT_EQ(a.values[i].uintVal, b.values[i].uintVal);
+	}
+}
+
+template <typename Var>
+void ExpectSameVariables(const std::vector<Var>& a, const std::vector<Var>& b)
+{
+	ASSERT_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); ++i)
+	{
+		EXPECT_EQ(a[i].type, b[i].type);
+		EXPECT_EQ(a[i].value.uintVal, b[i].value.uintVal);
+	}
+}
+
+/// The VMs must have been settled, which reading their tasks does
+inline void ExpectSameState(LHVM& a, LHVM& b)
+{
+	EXPECT_EQ(a.GetExecutedInstructions(), b.GetExecutedInstructions());
+	ExpectSameStack(a.GetMainStack(), b.GetMainStack());
+	ExpectSameVariables(a.GetVariables(), b.GetVariables());
+	ASSERT_EQ(a.GetTasks().size(), b.GetTasks().size());
+	for (auto ia = a.GetTasks().begin(), ib = b.GetTasks().begin(); ia != a.GetTasks().end(); ++ia, ++ib)
+	{
+		const auto& taskA = ia->second;
+		const auto& taskB = ib->second;
+		EXPECT_EQ(taskA.id, taskB.id);
+		EXPECT_EQ(taskA.scriptId, taskB.scriptId);
+		EXPECT_EQ(taskA.instructionAddress, taskB.instructionAddress);
+		EXPECT_EQ(taskA.waitingTaskId, taskB.waitingTaskId);
+		EXPECT_EQ(taskA.ticks, taskB.ticks);
+		EXPECT_EQ(taskA.inExceptionHandler, taskB.inExceptionHandler);
+		EXPECT_EQ(taskA.iield, taskB.iield);
+		EXPECT_EQ(taskA.sleeping, taskB.sleeping);
+		EXPECT_EQ(taskA.stop, taskB.stop);
+		ExpectSameStack(taskA.stack, taskB.stack);
+		ExpectSameVariables(taskA.localVars, taskB.localVars);
+	}
+}
+
+inline void ExpectSameState(Machine& a, Machine& b)
+{
+	EXPECT_EQ(a.errors, b.errors);
+	EXPECT_EQ(a.references, b.references);
+	ExpectSameState(a.vm, b.vm);
+}
+} // namespace lhvm_test
@@ -0,0 +1,325 @@
+/*******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include <cstdint>
+#include <cstring>
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <3D/L3DAnim.h>
+#include <ANMFile.h>
+#include <glm/gtc/epsilon.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtx/string_cast.hpp>
+#include <gtest/gtest.h>
+#include <spdlog/sinks/null_sink.h>
+#include <spdlog/spdlog.h>
+
+using namespace openblack;
+
+namespace
+{
+
+constexpr uint32_t k_Duration = 400;
+constexpr uint32_t k_LastKeyframeTime = 300;
+
+struct Keyframe
+{
+	uint32_t time;
+	std::vector<glm::mat4> bones;
+};
+
+/// Lay out keyframes the way an anm file does, every keyframe behind two levels of offsets
+std::vector<uint8_t> WriteAnm(const std::vector<Keyframe>& keyframes)
+{
+	anm::ANMHeader header {};
+	const std::string name = "test";
+	std::memcpy(header.name.data(), name.data(), name.size());
+	header.frameCount = static_cast<uint32_t>(keyframes.size());
+	header.animationDuration = k_Duration;
+	header.framesBase = sizeof(anm::ANMHeader);
+
+	std::vector<uint8_t> data(header.framesBase + keyframes.size() * sizeof(uint32_t));
+	std::memcpy(data.data(), &header, sizeof(header));
+	const auto append = [&data](const auto& value) {
+		const auto offset = data.size();
+		data.resize(offset + sizeof(value));
+		std::memcpy(data.data() + offset, &value, sizeof(value));
+	};
+	for (size_t i = 0; i < keyframes.size(); ++i)
+	{
+		const auto keyframe = static_cast<uint32_t>(data.size());
+		std::memcpy(data.data() + header.framesBase + i * sizeof(uint32_t), &keyframe, sizeof(keyframe));
+		append(keyframe + static_cast<uint32_t>(sizeof(uint32_t)));
+		append(keyframe + static_cast<uint32_t>(2 * sizeof(uint32_t)));
+		append(static_cast<uint32_t>(keyframes[i].bones.size()));
+		append(keyframes[i].time);
+		for (const auto& bone : keyframes[i].bones)
+		{
+			const anm::ANMBone affine = {{
+			    bone[0][0], bone[0][1], bone[0][2], //
+			    bone[1][0], bone[1][1], bone[1][2], //
+			    bone[2][0], bone[2][1], bone[2][2], //
+			    bone[3][0], bone[3][1], bone[3][2], //
+			}};
+			append(affine);
+		}
+	}
+	return data;
+}
+
+glm::mat4 RotateZ(float degrees, const glm::vec3& translation)
+{
+	return glm::rotate(glm::translate(glm::mat4(1.0f), translation), glm::radians(degrees), glm::vec3(0.0f, 0.0f, 1.0f));
+}
+
+/// Keyframes whose bones only rotate and translate. The first bone only moves so that interpolating its matrices
+/// gives the same bones as interpolating its rotation, the second one turns a quarter turn about z per keyframe.
+std::vector<Keyframe> RigidKeyframes()
+{
+	return {
+	    {0, {RotateZ(0.0f, {0.0f, 0.0f, 0.0f}), RotateZ(0.0f, {1.0f, 0.0f, 0.0f})}},
+	    {100, {RotateZ(0.0f, {2.0f, 4.0f, 0.0f}), RotateZ(90.0f, {1.0f, 2.0f, 0.0f})}},
+	    {k_LastKeyframeTime, {RotateZ(0.0f, {-2.0f, 0.0f, 6.0f}), RotateZ(180.0f, {1.0f, 2.0f, 4.0f})}},
+	};
+}
+
+/// Keyframes with scaled bones, which are interpolated as matrices like every bone was before
+std::vector<Keyframe> ScaledKeyframes()
+{
+	return {
+	    {0, {glm::scale(glm::mat4(1.0f), glm::vec3(1.0f)), RotateZ(30.0f, {1.0f, 0.0f, 0.0f})}},
+	    {100, {glm::scale(glm::mat4(1.0f), glm::vec3(2.0f, 1.0f, 3.0f)), RotateZ(60.0f, {0.0f, 1.0f, 0.0f})}},
+	    {k_LastKeyframeTime, {glm::scale(glm::mat4(1.0f), glm::vec3(0.5f)), RotateZ(90.0f, {0.0f, 0.0f, 1.0f})}},
+	};
+}
+
+/// Sample the per-frame matrices the way bones were looked up before they were kept as structures of arrays
+std::vector<glm::mat4> SampleFrames(const L3DAnim& animation, uint32_t time)
+{
+	const auto& frames = animation.GetFrames();
+	const uint32_t animationTime = time % animation.GetDuration();
+	uint32_t index = 0;
+	uint32_t previousTime = 0;
+	for (const auto& frame : frames)
+	{
+		if (frame.time >= animationTime)
+		{
+			break;
+		}
+		previousTime = frame.time;
+		index++;
+	}
+	if (index == 0)
+	{
+		return frames[0].bones;
+	}
+	if (index >= frames.size())
+	{
+		return frames[frames.size() - 1].bones;
+	}
+	const float t = static_cast<float>(animationTime - previousTime) / static_cast<float>(frames[index].time - previousTime);
+	std::vector<glm::mat4> bones(frames[index].bones.size());
+	for (size_t i = 0; i < bones.size(); ++i)
+	{
+		const auto& previous = frames[index - 1].bones[i];
+		const auto& next = frames[index].bones[i];
+		bones[i] = glm::mat4(glm::mix(previous[0], next[0], t), glm::mix(previous[1], next[1], t),
+		                     glm::mix(previous[2], next[2], t), glm::mix(previous[3], next[3], t));
+	}
+	return bones;
+}
+
+::testing::AssertionResult MatricesNear(const char* expr1, const char* expr2, const glm::mat4& m1, const glm::mat4& m2)
+{
+	constexpr float epsilon = 1e-4f;
+	for (glm::length_t column = 0; column < 4; ++column)
+	{
+		if (!glm::all(glm::epsilonEqual(m1[column], m2[column], epsilon)))
+		{
+			return ::testing::AssertionFailure() << expr1 << " is " << glm::to_string(m1) << "\n"
+			                                     << expr2 << " is " << glm::to_string(m2);
+		}
+	}
+	return ::testing::AssertionSuccess();
+}
+
+#define EXPECT_MAT4_NEAR(val1, val2) EXPECT_PRED_FORMAT2(MatricesNear, val1, val2)
+
+class TestL3DAnim: public ::testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		if (spdlog::get("game") == nullptr)
+		{
+			spdlog::null_logger_mt("game");
+		}
+	}
+
+	static L3DAnim Load(const std::vector<Keyframe>& keyframes)
+	{
+		L3DAnim animation;
+		EXPECT_TRUE(animation.LoadFromBuffer(WriteAnm(keyframes)));
+		EXPECT_EQ(animation.GetBoneCount(), keyframes[0].bones.size());
+		EXPECT_EQ(animation.GetDuration(), k_Duration);
+		return animation;
+	}
+};
+
+} // namespace
+
+TEST_F(TestL3DAnim, loadsFrames)
+{
+	const auto keyframes = RigidKeyframes();
+	const auto animation = Load(keyframes);
+	ASSERT_EQ(animation.GetFrames().size(), keyframes.size());
+	for (size_t frame = 0; frame < keyframes.size(); ++frame)
+	{
+		EXPECT_EQ(animation.GetFrames()[frame].time, keyframes[frame].time);
+		ASSERT_EQ(animation.GetFrames()[frame].bones.size(), keyframes[frame].bones.size());
+		for (size_t bone = 0; bone < keyframes[frame].bones.size(); ++bone)
+		{
+			EXPECT_MAT4_NEAR(animation.GetFrames()[frame].bones[bone], keyframes[frame].bones[bone]);
+		}
+	}
+}
+
+TEST_F(TestL3DAnim, keyframeBoundaries)
+{
+	for (const auto& keyframes : {RigidKeyframes(), ScaledKeyframes()})
+	{
+		const auto animation = Load(keyframes);
+		for (const auto& keyframe : keyframes)
+		{
+			SCOPED_TRACE("time " + std::to_string(keyframe.time));
+			const auto bones = animation.GetBoneMatrices(keyframe.time);
+			const auto expected = SampleFrames(animation, keyframe.time);
+			ASSERT_EQ(bones.size(), expected.size());
+			for (size_t bone = 0; bone < bones.size(); ++bone)
+			{
+				EXPECT_MAT4_NEAR(bones[bone], expected[bone]);
+				EXPECT_MAT4_NEAR(bones[bone], keyframe.bones[bone]);
+			}
+		}
+	}
+}
+
+TEST_F(TestL3DAnim, interpolatesRigidBones)
+{
+	const auto animation = Load(RigidKeyframes());
+	for (uint32_t time = 0; time < k_LastKeyframeTime; time += 7)
+	{
+		SCOPED_TRACE("time " + std::to_string(time));
+		const auto bones = animation.GetBoneMatrices(time);
+		const auto expected = SampleFrames(animation, time);
+		ASSERT_EQ(bones.size(), expected.size());
+
+		// Bones which only move interpolate the same as their matrices
+		EXPECT_MAT4_NEAR(bones[0], expected[0]);
+
+		// Turning bones keep turning at the same rate instead of shrinking half way like their matrices did
+		const bool first = time <= 100;
+		const float t = first ? static_cast<float>(time) / 100.0f : static_cast<float>(time - 100) / 200.0f;
+		const float degrees = first ? 90.0f * t : 90.0f + 90.0f * t;
+		auto turned = RotateZ(degrees, {});
+		turned[3] = expected[1][3];
+		EXPECT_MAT4_NEAR(bones[1], turned);
+	}
+}
+
+TEST_F(TestL3DAnim, interpolatesScaledBonesAsMatrices)
+{
+	const auto animation = Load(ScaledKeyframes());
+	for (uint32_t time = 0; time < k_LastKeyframeTime; time += 7)
+	{
+		SCOPED_TRACE("time " + std::to_string(time));
+		const auto bones = animation.GetBoneMatrices(time);
+		const auto expected = SampleFrames(animation, time);
+		ASSERT_EQ(bones.size(), expected.size());
+		for (size_t bone = 0; bone < bones.size(); ++bone)
+		{
+			EXPECT_MAT4_NEAR(bones[bone], expected[bone]);
+		}
+	}
+}
+
+TEST_F(TestL3DAnim, clampsPastLastKeyframe)
+{
+	for (const auto& keyframes : {RigidKeyframes(), ScaledKeyframes()})
+	{
+		const auto animation = Load(keyframes);
+		for (const uint32_t time : {k_LastKeyframeTime + 1, k_Duration - 1})
+		{
+			SCOPED_TRACE("time " + std::to_string(time));
+			const auto bones = animation.GetBoneMatrices(time);
+			const auto expected = SampleFrames(animation, time);
+			for (size_t bone = 0; bone < bones.size(); ++bone)
+			{
+				EXPECT_MAT4_NEAR(bones[bone], expected[bone]);
+				EXPECT_MAT4_NEAR(bones[bone], keyframes.back().bones[bone]);
+			}
+		}
+
+		// Time loops over the duration of the animation
+		const auto wrapped = animation.GetBoneMatrices(k_Duration + 50);
+		const auto expected = animation.GetBoneMatrices(50);
+		for (size_t bone = 0; bone < wrapped.size(); ++bone)
+		{
+			EXPECT_MAT4_NEAR(wrapped[bone], expected[bone]);
+		}
+	}
+}
+
+TEST_F(TestL3DAnim, cursorAndBatchSampleTheSame)
+{
+	for (const auto& keyframes : {RigidKeyframes(), ScaledKeyframes()})
+	{
+		const auto animation = Load(keyframes);
+		const auto boneCount = animation.GetBoneCount();
+
+		// Forward, backward and across the loop so that the cursor is both right and stale
+		std::vector<uint32_t> times;
+		for (uint32_t time = 0; time < 2 * k_Duration; time += 13)
+		{
+			times.push_back(time);
+		}
+		for (uint32_t time = k_Duration; time > 29; time -= 29)
+		{
+			times.push_back(time);
+		}
+
+		L3DAnim::SampleCursor cursor;
+		std::vector<glm::mat4> bones(boneCount);
+		for (const auto time : times)
+		{
+			SCOPED_TRACE("time " + std::to_string(time));
+			animation.SampleBoneMatrices(time, bones, &cursor);
+			const auto expected = animation.GetBoneMatrices(time);
+			for (size_t bone = 0; bone < boneCount; ++bone)
+			{
+				EXPECT_EQ(bones[bone], expected[bone]);
+			}
+		}
+
+		std::vector<glm::mat4> batch(times.size() * boneCount);
+		animation.SampleBoneMatrices(times, batch);
+		for (size_t i = 0; i < times.size(); ++i)
+		{
+			SCOPED_TRACE("time " + std::to_string(times[i]));
+			const auto expected = animation.GetBoneMatrices(times[i]);
+			for (size_t bone = 0; bone < boneCount; ++bone)
+			{
+				EXPECT_EQ(batch[i * boneCount + bone], expected[bone]);
+			}
+		}
+	}
+}
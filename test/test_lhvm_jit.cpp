@@ -0,0 +1,75 @@
+/*******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include <string>
+
+#include "lhvm_programs.h"
+
+using namespace lhvm_test;
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmJit, sameStateAsInterpreter)
+{
+	if (!LHVM::IsJitAvailable())
+	{
+		GTEST_SKIP() << "The JIT isn't available in this build";
+	}
+
+	// Long enough for every script to be compiled
+	constexpr uint32_t k_Ticks = 200;
+	constexpr uint32_t k_Seeds = 500;
+	uint32_t compiledScripts = 0;
+	for (uint32_t seed = 0; seed < k_Seeds; ++seed)
+	{
+		SCOPED_TRACE("seed " + std::to_string(seed));
+		std::mt19937 rng(seed);
+		const auto program = Generate(rng);
+		Machine interpreted;
+		Machine compiled;
+		Load(interpreted, InterpreterCore::Threaded, program);
+		Load(compiled, InterpreterCore::Jit, program);
+
+		for (uint32_t tick = 0; tick < k_Ticks; ++tick)
+		{
+			bool interpretedThrew = false;
+			bool compiledThrew = false;
+			try
+			{
+				interpreted.vm.LookIn(ScriptType::All);
+			}
+			catch (const std::exception&)
+			{
+				interpretedThrew = true;
+			}
+			try
+			{
+				compiled.vm.LookIn(ScriptType::All);
+			}
+			catch (const std::exception&)
+			{
+				compiledThrew = true;
+			}
+			ASSERT_EQ(interpretedThrew, compiledThrew) << "tick " << tick;
+			if (interpretedThrew)
+			{
+				break;
+			}
+		}
+		ExpectSameState(interpreted, compiled);
+		EXPECT_EQ(compiled.vm.GetJitFailedScriptCount(), 0u);
+		EXPECT_EQ(interpreted.vm.GetJitCompiledScriptCount(), 0u);
+		compiledScripts += compiled.vm.GetJitCompiledScriptCount();
+		if (HasFailure())
+		{
+			return;
+		}
+	}
+	// Scripts which end or throw early never go hot, but more than one a program loops for the whole run on average
+	EXPECT_GT(compiledScripts, k_Seeds);
+}
@@ -0,0 +1,92 @@
+/*******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include <cstdlib>
+
+#include <iterator>
+#include <string>
+
+#include <LHVMSnapshot.h>
+
+#include "lhvm_programs.h"
+
+using namespace lhvm_test;
+
+// The reference restores a snapshot of itself before every tick, which puts all of its tasks back in the ready ones. No
+// task is ever left sleeping or waiting across a tick, every task runs every tick like when the scheduler scanned them
+// all. The scheduled VM keeps its sleeping and waiting tasks out of the ticks and catches them up when they are read.
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmScheduler, sameStateAsRunningEveryTask)
+{
+	constexpr uint32_t k_Ticks = 200;
+	for (uint32_t seed = 0; seed < 300; ++seed)
+	{
+		SCOPED_TRACE("seed " + std::to_string(seed));
+		std::mt19937 rng(seed);
+		const auto program = GenerateScheduling(rng);
+		Machine scheduled;
+		Machine reference;
+		Load(scheduled, InterpreterCore::Threaded, program);
+		Load(reference, InterpreterCore::Threaded, program);
+
+		for (uint32_t tick = 0; tick < k_Ticks; ++tick)
+		{
+			ASSERT_EQ(reference.vm.RestoreSnapshot(reference.vm.TakeSnapshot()), EXIT_SUCCESS);
+
+			// Mostly every type like the game, sometimes one type so that the others fall behind
+			const auto pick = rng() % 8;
+			const auto mask = pick < 6 ? ScriptType::All : pick == 6 ? ScriptType::Script : ScriptType::Help;
+			bool scheduledThrew = false;
+			bool referenceThrew = false;
+			try
+			{
+				scheduled.vm.LookIn(mask);
+			}
+			catch (const std::exception&)
+			{
+				scheduledThrew = true;
+			}
+			try
+			{
+				reference.vm.LookIn(mask);
+			}
+			catch (const std::exception&)
+			{
+				referenceThrew = true;
+			}
+			ASSERT_EQ(scheduledThrew, referenceThrew) << "tick " << tick;
+			if (scheduledThrew)
+			{
+				break;
+			}
+			EXPECT_EQ(scheduled.vm.GetExecutedInstructions(), reference.vm.GetExecutedInstructions()) << "tick " << tick;
+
+			// Tasks stopped from outside of a tick, sleeping and waiting ones included
+			if (rng() % 16 == 0 && !reference.vm.GetTasks().empty())
+			{
+				auto task = reference.vm.GetTasks().begin();
+				std::advance(task, rng() % reference.vm.GetTasks().size());
+				const auto id = task->first;
+				scheduled.vm.StopTask(id);
+				reference.vm.StopTask(id);
+			}
+			if (HasFailure())
+			{
+				return;
+			}
+		}
+		EXPECT_EQ(scheduled.vm.GetTicks(), reference.vm.GetTicks());
+		ExpectSameState(scheduled, reference);
+		if (HasFailure())
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,145 @@
+/*******************************************************************************
+ * Copyright (c) 2018-2024 openblack developers
+ *
+ * For a complete list of all authors, please refer to contributors.md
+ * Interested in contributing? Visit https://github.com/openblack/openblack
+ *
+ * openblack is licensed under the GNU General Public License version 3.
+ *******************************************************************************/
+
+#include <cstdlib>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <LHVMSnapshot.h>
+
+#include "lhvm_programs.h"
+
+using namespace lhvm_test;
+
+namespace
+{
+/// Runs the VM until a native throws or the ticks are over, returns false if one threw
+bool RunTicks(Machine& machine, uint32_t ticks)
+{
+	for (uint32_t tick = 0; tick < ticks; ++tick)
+	{
+		try
+		{
+			machine.vm.LookIn(ScriptType::All);
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+} // namespace
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmSnapshot, restoredStateRunsOnTheSame)
+{
+	for (uint32_t seed = 0; seed < 200; ++seed)
+	{
+		SCOPED_TRACE("seed " + std::to_string(seed));
+		std::mt19937 rng(seed);
+		const auto program = Generate(rng);
+		Machine original;
+		Machine restored;
+		Load(original, InterpreterCore::Threaded, program);
+		Load(restored, InterpreterCore::Threaded, program);
+		if (!RunTicks(original, 50))
+		{
+			continue;
+		}
+
+		const auto buffer = original.vm.TakeSnapshot().Encode(seed % 2 == 0);
+		LHVMSnapshot snapshot;
+		ASSERT_EQ(snapshot.Decode(buffer), EXIT_SUCCESS);
+		ASSERT_EQ(restored.vm.RestoreSnapshot(snapshot), EXIT_SUCCESS);
+		ExpectSameState(original.vm, restored.vm);
+
+		// Errors and references from before the snapshot are only seen by the original
+		original.errors.clear();
+		restored.errors.clear();
+		original.references = restored.references = 0;
+		const auto originalFinished = RunTicks(original, 50);
+		const auto restoredFinished = RunTicks(restored, 50);
+		ASSERT_EQ(originalFinished, restoredFinished);
+		ExpectSameState(original.vm, restored.vm);
+		EXPECT_EQ(original.errors, restored.errors);
+		if (HasFailure())
+		{
+			return;
+		}
+	}
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmSnapshot, rejectsDamagedSnapshots)
+{
+	std::mt19937 rng(7);
+	const auto program = Generate(rng);
+	Machine machine;
+	Load(machine, InterpreterCore::Threaded, program);
+	RunTicks(machine, 20);
+
+	for (const bool compress : {false, true})
+	{
+		const auto buffer = machine.vm.TakeSnapshot().Encode(compress);
+		LHVMSnapshot snapshot;
+		for (size_t size = 0; size < buffer.size(); ++size)
+		{
+			EXPECT_EQ(snapshot.Decode({buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(size)}), EXIT_FAILURE);
+		}
+		// Damage has to be caught, or at least leave a snapshot which decodes safely
+		for (size_t i = 0; i < buffer.size(); ++i)
+		{
+			auto damaged = buffer;
+			damaged[i] ^= 0x5A;
+			static_cast<void>(snapshot.Decode(damaged));
+		}
+	}
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmSnapshot, rejectsOtherPrograms)
+{
+	std::mt19937 rngA(1);
+	std::mt19937 rngB(2);
+	Machine a;
+	Machine b;
+	Load(a, InterpreterCore::Threaded, Generate(rngA));
+	Load(b, InterpreterCore::Threaded, Generate(rngB));
+	RunTicks(a, 20);
+	RunTicks(b, 20);
+
+	const auto before = b.vm.GetExecutedInstructions();
+	EXPECT_EQ(b.vm.RestoreSnapshot(a.vm.TakeSnapshot()), EXIT_FAILURE);
+	EXPECT_EQ(b.vm.GetExecutedInstructions(), before);
+}
+
+// NOLINTNEXTLINE(cppcoreguidelines-avoid-non-const-global-variables): external macro
+TEST(TestLhvmSnapshot, writeAsync)
+{
+	std::mt19937 rng(3);
+	const auto program = Generate(rng);
+	Machine original;
+	Machine restored;
+	Load(original, InterpreterCore::Threaded, program);
+	Load(restored, InterpreterCore::Threaded, program);
+	RunTicks(original, 30);
+
+	const auto path = std::filesystem::path(TEST_BINARY_DIR) / "quicksave.lhvs";
+	auto written = LHVMSnapshot::WriteAsync(original.vm.TakeSnapshot(), path, true);
+	ASSERT_EQ(written.get(), EXIT_SUCCESS);
+
+	LHVMSnapshot snapshot;
+	ASSERT_EQ(snapshot.Read(path), EXIT_SUCCESS);
+	ASSERT_EQ(restored.vm.RestoreSnapshot(snapshot), EXIT_SUCCESS);
+	ExpectSameState(original.vm, restored.vm);
+	std::filesystem::remove(path);
+}